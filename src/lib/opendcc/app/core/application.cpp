@@ -320,6 +320,7 @@ Application::Application()
     auto package_provider = std::make_shared<FileSystemPackageProvider>();
     package_provider->add_path((m_application_root_path + "/packages/*").c_str());
     package_provider->register_package_parser("toml", std::make_shared<TOMLParser>());
+    package_provider->set_index_path(get_settings_path() + "package_index.json");
     m_package_registry->add_package_provider(package_provider);
 #if defined(OPENDCC_OS_WINDOWS)
     m_package_registry->define_token("APP_LIB_DIR", m_application_root_path + "/bin");
@@ -692,7 +693,7 @@ void Application::create_command_server()
         {
             return;
         }
-        std::string pid = find->second;
+        std::string pid = find->second.get_string();
 
         ipc::ServerInfo info;
 
@@ -701,14 +702,14 @@ void Application::create_command_server()
         {
             return;
         }
-        info.hostname = find->second;
+        info.hostname = find->second.get_string();
 
         find = command.args.find("input_port");
         if (find == end)
         {
             return;
         }
-        info.input_port = std::atoi(find->second.c_str());
+        info.input_port = static_cast<uint32_t>(find->second.get_int());
 
         auto& server_registry = ipc::ServerRegistry::instance();
         server_registry.add_server(pid, info);
@@ -746,7 +747,7 @@ void Application::create_command_server()
 
             auto usd_crop = crop;
             usd_crop.name = "CropUsdRender";
-            s_server->send_command(find->second, usd_crop);
+            s_server->send_command(find->second.get_string(), usd_crop);
         }
         else // scene_lib
         {
@@ -779,6 +780,10 @@ void Application::create_command_server()
     const auto& config = get_app_config();
 
     ipc::CommandServer::set_server_timeout(config.get<int>("ipc.command_server.server_timeout", 1000));
+    if (config.get<std::string>("ipc.command_server.protocol", "binary") == "text")
+    {
+        ipc::CommandServer::set_protocol(ipc::CommandServer::Protocol::Text);
+    }
     ipc::ServerInfo info;
     info.hostname = "127.0.0.1";
     info.input_port = config.get<uint32_t>("ipc.command_server.port", 8000);
@@ -5,6 +5,7 @@
 #include <pxr/usd/sdf/attributeSpec.h>
 #include <pxr/usd/sdf/primSpec.h>
 #include <regex>
+#include <unordered_map>
 #include <pxr/usd/usd/prim.h>
 #include <pxr/usd/usd/stage.h>
 #include <pxr/usd/usd/relationship.h>
@@ -17,6 +18,7 @@
 #include "opendcc/app/core/application.h"
 #include "opendcc/app/core/session.h"
 #include "opendcc/app/core/undo/router.h"
+#include "opendcc/app/core/sorted_path_set.h"
 #include "pxr/usd/usd/primRange.h"
 #include "pxr/usd/pcp/node.h"
 #include <opendcc/base/vendor/ghc/filesystem.hpp>
@@ -117,12 +119,23 @@ PXR_NS::TfToken commands::utils::get_new_name(const PXR_NS::TfToken& name_candid
 
 void commands::utils::rename_targets(const UsdStageRefPtr& stage, const SdfPath& old_path, const SdfPath& new_path)
 {
-    SdfPath prim_path = old_path;
-    std::function<void(const SdfPrimSpecHandle&, const SdfPath&)> traverse = [&](const SdfPrimSpecHandle& prim, const SdfPath& new_path) {
-        const auto& layer = stage->GetEditTarget().GetLayer();
+    rename_targets(stage, SdfPathVector { old_path }, SdfPathVector { new_path });
+}
+
+void commands::utils::rename_targets(const UsdStageRefPtr& stage, const SdfPathVector& old_paths, const SdfPathVector& new_paths)
+{
+    if (!TF_VERIFY(old_paths.size() == new_paths.size()) || old_paths.empty())
+        return;
+
+    std::unordered_map<SdfPath, SdfPath, SdfPath::Hash> renames;
+    for (size_t i = 0; i < old_paths.size(); ++i)
+        renames.emplace(old_paths[i], new_paths[i]);
+    const SortedPathSet renamed_paths(old_paths);
+
+    std::function<void(const SdfPrimSpecHandle&)> traverse = [&](const SdfPrimSpecHandle& prim) {
         for (const auto& child : prim->GetNameChildren())
         {
-            traverse(child, new_path);
+            traverse(child);
         }
 
         for (const auto& relationship : prim->GetRelationships())
@@ -131,9 +144,10 @@ void commands::utils::rename_targets(const UsdStageRefPtr& stage, const SdfPath&
             for (auto& target_index : targets.GetAddedOrExplicitItems())
             {
                 auto target = (SdfPathKeyPolicy::value_type)target_index;
-                if (target.HasPrefix(prim_path))
+                const auto old_path = renamed_paths.find_top_most_ancestor(target);
+                if (!old_path.IsEmpty())
                 {
-                    targets.ReplaceItemEdits(target, target.ReplacePrefix(prim_path, new_path));
+                    targets.ReplaceItemEdits(target, target.ReplacePrefix(old_path, renames[old_path]));
                 }
             }
         }
@@ -144,25 +158,33 @@ void commands::utils::rename_targets(const UsdStageRefPtr& stage, const SdfPath&
             for (const auto& connection : connections.GetAddedOrExplicitItems())
             {
                 auto target = (SdfPathKeyPolicy::value_type)connection;
-                if (target.HasPrefix(prim_path))
+                const auto old_path = renamed_paths.find_top_most_ancestor(target);
+                if (!old_path.IsEmpty())
                 {
-                    connections.ReplaceItemEdits(target, target.ReplacePrefix(prim_path, new_path));
+                    connections.ReplaceItemEdits(target, target.ReplacePrefix(old_path, renames[old_path]));
                 }
             }
         }
     };
 
-    traverse(stage->GetEditTarget().GetLayer()->GetPseudoRoot(), new_path);
+    traverse(stage->GetEditTarget().GetLayer()->GetPseudoRoot());
 }
 
 void commands::utils::delete_targets(const PXR_NS::UsdStageRefPtr& stage, const PXR_NS::SdfPath& remove_path)
 {
-    SdfPath prim_path = remove_path;
-    std::function<void(const SdfPrimSpecHandle&, const SdfPath&)> traverse = [&](const SdfPrimSpecHandle& prim, const SdfPath& new_path) {
-        const auto& layer = stage->GetEditTarget().GetLayer();
+    delete_targets(stage, SdfPathVector { remove_path });
+}
+
+void commands::utils::delete_targets(const PXR_NS::UsdStageRefPtr& stage, const PXR_NS::SdfPathVector& remove_paths)
+{
+    if (remove_paths.empty())
+        return;
+
+    const SortedPathSet removed_paths(remove_paths);
+    std::function<void(const SdfPrimSpecHandle&)> traverse = [&](const SdfPrimSpecHandle& prim) {
         for (const auto& child : prim->GetNameChildren())
         {
-            traverse(child, new_path);
+            traverse(child);
         }
 
         for (const auto& relationship : prim->GetRelationships())
@@ -171,7 +193,7 @@ void commands::utils::delete_targets(const PXR_NS::UsdStageRefPtr& stage, const
             for (auto& target_index : targets.GetAddedOrExplicitItems())
             {
                 auto target = (SdfPathKeyPolicy::value_type)target_index;
-                if (target.HasPrefix(prim_path))
+                if (removed_paths.has_ancestor(target))
                 {
                     targets.RemoveItemEdits(target);
                 }
@@ -184,7 +206,7 @@ void commands::utils::delete_targets(const PXR_NS::UsdStageRefPtr& stage, const
             for (const auto& connection : connections.GetAddedOrExplicitItems())
             {
                 auto target = (SdfPathKeyPolicy::value_type)connection;
-                if (target.HasPrefix(prim_path))
+                if (removed_paths.has_ancestor(target))
                 {
                     connections.RemoveItemEdits(target);
                 }
@@ -192,7 +214,7 @@ void commands::utils::delete_targets(const PXR_NS::UsdStageRefPtr& stage, const
         }
     };
 
-    traverse(stage->GetEditTarget().GetLayer()->GetPseudoRoot(), remove_path);
+    traverse(stage->GetEditTarget().GetLayer()->GetPseudoRoot());
 }
 
 void commands::utils::preserve_transform(const UsdPrim& prim, const UsdPrim& parent)
@@ -38,7 +38,12 @@ namespace commands
                                                           const PXR_NS::SdfPathVector& additional_paths = {});
         OPENDCC_API PXR_NS::TfToken get_new_name(const PXR_NS::TfToken& name_candidate, const PXR_NS::TfTokenVector& existing_names);
         OPENDCC_API void rename_targets(const PXR_NS::UsdStageRefPtr& stage, const PXR_NS::SdfPath& old_path, const PXR_NS::SdfPath& new_path);
+        // renames the targets of all the paths in one pass over the edit target layer,
+        // a target under several old paths is renamed by the top-most of them
+        OPENDCC_API void rename_targets(const PXR_NS::UsdStageRefPtr& stage, const PXR_NS::SdfPathVector& old_paths,
+                                        const PXR_NS::SdfPathVector& new_paths);
         OPENDCC_API void delete_targets(const PXR_NS::UsdStageRefPtr& stage, const PXR_NS::SdfPath& remove_path);
+        OPENDCC_API void delete_targets(const PXR_NS::UsdStageRefPtr& stage, const PXR_NS::SdfPathVector& remove_paths);
         OPENDCC_API void preserve_transform(const PXR_NS::UsdPrim& prim, const PXR_NS::UsdPrim& parent);
         OPENDCC_API PXR_NS::SdfPath get_common_parent(const PXR_NS::SdfPathVector& paths);
         OPENDCC_API void apply_schema_to_spec(const std::string& schema_name, const std::vector<PXR_NS::SdfPrimSpecHandle>& prim_specs);
@@ -275,6 +275,8 @@ void Session::update_watcher()
     {
         m_stage_watcher = std::make_unique<StageObjectChangedWatcher>(stage, [this](PXR_NS::UsdNotice::ObjectsChanged const &notice) {
             m_stage_changed_event_dispatcher.dispatch(StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED, notice);
+            if (m_stage_changes_dispatcher.has_subscribers())
+                m_stage_changes_dispatcher.dispatch(StageChangeSummary(notice));
         });
         m_edit_target_watcher =
             std::make_unique<StageEditTargetChangedWatcher>(stage, [this, stage](PXR_NS::UsdNotice::StageEditTargetChanged const &notice) {
@@ -332,6 +334,22 @@ void Session::unregister_stage_changed_callback(const StageChangedEventType &eve
     m_stage_changed_event_dispatcher.removeListener(event_type, handle);
 }
 
+StageChangesDispatcher::Handle Session::register_stage_changes_callback(const StageChangesDispatcher::Filter &filter,
+                                                                       const StageChangesDispatcher::Callback &callback)
+{
+    return m_stage_changes_dispatcher.subscribe(filter, callback);
+}
+
+void Session::set_stage_changes_filter(StageChangesDispatcher::Handle handle, const StageChangesDispatcher::Filter &filter)
+{
+    m_stage_changes_dispatcher.set_filter(handle, filter);
+}
+
+void Session::unregister_stage_changes_callback(StageChangesDispatcher::Handle handle)
+{
+    m_stage_changes_dispatcher.unsubscribe(handle);
+}
+
 Session::CallbackHandle Session::register_event_callback(EventType event_type, std::function<void()> callback)
 {
     return m_event_dispatcher.appendListener(event_type, callback);
@@ -19,6 +19,7 @@
 #include "opendcc/app/core/api.h"
 #include "opendcc/app/core/topology_cache.h"
 #include "opendcc/app/core/half_edge_cache.h"
+#include "opendcc/app/core/stage_change_summary.h"
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -264,6 +265,32 @@ public:
      * @param handle The callback handle.
      */
     OPENDCC_API void unregister_stage_changed_callback(const StageChangedEventType& event_type, StageChangedCallbackHandle& handle);
+    /**
+     * @brief Subscribes a callback to the changes of the current stage made to the filtered paths and fields.
+     *
+     * The notice is digested once into a StageChangeSummary shared by all subscribers,
+     * the callback is called only if the changes affect the filter.
+     *
+     * @param filter The paths and fields to watch.
+     * @param callback The function to be called with the changes.
+     *
+     * @return A callback handle which is required for unsubscription.
+     */
+    OPENDCC_API StageChangesDispatcher::Handle register_stage_changes_callback(const StageChangesDispatcher::Filter& filter,
+                                                                               const StageChangesDispatcher::Callback& callback);
+    /**
+     * @brief Replaces the filter of the subscribed callback.
+     *
+     * @param handle The callback handle.
+     * @param filter The paths and fields to watch.
+     */
+    OPENDCC_API void set_stage_changes_filter(StageChangesDispatcher::Handle handle, const StageChangesDispatcher::Filter& filter);
+    /**
+     * @brief Unsubscribes a callback from the current stage changes.
+     *
+     * @param handle The callback handle.
+     */
+    OPENDCC_API void unregister_stage_changes_callback(StageChangesDispatcher::Handle handle);
     /**
      * @brief Subscribes a callback to the common session events.
      *
@@ -340,6 +367,7 @@ private:
     using HalfEdgeCachePerStage = std::unordered_map<PXR_NS::UsdStageCache::Id, HalfEdgeCache, PXR_NS::TfHash>;
     HalfEdgeCachePerStage m_half_edge_cache;
     StageChangedEventDispatcher m_stage_changed_event_dispatcher;
+    StageChangesDispatcher m_stage_changes_dispatcher;
     std::shared_ptr<LayerTreeWatcher> m_layer_tree_watcher;
     std::shared_ptr<LayerStateDelegatesHolder> m_layer_state_delegates;
     std::unique_ptr<ShareEditsContext> m_share_context;
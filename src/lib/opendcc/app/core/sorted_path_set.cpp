@@ -0,0 +1,187 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/app/core/sorted_path_set.h"
+#include <algorithm>
+
+OPENDCC_NAMESPACE_OPEN
+PXR_NAMESPACE_USING_DIRECTIVE
+
+SortedPathSet::SortedPathSet(SdfPathVector paths)
+    : m_paths(std::move(paths))
+{
+    std::sort(m_paths.begin(), m_paths.end());
+    m_paths.erase(std::unique(m_paths.begin(), m_paths.end()), m_paths.end());
+}
+
+bool SortedPathSet::contains(const SdfPath& path) const
+{
+    return contains(m_paths, path);
+}
+
+bool SortedPathSet::has_ancestor(const SdfPath& path, bool include_self) const
+{
+    return has_ancestor(m_paths, path, include_self);
+}
+
+SdfPath SortedPathSet::find_top_most_ancestor(const SdfPath& path, bool include_self) const
+{
+    return find_top_most_ancestor(m_paths, path, include_self);
+}
+
+std::pair<SortedPathSet::const_iterator, SortedPathSet::const_iterator> SortedPathSet::get_subtree_range(const SdfPath& root) const
+{
+    return get_subtree_range(m_paths, root);
+}
+
+SdfPathVector SortedPathSet::get_top_most_paths() const
+{
+    auto result = m_paths;
+    remove_descendants(result);
+    return result;
+}
+
+bool SortedPathSet::contains(const SdfPathVector& sorted_paths, const SdfPath& path)
+{
+    return std::binary_search(sorted_paths.begin(), sorted_paths.end(), path);
+}
+
+bool SortedPathSet::has_ancestor(const SdfPathVector& sorted_paths, const SdfPath& path, bool include_self)
+{
+    return !find_top_most_ancestor(sorted_paths, path, include_self).IsEmpty();
+}
+
+SdfPath SortedPathSet::find_top_most_ancestor(const SdfPathVector& sorted_paths, const SdfPath& path, bool include_self)
+{
+    // ancestors precede the path, so only the paths up to it are searched
+    const auto last = std::upper_bound(sorted_paths.begin(), sorted_paths.end(), path);
+    if (last == sorted_paths.begin() || !path.IsAbsolutePath())
+        return SdfPath();
+
+    SdfPath result;
+    for (auto ancestor = include_self ? path : path.GetParentPath(); !ancestor.IsEmpty(); ancestor = ancestor.GetParentPath())
+    {
+        if (std::binary_search(sorted_paths.begin(), last, ancestor))
+            result = ancestor;
+    }
+    return result;
+}
+
+std::pair<SortedPathSet::const_iterator, SortedPathSet::const_iterator> SortedPathSet::get_subtree_range(const SdfPathVector& sorted_paths,
+                                                                                                        const SdfPath& root)
+{
+    const auto first = std::lower_bound(sorted_paths.begin(), sorted_paths.end(), root);
+    const auto last = std::partition_point(first, sorted_paths.end(), [&root](const SdfPath& path) { return path.HasPrefix(root); });
+    return { first, last };
+}
+
+void SortedPathSet::remove_descendants(SdfPathVector& sorted_paths)
+{
+    // descendants follow their ancestor, so comparing with the last kept path is enough
+    auto kept = sorted_paths.begin();
+    for (auto it = sorted_paths.begin(); it != sorted_paths.end(); ++it)
+    {
+        if (kept != sorted_paths.begin() && it->HasPrefix(*(kept - 1)))
+            continue;
+        if (kept != it)
+            *kept = std::move(*it);
+        ++kept;
+    }
+    sorted_paths.erase(kept, sorted_paths.end());
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+#include <chrono>
+#include <unordered_set>
+#include <pxr/base/tf/stringUtils.h>
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("SortedPathSet")
+{
+    DOCTEST_TEST_CASE("queries")
+    {
+        const SortedPathSet set({ SdfPath("/world/b"), SdfPath("/world"), SdfPath("/world/a/mesh"), SdfPath("/other"), SdfPath("/world"),
+                                  SdfPath("/world_1/a") });
+
+        DOCTEST_CHECK(set.size() == 5);
+        DOCTEST_CHECK(set.contains(SdfPath("/world/b")));
+        DOCTEST_CHECK(!set.contains(SdfPath("/world/a")));
+
+        DOCTEST_CHECK(set.has_ancestor(SdfPath("/world/a")));
+        DOCTEST_CHECK(set.has_ancestor(SdfPath("/other")));
+        DOCTEST_CHECK(!set.has_ancestor(SdfPath("/other"), false));
+        DOCTEST_CHECK(!set.has_ancestor(SdfPath("/world_1")));
+        DOCTEST_CHECK(!set.has_ancestor(SdfPath("/a")));
+        DOCTEST_CHECK(set.find_top_most_ancestor(SdfPath("/world/a/mesh/child")) == SdfPath("/world"));
+        DOCTEST_CHECK(set.find_top_most_ancestor(SdfPath("/world/a/mesh.points")) == SdfPath("/world"));
+        DOCTEST_CHECK(set.find_top_most_ancestor(SdfPath("/world"), false).IsEmpty());
+        DOCTEST_CHECK(set.find_top_most_ancestor(SdfPath("world/a")).IsEmpty());
+
+        auto range = set.get_subtree_range(SdfPath("/world"));
+        DOCTEST_CHECK(SdfPathVector(range.first, range.second) == SdfPathVector { SdfPath("/world"), SdfPath("/world/a/mesh"), SdfPath("/world/b") });
+        range = set.get_subtree_range(SdfPath("/world/a"));
+        DOCTEST_CHECK(SdfPathVector(range.first, range.second) == SdfPathVector { SdfPath("/world/a/mesh") });
+        range = set.get_subtree_range(SdfPath("/missing"));
+        DOCTEST_CHECK(range.first == range.second);
+        range = set.get_subtree_range(SdfPath::AbsoluteRootPath());
+        DOCTEST_CHECK(std::distance(range.first, range.second) == 5);
+
+        DOCTEST_CHECK(set.get_top_most_paths() == SdfPathVector { SdfPath("/other"), SdfPath("/world"), SdfPath("/world_1/a") });
+        DOCTEST_CHECK(SortedPathSet({ SdfPath::AbsoluteRootPath(), SdfPath("/a") }).get_top_most_paths() == SdfPathVector { SdfPath::AbsoluteRootPath() });
+        DOCTEST_CHECK(SortedPathSet().get_top_most_paths().empty());
+    }
+
+    DOCTEST_TEST_CASE("benchmark")
+    {
+        // a selection of groups with their children, as selected by the box selection in the outliner
+        const size_t groups_count = 1000;
+        const size_t children_count = 9;
+        SdfPathVector paths;
+        for (size_t i = 0; i < groups_count; ++i)
+        {
+            const SdfPath group(TfStringPrintf("/world/group_%zu", i));
+            paths.push_back(group);
+            for (size_t j = 0; j < children_count; ++j)
+                paths.push_back(group.AppendChild(TfToken(TfStringPrintf("child_%zu", j))));
+        }
+        std::reverse(paths.begin(), paths.end());
+
+        // reference: a path is top-most if none of its ancestors is in the hashed set of all paths
+        auto start = std::chrono::steady_clock::now();
+        const std::unordered_set<SdfPath, SdfPath::Hash> hashed_paths(paths.begin(), paths.end());
+        SdfPathVector hashed_result;
+        size_t hashed_ancestors_found = 0;
+        for (const auto& path : paths)
+        {
+            bool is_top = true;
+            for (auto parent = path.GetParentPath(); !parent.IsEmpty() && is_top; parent = parent.GetParentPath())
+                is_top = hashed_paths.count(parent) == 0;
+            if (is_top)
+                hashed_result.push_back(path);
+            else
+                ++hashed_ancestors_found;
+        }
+        const auto hashed_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        const SortedPathSet set(paths);
+        const auto sorted_result = set.get_top_most_paths();
+        size_t ancestors_found = 0;
+        for (const auto& path : paths)
+            ancestors_found += set.find_top_most_ancestor(path, false).IsEmpty() ? 0 : 1;
+        const auto sorted_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::sort(hashed_result.begin(), hashed_result.end());
+        DOCTEST_CHECK(hashed_result == sorted_result);
+        DOCTEST_CHECK(ancestors_found == hashed_ancestors_found);
+        DOCTEST_CHECK(sorted_result.size() == groups_count);
+        DOCTEST_CHECK(ancestors_found == groups_count * children_count);
+        DOCTEST_MESSAGE("top-most paths of " << paths.size() << " paths: hashed ancestor walk " << hashed_time
+                                             << " ms, sorted set with ancestor lookups " << sorted_time << " ms");
+    }
+}
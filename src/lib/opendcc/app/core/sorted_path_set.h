@@ -0,0 +1,78 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include "opendcc/opendcc.h"
+#include "opendcc/app/core/api.h"
+#include <pxr/usd/sdf/path.h>
+#include <utility>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Sorted set of absolute paths with hierarchy queries.
+ *
+ * The paths are sorted once. In the SdfPath order a path precedes its descendants and the descendants
+ * of a path form a contiguous range right after it, so ancestor lookups and subtree queries are binary searches
+ * instead of prefix checks against every path of the set.
+ *
+ * The static overloads run the same queries over an externally owned vector, e.g. Hd_SortedIds::GetIds(),
+ * which must be sorted and free of duplicates.
+ */
+class OPENDCC_API SortedPathSet
+{
+public:
+    using const_iterator = PXR_NS::SdfPathVector::const_iterator;
+
+    SortedPathSet() = default;
+    explicit SortedPathSet(PXR_NS::SdfPathVector paths);
+
+    const_iterator begin() const { return m_paths.begin(); }
+    const_iterator end() const { return m_paths.end(); }
+    size_t size() const { return m_paths.size(); }
+    bool empty() const { return m_paths.empty(); }
+    const PXR_NS::SdfPathVector& get_paths() const { return m_paths; }
+
+    bool contains(const PXR_NS::SdfPath& path) const;
+    /**
+     * @brief Checks whether the set contains an ancestor of the specified path.
+     *
+     * @param include_self Whether the path itself counts as its ancestor.
+     */
+    bool has_ancestor(const PXR_NS::SdfPath& path, bool include_self = true) const;
+    /**
+     * @brief Returns the top-most ancestor of the specified path contained in the set,
+     * an empty path if there is no such ancestor.
+     *
+     * @param include_self Whether the path itself counts as its ancestor.
+     */
+    PXR_NS::SdfPath find_top_most_ancestor(const PXR_NS::SdfPath& path, bool include_self = true) const;
+    /**
+     * @brief Returns the range of the paths of the set which have the specified path as prefix,
+     * the root itself is included if the set contains it.
+     *
+     */
+    std::pair<const_iterator, const_iterator> get_subtree_range(const PXR_NS::SdfPath& root) const;
+    /**
+     * @brief Returns the sorted paths of the set without the paths which have an ancestor in the set.
+     *
+     */
+    PXR_NS::SdfPathVector get_top_most_paths() const;
+
+    static bool contains(const PXR_NS::SdfPathVector& sorted_paths, const PXR_NS::SdfPath& path);
+    static bool has_ancestor(const PXR_NS::SdfPathVector& sorted_paths, const PXR_NS::SdfPath& path, bool include_self = true);
+    static PXR_NS::SdfPath find_top_most_ancestor(const PXR_NS::SdfPathVector& sorted_paths, const PXR_NS::SdfPath& path, bool include_self = true);
+    static std::pair<const_iterator, const_iterator> get_subtree_range(const PXR_NS::SdfPathVector& sorted_paths, const PXR_NS::SdfPath& root);
+    /**
+     * @brief Removes in place the paths which have an ancestor in the vector, the vector must be sorted.
+     *
+     */
+    static void remove_descendants(PXR_NS::SdfPathVector& sorted_paths);
+
+private:
+    PXR_NS::SdfPathVector m_paths;
+};
+
+OPENDCC_NAMESPACE_CLOSE
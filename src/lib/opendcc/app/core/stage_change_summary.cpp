@@ -0,0 +1,473 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/app/core/stage_change_summary.h"
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <algorithm>
+
+OPENDCC_NAMESPACE_OPEN
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    bool has_field(const TfTokenVector& changed_fields, const TfTokenVector& fields)
+    {
+        if (fields.empty())
+            return true;
+        for (const auto& field : fields)
+        {
+            if (std::find(changed_fields.begin(), changed_fields.end(), field) != changed_fields.end())
+                return true;
+        }
+        return false;
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////
+// StageChangeSummary
+//////////////////////////////////////////////////////////////////////////
+
+StageChangeSummary::StageChangeSummary(const UsdNotice::ObjectsChanged& notice)
+    : m_stage(notice.GetStage())
+{
+    const auto resynced = notice.GetResyncedPaths();
+    m_resynced_paths.assign(resynced.begin(), resynced.end());
+
+    const auto changed = notice.GetChangedInfoOnlyPaths();
+    m_changed_info.reserve(changed.size());
+    for (auto it = changed.begin(); it != changed.end(); ++it)
+        m_changed_info.push_back({ *it, it.GetChangedFields() });
+
+    sort();
+}
+
+const TfTokenVector& StageChangeSummary::get_changed_fields(const SdfPath& path) const
+{
+    static const TfTokenVector empty;
+    auto it = std::lower_bound(m_changed_info.begin(), m_changed_info.end(), path,
+                               [](const ChangedInfo& info, const SdfPath& path) { return info.path < path; });
+    return it != m_changed_info.end() && it->path == path ? it->fields : empty;
+}
+
+bool StageChangeSummary::is_resynced(const SdfPath& path) const
+{
+    for (auto ancestor = path; !ancestor.IsEmpty(); ancestor = ancestor.GetParentPath())
+    {
+        if (std::binary_search(m_resynced_paths.begin(), m_resynced_paths.end(), ancestor))
+            return true;
+    }
+    return false;
+}
+
+bool StageChangeSummary::affects(const SdfPath& path, const TfTokenVector& fields) const
+{
+    if (path.IsEmpty())
+        return false;
+
+    // self and descendants
+    auto resync_it = std::lower_bound(m_resynced_paths.begin(), m_resynced_paths.end(), path);
+    if (resync_it != m_resynced_paths.end() && resync_it->HasPrefix(path))
+        return true;
+    auto info_it = std::lower_bound(m_changed_info.begin(), m_changed_info.end(), path,
+                                    [](const ChangedInfo& info, const SdfPath& path) { return info.path < path; });
+    for (; info_it != m_changed_info.end() && info_it->path.HasPrefix(path); ++info_it)
+    {
+        if (has_field(info_it->fields, fields))
+            return true;
+    }
+
+    // ancestors, the pseudo-root changes are stage metadata which don't affect the prims
+    for (auto ancestor = path.GetParentPath(); !ancestor.IsEmpty(); ancestor = ancestor.GetParentPath())
+    {
+        if (std::binary_search(m_resynced_paths.begin(), m_resynced_paths.end(), ancestor) ||
+            std::binary_search(m_resynced_property_prims.begin(), m_resynced_property_prims.end(), ancestor))
+            return true;
+        if (ancestor.IsAbsoluteRootPath())
+            break;
+
+        const auto prim_path = ancestor.GetPrimPath();
+        auto range = std::equal_range(m_changed_prims.begin(), m_changed_prims.end(), std::make_pair(prim_path, size_t(0)),
+                                      [](const std::pair<SdfPath, size_t>& left, const std::pair<SdfPath, size_t>& right) {
+                                          return left.first < right.first;
+                                      });
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (has_field(m_changed_info[it->second].fields, fields))
+                return true;
+        }
+    }
+    return false;
+}
+
+bool StageChangeSummary::affects(const SdfPathVector& paths, const TfTokenVector& fields) const
+{
+    if (empty())
+        return false;
+    return std::any_of(paths.begin(), paths.end(), [this, &fields](const SdfPath& path) { return affects(path, fields); });
+}
+
+bool StageChangeSummary::affects_exactly(const SdfPath& path, const TfTokenVector& fields) const
+{
+    if (path.IsEmpty())
+        return false;
+    if (is_resynced(path))
+        return true;
+
+    const auto& changed_fields = get_changed_fields(path);
+    return !changed_fields.empty() && has_field(changed_fields, fields);
+}
+
+bool StageChangeSummary::affects_exactly(const SdfPathVector& paths, const TfTokenVector& fields) const
+{
+    if (empty())
+        return false;
+    return std::any_of(paths.begin(), paths.end(), [this, &fields](const SdfPath& path) { return affects_exactly(path, fields); });
+}
+
+void StageChangeSummary::merge(const StageChangeSummary& other)
+{
+    if (!m_stage)
+        m_stage = other.m_stage;
+    m_resynced_paths.insert(m_resynced_paths.end(), other.m_resynced_paths.begin(), other.m_resynced_paths.end());
+    m_changed_info.insert(m_changed_info.end(), other.m_changed_info.begin(), other.m_changed_info.end());
+    sort();
+}
+
+void StageChangeSummary::sort()
+{
+    SdfPath::RemoveDescendentPaths(&m_resynced_paths);
+    m_resynced_property_prims.clear();
+    for (const auto& path : m_resynced_paths)
+    {
+        if (path.IsPropertyPath())
+            m_resynced_property_prims.push_back(path.GetPrimPath());
+    }
+    std::sort(m_resynced_property_prims.begin(), m_resynced_property_prims.end());
+    m_resynced_property_prims.erase(std::unique(m_resynced_property_prims.begin(), m_resynced_property_prims.end()), m_resynced_property_prims.end());
+
+    std::stable_sort(m_changed_info.begin(), m_changed_info.end(), [](const ChangedInfo& left, const ChangedInfo& right) { return left.path < right.path; });
+    // merged summaries can contain the same path twice
+    auto last = m_changed_info.begin();
+    for (auto it = m_changed_info.begin(); it != m_changed_info.end(); ++it)
+    {
+        if (it != last && it->path == last->path)
+        {
+            for (auto& field : it->fields)
+            {
+                if (std::find(last->fields.begin(), last->fields.end(), field) == last->fields.end())
+                    last->fields.push_back(field);
+            }
+            continue;
+        }
+        if (it != m_changed_info.begin())
+            ++last;
+        if (it != last)
+            *last = std::move(*it);
+    }
+    if (!m_changed_info.empty())
+        m_changed_info.erase(last + 1, m_changed_info.end());
+
+    m_changed_prims.clear();
+    m_changed_prims.reserve(m_changed_info.size());
+    for (size_t i = 0; i < m_changed_info.size(); ++i)
+        m_changed_prims.emplace_back(m_changed_info[i].path.GetPrimPath(), i);
+    std::stable_sort(m_changed_prims.begin(), m_changed_prims.end(),
+                     [](const std::pair<SdfPath, size_t>& left, const std::pair<SdfPath, size_t>& right) { return left.first < right.first; });
+}
+
+//////////////////////////////////////////////////////////////////////////
+// StageChangesDispatcher
+//////////////////////////////////////////////////////////////////////////
+
+StageChangesDispatcher::StageChangesDispatcher()
+    : m_alive(std::make_shared<bool>(true))
+{
+}
+
+StageChangesDispatcher::~StageChangesDispatcher() = default;
+
+StageChangesDispatcher::Handle StageChangesDispatcher::subscribe(const Filter& filter, const Callback& callback)
+{
+    const auto handle = m_next_handle++;
+    auto& subscription = m_subscriptions[handle];
+    subscription.filter = filter;
+    subscription.callback = callback;
+    return handle;
+}
+
+void StageChangesDispatcher::set_filter(Handle handle, const Filter& filter)
+{
+    auto it = m_subscriptions.find(handle);
+    if (it != m_subscriptions.end())
+        it->second.filter = filter;
+}
+
+void StageChangesDispatcher::unsubscribe(Handle handle)
+{
+    m_subscriptions.erase(handle);
+}
+
+void StageChangesDispatcher::dispatch(const StageChangeSummary& summary)
+{
+    if (summary.empty())
+        return;
+
+    // callbacks can subscribe and unsubscribe
+    std::vector<Handle> handles;
+    handles.reserve(m_subscriptions.size());
+    for (const auto& entry : m_subscriptions)
+        handles.push_back(entry.first);
+
+    for (auto handle : handles)
+    {
+        auto it = m_subscriptions.find(handle);
+        if (it == m_subscriptions.end())
+            continue;
+
+        auto& subscription = it->second;
+        const auto& filter = subscription.filter;
+        if (filter.exact ? !summary.affects_exactly(filter.paths, filter.fields) : !summary.affects(filter.paths, filter.fields))
+            continue;
+
+        if (!subscription.filter.coalesce || !QCoreApplication::instance())
+        {
+            auto callback = subscription.callback;
+            callback(summary);
+            continue;
+        }
+
+        if (subscription.pending)
+            subscription.pending->merge(summary);
+        else
+            subscription.pending = std::make_unique<StageChangeSummary>(summary);
+
+        if (!m_flush_scheduled)
+        {
+            m_flush_scheduled = true;
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [this, alive = std::weak_ptr<bool>(m_alive)] {
+                    if (alive.lock())
+                        flush();
+                },
+                Qt::QueuedConnection);
+        }
+    }
+}
+
+void StageChangesDispatcher::flush()
+{
+    m_flush_scheduled = false;
+
+    std::vector<Handle> handles;
+    for (const auto& entry : m_subscriptions)
+    {
+        if (entry.second.pending)
+            handles.push_back(entry.first);
+    }
+
+    for (auto handle : handles)
+    {
+        auto it = m_subscriptions.find(handle);
+        if (it == m_subscriptions.end() || !it->second.pending)
+            continue;
+
+        auto pending = std::move(it->second.pending);
+        auto callback = it->second.callback;
+        callback(*pending);
+    }
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+#include <chrono>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/usd/sdf/changeBlock.h>
+#include <pxr/usd/usdGeom/xform.h>
+#include "opendcc/app/core/stage_watcher.h"
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("StageChangeSummary")
+{
+    DOCTEST_TEST_CASE("queries")
+    {
+        auto stage = UsdStage::CreateInMemory();
+        UsdGeomXform::Define(stage, SdfPath("/world/group/a"));
+        UsdGeomXform::Define(stage, SdfPath("/world/group/b"));
+        UsdGeomXform::Define(stage, SdfPath("/other"));
+
+        StageChangeSummary summary;
+        StageObjectChangedWatcher listener(stage, [&summary](const UsdNotice::ObjectsChanged& notice) { summary.merge(StageChangeSummary(notice)); });
+        {
+            SdfChangeBlock change_block;
+            UsdGeomXform(stage->GetPrimAtPath(SdfPath("/world/group"))).AddTranslateOp().Set(GfVec3d(1, 2, 3));
+            stage->GetPrimAtPath(SdfPath("/other")).SetMetadata(SdfFieldKeys->Documentation, std::string("doc"));
+            stage->SetStartTimeCode(10);
+        }
+        {
+            SdfChangeBlock change_block;
+            UsdGeomXform(stage->GetPrimAtPath(SdfPath("/world/group"))).GetXformOpOrderAttr().Set(VtTokenArray { TfToken("xformOp:translate") });
+        }
+
+        DOCTEST_CHECK(!summary.empty());
+        DOCTEST_CHECK(summary.get_stage() == stage);
+        DOCTEST_CHECK(summary.get_changed_fields(SdfPath::AbsoluteRootPath()).size() > 0);
+        DOCTEST_CHECK(summary.get_changed_fields(SdfPath("/world")).empty());
+
+        // ancestors and descendants are affected, siblings are not
+        DOCTEST_CHECK(summary.affects(SdfPath("/world/group/a")));
+        DOCTEST_CHECK(summary.affects(SdfPath("/world")));
+        DOCTEST_CHECK(summary.affects(SdfPath("/other"), { SdfFieldKeys->Documentation }));
+        DOCTEST_CHECK(!summary.affects(SdfPath("/other"), { SdfFieldKeys->Default }));
+        DOCTEST_CHECK(!summary.affects(SdfPath("/missing")));
+        // the stage metadata only affects the pseudo-root subscribers
+        DOCTEST_CHECK(!summary.affects(SdfPathVector { SdfPath("/missing"), SdfPath("/third") }));
+        DOCTEST_CHECK(summary.affects(SdfPath::AbsoluteRootPath(), { TfToken("startTimeCode") }));
+        DOCTEST_CHECK(summary.affects_exactly(SdfPath::AbsoluteRootPath(), { TfToken("startTimeCode") }));
+        DOCTEST_CHECK(!summary.affects_exactly(SdfPath::AbsoluteRootPath(), { TfToken("endTimeCode") }));
+        DOCTEST_CHECK(!summary.affects_exactly(SdfPath("/world")));
+        DOCTEST_CHECK(summary.affects_exactly(SdfPath("/other")));
+
+        // the descendants of the resynced paths are removed
+        StageChangeSummary resync_summary;
+        StageObjectChangedWatcher resync_listener(stage, [&resync_summary](const UsdNotice::ObjectsChanged& notice) {
+            resync_summary.merge(StageChangeSummary(notice));
+        });
+        {
+            SdfChangeBlock change_block;
+            stage->DefinePrim(SdfPath("/new/child"));
+            stage->DefinePrim(SdfPath("/new/child/grand_child"));
+        }
+        DOCTEST_CHECK(resync_summary.get_resynced_paths() == SdfPathVector { SdfPath("/new") });
+        DOCTEST_CHECK(resync_summary.is_resynced(SdfPath("/new/child/grand_child")));
+        DOCTEST_CHECK(resync_summary.affects(SdfPath("/new/child")));
+        DOCTEST_CHECK(!resync_summary.affects(SdfPath("/world")));
+        // a resync below the pseudo-root doesn't change the pseudo-root itself
+        DOCTEST_CHECK(resync_summary.affects(SdfPath::AbsoluteRootPath()));
+        DOCTEST_CHECK(!resync_summary.affects_exactly(SdfPath::AbsoluteRootPath()));
+    }
+
+    DOCTEST_TEST_CASE("dispatcher")
+    {
+        auto stage = UsdStage::CreateInMemory();
+        UsdGeomXform::Define(stage, SdfPath("/a"));
+        UsdGeomXform::Define(stage, SdfPath("/b"));
+
+        StageChangesDispatcher dispatcher;
+        StageObjectChangedWatcher listener(stage, [&dispatcher](const UsdNotice::ObjectsChanged& notice) { dispatcher.dispatch(StageChangeSummary(notice)); });
+
+        int a_calls = 0;
+        int all_calls = 0;
+        StageChangesDispatcher::Filter a_filter;
+        a_filter.paths = { SdfPath("/a") };
+        const auto a_handle = dispatcher.subscribe(a_filter, [&a_calls](const StageChangeSummary&) { ++a_calls; });
+        dispatcher.subscribe(StageChangesDispatcher::Filter(), [&all_calls](const StageChangeSummary&) { ++all_calls; });
+
+        UsdGeomXform(stage->GetPrimAtPath(SdfPath("/b"))).AddTranslateOp().Set(GfVec3d(1, 0, 0));
+        DOCTEST_CHECK(a_calls == 0);
+        DOCTEST_CHECK(all_calls > 0);
+
+        UsdGeomXform(stage->GetPrimAtPath(SdfPath("/a"))).AddTranslateOp().Set(GfVec3d(1, 0, 0));
+        DOCTEST_CHECK(a_calls > 0);
+
+        a_calls = 0;
+        a_filter.paths = { SdfPath("/b") };
+        dispatcher.set_filter(a_handle, a_filter);
+        stage->GetPrimAtPath(SdfPath("/a")).GetAttribute(TfToken("xformOp:translate")).Set(GfVec3d(2, 0, 0));
+        DOCTEST_CHECK(a_calls == 0);
+
+        int root_calls = 0;
+        StageChangesDispatcher::Filter root_filter;
+        root_filter.fields = { SdfFieldKeys->StartTimeCode };
+        root_filter.exact = true;
+        dispatcher.subscribe(root_filter, [&root_calls](const StageChangeSummary&) { ++root_calls; });
+
+        dispatcher.unsubscribe(a_handle);
+        stage->GetPrimAtPath(SdfPath("/b")).GetAttribute(TfToken("xformOp:translate")).Set(GfVec3d(2, 0, 0));
+        stage->DefinePrim(SdfPath("/c"));
+        DOCTEST_CHECK(a_calls == 0);
+        DOCTEST_CHECK(root_calls == 0);
+
+        stage->SetStartTimeCode(5);
+        DOCTEST_CHECK(root_calls == 1);
+    }
+
+    DOCTEST_TEST_CASE("dispatch_benchmark")
+    {
+        const int prims_count = 10000;
+        const int listeners_count = 50;
+        const int notices = 20;
+
+        auto stage = UsdStage::CreateInMemory();
+        std::vector<UsdAttribute> attributes;
+        {
+            SdfChangeBlock change_block;
+            for (int i = 0; i < prims_count; ++i)
+            {
+                auto prim = stage->DefinePrim(SdfPath(TfStringPrintf("/group_%d/prim_%d", i % 100, i)));
+                attributes.push_back(prim.CreateAttribute(TfToken("weight"), SdfValueTypeNames->Float));
+            }
+        }
+
+        // every listener watches one prim, as the transform tools watch the selection
+        SdfPathVector watched_paths;
+        for (int i = 0; i < listeners_count; ++i)
+            watched_paths.push_back(SdfPath(TfStringPrintf("/group_%d/prim_%d", (i * 7) % 100, i * 7 + 100 * (i % 3))));
+
+        int raw_hits = 0;
+        std::vector<std::function<void(const UsdNotice::ObjectsChanged&)>> raw_listeners;
+        for (const auto& path : watched_paths)
+        {
+            raw_listeners.push_back([path, &raw_hits](const UsdNotice::ObjectsChanged& notice) {
+                for (const auto& changed : notice.GetChangedInfoOnlyPaths())
+                {
+                    if (changed.GetPrimPath().HasPrefix(path) || path.HasPrefix(changed.GetPrimPath()))
+                    {
+                        ++raw_hits;
+                        return;
+                    }
+                }
+            });
+        }
+
+        int summary_hits = 0;
+        StageChangesDispatcher dispatcher;
+        for (const auto& path : watched_paths)
+        {
+            StageChangesDispatcher::Filter filter;
+            filter.paths = { path };
+            dispatcher.subscribe(filter, [&summary_hits](const StageChangeSummary&) { ++summary_hits; });
+        }
+
+        double raw_time = 0;
+        double summary_time = 0;
+        StageObjectChangedWatcher listener(stage, [&](const UsdNotice::ObjectsChanged& notice) {
+            auto start = std::chrono::steady_clock::now();
+            for (const auto& raw_listener : raw_listeners)
+                raw_listener(notice);
+            raw_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+            start = std::chrono::steady_clock::now();
+            dispatcher.dispatch(StageChangeSummary(notice));
+            summary_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        });
+
+        for (int n = 0; n < notices; ++n)
+        {
+            SdfChangeBlock change_block;
+            for (auto& attribute : attributes)
+                attribute.Set(float(n));
+        }
+
+        DOCTEST_CHECK(summary_hits == raw_hits);
+        DOCTEST_CHECK(summary_hits == listeners_count * notices);
+        DOCTEST_MESSAGE(prims_count << " paths, " << listeners_count << " listeners: " << raw_time / notices << " ms per notice parsed by every listener, "
+                                    << summary_time / notices << " ms per notice with the summary");
+    }
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include "opendcc/opendcc.h"
+#include "opendcc/app/core/api.h"
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/usd/notice.h>
+#include <pxr/usd/usd/stage.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <vector>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Digest of a UsdNotice::ObjectsChanged notice.
+ *
+ * The notice is parsed once: resynced paths are sorted and reduced to the paths without resynced ancestors,
+ * changed info is grouped by the changed object path with the list of its changed fields.
+ * The queries use binary searches, so testing a summary against a few paths doesn't depend on the notice size.
+ */
+class OPENDCC_API StageChangeSummary
+{
+public:
+    struct ChangedInfo
+    {
+        PXR_NS::SdfPath path;
+        PXR_NS::TfTokenVector fields;
+    };
+
+    StageChangeSummary() = default;
+    StageChangeSummary(const PXR_NS::UsdNotice::ObjectsChanged& notice);
+
+    PXR_NS::UsdStageWeakPtr get_stage() const { return m_stage; }
+    bool empty() const { return m_resynced_paths.empty() && m_changed_info.empty(); }
+
+    /**
+     * @brief Returns the sorted resynced paths, the descendants of the resynced paths are removed.
+     *
+     */
+    const PXR_NS::SdfPathVector& get_resynced_paths() const { return m_resynced_paths; }
+    /**
+     * @brief Returns the changed info sorted by path.
+     *
+     */
+    const std::vector<ChangedInfo>& get_changed_info() const { return m_changed_info; }
+    /**
+     * @brief Returns the fields changed on the object at the specified path,
+     * an empty vector if the object info isn't changed.
+     *
+     */
+    const PXR_NS::TfTokenVector& get_changed_fields(const PXR_NS::SdfPath& path) const;
+    /**
+     * @brief Checks whether the specified path or one of its ancestors is resynced.
+     *
+     */
+    bool is_resynced(const PXR_NS::SdfPath& path) const;
+    /**
+     * @brief Checks whether the changes affect the specified paths.
+     *
+     * A change affects a path if it is made to the path, its descendants or its ancestors except the pseudo-root.
+     * Resyncs always affect the related paths, info changes are only taken into account if they change
+     * one of the specified fields, an empty fields vector matches all fields.
+     */
+    bool affects(const PXR_NS::SdfPathVector& paths, const PXR_NS::TfTokenVector& fields = {}) const;
+    bool affects(const PXR_NS::SdfPath& path, const PXR_NS::TfTokenVector& fields = {}) const;
+    /**
+     * @brief Checks whether the changes affect the objects at the specified paths themselves.
+     *
+     * Only the resyncs of the paths or their ancestors and the info changes made to the paths are taken into account,
+     * the changes to the descendants are ignored, so a pseudo-root subscriber doesn't match every edit of the stage.
+     */
+    bool affects_exactly(const PXR_NS::SdfPathVector& paths, const PXR_NS::TfTokenVector& fields = {}) const;
+    bool affects_exactly(const PXR_NS::SdfPath& path, const PXR_NS::TfTokenVector& fields = {}) const;
+
+    /**
+     * @brief Adds the changes of the other summary.
+     *
+     */
+    void merge(const StageChangeSummary& other);
+
+private:
+    void sort();
+
+    PXR_NS::UsdStageWeakPtr m_stage;
+    PXR_NS::SdfPathVector m_resynced_paths;
+    // prims of the resynced properties, sorted
+    PXR_NS::SdfPathVector m_resynced_property_prims;
+    std::vector<ChangedInfo> m_changed_info;
+    // prim path of every changed info entry with the entry index, sorted by prim path
+    std::vector<std::pair<PXR_NS::SdfPath, size_t>> m_changed_prims;
+};
+
+/**
+ * @brief Dispatches stage change summaries to the subscribers whose paths and fields are affected.
+ *
+ * Coalescing subscribers receive all the changes merged into one summary on the next iteration of the event loop.
+ */
+class OPENDCC_API StageChangesDispatcher
+{
+public:
+    using Callback = std::function<void(const StageChangeSummary& summary)>;
+    using Handle = uint64_t;
+
+    struct Filter
+    {
+        // the subscriber is notified about the changes to these paths, their descendants and ancestors
+        PXR_NS::SdfPathVector paths = { PXR_NS::SdfPath::AbsoluteRootPath() };
+        // an empty vector matches all fields
+        PXR_NS::TfTokenVector fields;
+        // only the changes to the paths themselves are reported, see StageChangeSummary::affects_exactly
+        bool exact = false;
+        bool coalesce = false;
+    };
+
+    StageChangesDispatcher();
+    ~StageChangesDispatcher();
+
+    Handle subscribe(const Filter& filter, const Callback& callback);
+    void set_filter(Handle handle, const Filter& filter);
+    void unsubscribe(Handle handle);
+    bool has_subscribers() const { return !m_subscriptions.empty(); }
+
+    void dispatch(const StageChangeSummary& summary);
+    /**
+     * @brief Calls the coalescing subscribers with the pending changes.
+     *
+     */
+    void flush();
+
+private:
+    struct Subscription
+    {
+        Filter filter;
+        Callback callback;
+        std::unique_ptr<StageChangeSummary> pending;
+    };
+
+    std::map<Handle, Subscription> m_subscriptions;
+    Handle m_next_handle = 1;
+    bool m_flush_scheduled = false;
+    // queued flushes are skipped if the dispatcher is destroyed
+    std::shared_ptr<bool> m_alive;
+};
+
+OPENDCC_NAMESPACE_CLOSE
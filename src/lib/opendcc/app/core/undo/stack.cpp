@@ -15,27 +15,59 @@ PXR_NAMESPACE_USING_DIRECTIVE
 
 using namespace commands;
 
+namespace
+{
+    std::string format_log_string(const std::shared_ptr<Command>& cmd, const CommandArgs& args)
+    {
+        auto py_str = PythonCommandInterface::generate_python_cmd_str(cmd, args);
+        return py_str.empty() ? cmd->get_command_name() : py_str;
+    }
+};
+
+const std::string& UndoStack::CommandEntry::get_log_string() const
+{
+    if (!log_string_ready)
+    {
+        log_string = format_log_string(cmd, args);
+        log_string_ready = true;
+    }
+    return log_string;
+}
+
 UndoStack::UndoStack(size_t undo_limit /*= 100*/)
     : m_undo_limit(undo_limit)
 {
     m_callback_handle = PythonCommandInterface::instance().register_event_callback(
         [this](std::shared_ptr<Command> cmd, const CommandArgs& args, const CommandResult& cmd_result) {
-            auto py_str = PythonCommandInterface::generate_python_cmd_str(cmd, args);
-            if (py_str.empty())
-                py_str = cmd->get_command_name();
+            auto undo_cmd = std::dynamic_pointer_cast<UndoCommand>(cmd);
 
-            std::string result_str;
-            if (cmd_result.has_result())
+            // the python description is only built here when it is going to be logged, otherwise it is postponed
+            // until the entry is undone or redone
+            if (Logger::get_log_level() <= LogLevel::Info)
             {
-                const auto result_repr_str = PythonCommandInterface::generate_python_result_str(cmd_result);
-                if (!result_repr_str.empty())
-                    result_str = "Result: " + result_repr_str;
+                std::string result_str;
+                if (cmd_result.has_result())
+                {
+                    const auto result_repr_str = PythonCommandInterface::generate_python_result_str(cmd_result);
+                    if (!result_repr_str.empty())
+                        result_str = "Result: " + result_repr_str;
+                }
+
+                if (undo_cmd)
+                {
+                    CommandEntry entry { undo_cmd, args };
+                    OPENDCC_INFO("Executing: \"{}\" {}", entry.get_log_string(), result_str);
+                    push(std::move(entry));
+                }
+                else
+                {
+                    OPENDCC_INFO("Executing: \"{}\" {}", format_log_string(cmd, args), result_str);
+                }
+            }
+            else if (undo_cmd)
+            {
+                push(CommandEntry { undo_cmd, args });
             }
-
-            OPENDCC_INFO("Executing: \"{}\" {}", py_str, result_str);
-
-            if (auto undo_cmd = std::dynamic_pointer_cast<UndoCommand>(cmd))
-                push(CommandEntry { undo_cmd, py_str });
         });
 }
 
@@ -106,7 +138,7 @@ void UndoStack::push(std::shared_ptr<UndoCommand> command, bool execute /*= fals
     if (!m_enabled)
         return;
 
-    push(CommandEntry { command, "" });
+    push(CommandEntry { command, {}, command->get_command_name(), true });
 }
 
 void UndoStack::undo()
@@ -116,10 +148,7 @@ void UndoStack::undo()
         return;
 
     const auto& command = m_commands[m_index-- - 1];
-    if (command.log_string.empty())
-        OPENDCC_INFO("Undo: \"{}\"", command.cmd->get_command_name());
-    else
-        OPENDCC_INFO("Undo: \"{}\"", command.log_string);
+    OPENDCC_INFO("Undo: \"{}\"", command.get_log_string());
 
     command.cmd->undo();
 }
@@ -131,10 +160,7 @@ void UndoStack::redo()
         return;
 
     const auto& command = m_commands[m_index++];
-    if (command.log_string.empty())
-        OPENDCC_INFO("Redo: \"{}\"", command.cmd->get_command_name());
-    else
-        OPENDCC_INFO("Redo: \"{}\"", command.log_string);
+    OPENDCC_INFO("Redo: \"{}\"", command.get_log_string());
 
     command.cmd->redo();
 }
@@ -151,7 +177,7 @@ UndoStack::~UndoStack()
     PythonCommandInterface::instance().unregister_event_callback(m_callback_handle);
 }
 
-void UndoStack::push(const CommandEntry& command_entry)
+void UndoStack::push(CommandEntry command_entry)
 {
     Lock lock(m_mutex);
     if (!command_entry.cmd || !m_enabled)
@@ -174,7 +200,72 @@ void UndoStack::push(const CommandEntry& command_entry)
     {
         m_commands.pop_front();
     }
-    m_commands.push_back(command_entry);
+    m_commands.push_back(std::move(command_entry));
 }
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/usd/sdf/path.h>
+#include "opendcc/base/commands_api/core/command_interface.h"
+#include "opendcc/base/commands_api/core/command_registry.h"
+#include <chrono>
+OPENDCC_NAMESPACE_USING
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    class StackTestCommand : public commands::UndoCommand
+    {
+    public:
+        CommandResult execute(const CommandArgs& args) override { return CommandResult(CommandResult::Status::SUCCESS); }
+    };
+};
+
+DOCTEST_TEST_SUITE("UndoStackTests")
+{
+    DOCTEST_TEST_CASE("push_commands_with_array_args")
+    {
+        const std::string command_name = "undo_stack_test_command";
+        CommandRegistry::register_command(command_name, CommandSyntax().arg<VtVec3fArray>("points").kwarg<SdfPathVector>("paths"),
+                                          [] { return std::make_shared<StackTestCommand>(); });
+        CommandRegistry::register_command_interface(PythonCommandInterface::instance());
+        const auto log_level = Logger::get_log_level();
+
+        const VtVec3fArray points(100000, GfVec3f(1.0f));
+        const SdfPathVector paths(256, SdfPath("/root/prim"));
+        auto push_commands = [&](LogLevel level, size_t count) {
+            Logger::set_log_level(level);
+            commands::UndoStack stack(0);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto cmd = CommandRegistry::create_command(command_name);
+                CommandInterface::finalize(cmd, CommandArgs().arg(points).kwarg("paths", paths));
+            }
+            const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            DOCTEST_MESSAGE("pushed " << count << " commands at log level " << static_cast<int>(level) << " in " << elapsed << " ms");
+
+            DOCTEST_CHECK(stack.get_size() == count);
+            DOCTEST_CHECK(stack.can_undo());
+            stack.undo();
+            DOCTEST_CHECK(stack.can_redo());
+            stack.redo();
+            DOCTEST_CHECK(!stack.can_redo());
+        };
+
+        // the executed commands are not logged, so pushing must not format the arguments
+        DOCTEST_SUBCASE("deferred") { push_commands(LogLevel::Warning, 100000); }
+        // the default level logs the full python description of every command
+        DOCTEST_SUBCASE("logged") { push_commands(LogLevel::Info, 1000); }
+
+        Logger::set_log_level(log_level);
+        CommandRegistry::unregister_command_interface(PythonCommandInterface::instance());
+        CommandRegistry::unregister_command(command_name);
+    }
+}
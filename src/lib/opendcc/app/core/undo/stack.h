@@ -47,10 +47,15 @@ namespace commands
         struct CommandEntry
         {
             std::shared_ptr<UndoCommand> cmd;
-            std::string log_string;
+            // kept to format the log string on first access, the values are shared with the caller
+            CommandArgs args;
+            mutable std::string log_string;
+            mutable bool log_string_ready = false;
+
+            const std::string& get_log_string() const;
         };
 
-        void push(const CommandEntry& command_entry);
+        void push(CommandEntry command_entry);
 
         using Lock = std::lock_guard<std::recursive_mutex>;
 
@@ -16,12 +16,62 @@
 #include "opendcc/base/logging/logger.h"
 #include "opendcc/app/core/application.h"
 
+#include <mutex>
+#include <random>
+
 PXR_NAMESPACE_USING_DIRECTIVE;
 
 OPENDCC_NAMESPACE_OPEN
 
+struct UsdClipboard::FileState
+{
+    // serializes the exports, the state below is guarded by state_mutex
+    std::mutex write_mutex;
+    mutable std::mutex state_mutex;
+    uint64_t requested_generation = 0;
+    uint64_t written_generation = 0;
+    // stamp of the file content this session knows about, either written or read by it
+    std::string stamp;
+    // distinguishes the writes of this clipboard from the writes of other sessions
+    std::string session_id;
+};
+
+namespace
+{
+    SdfLayerRefPtr create_empty_clipboard_layer()
+    {
+        SdfLayerRefPtr layer = SdfLayer::CreateAnonymous();
+        SdfCreatePrimInLayer(layer, SdfPath("/Clipboard"));
+        return layer;
+    }
+
+    const std::string s_stamp_key = "clipboard_stamp";
+
+    // only the layer metadata is read, so a paste doesn't parse the whole file to find out it is unchanged
+    std::string read_clipboard_stamp(const std::string& path)
+    {
+        std::error_code ec;
+        if (!ghc::filesystem::exists(path, ec))
+        {
+            return {};
+        }
+        auto layer = SdfLayer::OpenAsAnonymous(path, true);
+        if (!layer)
+        {
+            return {};
+        }
+        const auto custom_data = layer->GetCustomLayerData();
+        const auto stamp = custom_data.find(s_stamp_key);
+        return stamp != custom_data.end() && stamp->second.IsHolding<std::string>() ? stamp->second.UncheckedGet<std::string>() : std::string();
+    }
+};
+
 UsdClipboard::UsdClipboard()
+    : m_file_state(std::make_shared<FileState>())
 {
+    std::random_device random;
+    m_file_state->session_id = std::to_string((static_cast<uint64_t>(random()) << 32) | random());
+
     auto clipboard_path = ghc::filesystem::temp_directory_path();
     clipboard_path.append("OpenDCCClipboard.usd");
     set_clipboard_path(clipboard_path.string());
@@ -29,15 +79,14 @@ UsdClipboard::UsdClipboard()
 
     if (!ghc::filesystem::exists(m_path_to_clipboard))
     {
-        SdfLayerRefPtr layer = SdfLayer::CreateAnonymous();
-        UsdStageRefPtr clipboard_stage = UsdStage::Open(layer->GetIdentifier(), UsdStage::LoadNone);
-        SdfCreatePrimInLayer(layer, SdfPath("/Clipboard"));
-        set_clipboard(clipboard_stage);
+        clear_clipboard();
     }
 }
 
 UsdClipboard::~UsdClipboard()
 {
+    wait_clipboard_file();
+
     if (m_clipboardStageCacheId.IsValid())
     {
         auto clipboardStageRef = PXR_NS::UsdUtilsStageCache::Get().Find(m_clipboardStageCacheId);
@@ -53,45 +102,45 @@ UsdClipboard::~UsdClipboard()
 
 UsdStageWeakPtr UsdClipboard::get_clipboard()
 {
-    auto layer = SdfLayer::FindOrOpen(m_path_to_clipboard);
-    if (!layer)
+    if (!m_clipboard_layer || is_clipboard_file_changed())
+    {
+        read_clipboard_file();
+    }
+    if (!m_clipboard_layer)
     {
         return {};
     }
 
-    UsdStageRefPtr clipboard = UsdStage::Open(m_path_to_clipboard);
-
-    if (m_clipboardStageCacheId.IsValid())
+    if (!m_clipboard_stage)
     {
-        auto clipboardStageRef = UsdUtilsStageCache::Get().Find(m_clipboardStageCacheId);
-        UsdUtilsStageCache::Get().Erase(clipboardStageRef);
+        m_clipboard_stage = UsdStage::Open(m_clipboard_layer);
     }
 
-    m_clipboardStageCacheId = UsdUtilsStageCache::Get().Insert(clipboard);
-
-    clipboard->Reload();
+    auto& stage_cache = UsdUtilsStageCache::Get();
+    if (!m_clipboardStageCacheId.IsValid() || stage_cache.Find(m_clipboardStageCacheId) != m_clipboard_stage)
+    {
+        if (m_clipboardStageCacheId.IsValid())
+        {
+            auto clipboardStageRef = stage_cache.Find(m_clipboardStageCacheId);
+            if (clipboardStageRef && clipboardStageRef != stage_cache.Find(m_tmpClipboardStageCacheId))
+            {
+                stage_cache.Erase(clipboardStageRef);
+            }
+        }
+        m_clipboardStageCacheId = stage_cache.Insert(m_clipboard_stage);
+    }
 
-    return clipboard;
+    return m_clipboard_stage;
 }
 
 void UsdClipboard::clear_clipboard()
 {
-    SdfLayerRefPtr layer = SdfLayer::CreateAnonymous();
-    UsdStageRefPtr stage = UsdStage::Open(layer->GetIdentifier(), UsdStage::LoadNone);
-    SdfCreatePrimInLayer(layer, SdfPath("/Clipboard"));
-    set_clipboard(stage);
+    set_clipboard_layer(create_empty_clipboard_layer());
 }
 
 void UsdClipboard::set_clipboard(const UsdStageWeakPtr& clipboard)
 {
-    SdfFileFormat::FileFormatArguments args;
-    args[UsdUsdFileFormatTokens->FormatArg] = m_clipboard_file_format;
-    if (!clipboard->GetRootLayer()->Export(m_path_to_clipboard, "OpenDCCСlipboard", args))
-    {
-        return;
-    }
-
-    clipboard->Unload();
+    save_clipboard_data(clipboard);
 }
 
 void UsdClipboard::set_clipboard_path(const std::string& clipboard_path)
@@ -106,14 +155,25 @@ void UsdClipboard::set_clipboard_file_format(const std::string& format)
 
 void UsdClipboard::save_clipboard_data(const UsdStageWeakPtr& stage)
 {
-    SdfFileFormat::FileFormatArguments args;
-    args[UsdUsdFileFormatTokens->FormatArg] = m_clipboard_file_format;
-    if (!stage->GetRootLayer()->Export(m_path_to_clipboard, "OpenDCCСlipboard", args))
+    if (!stage)
     {
         return;
     }
 
-    stage->Unload();
+    // stages made by get_new_clipboard_stage and get_new_clipboard_attribute are owned by the clipboard
+    // and are not edited after the copy, so they are kept as is, other stages are copied
+    auto tmp_stage = m_tmpClipboardStageCacheId.IsValid() ? UsdUtilsStageCache::Get().Find(m_tmpClipboardStageCacheId) : UsdStageRefPtr();
+    if (tmp_stage && UsdStagePtr(tmp_stage) == stage)
+    {
+        set_clipboard_layer(tmp_stage->GetRootLayer());
+        m_clipboard_stage = tmp_stage;
+    }
+    else
+    {
+        auto layer = SdfLayer::CreateAnonymous();
+        layer->TransferContent(stage->GetRootLayer());
+        set_clipboard_layer(layer);
+    }
 }
 
 void UsdClipboard::set_clipboard_attribute(const UsdAttribute& attribute)
@@ -129,6 +189,10 @@ void UsdClipboard::set_clipboard_stage(const UsdStageWeakPtr& stage)
 UsdAttribute UsdClipboard::get_clipboard_attribute()
 {
     auto clipboard_stage = get_clipboard();
+    if (!clipboard_stage)
+    {
+        return {};
+    }
     SdfPath attribute_path;
 
     auto custom_data = clipboard_stage->GetRootLayer()->GetCustomLayerData();
@@ -150,7 +214,10 @@ UsdAttribute UsdClipboard::get_clipboard_attribute()
 UsdStageWeakPtr UsdClipboard::get_clipboard_stage()
 {
     auto clipboard_stage = get_clipboard();
-    SdfPath attribute_path;
+    if (!clipboard_stage)
+    {
+        return {};
+    }
 
     auto custom_data = clipboard_stage->GetRootLayer()->GetCustomLayerData();
     auto data_type = custom_data.find("stored_data_type");
@@ -206,6 +273,107 @@ UsdAttribute UsdClipboard::get_new_clipboard_attribute(const SdfValueTypeName& t
     return clipboard_attribute;
 }
 
+void UsdClipboard::wait_clipboard_file()
+{
+    m_file_writer.Wait();
+}
+
+void UsdClipboard::set_clipboard_layer(const SdfLayerRefPtr& layer)
+{
+    m_clipboard_layer = layer;
+    m_clipboard_stage = nullptr;
+    write_clipboard_file();
+}
+
+void UsdClipboard::write_clipboard_file()
+{
+    uint64_t generation = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_file_state->state_mutex);
+        generation = ++m_file_state->requested_generation;
+    }
+    // mtime is too coarse to tell two quick copies apart, the file carries a stamp of its content instead
+    auto custom_data = m_clipboard_layer->GetCustomLayerData();
+    custom_data[s_stamp_key] = m_file_state->session_id + "." + std::to_string(generation);
+    m_clipboard_layer->SetCustomLayerData(custom_data);
+
+    m_file_writer.Run([state = m_file_state, layer = m_clipboard_layer, path = m_path_to_clipboard, format = m_clipboard_file_format, generation] {
+        std::lock_guard<std::mutex> write_lock(state->write_mutex);
+        {
+            std::lock_guard<std::mutex> lock(state->state_mutex);
+            // a later copy is going to overwrite the file anyway
+            if (generation != state->requested_generation)
+            {
+                return;
+            }
+        }
+
+        // export next to the clipboard file and move it over, so other sessions never read a partially written file
+        const ghc::filesystem::path file_path(path);
+        auto tmp_path = file_path.parent_path() / (file_path.stem().string() + ".tmp" + file_path.extension().string());
+
+        SdfFileFormat::FileFormatArguments args;
+        args[UsdUsdFileFormatTokens->FormatArg] = format;
+        std::error_code ec;
+        if (layer->Export(tmp_path.string(), "OpenDCCСlipboard", args))
+        {
+            ghc::filesystem::rename(tmp_path, file_path, ec);
+        }
+        else
+        {
+            ec = std::make_error_code(std::errc::io_error);
+        }
+        if (ec)
+        {
+            OPENDCC_WARN("Failed to write clipboard file \"{}\".", path);
+        }
+
+        // a stale file left by a failed write is not treated as a copy from another session either
+        const auto stamp = read_clipboard_stamp(path);
+        std::lock_guard<std::mutex> lock(state->state_mutex);
+        state->written_generation = generation;
+        state->stamp = stamp;
+    });
+}
+
+bool UsdClipboard::is_clipboard_file_changed() const
+{
+    std::string stamp;
+    {
+        std::lock_guard<std::mutex> lock(m_file_state->state_mutex);
+        // the in-memory layer is newer than the file until its write is finished
+        if (m_file_state->written_generation != m_file_state->requested_generation)
+        {
+            return false;
+        }
+        stamp = m_file_state->stamp;
+    }
+
+    std::error_code ec;
+    return ghc::filesystem::exists(m_path_to_clipboard, ec) && read_clipboard_stamp(m_path_to_clipboard) != stamp;
+}
+
+void UsdClipboard::read_clipboard_file()
+{
+    auto file_layer = SdfLayer::FindOrOpen(m_path_to_clipboard);
+    if (!file_layer)
+    {
+        return;
+    }
+    file_layer->Reload();
+
+    // the file layer is released right away, the next copy writes to it
+    m_clipboard_layer = SdfLayer::CreateAnonymous();
+    m_clipboard_layer->TransferContent(file_layer);
+    m_clipboard_stage = nullptr;
+
+    const auto custom_data = m_clipboard_layer->GetCustomLayerData();
+    const auto stamp = custom_data.find(s_stamp_key);
+    std::lock_guard<std::mutex> lock(m_file_state->state_mutex);
+    m_file_state->stamp =
+        stamp != custom_data.end() && stamp->second.IsHolding<std::string>() ? stamp->second.UncheckedGet<std::string>() : std::string();
+}
+
 OPENDCC_NAMESPACE_CLOSE
 
 #define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
@@ -214,6 +382,9 @@ OPENDCC_NAMESPACE_CLOSE
 #define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
 #include <doctest/doctest.h>
 #include <pxr/usd/sdf/types.h>
+#include <pxr/usd/sdf/changeBlock.h>
+#include <pxr/usd/sdf/primSpec.h>
+#include <chrono>
 
 OPENDCC_NAMESPACE_USING
 
@@ -360,4 +531,86 @@ DOCTEST_TEST_SUITE("clipboart_test")
         clipboard_plane_rel.GetTargets(&plane_targets);
         DOCTEST_CHECK(plane_targets.size() == 0);
     }
+
+    DOCTEST_TEST_CASE("paste_without_clipboard_file")
+    {
+        UsdClipboard clipboard;
+        clipboard.set_clipboard_path((ghc::filesystem::temp_directory_path() / "missing_dir" / "OpenDCCClipboard.usd").string());
+        auto new_clipboard_stage = clipboard.get_new_clipboard_stage("prims");
+        new_clipboard_stage->DefinePrim(SdfPath("/test_sphere"), TfToken("Sphere"));
+        clipboard.set_clipboard_stage(new_clipboard_stage);
+
+        auto clipboard_stage = clipboard.get_clipboard_stage();
+        DOCTEST_REQUIRE(clipboard_stage);
+        DOCTEST_CHECK(clipboard_stage->GetRootLayer() == new_clipboard_stage->GetRootLayer());
+        DOCTEST_CHECK(clipboard_stage->GetPrimAtPath(SdfPath("/test_sphere")).IsValid());
+        clipboard.wait_clipboard_file();
+    }
+
+    DOCTEST_TEST_CASE("clipboard_file_is_shared_between_sessions")
+    {
+        const auto clipboard_path = (ghc::filesystem::temp_directory_path() / "OpenDCCClipboardSessions.usd").string();
+        ghc::filesystem::remove(clipboard_path);
+
+        UsdClipboard first_session;
+        first_session.set_clipboard_path(clipboard_path);
+        auto new_clipboard_stage = first_session.get_new_clipboard_stage("prims");
+        new_clipboard_stage->DefinePrim(SdfPath("/test_cube"), TfToken("Cube"));
+        first_session.set_clipboard_stage(new_clipboard_stage);
+        first_session.wait_clipboard_file();
+        DOCTEST_CHECK(ghc::filesystem::exists(clipboard_path));
+
+        UsdClipboard second_session;
+        second_session.set_clipboard_path(clipboard_path);
+        auto clipboard_stage = second_session.get_clipboard_stage();
+        DOCTEST_REQUIRE(clipboard_stage);
+        DOCTEST_CHECK(clipboard_stage->GetPrimAtPath(SdfPath("/test_cube")).IsValid());
+
+        // the second session copies, the first one pastes the new data from the file
+        new_clipboard_stage = second_session.get_new_clipboard_stage("prims");
+        new_clipboard_stage->DefinePrim(SdfPath("/test_cone"), TfToken("Cone"));
+        second_session.set_clipboard_stage(new_clipboard_stage);
+        second_session.wait_clipboard_file();
+
+        clipboard_stage = first_session.get_clipboard_stage();
+        DOCTEST_REQUIRE(clipboard_stage);
+        DOCTEST_CHECK(clipboard_stage->GetPrimAtPath(SdfPath("/test_cone")).IsValid());
+        DOCTEST_CHECK(!clipboard_stage->GetPrimAtPath(SdfPath("/test_cube")).IsValid());
+
+        ghc::filesystem::remove(clipboard_path);
+    }
+
+    DOCTEST_TEST_CASE("paste_performance")
+    {
+        UsdClipboard clipboard;
+        auto new_clipboard_stage = clipboard.get_new_clipboard_stage("prims");
+        {
+            SdfChangeBlock change_block;
+            auto layer = new_clipboard_stage->GetRootLayer();
+            for (int i = 0; i < 10000; ++i)
+            {
+                auto prim_spec = SdfCreatePrimInLayer(layer, SdfPath("/root/prim_" + std::to_string(i)));
+                prim_spec->SetSpecifier(SdfSpecifierDef);
+                prim_spec->SetTypeName("Xform");
+            }
+        }
+        clipboard.set_clipboard_stage(new_clipboard_stage);
+
+        clipboard.wait_clipboard_file();
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < 100; ++i)
+        {
+            // the unchanged file is not read back, every paste gets the copied layer
+            auto clipboard_stage = clipboard.get_clipboard_stage();
+            DOCTEST_REQUIRE(clipboard_stage);
+            DOCTEST_CHECK(clipboard_stage->GetRootLayer() == new_clipboard_stage->GetRootLayer());
+        }
+        const auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        DOCTEST_MESSAGE("100 pastes of 10000 prims: " << elapsed << " ms");
+
+        auto clipboard_stage = clipboard.get_clipboard_stage();
+        DOCTEST_CHECK(clipboard_stage->GetPrimAtPath(SdfPath("/root/prim_0")).IsValid());
+        DOCTEST_CHECK(clipboard_stage->GetPrimAtPath(SdfPath("/root/prim_9999")).IsValid());
+    }
 }
@@ -10,10 +10,20 @@
 #include "pxr/base/vt/value.h"
 #include "pxr/usd/usd/stage.h"
 #include "pxr/usd/usd/attribute.h"
+#include <pxr/usd/sdf/layer.h>
 #include <pxr/usd/usdUtils/stageCache.h>
+#include <pxr/base/work/dispatcher.h>
+#include <memory>
 
 OPENDCC_NAMESPACE_OPEN
 
+/**
+ * @brief Holds the copied prims or attribute in an in-memory layer.
+ *
+ * Paste reads the in-memory layer directly. The clipboard file is written on a background thread
+ * so the data can be pasted in another session, and it is read back only when it was changed
+ * by another process.
+ */
 class OPENDCC_API UsdClipboard
 {
 public:
@@ -33,15 +43,30 @@ public:
     PXR_NS::UsdStageWeakPtr get_clipboard_stage();
     PXR_NS::UsdStageWeakPtr get_new_clipboard_stage(const std::string& data_type);
     PXR_NS::UsdAttribute get_new_clipboard_attribute(const PXR_NS::SdfValueTypeName& type_name);
+    /**
+     * @brief Blocks until the pending clipboard file writes are finished.
+     */
+    void wait_clipboard_file();
 
     UsdClipboard(UsdClipboard&&) = delete;
     UsdClipboard& operator=(UsdClipboard&&) = delete;
 
 private:
+    struct FileState;
+
+    void set_clipboard_layer(const PXR_NS::SdfLayerRefPtr& layer);
+    void write_clipboard_file();
+    bool is_clipboard_file_changed() const;
+    void read_clipboard_file();
+
     std::string m_path_to_clipboard;
     std::string m_clipboard_file_format;
     PXR_NS::UsdStageCache::Id m_clipboardStageCacheId;
     PXR_NS::UsdStageCache::Id m_tmpClipboardStageCacheId;
+    PXR_NS::SdfLayerRefPtr m_clipboard_layer;
+    PXR_NS::UsdStageRefPtr m_clipboard_stage;
+    std::shared_ptr<FileState> m_file_state;
+    PXR_NS::WorkDispatcher m_file_writer;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -22,6 +22,7 @@ void py_interp::bind::wrap_usd_clipboard(pybind11::module& m)
         .def("get_clipboard_attribute", &UsdClipboard::get_clipboard_attribute)
         .def("get_clipboard_stage", &UsdClipboard::get_clipboard_stage)
         .def("get_new_clipboard_stage", &UsdClipboard::get_new_clipboard_stage)
-        .def("get_new_clipboard_attribute", &UsdClipboard::get_new_clipboard_attribute);
+        .def("get_new_clipboard_attribute", &UsdClipboard::get_new_clipboard_attribute)
+        .def("wait_clipboard_file", &UsdClipboard::wait_clipboard_file);
 }
 OPENDCC_NAMESPACE_CLOSE
@@ -123,6 +123,7 @@ MainWindow::MainWindow()
     // status_bar_label->setStyleSheet("QLabel{color: rgb(200, 200, 200);}");
     m_status_bar_logging = std::make_unique<StatusBarLoggingDelegate>(this);
     m_logger_panel_manager = new LoggerManager(this);
+    m_logger_panel_manager->set_message_capacity(Application::instance().get_settings()->get("logger.max_messages", 100000));
 
     auto timer = new QTimer(this);
     connect(timer, &QTimer::timeout, this, [] { Application::instance().get_session()->process_events(); });
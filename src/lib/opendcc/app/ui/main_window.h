@@ -125,7 +125,7 @@ private:
     Settings::SettingChangedHandle m_timeline_keyframe_current_time_indicator_type_callback_id;
     Settings::SettingChangedHandle m_timeline_keyframe_display_type_callback_id;
 
-    Session::StageChangedCallbackHandle m_timeline_stage_callback_id;
+    StageChangesDispatcher::Handle m_timeline_stage_callback_id = 0;
     Application::CallbackHandle m_timeline_current_stage_callback_id;
     Application::CallbackHandle m_timeline_selection_changed_callback_id;
     Application::CallbackHandle m_timeline_current_time_changed_callback_id;
@@ -16,6 +16,17 @@
 
 OPENDCC_NAMESPACE_OPEN
 
+namespace
+{
+    // the stage metadata the timeline follows
+    static const PXR_NS::TfToken start_time_code_token("startTimeCode");
+    static const PXR_NS::TfToken end_time_code_token("endTimeCode");
+    static const PXR_NS::TfToken min_time_code_token("minTimeCode");
+    static const PXR_NS::TfToken max_time_code_token("maxTimeCode");
+    static const PXR_NS::TfToken fps_token("framesPerSecond");
+    static const PXR_NS::TfToken time_codes_per_second_token("timeCodesPerSecond");
+}
+
 void MainWindow::update_timeline_samples()
 {
     if (!m_timeline_widget || !m_timeline_widget->time_bar_widget())
@@ -279,12 +290,16 @@ void MainWindow::init_timeline_ui()
             m_timeline_widget->time_bar_widget()->set_keyframe_display_type(get_keyframe_display_type(val.get<int>(0)));
         });
 
-    m_timeline_stage_callback_id = Application::instance().get_session()->register_stage_changed_callback(
-        Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED, [this](PXR_NS::UsdNotice::ObjectsChanged const& notice) {
-            auto notice_stage = notice.GetStage();
+    StageChangesDispatcher::Filter timeline_filter;
+    timeline_filter.paths = { PXR_NS::SdfPath::AbsoluteRootPath() };
+    timeline_filter.exact = true;
+    timeline_filter.fields = { start_time_code_token, end_time_code_token, min_time_code_token,
+                               max_time_code_token,   fps_token,           time_codes_per_second_token };
+    m_timeline_stage_callback_id = Application::instance().get_session()->register_stage_changes_callback(
+        timeline_filter, [this](const StageChangeSummary& summary) {
             auto current_stage = Application::instance().get_session()->get_current_stage();
 
-            if (notice_stage != current_stage)
+            if (summary.get_stage() != current_stage)
             {
                 return;
             }
@@ -296,49 +311,41 @@ void MainWindow::init_timeline_ui()
             double start_time;
             double end_time;
 
-            for (auto& path : notice.GetChangedInfoOnlyPaths())
+            for (auto& token : summary.get_changed_fields(PXR_NS::SdfPath::AbsoluteRootPath()))
             {
-                if (path == PXR_NS::SdfPath("/"))
+                if (token == start_time_code_token && current_stage->HasAuthoredMetadata(token) &&
+                    !qFuzzyCompare(range_slider->get_start_time(), current_stage->GetStartTimeCode()))
+                {
+                    m_timeline_slider->get_range_slider()->set_start_time(current_stage->GetStartTimeCode());
+                }
+                else if (token == end_time_code_token && current_stage->HasAuthoredMetadata(token) &&
+                         !qFuzzyCompare(range_slider->get_end_time(), current_stage->GetEndTimeCode()))
+                {
+                    m_timeline_slider->get_range_slider()->set_end_time(current_stage->GetEndTimeCode());
+                }
+                else if (token == min_time_code_token && current_stage->HasAuthoredMetadata(token))
                 {
-                    for (auto& token : notice.GetChangedFields(path))
+                    PXR_INTERNAL_NS::SdfTimeCode code;
+
+                    if (!current_stage->GetMetadata(token, &code))
+                    {
+                        break;
+                    }
+
+                    start_time = code.GetValue();
+                    found_start_time = true;
+                }
+                else if (token == max_time_code_token && current_stage->HasAuthoredMetadata(token))
+                {
+                    PXR_INTERNAL_NS::SdfTimeCode code;
+
+                    if (!current_stage->GetMetadata(token, &code))
                     {
-                        if (token == PXR_NS::TfToken("startTimeCode") && current_stage->HasAuthoredMetadata(token) &&
-                            !qFuzzyCompare(range_slider->get_start_time(), current_stage->GetStartTimeCode()))
-                        {
-                            m_timeline_slider->get_range_slider()->set_start_time(current_stage->GetStartTimeCode());
-                        }
-                        else if (token == PXR_NS::TfToken("endTimeCode") && current_stage->HasAuthoredMetadata(token) &&
-                                 !qFuzzyCompare(range_slider->get_end_time(), current_stage->GetEndTimeCode()))
-                        {
-                            m_timeline_slider->get_range_slider()->set_end_time(current_stage->GetEndTimeCode());
-                        }
-                        else if (token == PXR_NS::TfToken("minTimeCode") && current_stage->HasAuthoredMetadata(token))
-                        {
-                            PXR_INTERNAL_NS::SdfTimeCode code;
-
-                            if (!current_stage->GetMetadata(token, &code))
-                            {
-                                break;
-                            }
-
-                            start_time = code.GetValue();
-                            found_start_time = true;
-                        }
-                        else if (token == PXR_NS::TfToken("maxTimeCode") && current_stage->HasAuthoredMetadata(token))
-                        {
-                            PXR_INTERNAL_NS::SdfTimeCode code;
-
-                            if (!current_stage->GetMetadata(token, &code))
-                            {
-                                break;
-                            }
-
-                            end_time = code.GetValue();
-                            found_end_time = true;
-                        }
+                        break;
                     }
 
-                    break;
+                    end_time = code.GetValue();
+                    found_end_time = true;
                 }
             }
 
@@ -346,7 +353,7 @@ void MainWindow::init_timeline_ui()
             {
                 range_slider->set_current_start_time(start_time);
             }
-            else if (!current_stage->HasAuthoredMetadata(PXR_NS::TfToken("minTimeCode")))
+            else if (!current_stage->HasAuthoredMetadata(min_time_code_token))
             {
                 range_slider->set_current_start_time(range_slider->get_start_time());
             }
@@ -355,7 +362,7 @@ void MainWindow::init_timeline_ui()
             {
                 range_slider->set_current_end_time(end_time);
             }
-            else if (!current_stage->HasAuthoredMetadata(PXR_NS::TfToken("maxTimeCode")))
+            else if (!current_stage->HasAuthoredMetadata(max_time_code_token))
             {
                 range_slider->set_current_end_time(range_slider->get_end_time());
             }
@@ -431,8 +438,7 @@ void MainWindow::init_timeline_ui()
 
 void MainWindow::cleanup_timeline_ui()
 {
-    Application::instance().get_session()->unregister_stage_changed_callback(Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED,
-                                                                             m_timeline_stage_callback_id);
+    Application::instance().get_session()->unregister_stage_changes_callback(m_timeline_stage_callback_id);
     Application::instance().unregister_event_callback(Application::EventType::CURRENT_STAGE_CHANGED, m_timeline_current_stage_callback_id);
     Application::instance().unregister_event_callback(Application::EventType::SELECTION_CHANGED, m_timeline_selection_changed_callback_id);
     Application::instance().unregister_event_callback(Application::EventType::UI_ESCAPE_KEY_ACTION, m_escape_action_callback_id);
@@ -8,6 +8,9 @@
 #endif
 #include "texture_plugin.h"
 #include "OpenImageIO/imagebufalgo.h"
+#include <pxr/base/work/loops.h>
+#include <algorithm>
+#include <set>
 
 PXR_NAMESPACE_USING_DIRECTIVE
 OPENDCC_NAMESPACE_OPEN
@@ -38,18 +41,20 @@ bool InMemoryTexture::_OpenForReading(std::string const& filename, int subimage,
 bool InMemoryTexture::_OpenForReading(std::string const& filename, int subimage, int mip, bool suppressErrors)
 #endif
 {
-    if (mip != 0)
-        return false;
-
-    if (auto tex = InMemoryTextureRegistry::instance().get_texture(filename))
+    if (auto tex = InMemoryTextureRegistry::instance().get_mipmapped_texture(filename))
     {
-        m_buf = tex;
+        if (mip < 0 || mip >= tex->get_num_mip_levels())
+            return false;
+
+        m_texture = tex;
         m_filename = filename;
+        m_mip = mip;
         return true;
     }
 
     m_filename.clear();
-    m_buf.reset();
+    m_texture.reset();
+    m_mip = 0;
     return false;
 }
 #if PXR_VERSION >= 2108
@@ -73,21 +78,24 @@ bool InMemoryTexture::IsColorSpaceSRGB() const
 
 int InMemoryTexture::GetNumMipLevels() const
 {
+    if (auto texture = m_texture.lock())
+        return texture->get_num_mip_levels();
     return 1;
 }
 
 int InMemoryTexture::GetBytesPerPixel() const
 {
-    if (!m_buf.expired())
-        return m_buf.lock()->spec().pixel_bytes();
+    if (auto texture = m_texture.lock())
+        return texture->get_buffer()->spec().pixel_bytes();
     return 0;
 }
 #if PXR_VERSION >= 2108
 HioFormat InMemoryTexture::GetFormat() const
 {
-    if (m_buf.expired())
+    auto texture = m_texture.lock();
+    if (!texture)
         return HioFormat::HioFormatUNorm8;
-    switch (m_buf.lock()->spec().nchannels)
+    switch (texture->get_buffer()->spec().nchannels)
     {
     case 4:
         return HioFormatUNorm8Vec4;
@@ -103,9 +111,10 @@ HioFormat InMemoryTexture::GetFormat() const
 
 GLenum InMemoryTexture::GetFormat() const
 {
-    if (m_buf.expired())
+    auto texture = m_texture.lock();
+    if (!texture)
         return 1;
-    switch (m_buf.lock()->spec().nchannels)
+    switch (texture->get_buffer()->spec().nchannels)
     {
     case 1:
         return GL_RED;
@@ -128,16 +137,16 @@ GLenum InMemoryTexture::GetType() const
 
 int InMemoryTexture::GetHeight() const
 {
-    if (m_buf.expired())
-        return 0;
-    return m_buf.lock()->spec().height;
+    if (auto texture = m_texture.lock())
+        return texture->get_level_height(m_mip);
+    return 0;
 }
 
 int InMemoryTexture::GetWidth() const
 {
-    if (m_buf.expired())
-        return 0;
-    return m_buf.lock()->spec().width;
+    if (auto texture = m_texture.lock())
+        return texture->get_level_width(m_mip);
+    return 0;
 }
 
 std::string const& InMemoryTexture::GetFilename() const
@@ -150,13 +159,20 @@ bool InMemoryTexture::Write(StorageSpec const& storage, VtDictionary const& meta
     return false;
 }
 
+std::shared_ptr<OIIO::ImageBuf> InMemoryTexture::get_level_buffer() const
+{
+    if (auto texture = m_texture.lock())
+        return texture->get_level(m_mip);
+    return nullptr;
+}
+
 bool InMemoryTexture::ReadCropped(int const cropTop, int const cropBottom, int const cropLeft, int const cropRight, StorageSpec const& storage)
 {
     // Probably we should output some color for debugging purposes
-    if (m_buf.expired())
+    auto buf = get_level_buffer();
+    if (!buf)
         return false;
 
-    auto buf = m_buf.lock();
     OIIO::ImageBuf* result = buf.get();
 
     OIIO::ImageBuf cropped;
@@ -166,11 +182,9 @@ bool InMemoryTexture::ReadCropped(int const cropTop, int const cropBottom, int c
         result = &cropped;
     }
 
-    // We don't support mipmaping and GetNumMipLevels always returns 1. But Storm UDIM texture object doesn't care,
-    // it still tries to load mipmaped images, since it's readonly call, we can easily resample buffer to the desired
-    // mip level.
+    // Mip levels are served from the pyramid, resampling is only a fallback for sizes that don't match any level.
     OIIO::ImageBuf formatted;
-    if (storage.width != buf->spec().width || storage.height != buf->spec().height)
+    if (storage.width != result->spec().width || storage.height != result->spec().height)
     {
         OIIO::ImageBufAlgo::resample(formatted, *result, false, OIIO::ROI(0, storage.width, 0, storage.height));
         result = &formatted;
@@ -182,6 +196,171 @@ bool InMemoryTexture::ReadCropped(int const cropTop, int const cropBottom, int c
     return true;
 }
 
+InMemoryMipmappedTexture::InMemoryMipmappedTexture(std::shared_ptr<OIIO::ImageBuf> buffer)
+    : m_buffer(buffer)
+{
+    const auto& spec = m_buffer->spec();
+    m_levels.push_back(m_buffer);
+    m_tiles_x = (spec.width + s_tile_size - 1) / s_tile_size;
+    m_tiles_y = (spec.height + s_tile_size - 1) / s_tile_size;
+    m_dirty_tiles.reset(new std::atomic<bool>[size_t(m_tiles_x) * m_tiles_y]());
+
+    for (int size = std::max(spec.width, spec.height); size > 1; size /= 2)
+        ++m_num_mip_levels;
+}
+
+std::shared_ptr<OIIO::ImageBuf> InMemoryMipmappedTexture::get_buffer() const
+{
+    return m_buffer;
+}
+
+int InMemoryMipmappedTexture::get_num_mip_levels() const
+{
+    return m_num_mip_levels;
+}
+
+int InMemoryMipmappedTexture::get_level_width(int level) const
+{
+    return std::max(1, m_buffer->spec().width >> level);
+}
+
+int InMemoryMipmappedTexture::get_level_height(int level) const
+{
+    return std::max(1, m_buffer->spec().height >> level);
+}
+
+void InMemoryMipmappedTexture::mark_dirty(int x, int y)
+{
+    const int tile_x = x / s_tile_size;
+    const int tile_y = y / s_tile_size;
+    if (x < 0 || y < 0 || tile_x >= m_tiles_x || tile_y >= m_tiles_y)
+        return;
+
+    m_dirty_tiles[size_t(tile_y) * m_tiles_x + tile_x].store(true, std::memory_order_relaxed);
+    m_has_dirty_tiles.store(true, std::memory_order_release);
+}
+
+void InMemoryMipmappedTexture::mark_dirty(const OIIO::ROI& roi)
+{
+    const int tile_x_begin = std::max(0, roi.xbegin / s_tile_size);
+    const int tile_y_begin = std::max(0, roi.ybegin / s_tile_size);
+    const int tile_x_end = std::min(m_tiles_x, (roi.xend + s_tile_size - 1) / s_tile_size);
+    const int tile_y_end = std::min(m_tiles_y, (roi.yend + s_tile_size - 1) / s_tile_size);
+    for (int tile_y = tile_y_begin; tile_y < tile_y_end; ++tile_y)
+    {
+        for (int tile_x = tile_x_begin; tile_x < tile_x_end; ++tile_x)
+            m_dirty_tiles[size_t(tile_y) * m_tiles_x + tile_x].store(true, std::memory_order_relaxed);
+    }
+    if (tile_x_begin < tile_x_end && tile_y_begin < tile_y_end)
+        m_has_dirty_tiles.store(true, std::memory_order_release);
+}
+
+std::shared_ptr<OIIO::ImageBuf> InMemoryMipmappedTexture::get_level(int level)
+{
+    if (level <= 0)
+        return m_buffer;
+    level = std::min(level, m_num_mip_levels - 1);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_has_dirty_tiles.exchange(false, std::memory_order_acquire) && m_levels.size() > 1)
+    {
+        std::vector<OIIO::ROI> dirty_tiles;
+        for (int tile_y = 0; tile_y < m_tiles_y; ++tile_y)
+        {
+            for (int tile_x = 0; tile_x < m_tiles_x; ++tile_x)
+            {
+                if (m_dirty_tiles[size_t(tile_y) * m_tiles_x + tile_x].exchange(false, std::memory_order_relaxed))
+                {
+                    dirty_tiles.emplace_back(tile_x * s_tile_size, (tile_x + 1) * s_tile_size, tile_y * s_tile_size, (tile_y + 1) * s_tile_size);
+                }
+            }
+        }
+
+        for (int cur_level = 1; cur_level < int(m_levels.size()); ++cur_level)
+        {
+            // Regions of neighbouring tiles stop being disjoint once a tile shrinks below one pixel,
+            // but then they are identical, so deduplication by origin is exact.
+            std::set<std::pair<int, int>> visited;
+            std::vector<OIIO::ROI> regions;
+            const int scale = 1 << cur_level;
+            for (const auto& tile : dirty_tiles)
+            {
+                OIIO::ROI region(tile.xbegin / scale, std::min(get_level_width(cur_level), (tile.xend + scale - 1) / scale), tile.ybegin / scale,
+                                 std::min(get_level_height(cur_level), (tile.yend + scale - 1) / scale));
+                if (region.xbegin < region.xend && region.ybegin < region.yend && visited.emplace(region.xbegin, region.ybegin).second)
+                    regions.push_back(region);
+            }
+            PXR_NS::WorkParallelForN(regions.size(), [this, cur_level, &regions](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    update_level_region(cur_level, regions[i]);
+            });
+        }
+    }
+    else if (m_levels.size() == 1)
+    {
+        // nothing is built yet, pending dirty tiles are covered by the full build below
+        for (size_t i = 0; i < size_t(m_tiles_x) * m_tiles_y; ++i)
+            m_dirty_tiles[i].store(false, std::memory_order_relaxed);
+    }
+
+    for (int cur_level = int(m_levels.size()); cur_level <= level; ++cur_level)
+    {
+        const auto& spec = m_buffer->spec();
+        OIIO::ImageSpec level_spec(get_level_width(cur_level), get_level_height(cur_level), spec.nchannels, spec.format);
+        level_spec.channelnames = spec.channelnames;
+        m_levels.push_back(std::make_shared<OIIO::ImageBuf>(level_spec));
+
+        const int tiles_x = (level_spec.width + s_tile_size - 1) / s_tile_size;
+        const int tiles_y = (level_spec.height + s_tile_size - 1) / s_tile_size;
+        PXR_NS::WorkParallelForN(size_t(tiles_x) * tiles_y, [this, cur_level, tiles_x, &level_spec](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                const int tile_x = int(i % tiles_x);
+                const int tile_y = int(i / tiles_x);
+                update_level_region(cur_level, OIIO::ROI(tile_x * s_tile_size, std::min(level_spec.width, (tile_x + 1) * s_tile_size),
+                                                         tile_y * s_tile_size, std::min(level_spec.height, (tile_y + 1) * s_tile_size)));
+            }
+        });
+    }
+
+    return m_levels[level];
+}
+
+void InMemoryMipmappedTexture::update_level_region(int level, const OIIO::ROI& roi)
+{
+    const auto& src = *m_levels[level - 1];
+    auto& dst = *m_levels[level];
+    const int nchannels = src.spec().nchannels;
+    const int src_width = src.spec().width;
+    const int src_height = src.spec().height;
+
+    const OIIO::ROI src_roi(2 * roi.xbegin, std::min(src_width, 2 * roi.xend), 2 * roi.ybegin, std::min(src_height, 2 * roi.yend), 0, 1, 0,
+                            nchannels);
+    std::vector<float> src_pixels(size_t(src_roi.width()) * src_roi.height() * nchannels);
+    src.get_pixels(src_roi, OIIO::TypeDesc::FLOAT, src_pixels.data());
+
+    const OIIO::ROI dst_roi(roi.xbegin, roi.xend, roi.ybegin, roi.yend, 0, 1, 0, nchannels);
+    std::vector<float> dst_pixels(size_t(dst_roi.width()) * dst_roi.height() * nchannels);
+    for (int y = 0; y < dst_roi.height(); ++y)
+    {
+        const int y0 = std::min(2 * y, src_roi.height() - 1);
+        const int y1 = std::min(2 * y + 1, src_roi.height() - 1);
+        for (int x = 0; x < dst_roi.width(); ++x)
+        {
+            const int x0 = std::min(2 * x, src_roi.width() - 1);
+            const int x1 = std::min(2 * x + 1, src_roi.width() - 1);
+            const float* p00 = &src_pixels[(size_t(y0) * src_roi.width() + x0) * nchannels];
+            const float* p01 = &src_pixels[(size_t(y0) * src_roi.width() + x1) * nchannels];
+            const float* p10 = &src_pixels[(size_t(y1) * src_roi.width() + x0) * nchannels];
+            const float* p11 = &src_pixels[(size_t(y1) * src_roi.width() + x1) * nchannels];
+            float* out = &dst_pixels[(size_t(y) * dst_roi.width() + x) * nchannels];
+            for (int c = 0; c < nchannels; ++c)
+                out[c] = 0.25f * (p00[c] + p01[c] + p10[c] + p11[c]);
+        }
+    }
+    dst.set_pixels(dst_roi, OIIO::TypeDesc::FLOAT, dst_pixels.data());
+}
+
 InMemoryTextureRegistry& InMemoryTextureRegistry::instance()
 {
     static InMemoryTextureRegistry instance;
@@ -189,6 +368,13 @@ InMemoryTextureRegistry& InMemoryTextureRegistry::instance()
 }
 
 std::shared_ptr<OIIO::ImageBuf> InMemoryTextureRegistry::get_texture(const std::string& path) const
+{
+    Lock lock(m_mutex);
+    auto it = m_texture_cache.find(path);
+    return it != m_texture_cache.end() ? it->second->get_buffer() : nullptr;
+}
+
+std::shared_ptr<InMemoryMipmappedTexture> InMemoryTextureRegistry::get_mipmapped_texture(const std::string& path) const
 {
     Lock lock(m_mutex);
     auto it = m_texture_cache.find(path);
@@ -201,10 +387,97 @@ void InMemoryTextureRegistry::remove_texture(const std::string& path)
     m_texture_cache.erase(path);
 }
 
-void InMemoryTextureRegistry::add_texture(const std::string& path, std::shared_ptr<OIIO::ImageBuf> buffer)
+std::shared_ptr<InMemoryMipmappedTexture> InMemoryTextureRegistry::add_texture(const std::string& path, std::shared_ptr<OIIO::ImageBuf> buffer)
 {
+    auto texture = std::make_shared<InMemoryMipmappedTexture>(buffer);
     Lock lock(m_mutex);
-    m_texture_cache[path] = buffer;
+    m_texture_cache[path] = texture;
+    return texture;
 }
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+
+namespace
+{
+    std::shared_ptr<OIIO::ImageBuf> make_test_image(int width, int height)
+    {
+        auto buffer = std::make_shared<OIIO::ImageBuf>(OIIO::ImageSpec(width, height, 4, OIIO::TypeDesc::UINT8));
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (size_t i = 0; i < pixels.size(); ++i)
+            pixels[i] = uint8_t((i * 7919) % 251);
+        buffer->set_pixels(buffer->roi(), OIIO::TypeDesc::UINT8, pixels.data());
+        return buffer;
+    }
+
+    void paint_dab(OIIO::ImageBuf& buffer, InMemoryMipmappedTexture& texture, int center_x, int center_y, int radius)
+    {
+        const float color[] = { 1.0f, 0.0f, 0.0f, 1.0f };
+        for (int y = center_y - radius; y < center_y + radius; ++y)
+        {
+            for (int x = center_x - radius; x < center_x + radius; ++x)
+            {
+                buffer.setpixel(x, y, color);
+                texture.mark_dirty(x, y);
+            }
+        }
+    }
+};
+
+DOCTEST_TEST_SUITE("in_memory_texture")
+{
+    DOCTEST_TEST_CASE("incremental_mip_update_matches_full_build")
+    {
+        auto buffer = make_test_image(300, 170);
+        InMemoryMipmappedTexture texture(buffer);
+        DOCTEST_CHECK(texture.get_num_mip_levels() == 9);
+        DOCTEST_CHECK(texture.get_level(texture.get_num_mip_levels() - 1)->spec().width == 1);
+
+        paint_dab(*buffer, texture, 100, 60, 20);
+        paint_dab(*buffer, texture, 290, 160, 8);
+
+        InMemoryMipmappedTexture reference(std::make_shared<OIIO::ImageBuf>(*buffer));
+        for (int level = 1; level < texture.get_num_mip_levels(); ++level)
+        {
+            auto updated = texture.get_level(level);
+            auto rebuilt = reference.get_level(level);
+            DOCTEST_CHECK(updated->spec().width == rebuilt->spec().width);
+            DOCTEST_CHECK(updated->spec().height == rebuilt->spec().height);
+            DOCTEST_CHECK(OIIO::ImageBufAlgo::compare(*updated, *rebuilt, 0.0f, 0.0f).nfail == 0);
+        }
+    }
+
+    DOCTEST_TEST_CASE("per_stroke_update_cost_8k")
+    {
+        using ms = std::chrono::duration<double, std::milli>;
+        auto buffer = make_test_image(8192, 8192);
+        InMemoryMipmappedTexture texture(buffer);
+        const int last_level = texture.get_num_mip_levels() - 1;
+
+        auto start = std::chrono::steady_clock::now();
+        texture.get_level(last_level);
+        const auto full_build = std::chrono::steady_clock::now() - start;
+
+        constexpr int dab_count = 16;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < dab_count; ++i)
+            paint_dab(*buffer, texture, 4000 + i * 16, 4000, 32);
+        const auto paint = std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        texture.get_level(last_level);
+        const auto stroke_update = std::chrono::steady_clock::now() - start;
+
+        DOCTEST_MESSAGE("8K pyramid: full build " << ms(full_build).count() << " ms, stroke paint " << ms(paint).count() << " ms, stroke update "
+                                                  << ms(stroke_update).count() << " ms");
+        DOCTEST_CHECK(stroke_update < full_build);
+    }
+}
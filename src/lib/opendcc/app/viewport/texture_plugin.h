@@ -9,6 +9,9 @@
 #include "opendcc/app/core/api.h"
 #include <OpenImageIO/imagebuf.h>
 #include <pxr/pxr.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
 #if PXR_VERSION < 2108
 #include <pxr/imaging/glf/image.h>
 #else
@@ -27,15 +30,55 @@ template <class T>
 using PxrImageFactory = PXR_NS::HioImageFactory<T>;
 #endif
 
+/**
+ * @brief In-memory image with a lazily built box-filtered mip pyramid.
+ *
+ * Writers modify the level 0 buffer directly and report the touched pixels with mark_dirty.
+ * Mip levels are built on first request, after that only the tiles marked dirty since the
+ * previous request are rebuilt at each level.
+ */
+class OPENDCC_API InMemoryMipmappedTexture
+{
+public:
+    static constexpr int s_tile_size = 64;
+
+    InMemoryMipmappedTexture(std::shared_ptr<OIIO::ImageBuf> buffer);
+
+    std::shared_ptr<OIIO::ImageBuf> get_buffer() const;
+    int get_num_mip_levels() const;
+    int get_level_width(int level) const;
+    int get_level_height(int level) const;
+
+    // Thread-safe and lock-free, can be called from painting threads for every written pixel.
+    void mark_dirty(int x, int y);
+    void mark_dirty(const OIIO::ROI& roi);
+
+    // Returns the requested level with all pending dirty tiles applied, level 0 is the source buffer.
+    std::shared_ptr<OIIO::ImageBuf> get_level(int level);
+
+private:
+    void update_level_region(int level, const OIIO::ROI& roi);
+
+    std::shared_ptr<OIIO::ImageBuf> m_buffer;
+    std::vector<std::shared_ptr<OIIO::ImageBuf>> m_levels;
+    std::unique_ptr<std::atomic<bool>[]> m_dirty_tiles;
+    std::atomic<bool> m_has_dirty_tiles { false };
+    int m_tiles_x = 0;
+    int m_tiles_y = 0;
+    int m_num_mip_levels = 1;
+    std::mutex m_mutex;
+};
+
 class OPENDCC_API InMemoryTextureRegistry
 {
 public:
     static InMemoryTextureRegistry& instance();
 
-    void add_texture(const std::string& path, std::shared_ptr<OIIO::ImageBuf> buffer);
+    std::shared_ptr<InMemoryMipmappedTexture> add_texture(const std::string& path, std::shared_ptr<OIIO::ImageBuf> buffer);
     void remove_texture(const std::string& path);
 
     std::shared_ptr<OIIO::ImageBuf> get_texture(const std::string& path) const;
+    std::shared_ptr<InMemoryMipmappedTexture> get_mipmapped_texture(const std::string& path) const;
 
 private:
     InMemoryTextureRegistry() = default;
@@ -46,7 +89,7 @@ private:
 
     using Lock = std::lock_guard<std::mutex>;
     mutable std::mutex m_mutex;
-    std::unordered_map<std::string, std::shared_ptr<OIIO::ImageBuf>> m_texture_cache;
+    std::unordered_map<std::string, std::shared_ptr<InMemoryMipmappedTexture>> m_texture_cache;
 };
 
 class OPENDCC_API InMemoryTexture : public PxrImageBase
@@ -86,8 +129,11 @@ protected:
     virtual bool _OpenForWriting(std::string const& filename) override;
 
 private:
-    std::weak_ptr<OIIO::ImageBuf> m_buf;
+    std::shared_ptr<OIIO::ImageBuf> get_level_buffer() const;
+
+    std::weak_ptr<InMemoryMipmappedTexture> m_texture;
     std::string m_filename;
+    int m_mip = 0;
 };
 
 OPENDCC_NAMESPACE_CLOSE
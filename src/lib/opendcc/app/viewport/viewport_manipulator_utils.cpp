@@ -14,6 +14,8 @@
 #include "viewport_hydra_engine.h"
 #include "viewport_gl_widget.h"
 #include "opendcc/app/core/undo/router.h"
+#include <pxr/base/work/reduce.h>
+#include <algorithm>
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -340,19 +342,32 @@ namespace manipulator_utils
                                                               const PXR_NS::VtArray<PXR_NS::GfVec3f>& points,
                                                               const PXR_NS::GfMatrix4d& world_transform)
     {
-        PXR_NS::GfVec3f centroid = { 0, 0, 0 };
-        size_t point_count = 0;
-        std::unordered_set<int> visited;
-        visit_all_selected_points(selection_data, prim, [&](int point_index) {
-            if (visited.find(point_index) == visited.end())
-            {
-                visited.insert(point_index);
-                const auto& point = points[point_index];
-                centroid += GfVec3f(world_transform.Transform(point));
-                ++point_count;
-            }
+        // edges and faces share vertices, the indices are deduplicated by sorting instead of a per-point set
+        std::vector<int> indices;
+        indices.reserve(selection_data.get_point_indices().size());
+        visit_all_selected_points(selection_data, prim, [&indices, &points](int point_index) {
+            if (point_index >= 0 && point_index < points.size())
+                indices.push_back(point_index);
         });
-        return std::make_tuple(centroid, point_count);
+        std::sort(indices.begin(), indices.end());
+        indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+        if (indices.empty())
+            return std::make_tuple(PXR_NS::GfVec3f(0), size_t(0));
+
+        const auto sum = PXR_NS::WorkParallelReduceN(
+            PXR_NS::GfVec3d(0), indices.size(),
+            [&indices, &points](size_t begin, size_t end, const PXR_NS::GfVec3d& identity) {
+                auto result = identity;
+                for (auto i = begin; i < end; ++i)
+                    result += PXR_NS::GfVec3d(points[indices[i]]);
+                return result;
+            },
+            [](const PXR_NS::GfVec3d& left, const PXR_NS::GfVec3d& right) { return left + right; });
+
+        // the transform is affine, so transforming the average once gives the average of the transformed points
+        const auto point_count = indices.size();
+        const auto centroid = world_transform.Transform(sum / static_cast<double>(point_count));
+        return std::make_tuple(PXR_NS::GfVec3f(centroid * static_cast<double>(point_count)), point_count);
     }
 
     bool ViewportSelection::operator()()
@@ -4,49 +4,163 @@
 #include "opendcc/base/commands_api/core/args.h"
 #include "opendcc/base/commands_api/core/command_registry.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <mutex>
+#include <string_view>
+#include <tuple>
+
 OPENDCC_NAMESPACE_OPEN
-const std::vector<std::shared_ptr<CommandArgBase>>& CommandArgs::get_args() const
+
+namespace
+{
+    class ArgTypeRegistry
+    {
+    public:
+        static uint32_t register_type(const std::type_index& type)
+        {
+            static ArgTypeRegistry s_registry;
+            std::lock_guard<std::mutex> lock(s_registry.m_mutex);
+            return s_registry.m_ids.emplace(type, static_cast<uint32_t>(s_registry.m_ids.size() + 1)).first->second;
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::unordered_map<std::type_index, uint32_t> m_ids;
+    };
+
+    class ArgNameTable
+    {
+    public:
+        static ArgNameTable& instance()
+        {
+            static ArgNameTable s_table;
+            return s_table;
+        }
+
+        std::pair<const std::string*, uint32_t> intern(std::string_view name)
+        {
+            // names repeat a lot, so every thread keeps its own lock free view of the table
+            thread_local std::unordered_map<std::string_view, std::pair<const std::string*, uint32_t>> s_cache;
+            auto cached = s_cache.find(name);
+            if (cached != s_cache.end())
+                return cached->second;
+
+            std::pair<const std::string*, uint32_t> result;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto iter = m_ids.emplace(std::string(name), static_cast<uint32_t>(m_ids.size())).first;
+                result = { &iter->first, iter->second };
+            }
+            s_cache.emplace(*result.first, result);
+            return result;
+        }
+
+    private:
+        ArgNameTable() { m_ids.emplace("", 0); }
+
+        std::mutex m_mutex;
+        // node based, so the key addresses stay valid
+        std::unordered_map<std::string, uint32_t> m_ids;
+    };
+};
+
+uint32_t commands_api::detail::register_arg_type(const std::type_index& type)
+{
+    return ArgTypeRegistry::register_type(type);
+}
+
+const std::string& CommandArgName::get_string() const
+{
+    static const std::string s_empty;
+    return m_string ? *m_string : s_empty;
+}
+
+CommandArgName::CommandArgName(const std::string& name)
+{
+    std::tie(m_string, m_id) = ArgNameTable::instance().intern(name);
+}
+
+CommandArgName::CommandArgName(const char* name)
+{
+    // names are mostly string literals, so a small cache indexed by the pointer catches them before hashing,
+    // the contents are compared anyway since the same pointer may hold another name later
+    struct CacheEntry
+    {
+        const char* ptr = nullptr;
+        const std::string* string = nullptr;
+        uint32_t id = 0;
+    };
+    thread_local std::array<CacheEntry, 64> s_cache;
+    auto& entry = s_cache[(reinterpret_cast<uintptr_t>(name) >> 3) % s_cache.size()];
+    if (entry.ptr == name && std::strcmp(name, entry.string->c_str()) == 0)
+    {
+        m_string = entry.string;
+        m_id = entry.id;
+        return;
+    }
+    std::tie(m_string, m_id) = ArgNameTable::instance().intern(name);
+    entry = { name, m_string, m_id };
+}
+
+const CommandArgs::Args& CommandArgs::get_args() const
 {
     return m_args;
 }
 
-const std::unordered_map<std::string, std::shared_ptr<CommandArgBase>>& CommandArgs::get_kwargs() const
+const CommandArgs::Kwargs& CommandArgs::get_kwargs() const
 {
     return m_kwargs;
 }
 
-CommandArgs& CommandArgs::kwarg(std::string name, std::shared_ptr<CommandArgBase> arg)
+CommandArgs& CommandArgs::set_kwarg(const CommandArgName& name, CommandArgValue value)
 {
-    m_kwargs[name] = arg;
+    for (auto& kwarg : m_kwargs)
+    {
+        if (kwarg.first == name)
+        {
+            kwarg.second = std::move(value);
+            return *this;
+        }
+    }
+    m_kwargs.push_back({ name, std::move(value) });
     return *this;
 }
 
+CommandArgs& CommandArgs::kwarg(const CommandArgName& name, std::shared_ptr<CommandArgBase> arg)
+{
+    return set_kwarg(name, CommandArgValue(std::move(arg)));
+}
+
 CommandArgs& CommandArgs::pos_arg(uint32_t pos, std::shared_ptr<CommandArgBase> arg)
 {
     m_args.resize(std::max(m_args.size(), static_cast<size_t>(pos + 1)));
-    m_args[pos] = arg;
+    m_args[pos] = CommandArgValue(std::move(arg));
     return *this;
 }
 
 CommandArgs& CommandArgs::arg(std::shared_ptr<CommandArgBase> arg)
 {
-    m_args.push_back(arg);
+    m_args.push_back(CommandArgValue(std::move(arg)));
     return *this;
 }
 
-std::shared_ptr<CommandArgBase> CommandArgs::get_arg(uint32_t pos) const
+const CommandArgBase* CommandArgs::get_arg(uint32_t pos) const
 {
     if (pos >= m_args.size())
         return nullptr;
-    return m_args[pos];
+    return m_args[pos].get();
 }
 
-std::shared_ptr<CommandArgBase> CommandArgs::get_kwarg(std::string name) const
+const CommandArgBase* CommandArgs::get_kwarg(const CommandArgName& name) const
 {
-    auto iter = m_kwargs.find(name);
-    if (iter == m_kwargs.end())
-        return nullptr;
-    return iter->second;
+    for (const auto& kwarg : m_kwargs)
+    {
+        if (kwarg.first == name)
+            return kwarg.second.get();
+    }
+    return nullptr;
 }
 
 bool CommandArgs::has_arg(uint32_t pos) const
@@ -54,9 +168,9 @@ bool CommandArgs::has_arg(uint32_t pos) const
     return m_args.size() > pos;
 }
 
-bool CommandArgs::has_kwarg(std::string name) const
+bool CommandArgs::has_kwarg(const CommandArgName& name) const
 {
-    return m_kwargs.find(name) != m_kwargs.end();
+    return std::any_of(m_kwargs.begin(), m_kwargs.end(), [&name](const auto& kwarg) { return kwarg.first == name; });
 }
 
 bool CommandArgBase::is_convertible(const std::shared_ptr<CommandArgBase>& arg) const
@@ -9,21 +9,60 @@
 #include "opendcc/base/commands_api/core/api.h"
 #include "opendcc/base/commands_api/core/command_syntax.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
 #include <memory>
+#include <new>
 #include <typeindex>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
 
 OPENDCC_NAMESPACE_OPEN
 
+namespace commands_api
+{
+    namespace detail
+    {
+        COMMANDS_API uint32_t register_arg_type(const std::type_index& type);
+    };
+};
+
+/**
+ * @brief Returns the process wide integer id of an argument type.
+ *
+ * Ids are handed out by commands_api, so they match across shared libraries.
+ */
+template <class T>
+uint32_t get_command_arg_type_id()
+{
+    static const uint32_t s_type_id = commands_api::detail::register_arg_type(typeid(T));
+    return s_type_id;
+}
+
 class COMMANDS_API CommandArgBase
 {
 public:
     virtual ~CommandArgBase() = default;
     virtual const std::type_info& get_type_info() const = 0;
+    uint32_t get_type_id() const { return m_type_id; }
     bool is_convertible(const std::shared_ptr<CommandArgBase>& arg) const;
     bool is_convertible(const std::type_index& arg_type) const;
     bool is_convertible(const TypeIndices& arg_types) const;
+
+    // constructs a copy of the argument in the buffer, used by CommandArgValue for inline values
+    virtual CommandArgBase* copy_to(void* buffer) const = 0;
+    virtual CommandArgBase* move_to(void* buffer) noexcept = 0;
+
+protected:
+    explicit CommandArgBase(uint32_t type_id)
+        : m_type_id(type_id)
+    {
+    }
+
+private:
+    uint32_t m_type_id;
 };
 
 template <class T>
@@ -31,12 +70,22 @@ class CommandArg : public CommandArgBase
 {
 public:
     CommandArg(const T& value)
-        : m_value(value)
+        : CommandArgBase(get_command_arg_type_id<T>())
+        , m_value(value)
+    {
+    }
+
+    CommandArg(T&& value)
+        : CommandArgBase(get_command_arg_type_id<T>())
+        , m_value(std::move(value))
     {
     }
 
     const std::type_info& get_type_info() const override { return typeid(T); }
 
+    CommandArgBase* copy_to(void* buffer) const override { return new (buffer) CommandArg<T>(m_value); }
+    CommandArgBase* move_to(void* buffer) noexcept override { return new (buffer) CommandArg<T>(std::move(m_value)); }
+
     operator T() const { return m_value; }
 
     const T& get_value() const { return m_value; }
@@ -45,9 +94,275 @@ private:
     T m_value;
 };
 
+/**
+ * @brief Casts an argument to CommandArg<T> by comparing type ids, returns nullptr if the types differ.
+ */
+template <class T>
+const CommandArg<T>* command_arg_cast(const CommandArgBase* arg)
+{
+    return arg && arg->get_type_id() == get_command_arg_type_id<T>() ? static_cast<const CommandArg<T>*>(arg) : nullptr;
+}
+
+/**
+ * @brief Holds a single command argument.
+ *
+ * Small values which can be moved without throwing are stored inline,
+ * larger ones and arguments created elsewhere (e.g. by the python bindings) are shared.
+ */
+class CommandArgValue
+{
+public:
+    static constexpr size_t s_inline_size = 64;
+
+    CommandArgValue() = default;
+    CommandArgValue(std::shared_ptr<CommandArgBase> arg)
+        : m_shared(std::move(arg))
+    {
+    }
+    CommandArgValue(const CommandArgValue& other)
+        : m_shared(other.m_shared)
+    {
+        if (other.m_inline)
+            m_inline = other.m_inline->copy_to(&m_buffer);
+    }
+    CommandArgValue(CommandArgValue&& other) noexcept
+        : m_shared(std::move(other.m_shared))
+    {
+        if (other.m_inline)
+        {
+            m_inline = other.m_inline->move_to(&m_buffer);
+            other.reset();
+        }
+    }
+    CommandArgValue& operator=(const CommandArgValue& other)
+    {
+        if (this != &other)
+        {
+            reset();
+            m_shared = other.m_shared;
+            if (other.m_inline)
+                m_inline = other.m_inline->copy_to(&m_buffer);
+        }
+        return *this;
+    }
+    CommandArgValue& operator=(CommandArgValue&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            m_shared = std::move(other.m_shared);
+            if (other.m_inline)
+            {
+                m_inline = other.m_inline->move_to(&m_buffer);
+                other.reset();
+            }
+        }
+        return *this;
+    }
+    ~CommandArgValue() { reset(); }
+
+    template <class T, class TValue>
+    static CommandArgValue make(TValue&& value)
+    {
+        CommandArgValue result;
+        if constexpr (sizeof(CommandArg<T>) <= s_inline_size && alignof(CommandArg<T>) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible<T>::value)
+            result.m_inline = new (&result.m_buffer) CommandArg<T>(std::forward<TValue>(value));
+        else
+            result.m_shared = std::make_shared<CommandArg<T>>(std::forward<TValue>(value));
+        return result;
+    }
+
+    const CommandArgBase* get() const { return m_inline ? m_inline : m_shared.get(); }
+    const CommandArgBase* operator->() const { return get(); }
+    const CommandArgBase& operator*() const { return *get(); }
+    explicit operator bool() const { return get() != nullptr; }
+
+    template <class T>
+    const CommandArg<T>* get_as() const
+    {
+        return command_arg_cast<T>(get());
+    }
+
+    void reset()
+    {
+        if (m_inline)
+        {
+            m_inline->~CommandArgBase();
+            m_inline = nullptr;
+        }
+        m_shared.reset();
+    }
+
+private:
+    std::aligned_storage_t<s_inline_size, alignof(std::max_align_t)> m_buffer;
+    CommandArgBase* m_inline = nullptr;
+    std::shared_ptr<CommandArgBase> m_shared;
+};
+
+/**
+ * @brief Interned keyword argument name.
+ *
+ * Names are compared by id, the string is stored once per process.
+ */
+class COMMANDS_API CommandArgName
+{
+public:
+    CommandArgName() = default;
+    CommandArgName(const std::string& name);
+    CommandArgName(const char* name);
+
+    uint32_t get_id() const { return m_id; }
+    const std::string& get_string() const;
+    operator const std::string&() const { return get_string(); }
+
+    bool operator==(const CommandArgName& other) const { return m_id == other.m_id; }
+    bool operator!=(const CommandArgName& other) const { return m_id != other.m_id; }
+
+private:
+    // nullptr for the empty name
+    const std::string* m_string = nullptr;
+    uint32_t m_id = 0;
+};
+
+namespace commands_api
+{
+    namespace detail
+    {
+        // keeps the first N elements inline, the rest goes to a heap allocated tail
+        template <class T, size_t N>
+        class InlineVector
+        {
+        public:
+            template <class TOwner, class TValue>
+            class Iterator
+            {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = std::remove_const_t<TValue>;
+                using difference_type = std::ptrdiff_t;
+                using pointer = TValue*;
+                using reference = TValue&;
+
+                Iterator(TOwner* owner, size_t index)
+                    : m_owner(owner)
+                    , m_index(index)
+                {
+                }
+                TValue& operator*() const { return (*m_owner)[m_index]; }
+                TValue* operator->() const { return &(*m_owner)[m_index]; }
+                Iterator& operator++()
+                {
+                    ++m_index;
+                    return *this;
+                }
+                Iterator operator++(int)
+                {
+                    auto result = *this;
+                    ++m_index;
+                    return result;
+                }
+                bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+                bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+            private:
+                TOwner* m_owner;
+                size_t m_index;
+            };
+            using iterator = Iterator<InlineVector, T>;
+            using const_iterator = Iterator<const InlineVector, const T>;
+
+            InlineVector() = default;
+            InlineVector(const InlineVector& other)
+                : m_tail(other.m_tail)
+            {
+                for (size_t i = 0; i < other.inline_size(); ++i)
+                    new (inline_ptr(i)) T(other[i]);
+                m_size = other.m_size;
+            }
+            InlineVector(InlineVector&& other) noexcept
+                : m_tail(std::move(other.m_tail))
+            {
+                for (size_t i = 0; i < other.inline_size(); ++i)
+                    new (inline_ptr(i)) T(std::move(other[i]));
+                m_size = other.m_size;
+                other.clear();
+            }
+            InlineVector& operator=(const InlineVector& other)
+            {
+                if (this != &other)
+                {
+                    clear();
+                    for (size_t i = 0; i < other.inline_size(); ++i)
+                        new (inline_ptr(i)) T(other[i]);
+                    m_tail = other.m_tail;
+                    m_size = other.m_size;
+                }
+                return *this;
+            }
+            InlineVector& operator=(InlineVector&& other) noexcept
+            {
+                if (this != &other)
+                {
+                    clear();
+                    for (size_t i = 0; i < other.inline_size(); ++i)
+                        new (inline_ptr(i)) T(std::move(other[i]));
+                    m_tail = std::move(other.m_tail);
+                    m_size = other.m_size;
+                    other.clear();
+                }
+                return *this;
+            }
+            ~InlineVector() { clear(); }
+
+            size_t size() const { return m_size; }
+            bool empty() const { return m_size == 0; }
+            T& operator[](size_t i) { return i < N ? *inline_ptr(i) : m_tail[i - N]; }
+            const T& operator[](size_t i) const { return i < N ? *inline_ptr(i) : m_tail[i - N]; }
+
+            void push_back(T value)
+            {
+                if (m_size < N)
+                    new (inline_ptr(m_size)) T(std::move(value));
+                else
+                    m_tail.push_back(std::move(value));
+                ++m_size;
+            }
+            void resize(size_t size)
+            {
+                for (size_t i = size; i < inline_size(); ++i)
+                    inline_ptr(i)->~T();
+                for (size_t i = inline_size(); i < std::min(size, N); ++i)
+                    new (inline_ptr(i)) T();
+                m_tail.resize(size > N ? size - N : 0);
+                m_size = size;
+            }
+            void clear() { resize(0); }
+
+            iterator begin() { return iterator(this, 0); }
+            iterator end() { return iterator(this, m_size); }
+            const_iterator begin() const { return const_iterator(this, 0); }
+            const_iterator end() const { return const_iterator(this, m_size); }
+
+        private:
+            size_t inline_size() const { return std::min(m_size, N); }
+            T* inline_ptr(size_t i) { return reinterpret_cast<T*>(&m_inline[i]); }
+            const T* inline_ptr(size_t i) const { return reinterpret_cast<const T*>(&m_inline[i]); }
+
+            // constructed only up to size
+            std::aligned_storage_t<sizeof(T), alignof(T)> m_inline[N];
+            std::vector<T> m_tail;
+            size_t m_size = 0;
+        };
+    };
+};
+
 class COMMANDS_API CommandArgs
 {
 public:
+    using Args = commands_api::detail::InlineVector<CommandArgValue, 4>;
+    using Kwargs = commands_api::detail::InlineVector<std::pair<CommandArgName, CommandArgValue>, 4>;
+
     CommandArgs() = default;
     CommandArgs(const CommandArgs&) = default;
     CommandArgs(CommandArgs&&) = default;
@@ -55,44 +370,43 @@ public:
     CommandArgs& operator=(CommandArgs&&) = default;
 
     CommandArgs& arg(std::shared_ptr<CommandArgBase> arg);
-    CommandArgs& kwarg(std::string name, std::shared_ptr<CommandArgBase> arg);
+    CommandArgs& kwarg(const CommandArgName& name, std::shared_ptr<CommandArgBase> arg);
     CommandArgs& pos_arg(uint32_t pos, std::shared_ptr<CommandArgBase> arg);
 
     template <class T>
     CommandArgs& arg(T&& arg);
     template <class T>
-    CommandArgs& kwarg(std::string name, T&& arg);
+    CommandArgs& kwarg(const CommandArgName& name, T&& arg);
     template <class T>
     CommandArgs& pos_arg(uint32_t pos, T&& arg);
 
-    std::shared_ptr<CommandArgBase> get_arg(uint32_t pos) const;
-    std::shared_ptr<CommandArgBase> get_kwarg(std::string name) const;
+    const CommandArgBase* get_arg(uint32_t pos) const;
+    const CommandArgBase* get_kwarg(const CommandArgName& name) const;
 
+    // the returned pointers are valid while the args are alive and unchanged
     template <class T>
-    std::shared_ptr<CommandArg<T>> get_arg(uint32_t pos) const
+    const CommandArg<T>* get_arg(uint32_t pos) const
     {
-        if (auto arg = get_arg(pos))
-            return std::dynamic_pointer_cast<CommandArg<T>>(arg);
-        return nullptr;
+        return command_arg_cast<T>(get_arg(pos));
     }
 
     template <class T>
-    std::shared_ptr<CommandArg<T>> get_kwarg(std::string name) const
+    const CommandArg<T>* get_kwarg(const CommandArgName& name) const
     {
-        if (auto arg = get_kwarg(name))
-            return std::dynamic_pointer_cast<CommandArg<T>>(arg);
-        return nullptr;
+        return command_arg_cast<T>(get_kwarg(name));
     }
 
     bool has_arg(uint32_t pos) const;
-    bool has_kwarg(std::string name) const;
+    bool has_kwarg(const CommandArgName& name) const;
 
-    const std::vector<std::shared_ptr<CommandArgBase>>& get_args() const;
-    const std::unordered_map<std::string, std::shared_ptr<CommandArgBase>>& get_kwargs() const;
+    const Args& get_args() const;
+    const Kwargs& get_kwargs() const;
 
 private:
-    std::vector<std::shared_ptr<CommandArgBase>> m_args;
-    std::unordered_map<std::string, std::shared_ptr<CommandArgBase>> m_kwargs;
+    CommandArgs& set_kwarg(const CommandArgName& name, CommandArgValue value);
+
+    Args m_args;
+    Kwargs m_kwargs;
 };
 
 template <class T>
@@ -122,22 +436,21 @@ struct ArgTypeInfo<const char*>
 template <class T>
 CommandArgs& CommandArgs::arg(T&& arg)
 {
-    m_args.push_back(std::make_shared<CommandArg<typename ArgTypeInfo<std::decay_t<T>>::Type>>(std::forward<T>(arg)));
+    m_args.push_back(CommandArgValue::make<typename ArgTypeInfo<std::decay_t<T>>::Type>(std::forward<T>(arg)));
     return *this;
 }
 
 template <class T>
-CommandArgs& CommandArgs::kwarg(std::string name, T&& arg)
+CommandArgs& CommandArgs::kwarg(const CommandArgName& name, T&& arg)
 {
-    m_kwargs[name] = std::make_shared<CommandArg<typename ArgTypeInfo<std::decay_t<T>>::Type>>(std::forward<T>(arg));
-    return *this;
+    return set_kwarg(name, CommandArgValue::make<typename ArgTypeInfo<std::decay_t<T>>::Type>(std::forward<T>(arg)));
 }
 
 template <class T>
 CommandArgs& CommandArgs::pos_arg(uint32_t pos, T&& arg)
 {
     m_args.resize(std::max(m_args.size(), static_cast<size_t>(pos + 1)));
-    m_args[pos] = std::make_shared<CommandArg<typename ArgTypeInfo<std::decay_t<T>>::Type>>(std::forward<T>(arg));
+    m_args[pos] = CommandArgValue::make<typename ArgTypeInfo<std::decay_t<T>>::Type>(std::forward<T>(arg));
     return *this;
 }
 
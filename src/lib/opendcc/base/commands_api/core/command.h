@@ -39,7 +39,9 @@ public:
     template <class T>
     std::shared_ptr<CommandArg<T>> get_result() const
     {
-        return std::dynamic_pointer_cast<CommandArg<T>>(m_result_value);
+        if (!command_arg_cast<T>(m_result_value.get()))
+            return nullptr;
+        return std::static_pointer_cast<CommandArg<T>>(m_result_value);
     }
 
     std::shared_ptr<CommandArgBase> get_result() const;
@@ -35,15 +35,16 @@ namespace
         const auto& syntax_kwarg_types = syntax.get_kwarg_descriptors();
         for (const auto& kwarg : args.get_kwargs())
         {
-            auto reference = syntax_kwarg_types.find(kwarg.first);
+            const auto& name = kwarg.first.get_string();
+            auto reference = syntax_kwarg_types.find(name);
             if (reference == syntax_kwarg_types.end())
             {
-                OPENDCC_ERROR("Unknown option \"{}\".", kwarg.first);
+                OPENDCC_ERROR("Unknown option \"{}\".", name);
                 return false;
             }
             if (!kwarg.second->is_convertible(reference->second.type_indices))
             {
-                OPENDCC_ERROR("Incorrect type of \"{}\" argument.", kwarg.first);
+                OPENDCC_ERROR("Incorrect type of \"{}\" argument.", name);
                 return false;
             }
         }
@@ -77,7 +77,7 @@ namespace
         if (!value)
             return T();
 
-        auto derived_value = std::dynamic_pointer_cast<CommandArg<T>>(value);
+        auto derived_value = command_arg_cast<T>(value.get());
         if (!derived_value)
             return T();
 
@@ -292,3 +292,155 @@ void CommandRegistry::register_conversion_impl(const std::type_index& from, cons
 }
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+
+#include <array>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+
+namespace
+{
+    class RegistryTestCommand : public Command
+    {
+    public:
+        CommandResult execute(const CommandArgs& args) override
+        {
+            auto path = args.get_arg<std::string>(0);
+            auto value = args.get_kwarg<double>("value");
+            auto visible = args.get_kwarg<bool>("visible");
+            if (!path || !value || !visible)
+                return CommandResult(CommandResult::Status::INVALID_ARG);
+            return CommandResult(CommandResult::Status::SUCCESS, value->get_value() + path->get_value().size());
+        }
+    };
+
+    // storage the args used to have, kept as a baseline
+    class SharedCommandArgs
+    {
+    public:
+        template <class T>
+        SharedCommandArgs& arg(T&& value)
+        {
+            m_args.push_back(std::make_shared<CommandArg<typename ArgTypeInfo<std::decay_t<T>>::Type>>(std::forward<T>(value)));
+            return *this;
+        }
+        template <class T>
+        SharedCommandArgs& kwarg(std::string name, T&& value)
+        {
+            m_kwargs[name] = std::make_shared<CommandArg<typename ArgTypeInfo<std::decay_t<T>>::Type>>(std::forward<T>(value));
+            return *this;
+        }
+        template <class T>
+        std::shared_ptr<CommandArg<T>> get_arg(uint32_t pos) const
+        {
+            return pos < m_args.size() ? std::dynamic_pointer_cast<CommandArg<T>>(m_args[pos]) : nullptr;
+        }
+        template <class T>
+        std::shared_ptr<CommandArg<T>> get_kwarg(std::string name) const
+        {
+            auto iter = m_kwargs.find(name);
+            return iter != m_kwargs.end() ? std::dynamic_pointer_cast<CommandArg<T>>(iter->second) : nullptr;
+        }
+
+    private:
+        std::vector<std::shared_ptr<CommandArgBase>> m_args;
+        std::unordered_map<std::string, std::shared_ptr<CommandArgBase>> m_kwargs;
+    };
+
+    template <class TFn>
+    double measure_ms(TFn fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+DOCTEST_TEST_SUITE("CommandRegistryTests")
+{
+    DOCTEST_TEST_CASE("args_storage")
+    {
+        // too large to be stored inline
+        using BigValue = std::array<double, 16>;
+        BigValue big;
+        big.fill(1.0);
+        CommandArgs args;
+        args.arg(1).arg("text").arg(big).arg(2.5f).arg(true).kwarg("flag", false).kwarg("flag", true);
+
+        DOCTEST_CHECK(args.get_args().size() == 5);
+        DOCTEST_CHECK(args.get_arg<int>(0)->get_value() == 1);
+        DOCTEST_CHECK(args.get_arg<std::string>(1)->get_value() == "text");
+        DOCTEST_CHECK(args.get_arg<BigValue>(2)->get_value() == big);
+        DOCTEST_CHECK(args.get_arg<float>(3)->get_value() == 2.5f);
+        DOCTEST_CHECK(args.get_arg<bool>(4)->get_value());
+        DOCTEST_CHECK(args.get_arg<double>(3) == nullptr);
+        DOCTEST_CHECK(args.get_arg<int>(5) == nullptr);
+
+        DOCTEST_CHECK(args.get_kwargs().size() == 1);
+        DOCTEST_CHECK(args.has_kwarg("flag"));
+        DOCTEST_CHECK(!args.has_kwarg("other"));
+        DOCTEST_CHECK(args.get_kwarg<bool>(std::string("flag"))->get_value());
+
+        const auto copy = args;
+        args = CommandArgs().pos_arg(2, std::string("moved"));
+        DOCTEST_CHECK(copy.get_arg<std::string>(1)->get_value() == "text");
+        DOCTEST_CHECK(copy.get_arg<BigValue>(2)->get_value() == big);
+        DOCTEST_CHECK(args.get_args().size() == 3);
+        DOCTEST_CHECK(!args.get_args()[0]);
+        DOCTEST_CHECK(args.get_arg<std::string>(2)->get_value() == "moved");
+
+        CommandArgs shared;
+        shared.arg(std::shared_ptr<CommandArgBase>(std::make_shared<CommandArg<int>>(7)));
+        DOCTEST_CHECK(shared.get_arg<int>(0)->get_value() == 7);
+    }
+
+    DOCTEST_TEST_CASE("dispatch_benchmark")
+    {
+        const std::string command_name = "registry_test_command";
+        CommandRegistry::register_command(command_name,
+                                          CommandSyntax().arg<std::string>("path").kwarg<double>("value").kwarg<bool>("visible").result<double>(),
+                                          [] { return std::make_shared<RegistryTestCommand>(); });
+
+        constexpr int count = 200000;
+        const std::string path = "/root/geometry/mesh";
+        double sum = 0;
+        const auto legacy_ms = measure_ms([&] {
+            for (int i = 0; i < count; ++i)
+            {
+                SharedCommandArgs args;
+                args.arg(path).kwarg("value", 1.0).kwarg("visible", true);
+                if (args.get_arg<std::string>(0) && args.get_kwarg<bool>("visible"))
+                    sum += args.get_kwarg<double>("value")->get_value();
+            }
+        });
+        const auto args_ms = measure_ms([&] {
+            for (int i = 0; i < count; ++i)
+            {
+                CommandArgs args;
+                args.arg(path).kwarg("value", 1.0).kwarg("visible", true);
+                if (args.get_arg<std::string>(0) && args.get_kwarg<bool>("visible"))
+                    sum += args.get_kwarg<double>("value")->get_value();
+            }
+        });
+        DOCTEST_CHECK(sum == 2.0 * count);
+
+        int succeeded = 0;
+        const auto dispatch_ms = measure_ms([&] {
+            for (int i = 0; i < count; ++i)
+            {
+                if (CommandInterface::execute(command_name, CommandArgs().arg(path).kwarg("value", 1.0).kwarg("visible", true), false))
+                    ++succeeded;
+            }
+        });
+        DOCTEST_CHECK(succeeded == count);
+
+        DOCTEST_MESSAGE("build and read args x" << count << ": shared storage " << legacy_ms << " ms, inline storage " << args_ms << " ms");
+        DOCTEST_MESSAGE("CommandInterface::execute x" << count << ": " << dispatch_ms << " ms");
+
+        CommandRegistry::unregister_command(command_name);
+    }
+}
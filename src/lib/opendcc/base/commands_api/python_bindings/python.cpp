@@ -30,6 +30,9 @@ namespace py_utils
 {
     std::string generate_python_cmd_str(const std::string& command_name, const CommandArgs& args)
     {
+        if (!Py_IsInitialized())
+            return "";
+
         pybind11::gil_scoped_acquire gil;
         // PyLock lock;
         tuple pyargs;
@@ -58,7 +61,7 @@ namespace py_utils
 
         PyLock lock;
         auto result_type = std::type_index(result.get_type_info());
-        const auto pyobj = PythonCommandInterface::to_python(result.get_result(), { result_type });
+        const auto pyobj = PythonCommandInterface::to_python(result.get_result().get(), { result_type });
 
         PyTypeObject* pyobj_type = pyobj.ptr()->ob_type;
         auto bo = PyBaseObject_Type;
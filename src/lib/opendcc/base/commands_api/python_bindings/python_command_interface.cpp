@@ -15,7 +15,7 @@ struct PythonCommandInterface::Pimpl
     PythonCommandInterface::EventDispatcher dispatcher;
 };
 
-pybind11::object PythonCommandInterface::to_python(const std::shared_ptr<CommandArgBase>& arg, const TypeIndices& arg_types)
+pybind11::object PythonCommandInterface::to_python(const CommandArgBase* arg, const TypeIndices& arg_types)
 {
     auto& pimpl = instance().m_pimpl;
     for (const auto& type : arg_types)
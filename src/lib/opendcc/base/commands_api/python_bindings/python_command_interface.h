@@ -21,13 +21,13 @@ public:
         COMMAND_EXECUTE
     };
 
-    using ToPythonFn = std::function<pybind11::object(const std::shared_ptr<CommandArgBase>&)>;
+    using ToPythonFn = std::function<pybind11::object(const CommandArgBase*)>;
     using FromPythonFn = std::function<std::shared_ptr<CommandArgBase>(const pybind11::object&)>;
     using CallbackFn = void(const std::shared_ptr<Command>&, const CommandArgs&, const CommandResult&);
     using EventDispatcher = eventpp::EventDispatcher<EventType, CallbackFn>;
     using EventDispatcherHandle = EventDispatcher::Handle;
 
-    static pybind11::object to_python(const std::shared_ptr<CommandArgBase>& arg, const TypeIndices& arg_types);
+    static pybind11::object to_python(const CommandArgBase* arg, const TypeIndices& arg_types);
     static std::shared_ptr<CommandArgBase> from_python(const pybind11::object& arg, const TypeIndices& arg_types);
 
     EventDispatcherHandle register_event_callback(const std::function<CallbackFn>& callback);
@@ -38,8 +38,8 @@ public:
     {
         register_conversion_impl(
             type_name, typeid(T),
-            [](const std::shared_ptr<CommandArgBase>& arg) {
-                if (auto downcasted = std::dynamic_pointer_cast<CommandArg<T>>(arg))
+            [](const CommandArgBase* arg) {
+                if (auto downcasted = command_arg_cast<T>(arg))
                 {
                     return pybind11::cast(downcasted->get_value());
                 }
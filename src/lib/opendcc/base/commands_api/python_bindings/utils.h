@@ -40,10 +40,11 @@ namespace py_utils
         pykwargs.clear();
         for (const auto& kwarg : args.get_kwargs())
         {
-            auto py_obj = PythonCommandInterface::to_python(kwarg.second, syntax.get_kwarg_descriptor(kwarg.first).type_indices);
+            const auto& name = kwarg.first.get_string();
+            auto py_obj = PythonCommandInterface::to_python(kwarg.second.get(), syntax.get_kwarg_descriptor(name).type_indices);
             if (!py_obj.is_none())
             {
-                pykwargs[pybind11::str(kwarg.first)] = py_obj;
+                pykwargs[pybind11::str(name)] = py_obj;
             }
             else
             {
@@ -238,7 +238,7 @@ namespace
         }
         const auto result = CommandInterface::execute(command, args);
         std::type_index return_type = result.get_type_info();
-        return CommandResult(result.get_status(), PythonCommandInterface::to_python(result.get_result(), { return_type }));
+        return CommandResult(result.get_status(), PythonCommandInterface::to_python(result.get_result().get(), { return_type }));
     }
 
     CommandResult* cmd_result_constructor(CommandResult::Status status, object result)
@@ -5,6 +5,9 @@
 
 #include "opendcc/base/utils/string_utils.h"
 
+#include <cstdlib>
+#include <cstring>
+
 OPENDCC_NAMESPACE_OPEN
 
 IPC_NAMESPACE_OPEN
@@ -12,6 +15,110 @@ IPC_NAMESPACE_OPEN
 static const auto arg_splitter = ' ';
 static const auto key_value_splitter = '=';
 
+// "\0IPC" can't start a text command
+static const char binary_magic[] = { '\0', 'I', 'P', 'C' };
+static const uint8_t binary_version = 1;
+static const size_t binary_header_size = sizeof(binary_magic) + 1 /*version*/ + 4 /*command count*/;
+
+//////////////////////////////////////////////////////////////////////////
+// CommandArg
+//////////////////////////////////////////////////////////////////////////
+
+CommandArg::CommandArg(std::string value)
+    : m_data(std::move(value))
+{
+}
+
+CommandArg::CommandArg(const char* value)
+    : m_data(value)
+{
+}
+
+CommandArg::CommandArg(double value)
+    : m_type(Type::Float)
+    , m_float(value)
+{
+}
+
+/* static */
+CommandArg CommandArg::from_bytes(std::string data)
+{
+    CommandArg result(std::move(data));
+    result.m_type = Type::Bytes;
+    return result;
+}
+
+CommandArg::Type CommandArg::get_type() const
+{
+    return m_type;
+}
+
+int64_t CommandArg::get_int() const
+{
+    switch (m_type)
+    {
+    case Type::Int:
+        return m_int;
+    case Type::Float:
+        return static_cast<int64_t>(m_float);
+    default:
+        return std::strtoll(m_data.c_str(), nullptr, 10);
+    }
+}
+
+double CommandArg::get_float() const
+{
+    switch (m_type)
+    {
+    case Type::Int:
+        return static_cast<double>(m_int);
+    case Type::Float:
+        return m_float;
+    default:
+        return std::strtod(m_data.c_str(), nullptr);
+    }
+}
+
+std::string CommandArg::get_string() const
+{
+    switch (m_type)
+    {
+    case Type::Int:
+        return std::to_string(m_int);
+    case Type::Float:
+        return std::to_string(m_float);
+    default:
+        return m_data;
+    }
+}
+
+bool CommandArg::operator==(const CommandArg& other) const
+{
+    if (m_type != other.m_type)
+    {
+        return false;
+    }
+
+    switch (m_type)
+    {
+    case Type::Int:
+        return m_int == other.m_int;
+    case Type::Float:
+        return m_float == other.m_float;
+    default:
+        return m_data == other.m_data;
+    }
+}
+
+bool CommandArg::operator!=(const CommandArg& other) const
+{
+    return !(*this == other);
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Command
+//////////////////////////////////////////////////////////////////////////
+
 std::string Command::to_string() const
 {
     std::string result;
@@ -20,7 +127,7 @@ std::string Command::to_string() const
 
     for (const auto& arg : args)
     {
-        result += arg_splitter + arg.first + key_value_splitter + arg.second;
+        result += arg_splitter + arg.first + key_value_splitter + arg.second.get_string();
     }
 
     return result;
@@ -58,6 +165,283 @@ Command Command::from_string(const std::string& string)
     return result;
 }
 
+namespace
+{
+    class BinaryWriter
+    {
+    public:
+        BinaryWriter(std::string& out)
+            : m_out(out)
+        {
+        }
+
+        void write_u8(uint8_t value) { m_out.push_back(static_cast<char>(value)); }
+        void write_u32(uint32_t value)
+        {
+            for (int i = 0; i < 4; ++i)
+                m_out.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+        }
+        void write_u64(uint64_t value)
+        {
+            for (int i = 0; i < 8; ++i)
+                m_out.push_back(static_cast<char>((value >> (i * 8)) & 0xff));
+        }
+        void write_string(const std::string& value)
+        {
+            write_u32(static_cast<uint32_t>(value.size()));
+            m_out.append(value);
+        }
+
+    private:
+        std::string& m_out;
+    };
+
+    class BinaryReader
+    {
+    public:
+        BinaryReader(const char* data, size_t size)
+            : m_data(data)
+            , m_size(size)
+        {
+        }
+
+        bool read_u8(uint8_t& value)
+        {
+            if (m_size - m_pos < 1)
+                return false;
+            value = static_cast<uint8_t>(m_data[m_pos++]);
+            return true;
+        }
+        bool read_u32(uint32_t& value)
+        {
+            uint64_t result;
+            if (!read_le(result, 4))
+                return false;
+            value = static_cast<uint32_t>(result);
+            return true;
+        }
+        bool read_u64(uint64_t& value) { return read_le(value, 8); }
+        bool read_string(std::string& value)
+        {
+            uint32_t size;
+            if (!read_u32(size) || m_size - m_pos < size)
+                return false;
+            value.assign(m_data + m_pos, size);
+            m_pos += size;
+            return true;
+        }
+        bool at_end() const { return m_pos == m_size; }
+
+    private:
+        bool read_le(uint64_t& value, size_t bytes)
+        {
+            if (m_size - m_pos < bytes)
+                return false;
+            value = 0;
+            for (size_t i = 0; i < bytes; ++i)
+                value |= static_cast<uint64_t>(static_cast<uint8_t>(m_data[m_pos + i])) << (i * 8);
+            m_pos += bytes;
+            return true;
+        }
+
+        const char* m_data;
+        size_t m_size;
+        size_t m_pos = 0;
+    };
+};
+
+/* static */
+std::string Command::to_binary(const std::vector<Command>& commands)
+{
+    std::string result;
+    result.reserve(binary_header_size + commands.size() * 64);
+
+    BinaryWriter writer(result);
+    result.append(binary_magic, sizeof(binary_magic));
+    writer.write_u8(binary_version);
+    writer.write_u32(static_cast<uint32_t>(commands.size()));
+
+    for (const auto& command : commands)
+    {
+        writer.write_string(command.name);
+        writer.write_u32(static_cast<uint32_t>(command.args.size()));
+        for (const auto& arg : command.args)
+        {
+            writer.write_string(arg.first);
+            writer.write_u8(static_cast<uint8_t>(arg.second.m_type));
+            switch (arg.second.m_type)
+            {
+            case CommandArg::Type::Int:
+                writer.write_u64(static_cast<uint64_t>(arg.second.m_int));
+                break;
+            case CommandArg::Type::Float:
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &arg.second.m_float, sizeof(bits));
+                writer.write_u64(bits);
+                break;
+            }
+            default:
+                writer.write_string(arg.second.m_data);
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* static */
+bool Command::is_binary(const char* data, size_t size)
+{
+    return size >= sizeof(binary_magic) && std::memcmp(data, binary_magic, sizeof(binary_magic)) == 0;
+}
+
+/* static */
+bool Command::from_binary(const char* data, size_t size, std::vector<Command>& commands)
+{
+    if (!is_binary(data, size))
+    {
+        return false;
+    }
+
+    BinaryReader reader(data + sizeof(binary_magic), size - sizeof(binary_magic));
+    uint8_t version;
+    uint32_t count;
+    if (!reader.read_u8(version) || version != binary_version || !reader.read_u32(count))
+    {
+        return false;
+    }
+
+    const auto first = commands.size();
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        Command command;
+        uint32_t args_count;
+        if (!reader.read_string(command.name) || !reader.read_u32(args_count))
+        {
+            commands.resize(first);
+            return false;
+        }
+
+        for (uint32_t j = 0; j < args_count; ++j)
+        {
+            std::string key;
+            uint8_t type;
+            if (!reader.read_string(key) || !reader.read_u8(type))
+            {
+                commands.resize(first);
+                return false;
+            }
+
+            CommandArg arg;
+            bool read = false;
+            switch (static_cast<CommandArg::Type>(type))
+            {
+            case CommandArg::Type::String:
+            case CommandArg::Type::Bytes:
+                arg.m_type = static_cast<CommandArg::Type>(type);
+                read = reader.read_string(arg.m_data);
+                break;
+            case CommandArg::Type::Int:
+            {
+                uint64_t value;
+                read = reader.read_u64(value);
+                arg.m_type = CommandArg::Type::Int;
+                arg.m_int = static_cast<int64_t>(value);
+                break;
+            }
+            case CommandArg::Type::Float:
+            {
+                uint64_t bits;
+                read = reader.read_u64(bits);
+                arg.m_type = CommandArg::Type::Float;
+                std::memcpy(&arg.m_float, &bits, sizeof(bits));
+                break;
+            }
+            }
+
+            if (!read)
+            {
+                commands.resize(first);
+                return false;
+            }
+            command.args[std::move(key)] = std::move(arg);
+        }
+
+        commands.push_back(std::move(command));
+    }
+
+    if (!reader.at_end())
+    {
+        commands.resize(first);
+        return false;
+    }
+    return true;
+}
+
 IPC_NAMESPACE_CLOSE
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("IpcCommand")
+{
+    DOCTEST_TEST_CASE("binary_round_trip")
+    {
+        std::vector<ipc::Command> commands(3);
+        commands[0].name = "RenderProgress";
+        commands[0].args["frame"] = 42;
+        commands[0].args["progress"] = 0.25;
+        commands[0].args["status"] = "rendering";
+        commands[0].args["thumbnail"] = ipc::CommandArg::from_bytes(std::string("\0\1\2=\xff", 5));
+        commands[1].name = "CancelRender";
+        commands[2].name = "Crop";
+        commands[2].args["min_x"] = -10;
+
+        const auto frame = ipc::Command::to_binary(commands);
+        DOCTEST_CHECK(ipc::Command::is_binary(frame.data(), frame.size()));
+        DOCTEST_CHECK(!ipc::Command::is_binary(commands[0].to_string().data(), commands[0].to_string().size()));
+
+        std::vector<ipc::Command> decoded;
+        DOCTEST_REQUIRE(ipc::Command::from_binary(frame.data(), frame.size(), decoded));
+        DOCTEST_REQUIRE(decoded.size() == commands.size());
+        for (size_t i = 0; i < commands.size(); ++i)
+        {
+            DOCTEST_CHECK(decoded[i].name == commands[i].name);
+            DOCTEST_CHECK(decoded[i].args == commands[i].args);
+        }
+        DOCTEST_CHECK(decoded[0].args["frame"].get_type() == ipc::CommandArg::Type::Int);
+        DOCTEST_CHECK(decoded[0].args["progress"].get_float() == 0.25);
+        DOCTEST_CHECK(decoded[2].args["min_x"].get_int() == -10);
+
+        // truncated and unknown version frames are rejected without partial results
+        decoded.clear();
+        DOCTEST_CHECK(!ipc::Command::from_binary(frame.data(), frame.size() - 1, decoded));
+        auto future_frame = frame;
+        future_frame[4] = 2;
+        DOCTEST_CHECK(!ipc::Command::from_binary(future_frame.data(), future_frame.size(), decoded));
+        DOCTEST_CHECK(decoded.empty());
+    }
+
+    DOCTEST_TEST_CASE("text_compatibility")
+    {
+        ipc::Command command;
+        command.name = "ServerCreated";
+        command.args["pid"] = "1234";
+        command.args["input_port"] = 8000;
+
+        const auto parsed = ipc::Command::from_string(command.to_string());
+        DOCTEST_CHECK(parsed.name == "ServerCreated");
+        DOCTEST_CHECK(parsed.args.at("pid").get_string() == "1234");
+        DOCTEST_CHECK(parsed.args.at("input_port").get_type() == ipc::CommandArg::Type::String);
+        DOCTEST_CHECK(parsed.args.at("input_port").get_int() == 8000);
+    }
+}
@@ -9,13 +9,82 @@
 #include "opendcc/base/ipc_commands_api/api.h"
 #include "opendcc/base/ipc_commands_api/ipc.h"
 
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 OPENDCC_NAMESPACE_OPEN
 
 IPC_NAMESPACE_OPEN
 
+/**
+ * @class CommandArg
+ * @brief Typed value of an ipc command argument.
+ *
+ * Arguments received in text mode are strings, the accessors convert between the types when needed.
+ */
+class IPC_COMMANDS_API CommandArg
+{
+public:
+    /**
+     * @brief The type of the value, the numbers are a part of the binary protocol.
+     */
+    enum class Type : uint8_t
+    {
+        String = 0,
+        Int = 1,
+        Float = 2,
+        Bytes = 3
+    };
+
+    CommandArg() = default;
+    CommandArg(std::string value);
+    CommandArg(const char* value);
+    CommandArg(double value);
+    template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+    CommandArg(T value)
+        : m_type(Type::Int)
+        , m_int(static_cast<int64_t>(value))
+    {
+    }
+
+    /**
+     * @brief Creates a bytes argument, its data is passed as is by the binary protocol.
+     * @param data The raw data.
+     */
+    static CommandArg from_bytes(std::string data);
+
+    Type get_type() const;
+
+    /**
+     * @brief Returns the value as an integer, strings are parsed, 0 if it is not a number.
+     */
+    int64_t get_int() const;
+
+    /**
+     * @brief Returns the value as a floating point number, strings are parsed, 0 if it is not a number.
+     */
+    double get_float() const;
+
+    /**
+     * @brief Returns the text of numbers or the data of strings and bytes.
+     */
+    std::string get_string() const;
+
+    bool operator==(const CommandArg& other) const;
+    bool operator!=(const CommandArg& other) const;
+
+private:
+    friend struct Command;
+
+    Type m_type = Type::String;
+    int64_t m_int = 0;
+    double m_float = 0;
+    std::string m_data;
+};
+
 /**
  * @struct Command
  * @brief Structure which represents an ipc command.
@@ -30,11 +99,12 @@ struct IPC_COMMANDS_API Command
     /**
      * @brief Arguments of the command.
      */
-    std::unordered_map<std::string /* key */, std::string /* value */> args;
+    std::unordered_map<std::string /* key */, CommandArg /* value */> args;
 
     /**
      * @brief Converts the Command to its string representation.
      * @return The string representation of the Command.
+     * @note Argument types are not preserved.
      */
     std::string to_string() const;
 
@@ -44,6 +114,31 @@ struct IPC_COMMANDS_API Command
      * @return The Command.
      */
     static Command from_string(const std::string& string);
+
+    /**
+     * @brief Encodes a batch of commands to a binary frame.
+     *
+     * The frame starts with a header (a magic number which can't start a text command, the protocol version
+     * and the number of commands), followed by the commands. A command is its name and arguments,
+     * every argument is a key, a type tag and a value. Integers are little endian, strings are length prefixed.
+     * @param commands The commands to encode.
+     * @return The frame.
+     */
+    static std::string to_binary(const std::vector<Command>& commands);
+
+    /**
+     * @brief Checks if the message is a binary frame, otherwise it is a text command.
+     */
+    static bool is_binary(const char* data, size_t size);
+
+    /**
+     * @brief Decodes a binary frame created by to_binary.
+     * @param data The frame data.
+     * @param size The frame size.
+     * @param commands The decoded commands are appended to it.
+     * @return False if the frame is malformed or has an unsupported version.
+     */
+    static bool from_binary(const char* data, size_t size, std::vector<Command>& commands);
 };
 
 IPC_NAMESPACE_CLOSE
@@ -11,6 +11,8 @@
 #include "opendcc/base/defines.h"
 #include "opendcc/base/vendor/cppzmq/zmq.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <queue>
 #include <mutex>
 #include <future>
@@ -64,7 +66,8 @@ public:
         }
 
         m_input_thread = std::thread([this] { listen_commands(); });
-        m_send_thread = std::thread([this] { send_commands(); });
+        m_dispatch_thread = std::thread([this] { dispatch_commands(); });
+        m_send_thread = std::thread([this] { process_send_queue(); });
     }
 
     ~CommandServerImpl()
@@ -81,6 +84,18 @@ public:
             m_input_thread.join();
         }
 
+        if (m_dispatch_thread.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_dispatch_mutex);
+                m_stop_dispatch = true;
+            }
+
+            m_dispatch_cv.notify_all();
+
+            m_dispatch_thread.join();
+        }
+
         if (m_send_thread.joinable())
         {
             {
@@ -94,9 +109,11 @@ public:
         }
     }
 
-    void send_command(const ServerInfo& info, const Command& command)
+    void send_command(const ServerInfo& info, const Command& command) { send_commands(info, { command }); }
+
+    void send_commands(const ServerInfo& info, std::vector<Command> commands)
     {
-        if (!valid())
+        if (!valid() || commands.empty())
         {
             return;
         }
@@ -104,7 +121,7 @@ public:
         {
             SendQueueLocker lock(m_send_mutex);
 
-            m_send_queue.push({ info, command });
+            m_send_queue.push({ info, std::move(commands) });
         }
 
         m_send_cv.notify_all();
@@ -148,6 +165,7 @@ private:
         const auto wait = std::chrono::milliseconds(0);
 
         zmq::message_t message;
+        std::vector<Command> commands;
         while (m_stop_listen_future.wait_for(wait) != std::future_status::ready)
         {
             try
@@ -157,10 +175,27 @@ private:
                     continue;
                 }
 
-                const auto message_str = message.to_string();
-                const auto command = Command::from_string(message_str);
+                const auto data = message.data<char>();
+                if (Command::is_binary(data, message.size()))
+                {
+                    if (!Command::from_binary(data, message.size(), commands))
+                    {
+                        OPENDCC_ERROR("CommandServer::listen_commands: malformed or unsupported binary message.");
+                        continue;
+                    }
+                }
+                else
+                {
+                    commands.push_back(Command::from_string(message.to_string()));
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_dispatch_mutex);
+                    std::move(commands.begin(), commands.end(), std::back_inserter(m_dispatch_queue));
+                }
+                commands.clear();
 
-                CommandRegistry::instance().handle_command(command);
+                m_dispatch_cv.notify_one();
             }
             catch (const zmq::error_t& error)
             {
@@ -172,17 +207,41 @@ private:
         }
     }
 
-    void send_commands()
+    void dispatch_commands()
     {
-        const auto wait = std::chrono::milliseconds(0);
-        auto& registry = ServerRegistry::instance();
+        auto& registry = CommandRegistry::instance();
 
+        std::vector<Command> commands;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_dispatch_mutex);
+                m_dispatch_cv.wait(lock, [this] { return m_stop_dispatch || !m_dispatch_queue.empty(); });
+
+                if (m_stop_dispatch)
+                {
+                    break;
+                }
+
+                std::swap(commands, m_dispatch_queue);
+            }
+
+            for (const auto& command : commands)
+            {
+                registry.handle_command(command);
+            }
+            commands.clear();
+        }
+    }
+
+    void process_send_queue()
+    {
         SendQueue send_queue;
         while (true)
         {
             {
                 std::unique_lock<std::mutex> lock(m_send_mutex);
-                m_send_cv.wait(lock, [this, wait] { return m_stop_send || !m_send_queue.empty(); });
+                m_send_cv.wait(lock, [this] { return m_stop_send || !m_send_queue.empty(); });
                 std::swap(send_queue, m_send_queue);
 
                 if (m_stop_send)
@@ -191,35 +250,77 @@ private:
                 }
             }
 
+            // everything queued for the same server goes through one connection, keeping the order of the commands
+            std::vector<std::pair<std::string /*address*/, std::vector<Command>>> batches;
             while (!send_queue.empty())
             {
-                const auto& front = send_queue.front();
+                auto& front = send_queue.front();
                 const auto address = front.info.get_tcp_address();
-                const auto str_command = front.command.to_string();
-
-                try
+                auto batch = std::find_if(batches.begin(), batches.end(), [&address](const auto& item) { return item.first == address; });
+                if (batch == batches.end())
                 {
-                    zmq::socket_t socket(m_context, zmq::socket_type::push);
-                    socket.set(zmq::sockopt::sndtimeo, CommandServer::get_server_timeout());
-                    socket.set(zmq::sockopt::rcvtimeo, CommandServer::get_server_timeout());
-                    socket.bind(address);
-                    socket.send(str_command.begin(), str_command.end());
-                    socket.unbind(address);
-                    socket.close();
+                    batches.emplace_back(address, std::move(front.commands));
                 }
-                catch (const zmq::error_t& error)
+                else
                 {
-                    OPENDCC_ERROR("CommandServer send_command to Server ({}) end with error: {}", address, error.what());
+                    std::move(front.commands.begin(), front.commands.end(), std::back_inserter(batch->second));
+                }
+                send_queue.pop();
+            }
 
-                    if (error.num() == EADDRINUSE) // Address in use
-                    {
-                        OPENDCC_DEBUG("CommandServer:Try send again.");
-                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-                        continue;
-                    }
+            for (const auto& batch : batches)
+            {
+                send_batch(batch.first, batch.second);
+            }
+        }
+    }
+
+    void send_batch(const std::string& address, const std::vector<Command>& commands)
+    {
+        std::vector<std::string> messages;
+        if (CommandServer::get_protocol() == CommandServer::Protocol::Binary)
+        {
+            for (size_t i = 0; i < commands.size(); i += s_max_commands_per_message)
+            {
+                const auto end = std::min(commands.size(), i + s_max_commands_per_message);
+                messages.push_back(Command::to_binary(std::vector<Command>(commands.begin() + i, commands.begin() + end)));
+            }
+        }
+        else
+        {
+            for (const auto& command : commands)
+            {
+                messages.push_back(command.to_string());
+            }
+        }
+
+        while (true)
+        {
+            try
+            {
+                zmq::socket_t socket(m_context, zmq::socket_type::push);
+                socket.set(zmq::sockopt::sndtimeo, CommandServer::get_server_timeout());
+                socket.set(zmq::sockopt::rcvtimeo, CommandServer::get_server_timeout());
+                socket.bind(address);
+                for (const auto& message : messages)
+                {
+                    socket.send(message.begin(), message.end());
                 }
+                socket.unbind(address);
+                socket.close();
+                return;
+            }
+            catch (const zmq::error_t& error)
+            {
+                OPENDCC_ERROR("CommandServer send_command to Server ({}) end with error: {}", address, error.what());
 
-                send_queue.pop();
+                if (error.num() == EADDRINUSE) // Address in use
+                {
+                    OPENDCC_DEBUG("CommandServer:Try send again.");
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    continue;
+                }
+                return;
             }
         }
     }
@@ -229,6 +330,7 @@ private:
     std::string m_pid;
 
     std::thread m_input_thread;
+    std::thread m_dispatch_thread;
     std::thread m_send_thread;
 
     std::promise<void> m_stop_listen_signal;
@@ -237,13 +339,21 @@ private:
     std::condition_variable m_send_cv;
     bool m_stop_send = false;
 
+    std::mutex m_dispatch_mutex;
+    std::condition_variable m_dispatch_cv;
+    std::vector<Command> m_dispatch_queue;
+    bool m_stop_dispatch = false;
+
     zmq::context_t m_context;
     zmq::socket_t m_listener;
 
+    // large frames would delay the first handled command on the receiving side
+    static constexpr size_t s_max_commands_per_message = 1024;
+
     struct SendInfo
     {
         ServerInfo info;
-        Command command;
+        std::vector<Command> commands;
     };
     using SendQueue = std::queue<SendInfo>;
     using SendQueueLocker = std::lock_guard<std::mutex>;
@@ -276,6 +386,11 @@ void CommandServer::send_command(const std::string& pid, const Command& command)
     m_impl->send_command(pid, command);
 }
 
+void CommandServer::send_commands(const ServerInfo& info, std::vector<Command> commands)
+{
+    m_impl->send_commands(info, std::move(commands));
+}
+
 const ServerInfo& CommandServer::get_info() const
 {
     return m_impl->get_info();
@@ -298,6 +413,175 @@ int CommandServer::get_server_timeout()
     return s_server_timeout;
 }
 
+/* static */ std::atomic<CommandServer::Protocol> CommandServer::s_protocol { CommandServer::Protocol::Binary };
+
+void CommandServer::set_protocol(Protocol protocol)
+{
+    s_protocol = protocol;
+}
+
+CommandServer::Protocol CommandServer::get_protocol()
+{
+    return s_protocol;
+}
+
 IPC_NAMESPACE_CLOSE
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+
+#include "opendcc/base/utils/env.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <thread>
+
+OPENDCC_NAMESPACE_USING
+
+namespace
+{
+    // "<receiver address> <protocol> <count>", set for the sender process started by the benchmark
+    const char* s_benchmark_env = "OPENDCC_IPC_BENCHMARK_RECEIVER";
+
+    std::atomic<int> s_benchmark_handled { 0 };
+    std::atomic<int64_t> s_benchmark_first_handled { 0 };
+    std::atomic<bool> s_benchmark_done { false };
+    std::mutex s_benchmark_reply_mutex;
+    std::string s_benchmark_reply_to;
+
+    std::vector<ipc::Command> make_benchmark_commands(int count)
+    {
+        std::vector<ipc::Command> commands(count);
+        for (int i = 0; i < count; ++i)
+        {
+            commands[i].name = "ipc_benchmark";
+            commands[i].args["index"] = i;
+            commands[i].args["progress"] = i / static_cast<double>(count);
+            commands[i].args["status"] = "rendering";
+        }
+        return commands;
+    }
+
+    void handle_benchmark_command(const ipc::Command& command)
+    {
+        if (++s_benchmark_handled == 1)
+            s_benchmark_first_handled = std::chrono::steady_clock::now().time_since_epoch().count();
+
+        auto reply_to = command.args.find("reply_to");
+        if (reply_to != command.args.end())
+        {
+            std::lock_guard<std::mutex> lock(s_benchmark_reply_mutex);
+            s_benchmark_reply_to = reply_to->second.get_string();
+        }
+    }
+
+    template <class Predicate>
+    bool wait_for(std::chrono::seconds timeout, Predicate predicate)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (!predicate() && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return predicate();
+    }
+
+    // the sender runs the same tests in a new process, only commands_per_second_sender does something there
+    int run_benchmark_sender()
+    {
+        auto command = "\"" + get_executable_path() + "\" --with-tests --exit --test-case=commands_per_second_sender";
+#ifdef OPENDCC_OS_WINDOWS
+        // cmd.exe strips the outer quotes
+        command = "\"" + command + "\"";
+#endif
+        return std::system(command.c_str());
+    }
+};
+
+DOCTEST_TEST_SUITE("IpcCommandServer")
+{
+    DOCTEST_TEST_CASE("commands_per_second")
+    {
+        constexpr int count = 100000;
+        ipc::CommandRegistry::instance().add_handler("ipc_benchmark", handle_benchmark_command);
+
+        for (const auto protocol : { ipc::CommandServer::Protocol::Text, ipc::CommandServer::Protocol::Binary })
+        {
+            const auto protocol_name = protocol == ipc::CommandServer::Protocol::Binary ? "binary" : "text";
+            s_benchmark_handled = 0;
+            {
+                std::lock_guard<std::mutex> lock(s_benchmark_reply_mutex);
+                s_benchmark_reply_to.clear();
+            }
+
+            const auto previous_protocol = ipc::CommandServer::get_protocol();
+            ipc::CommandServer::set_protocol(protocol);
+            ipc::CommandServer receiver(ipc::ServerInfo { "127.0.0.1", ipc::ServerInfo::s_invalid_port });
+            DOCTEST_REQUIRE(receiver.valid());
+
+            set_env(s_benchmark_env,
+                    receiver.get_info().get_tcp_address() + " " + std::to_string(static_cast<int>(protocol)) + " " + std::to_string(count));
+            int sender_result = -1;
+            std::thread sender([&sender_result] { sender_result = run_benchmark_sender(); });
+            // the startup of the sender process is not measured, the clock starts with the first received command
+            const auto received = wait_for(std::chrono::seconds(120), [] { return s_benchmark_handled == count; });
+            const auto end = std::chrono::steady_clock::now();
+
+            std::string reply_to;
+            {
+                std::lock_guard<std::mutex> lock(s_benchmark_reply_mutex);
+                reply_to = s_benchmark_reply_to;
+            }
+            if (!reply_to.empty())
+            {
+                ipc::Command done;
+                done.name = "ipc_benchmark_done";
+                receiver.send_command(ipc::ServerInfo::from_string(reply_to), done);
+            }
+            sender.join();
+            set_env(s_benchmark_env, "");
+            ipc::CommandServer::set_protocol(previous_protocol);
+
+            DOCTEST_CHECK(received);
+            DOCTEST_CHECK(sender_result == 0);
+            const auto start = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(s_benchmark_first_handled.load()));
+            const auto seconds = std::chrono::duration<double>(end - start).count();
+            DOCTEST_MESSAGE(protocol_name << ": " << s_benchmark_handled.load() << " commands from another process in " << seconds * 1000
+                                          << " ms, " << static_cast<int64_t>(s_benchmark_handled / seconds) << " commands/s");
+        }
+    }
+
+    DOCTEST_TEST_CASE("commands_per_second_sender")
+    {
+        const auto receiver = get_env(s_benchmark_env);
+        if (receiver.empty())
+            return;
+
+        std::istringstream stream(receiver);
+        std::string address;
+        int protocol = 0;
+        int count = 0;
+        stream >> address >> protocol >> count;
+        DOCTEST_REQUIRE(count > 0);
+
+        ipc::CommandServer::set_protocol(static_cast<ipc::CommandServer::Protocol>(protocol));
+        ipc::CommandRegistry::instance().add_handler("ipc_benchmark_done", [](const ipc::Command&) { s_benchmark_done = true; });
+        ipc::CommandServer sender(ipc::ServerInfo { "127.0.0.1", ipc::ServerInfo::s_invalid_port });
+        DOCTEST_REQUIRE(sender.valid());
+
+        auto commands = make_benchmark_commands(count);
+        commands.back().args["reply_to"] = sender.get_info().get_tcp_address();
+        const auto receiver_info = ipc::ServerInfo::from_string(address);
+        for (const auto& command : commands)
+        {
+            sender.send_command(receiver_info, command);
+        }
+        // the queued commands are dropped if the server is destroyed before they are sent
+        DOCTEST_CHECK(wait_for(std::chrono::seconds(60), [] { return s_benchmark_done.load(); }));
+    }
+}
@@ -11,7 +11,9 @@
 #include "opendcc/base/ipc_commands_api/command.h"
 #include "opendcc/base/ipc_commands_api/server_info.h"
 
+#include <atomic>
 #include <memory>
+#include <vector>
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -27,12 +29,30 @@ class CommandServerImpl;
  * @class CommandServer
  * @brief The CommandServer is designed to listen to the address "tcp://info.hostname:info.input_port".
  * Upon receiving a command, the server makes an attempt of handling it by utilizing the "CommandRegistry".
+ * Commands are handled on a separate dispatch thread, so that slow handlers don't hold up receiving.
  * The CommandServer class also provides functionality for sending commands over ipc.
+ * Queued commands are sent in binary frames batching all commands for the same server,
+ * text messages with a single command each are still accepted and can be sent with Protocol::Text.
  * It uses the CommandServerImpl class for the actual implementation.
  */
 class IPC_COMMANDS_API CommandServer
 {
 public:
+    /**
+     * @brief The encoding of the sent commands.
+     */
+    enum class Protocol
+    {
+        /**
+         * @brief Command::to_binary frames with typed arguments, several commands per message.
+         */
+        Binary,
+        /**
+         * @brief Command::to_string messages, one command per message, for servers which don't read binary frames.
+         */
+        Text
+    };
+
     /**
      * @brief Constructs a CommandServer with the given server information.
      * @param info The server information.
@@ -60,6 +80,14 @@ public:
      */
     void send_command(const std::string& pid, const Command& command);
 
+    /**
+     * @brief Sends several commands over ipc to the server with the given server information.
+     * @param info The server information.
+     * @param commands The commands to send, they are handled in order.
+     * @note Does nothing if server is not reachable.
+     */
+    void send_commands(const ServerInfo& info, std::vector<Command> commands);
+
     /**
      * @brief Returns the server information.
      * @return The server information.
@@ -76,8 +104,13 @@ public:
 
     static int get_server_timeout();
 
+    static void set_protocol(Protocol protocol);
+
+    static Protocol get_protocol();
+
 private:
     static int s_server_timeout;
+    static std::atomic<Protocol> s_protocol;
 
     std::unique_ptr<CommandServerImpl> m_impl;
 };
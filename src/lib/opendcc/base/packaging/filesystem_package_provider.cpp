@@ -7,10 +7,181 @@
 #include "pxr/base/tf/pathUtils.h"
 #include "opendcc/base/vendor/ghc/filesystem.hpp"
 #include "opendcc/base/logging/logger.h"
+#include <pxr/base/js/json.h>
+#include <fstream>
 
 PXR_NAMESPACE_USING_DIRECTIVE
 OPENDCC_NAMESPACE_OPEN
 
+namespace
+{
+    static const int s_index_version = 1;
+
+    int64_t get_modification_time(const std::string& path)
+    {
+        std::error_code ec;
+        const auto time = ghc::filesystem::last_write_time(path, ec);
+        return ec ? -1 : static_cast<int64_t>(time.time_since_epoch().count());
+    }
+
+    // directories a glob pattern depends on: the directory before the first wildcard and
+    // all directories the pattern matches, adding or removing a package changes one of them
+    std::vector<std::string> get_glob_directories(const std::string& pattern)
+    {
+        std::vector<std::string> result;
+        const auto wildcard = pattern.find_first_of("*?[");
+        if (wildcard == std::string::npos)
+        {
+            result.push_back(pattern);
+            return result;
+        }
+
+        const auto separator = pattern.find_last_of("/\\", wildcard);
+        if (separator != std::string::npos)
+        {
+            result.push_back(pattern.substr(0, separator));
+        }
+        for (const auto& path : TfGlob(pattern, 0))
+        {
+            if (ghc::filesystem::is_directory(path))
+            {
+                result.push_back(path);
+            }
+        }
+        return result;
+    }
+
+    // values are stored with their type, so the package attributes are restored exactly as parsed
+    JsValue to_json(const VtValue& value)
+    {
+        JsObject result;
+        if (value.IsHolding<std::string>())
+        {
+            result["type"] = JsValue("string");
+            result["value"] = JsValue(value.UncheckedGet<std::string>());
+        }
+        else if (value.IsHolding<int64_t>())
+        {
+            result["type"] = JsValue("int");
+            result["value"] = JsValue(value.UncheckedGet<int64_t>());
+        }
+        else if (value.IsHolding<double>())
+        {
+            result["type"] = JsValue("double");
+            result["value"] = JsValue(value.UncheckedGet<double>());
+        }
+        else if (value.IsHolding<bool>())
+        {
+            result["type"] = JsValue("bool");
+            result["value"] = JsValue(value.UncheckedGet<bool>());
+        }
+        else if (value.IsHolding<VtArray<VtValue>>())
+        {
+            JsArray array;
+            for (const auto& item : value.UncheckedGet<VtArray<VtValue>>())
+            {
+                array.push_back(to_json(item));
+            }
+            result["type"] = JsValue("array");
+            result["value"] = JsValue(array);
+        }
+        else if (value.IsHolding<VtDictionary>())
+        {
+            JsObject object;
+            for (const auto& item : value.UncheckedGet<VtDictionary>())
+            {
+                object[item.first] = to_json(item.second);
+            }
+            result["type"] = JsValue("table");
+            result["value"] = JsValue(object);
+        }
+        else if (value.IsHolding<VtArray<VtDictionary>>())
+        {
+            JsArray array;
+            for (const auto& item : value.UncheckedGet<VtArray<VtDictionary>>())
+            {
+                array.push_back(to_json(VtValue(item)));
+            }
+            result["type"] = JsValue("table_array");
+            result["value"] = JsValue(array);
+        }
+        return JsValue(result);
+    }
+
+    VtValue from_json(const JsValue& json)
+    {
+        if (!json.IsObject())
+        {
+            return VtValue();
+        }
+        const auto& object = json.GetJsObject();
+        const auto type_it = object.find("type");
+        const auto value_it = object.find("value");
+        if (type_it == object.end() || value_it == object.end() || !type_it->second.IsString())
+        {
+            return VtValue();
+        }
+
+        const auto& type = type_it->second.GetString();
+        const auto& value = value_it->second;
+        if (type == "string" && value.IsString())
+        {
+            return VtValue(value.GetString());
+        }
+        else if (type == "int" && value.IsInt())
+        {
+            return VtValue(value.GetInt64());
+        }
+        else if (type == "double" && value.IsReal())
+        {
+            return VtValue(value.GetReal());
+        }
+        else if (type == "bool" && value.IsBool())
+        {
+            return VtValue(value.GetBool());
+        }
+        else if (type == "array" && value.IsArray())
+        {
+            VtArray<VtValue> array;
+            for (const auto& item : value.GetJsArray())
+            {
+                array.push_back(from_json(item));
+            }
+            return VtValue(array);
+        }
+        else if (type == "table" && value.IsObject())
+        {
+            VtDictionary dict;
+            for (const auto& item : value.GetJsObject())
+            {
+                dict[item.first] = from_json(item.second);
+            }
+            return VtValue(dict);
+        }
+        else if (type == "table_array" && value.IsArray())
+        {
+            VtArray<VtDictionary> array;
+            for (const auto& item : value.GetJsArray())
+            {
+                const auto dict = from_json(item);
+                array.push_back(dict.IsHolding<VtDictionary>() ? dict.UncheckedGet<VtDictionary>() : VtDictionary());
+            }
+            return VtValue(std::move(array));
+        }
+        return VtValue();
+    }
+
+    std::vector<std::string> to_string_vector(const JsValue& json)
+    {
+        std::vector<std::string> result;
+        if (json.IsArrayOf<std::string>())
+        {
+            result = json.GetArrayOf<std::string>();
+        }
+        return result;
+    }
+};
+
 FileSystemPackageProvider::FileSystemPackageProvider()
 {
     register_package_parser("toml", std::make_shared<TOMLParser>());
@@ -46,31 +217,66 @@ void FileSystemPackageProvider::fetch()
 
     OPENDCC_INFO("Fetching packages from the following directories: {}", glob_patterns_str);
 
-    const auto found_package_paths = TfGlob(glob_patterns, ARCH_GLOB_MARK);
+    const auto index_valid = is_index_valid(glob_patterns);
+    if (!index_valid)
+    {
+        m_index.glob_patterns = glob_patterns;
+        m_index.directories.clear();
+        for (const auto& dir : m_package_directories)
+        {
+            for (const auto& glob_dir : get_glob_directories(dir))
+            {
+                m_index.directories.emplace_back(glob_dir, get_modification_time(glob_dir));
+            }
+        }
+        m_index.package_paths = TfGlob(glob_patterns, ARCH_GLOB_MARK);
+    }
 
+    auto index_changed = !index_valid;
+    std::unordered_map<std::string, Index::Entry> indexed_packages;
     std::unordered_map<std::string, std::string> unique_packages;
-    for (const auto& path : found_package_paths)
+    for (const auto& path : m_index.package_paths)
     {
-        ghc::filesystem::path file_path(path);
-        auto parser = m_package_parsers[file_path.extension().string()];
-        if (parser)
+        const auto modification_time = get_modification_time(path);
+        PackageData data;
+        auto indexed = m_index.packages.find(path);
+        if (!m_index_path.empty() && indexed != m_index.packages.end() && indexed->second.modification_time == modification_time)
+        {
+            data = indexed->second.data;
+        }
+        else
         {
-            auto data = parser->parse(path);
-            if (data)
+            ghc::filesystem::path file_path(path);
+            auto parser = m_package_parsers[file_path.extension().string()];
+            if (parser)
             {
-                auto unique_pkg = unique_packages.emplace(data.name, path);
+                data = parser->parse(path);
+                index_changed = true;
+            }
+        }
 
-                if (!unique_pkg.second)
-                {
-                    OPENDCC_WARN("Package with name '{}' ({}) was already discovered at path '{}'. Ignoring all duplicates.", data.name, path,
-                                 unique_pkg.first->second);
-                    continue;
-                }
+        if (data)
+        {
+            indexed_packages[path] = Index::Entry { modification_time, data };
+            auto unique_pkg = unique_packages.emplace(data.name, path);
 
-                m_cached_packages.push_back(std::move(data));
+            if (!unique_pkg.second)
+            {
+                OPENDCC_WARN("Package with name '{}' ({}) was already discovered at path '{}'. Ignoring all duplicates.", data.name, path,
+                             unique_pkg.first->second);
+                continue;
             }
+
+            m_cached_packages.push_back(std::move(data));
         }
     }
+    index_changed |= indexed_packages.size() != m_index.packages.size();
+    m_index.packages = std::move(indexed_packages);
+
+    if (index_changed && !m_index_path.empty())
+    {
+        write_index();
+    }
 }
 
 const std::vector<PackageData>& FileSystemPackageProvider::get_cached_packages() const
@@ -111,4 +317,269 @@ void FileSystemPackageProvider::remove_path(const char* file_system_path)
     m_package_directories.erase(it);
 }
 
+void FileSystemPackageProvider::set_index_path(const std::string& index_path)
+{
+    m_index_path = index_path;
+    m_index = Index();
+    if (!m_index_path.empty())
+    {
+        read_index();
+    }
+}
+
+bool FileSystemPackageProvider::is_index_valid(const std::vector<std::string>& glob_patterns) const
+{
+    if (m_index_path.empty() || m_index.glob_patterns != glob_patterns)
+    {
+        return false;
+    }
+
+    for (const auto& dir : m_index.directories)
+    {
+        if (get_modification_time(dir.first) != dir.second)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FileSystemPackageProvider::read_index()
+{
+    std::ifstream input_stream(m_index_path);
+    if (!input_stream.is_open())
+    {
+        return;
+    }
+
+    JsParseError error;
+    const auto root = JsParseStream(input_stream, &error);
+    if (!root.IsObject())
+    {
+        OPENDCC_WARN("Failed to read package index '{}': {}", m_index_path, error.reason);
+        return;
+    }
+
+    const auto& root_object = root.GetJsObject();
+    const auto version = root_object.find("version");
+    if (version == root_object.end() || !version->second.IsInt() || version->second.GetInt() != s_index_version)
+    {
+        return;
+    }
+
+    Index index;
+    auto find = [](const JsObject& object, const char* key) {
+        const auto it = object.find(key);
+        return it != object.end() ? it->second : JsValue();
+    };
+
+    index.glob_patterns = to_string_vector(find(root_object, "glob_patterns"));
+    const auto directories = find(root_object, "directories");
+    if (directories.IsArray())
+    {
+        for (const auto& dir : directories.GetJsArray())
+        {
+            if (!dir.IsObject())
+            {
+                continue;
+            }
+            const auto path = find(dir.GetJsObject(), "path");
+            const auto time = find(dir.GetJsObject(), "modification_time");
+            if (path.IsString() && time.IsInt())
+            {
+                index.directories.emplace_back(path.GetString(), time.GetInt64());
+            }
+        }
+    }
+    index.package_paths = to_string_vector(find(root_object, "package_paths"));
+
+    const auto packages = find(root_object, "packages");
+    if (packages.IsArray())
+    {
+        for (const auto& package : packages.GetJsArray())
+        {
+            if (!package.IsObject())
+            {
+                continue;
+            }
+            const auto& package_object = package.GetJsObject();
+            const auto path = find(package_object, "path");
+            const auto time = find(package_object, "modification_time");
+            const auto name = find(package_object, "name");
+            const auto attributes = find(package_object, "attributes");
+            if (!path.IsString() || !time.IsInt() || !name.IsString() || !attributes.IsArray())
+            {
+                continue;
+            }
+
+            Index::Entry entry;
+            entry.modification_time = time.GetInt64();
+            entry.data.name = name.GetString();
+            entry.data.path = find(package_object, "package_path").IsString() ? find(package_object, "package_path").GetString() : std::string();
+            for (const auto& attribute : attributes.GetJsArray())
+            {
+                if (!attribute.IsObject())
+                {
+                    continue;
+                }
+                const auto attribute_name = find(attribute.GetJsObject(), "name");
+                if (attribute_name.IsString())
+                {
+                    entry.data.raw_attributes.push_back(PackageAttribute { attribute_name.GetString(), from_json(find(attribute.GetJsObject(), "value")) });
+                }
+            }
+            index.packages[path.GetString()] = std::move(entry);
+        }
+    }
+
+    m_index = std::move(index);
+}
+
+void FileSystemPackageProvider::write_index() const
+{
+    JsObject root;
+    root["version"] = JsValue(s_index_version);
+
+    JsArray glob_patterns;
+    for (const auto& pattern : m_index.glob_patterns)
+    {
+        glob_patterns.push_back(JsValue(pattern));
+    }
+    root["glob_patterns"] = JsValue(glob_patterns);
+
+    JsArray directories;
+    for (const auto& dir : m_index.directories)
+    {
+        JsObject dir_object;
+        dir_object["path"] = JsValue(dir.first);
+        dir_object["modification_time"] = JsValue(dir.second);
+        directories.push_back(JsValue(dir_object));
+    }
+    root["directories"] = JsValue(directories);
+
+    JsArray package_paths;
+    for (const auto& path : m_index.package_paths)
+    {
+        package_paths.push_back(JsValue(path));
+    }
+    root["package_paths"] = JsValue(package_paths);
+
+    JsArray packages;
+    for (const auto& package : m_index.packages)
+    {
+        JsObject package_object;
+        package_object["path"] = JsValue(package.first);
+        package_object["modification_time"] = JsValue(package.second.modification_time);
+        package_object["name"] = JsValue(package.second.data.name);
+        package_object["package_path"] = JsValue(package.second.data.path);
+
+        JsArray attributes;
+        for (const auto& attribute : package.second.data.raw_attributes)
+        {
+            JsObject attribute_object;
+            attribute_object["name"] = JsValue(attribute.name);
+            attribute_object["value"] = to_json(attribute.value);
+            attributes.push_back(JsValue(attribute_object));
+        }
+        package_object["attributes"] = JsValue(attributes);
+        packages.push_back(JsValue(package_object));
+    }
+    root["packages"] = JsValue(packages);
+
+    std::ofstream output_stream(m_index_path);
+    if (!output_stream.is_open())
+    {
+        OPENDCC_WARN("Failed to write package index '{}'.", m_index_path);
+        return;
+    }
+    JsWriteToStream(JsValue(root), output_stream);
+}
+
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+#include <algorithm>
+#include <chrono>
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("PackagingFileSystemPackageProviderTests")
+{
+    DOCTEST_TEST_CASE("discovery_index")
+    {
+        struct CountingParser : TOMLParser
+        {
+            PackageData parse(const std::string& path) override
+            {
+                ++parse_count;
+                return TOMLParser::parse(path);
+            }
+            int parse_count = 0;
+        };
+
+        char tmp_dir_str[1024] = {};
+        tmpnam(tmp_dir_str);
+        const auto tmp_dir = ghc::filesystem::path(tmp_dir_str);
+        const auto packages_dir = tmp_dir / "packages";
+        const auto index_path = (tmp_dir / "package_index.json").string();
+        auto write_package = [&packages_dir](const std::string& name, const std::string& text) {
+            ghc::filesystem::create_directories(packages_dir / name);
+            std::ofstream out((packages_dir / name / "package.toml").string());
+            out << "[base]\nname = '" << name << "'\n" << text;
+        };
+        auto touch = [](const ghc::filesystem::path& path) {
+            ghc::filesystem::last_write_time(path, ghc::filesystem::last_write_time(path) + std::chrono::seconds(2));
+        };
+        auto fetch = [&packages_dir, &index_path](int& parse_count) {
+            auto parser = std::make_shared<CountingParser>();
+            FileSystemPackageProvider provider;
+            provider.register_package_parser("toml", parser);
+            provider.add_path((packages_dir.generic_string() + "/*").c_str());
+            provider.set_index_path(index_path);
+            provider.fetch();
+            parse_count = parser->parse_count;
+            auto packages = provider.get_cached_packages();
+            std::sort(packages.begin(), packages.end(), [](const PackageData& left, const PackageData& right) { return left.name < right.name; });
+            return packages;
+        };
+
+        write_package("a", "[native]\nload = [{ path = 'liba.so' }]\n");
+        write_package("b", "[dependencies]\na = {}\n[python]\nimport = [{ module = 'b' }]\nvalue = 3.5\nflag = true\n");
+
+        int parse_count = 0;
+        const auto parsed = fetch(parse_count);
+        DOCTEST_CHECK_EQ(parse_count, 2);
+        DOCTEST_REQUIRE_EQ(parsed.size(), 2);
+        DOCTEST_CHECK(ghc::filesystem::exists(index_path));
+
+        const auto indexed = fetch(parse_count);
+        DOCTEST_CHECK_EQ(parse_count, 0);
+        DOCTEST_REQUIRE_EQ(indexed.size(), 2);
+        for (size_t i = 0; i < parsed.size(); ++i)
+        {
+            DOCTEST_CHECK_EQ(indexed[i].name, parsed[i].name);
+            DOCTEST_CHECK_EQ(indexed[i].path, parsed[i].path);
+            DOCTEST_REQUIRE_EQ(indexed[i].raw_attributes.size(), parsed[i].raw_attributes.size());
+            for (size_t j = 0; j < parsed[i].raw_attributes.size(); ++j)
+            {
+                DOCTEST_CHECK_EQ(indexed[i].raw_attributes[j].name, parsed[i].raw_attributes[j].name);
+                DOCTEST_CHECK_EQ(indexed[i].raw_attributes[j].value, parsed[i].raw_attributes[j].value);
+            }
+        }
+
+        // only the changed package is parsed again
+        write_package("a", "[native]\nload = [{ path = 'liba2.so' }]\n");
+        touch(packages_dir / "a" / "package.toml");
+        DOCTEST_CHECK_EQ(fetch(parse_count).size(), 2);
+        DOCTEST_CHECK_EQ(parse_count, 1);
+
+        // a new package directory changes the modification time of the packages directory
+        write_package("c", "");
+        touch(packages_dir);
+        DOCTEST_CHECK_EQ(fetch(parse_count).size(), 3);
+        DOCTEST_CHECK_EQ(parse_count, 1);
+
+        ghc::filesystem::remove_all(tmp_dir);
+    }
+}
@@ -28,11 +28,40 @@ public:
     void register_package_parser(const std::string& extension, const std::shared_ptr<PackageParser>& parser);
     void add_path(const char* package_directory);
     void remove_path(const char* package_directory);
+    /**
+     * @brief Sets the file the package discovery index is stored in.
+     *
+     * The index keeps the package files found in the package directories and their parsed data.
+     * The package directories are globbed again only if the modification time of a directory has changed,
+     * and only the package files with a new modification time are parsed again.
+     * An empty path disables the index.
+     */
+    void set_index_path(const std::string& index_path);
 
 private:
+    struct Index
+    {
+        struct Entry
+        {
+            int64_t modification_time = 0;
+            PackageData data;
+        };
+
+        std::vector<std::string> glob_patterns;
+        std::vector<std::pair<std::string, int64_t>> directories;
+        std::vector<std::string> package_paths;
+        std::unordered_map<std::string, Entry> packages;
+    };
+
+    bool is_index_valid(const std::vector<std::string>& glob_patterns) const;
+    void read_index();
+    void write_index() const;
+
     std::unordered_map<std::string, std::shared_ptr<PackageParser>> m_package_parsers;
     std::vector<std::string> m_package_directories;
     std::vector<PackageData> m_cached_packages;
+    std::string m_index_path;
+    Index m_index;
 };
 
 OPENDCC_NAMESPACE_CLOSE
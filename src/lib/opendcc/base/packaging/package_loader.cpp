@@ -18,6 +18,12 @@ PXR_NAMESPACE_USING_DIRECTIVE
 #include "opendcc/base/utils/string_utils.h"
 #include "opendcc/base/utils/env.h"
 #include "opendcc/base/utils/file_system.h"
+#include <pxr/base/js/json.h>
+#include <pxr/base/work/dispatcher.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <unordered_set>
 
 using namespace pybind11;
 OPENDCC_NAMESPACE_OPEN
@@ -34,6 +40,40 @@ namespace
         return result;
     }
 
+    static const std::string s_native_loads = "native.load";
+    static const std::string s_native_entry_points = "native.entry_point";
+
+    void* open_library(const std::string& path)
+    {
+#ifdef OPENDCC_OS_WINDOWS
+        return dl_open(path, LOAD_WITH_ALTERED_SEARCH_PATH);
+#else
+        return dl_open(path, RTLD_NOW);
+#endif
+    }
+
+    std::vector<std::string> get_native_library_paths(const PackageSharedData& pkg_data)
+    {
+        std::vector<std::string> result;
+        for (const auto& col : { s_native_loads, s_native_entry_points })
+        {
+            for (const auto& lib : pkg_data.get_resolved<VtArray<VtDictionary>>(col))
+            {
+                auto it = lib.find("path");
+                if (it != lib.end() && it->second.IsHolding<std::string>())
+                {
+                    result.push_back(make_absolute_path(pkg_data.root_dir, it->second.UncheckedGet<std::string>()).string());
+                }
+            }
+        }
+        return result;
+    }
+
+    double elapsed_ms(const std::chrono::steady_clock::time_point& start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
     class PyLock
     {
     public:
@@ -79,116 +119,321 @@ PackageLoader::~PackageLoader() {}
 
 bool PackageLoader::load(const std::string& pkg_name)
 {
-    auto data_it = m_pkg_shared_data.find(pkg_name);
-    if (data_it == m_pkg_shared_data.end())
+    return load(std::vector<std::string> { pkg_name });
+}
+
+bool PackageLoader::load(const std::vector<std::string>& pkg_names)
+{
+    auto result = true;
+
+    // packages to load in dependency order and the requested package each of them is loaded for
+    std::vector<std::shared_ptr<PackageSharedData>> packages;
+    std::vector<std::string> requested_by;
+    std::unordered_set<std::string> queued;
+    for (const auto& pkg_name : pkg_names)
     {
-        OPENDCC_ERROR("Failed to load package '{}': package is unknown.", pkg_name);
-        return false;
+        auto data_it = m_pkg_shared_data.find(pkg_name);
+        if (data_it == m_pkg_shared_data.end())
+        {
+            OPENDCC_ERROR("Failed to load package '{}': package is unknown.", pkg_name);
+            result = false;
+            continue;
+        }
+
+        auto& data = data_it->second;
+        if (data->loaded)
+        {
+            continue;
+        }
+
+        auto deps = m_pkg_resolver->get_dependencies(data->name);
+
+        if (deps.empty())
+        {
+            OPENDCC_ERROR("Failed to load package '{}'.", pkg_name);
+            result = false;
+            continue;
+        }
+
+        std::vector<std::shared_ptr<PackageSharedData>> deps_data;
+        deps_data.reserve(deps.size());
+        for (const auto& dep : deps)
+        {
+            auto it = m_pkg_shared_data.find(dep);
+            if (it == m_pkg_shared_data.end())
+            {
+                OPENDCC_ERROR("Failed to load package '{}': package data for '{}' is not found.", pkg_name, dep);
+                break;
+            }
+            deps_data.push_back(it->second);
+        }
+        if (deps_data.size() != deps.size())
+        {
+            result = false;
+            continue;
+        }
+
+        for (const auto& pkg_data : deps_data)
+        {
+            if (!pkg_data->loaded && queued.insert(pkg_data->name).second)
+            {
+                packages.push_back(pkg_data);
+                requested_by.push_back(pkg_name);
+            }
+        }
     }
 
-    auto& data = data_it->second;
-    if (data->loaded)
+    if (packages.empty())
     {
-        return true;
+        return result;
     }
 
-    auto deps = m_pkg_resolver->get_dependencies(data->name);
+    std::vector<PackageLoadTiming> timings(packages.size());
+    std::vector<bool> skipped(packages.size(), false);
+    std::unordered_set<std::string> failed;
+    for (size_t i = 0; i < packages.size(); ++i)
+    {
+        const auto& pkg_data = packages[i];
+        timings[i].name = pkg_data->name;
 
-    if (deps.empty())
+        // packages that depend on a failed package are not loaded
+        for (const auto& dep : pkg_data->direct_dependencies)
+        {
+            if (failed.find(dep.first) != failed.end())
+            {
+                skipped[i] = true;
+                break;
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        OPENDCC_INFO("Loading package '{}'", pkg_data->name);
+        if (skipped[i] || !prepare_environment(pkg_data, requested_by[i]))
+        {
+            skipped[i] = true;
+            failed.insert(pkg_data->name);
+            result = false;
+        }
+        timings[i].environment_ms = elapsed_ms(start);
+    }
+
+    // opening a library runs its static initialization, the libraries of independent packages are opened concurrently,
+    // load_cpp_libs then reopens them from the loaded modules
+    std::vector<std::vector<void*>> opened_libs;
+    if (m_parallel_native_loading)
     {
-        OPENDCC_ERROR("Failed to load package '{}'.", pkg_name);
-        return false;
+        opened_libs = open_native_libs(packages, skipped, timings);
     }
 
-    for (const auto& dep : deps)
+    for (size_t i = 0; i < packages.size(); ++i)
     {
-        auto it = m_pkg_shared_data.find(dep);
-        if (it == m_pkg_shared_data.end())
+        if (skipped[i])
         {
-            OPENDCC_ERROR("Failed to load package '{}': package data for '{}' is not found.", pkg_name, dep);
-            return false;
+            continue;
         }
 
-        const auto& pkg_data = it->second;
-        if (pkg_data->loaded)
+        const auto& pkg_data = packages[i];
+        auto load_cpp = [this, &pkg_data, &timing = timings[i]] {
+            const auto start = std::chrono::steady_clock::now();
+            load_cpp_libs(pkg_data);
+            timing.native_initialize_ms = elapsed_ms(start);
+        };
+        auto load_python = [this, &pkg_data, &timing = timings[i]] {
+            const auto start = std::chrono::steady_clock::now();
+            load_python_modules(pkg_data);
+            timing.python_ms = elapsed_ms(start);
+        };
+
+        const auto first_entry_point = pkg_data->get_resolved("base.first_entry_point", "cpp");
+        if (first_entry_point == "cpp")
         {
-            continue;
+            load_cpp();
+            load_python();
         }
+        else if (first_entry_point == "python")
+        {
+            load_python();
+            load_cpp();
+        }
+        pkg_data->loaded = true;
+    }
 
-        OPENDCC_INFO("Loading package '{}'", pkg_data->name);
-        // extend python environment modules because C++ code might depend on it, in theory
-        if (!extend_python_path(pkg_data->root_dir, pkg_name, pkg_data->name))
+    for (const auto& libs : opened_libs)
+    {
+        for (auto handle : libs)
         {
-            return false;
+            dl_close(handle);
         }
+    }
+
+    m_load_profile.insert(m_load_profile.end(), timings.begin(), timings.end());
+    return result;
+}
 
-        const auto& environment = pkg_data->get_resolved<VtDictionary>("environment");
-        if (!environment.empty())
+bool PackageLoader::prepare_environment(const std::shared_ptr<PackageSharedData>& pkg_data, const std::string& pkg_name) const
+{
+    // extend python environment modules because C++ code might depend on it, in theory
+    if (!extend_python_path(pkg_data->root_dir, pkg_name, pkg_data->name))
+    {
+        return false;
+    }
+
+    const auto& environment = pkg_data->get_resolved<VtDictionary>("environment");
+    if (!environment.empty())
+    {
+        for (const auto& attr : environment)
         {
-            for (const auto& attr : environment)
+            const auto& env_name = attr.first;
+            // PYTHONPATH is handled in different way below
+            if (env_name == "PYTHONPATH")
             {
-                const auto& env_name = attr.first;
-                // PYTHONPATH is handled in different way below
-                if (env_name == "PYTHONPATH")
-                {
-                    continue;
-                }
+                continue;
+            }
 
-                const auto& vals = attr.second.Get<VtArray<VtDictionary>>();
-                // TODO: revisit it, make more clever design with append/prepend to variable, etc
-                // for now support only for PYTHONPATH and PATH. Prepend new values for PATH
-                if (env_name != "PATH")
+            const auto& vals = attr.second.Get<VtArray<VtDictionary>>();
+            // TODO: revisit it, make more clever design with append/prepend to variable, etc
+            // for now support only for PYTHONPATH and PATH. Prepend new values for PATH
+            if (env_name != "PATH")
+            {
+                continue;
+            }
+
+            auto cur_env_var_value = get_env(env_name);
+            for (const auto& val : vals)
+            {
+                const auto env_val = val.GetValueAtPath("value");
+                if (!env_val)
                 {
+                    OPENDCC_WARN("Failed to extend environment variable '{}' for package '{}': 'value' entry not found.", env_name, pkg_data->name);
                     continue;
                 }
 
-                auto cur_env_var_value = get_env(env_name);
-                for (const auto& val : vals)
-                {
-                    const auto env_val = val.GetValueAtPath("value");
-                    if (!env_val)
-                    {
-                        OPENDCC_WARN("Failed to extend environment variable '{}' for package '{}': 'value' entry not found.", env_name, dep);
-                        continue;
-                    }
-
-                    const auto path = make_absolute_path(pkg_data->root_dir, env_val->Get<std::string>()).string();
-                    cur_env_var_value = path + OPENDCC_PATH_LIST_SEPARATOR + cur_env_var_value;
-                }
-                set_env(env_name, cur_env_var_value);
+                const auto path = make_absolute_path(pkg_data->root_dir, env_val->Get<std::string>()).string();
+                cur_env_var_value = path + OPENDCC_PATH_LIST_SEPARATOR + cur_env_var_value;
             }
+            set_env(env_name, cur_env_var_value);
         }
+    }
 
-        const auto& pythonpath_env = pkg_data->get_resolved<VtArray<VtDictionary>>("environment.PYTHONPATH");
-        for (const auto& env_entry : pythonpath_env)
+    const auto& pythonpath_env = pkg_data->get_resolved<VtArray<VtDictionary>>("environment.PYTHONPATH");
+    for (const auto& env_entry : pythonpath_env)
+    {
+        const auto env_val = env_entry.GetValueAtPath("value");
+        if (!env_val)
+        {
+            OPENDCC_WARN("Failed to extend Python environment for package '{}': 'value' entry not found.", pkg_data->name);
+            continue;
+        }
+        auto path = make_absolute_path(pkg_data->root_dir, env_val->Get<std::string>());
+        if (!extend_python_path(path.lexically_normal().generic_string(), pkg_name, pkg_data->name))
+        {
+            continue;
+        }
+    }
+    return true;
+}
+
+std::vector<std::vector<void*>> PackageLoader::open_native_libs(const std::vector<std::shared_ptr<PackageSharedData>>& packages,
+                                                                const std::vector<bool>& skipped, std::vector<PackageLoadTiming>& timings) const
+{
+    const auto count = packages.size();
+    std::vector<std::vector<void*>> result(count);
+
+    std::unordered_map<std::string, size_t> indices;
+    for (size_t i = 0; i < count; ++i)
+    {
+        indices[packages[i]->name] = i;
+    }
+
+    // a package is opened when the packages it depends on in this batch are opened
+    std::vector<std::vector<size_t>> dependees(count);
+    std::unique_ptr<std::atomic<size_t>[]> pending_deps(new std::atomic<size_t>[count]);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t deps_count = 0;
+        for (const auto& dep : packages[i]->direct_dependencies)
         {
-            const auto env_val = env_entry.GetValueAtPath("value");
-            if (!env_val)
+            auto it = indices.find(dep.first);
+            if (it != indices.end())
             {
-                OPENDCC_WARN("Failed to extend Python environment for package '{}': 'value' entry not found.", dep);
-                continue;
+                dependees[it->second].push_back(i);
+                ++deps_count;
             }
-            auto path = make_absolute_path(pkg_data->root_dir, env_val->Get<std::string>());
-            if (!extend_python_path(path.lexically_normal().generic_string(), pkg_name, pkg_data->name))
+        }
+        pending_deps[i] = deps_count;
+    }
+
+    WorkDispatcher dispatcher;
+    std::function<void(size_t)> open = [&](size_t i) {
+        if (!skipped[i])
+        {
+            const auto start = std::chrono::steady_clock::now();
+            for (const auto& path : get_native_library_paths(*packages[i]))
             {
-                continue;
+                // errors are reported when the library is loaded by load_cpp_libs
+                if (auto handle = open_library(path))
+                {
+                    result[i].push_back(handle);
+                }
             }
+            timings[i].native_open_ms = elapsed_ms(start);
         }
 
-        const auto first_entry_point = pkg_data->get_resolved("base.first_entry_point", "cpp");
-        if (first_entry_point == "cpp")
+        for (auto dependee : dependees[i])
         {
-            load_cpp_libs(pkg_data);
-            load_python_modules(pkg_data);
+            if (--pending_deps[dependee] == 0)
+            {
+                dispatcher.Run([&open, dependee] { open(dependee); });
+            }
         }
-        else if (first_entry_point == "python")
+    };
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (pending_deps[i] == 0)
         {
-            load_python_modules(pkg_data);
-            load_cpp_libs(pkg_data);
+            dispatcher.Run([&open, i] { open(i); });
         }
-        pkg_data->loaded = true;
     }
+    dispatcher.Wait();
+    return result;
+}
+
+void PackageLoader::set_parallel_native_loading(bool enable)
+{
+    m_parallel_native_loading = enable;
+}
 
+const std::vector<PackageLoadTiming>& PackageLoader::get_load_profile() const
+{
+    return m_load_profile;
+}
+
+bool PackageLoader::write_load_profile(const std::string& path) const
+{
+    auto file_stream = std::ofstream(path);
+    if (!file_stream.is_open())
+    {
+        OPENDCC_ERROR("Failed to write package load profile to '{}'.", path);
+        return false;
+    }
+
+    JsWriter writer(file_stream, JsWriter::Style::Pretty);
+    writer.BeginObject();
+    writer.WriteKey("packages");
+    writer.BeginArray();
+    for (const auto& timing : m_load_profile)
+    {
+        writer.BeginObject();
+        writer.WriteKeyValue("name", timing.name);
+        writer.WriteKeyValue("environment_ms", timing.environment_ms);
+        writer.WriteKeyValue("native_open_ms", timing.native_open_ms);
+        writer.WriteKeyValue("native_initialize_ms", timing.native_initialize_ms);
+        writer.WriteKeyValue("python_ms", timing.python_ms);
+        writer.EndObject();
+    }
+    writer.EndArray();
+    writer.EndObject();
     return true;
 }
 
@@ -396,10 +641,7 @@ bool PackageLoader::extend_python_path(const std::string& path, const std::strin
 
 bool PackageLoader::load_cpp_libs(const std::shared_ptr<PackageSharedData>& pkg_data)
 {
-    static const std::string native_loads = "native.load";
-    static const std::string native_entry_points = "native.entry_point";
-
-    for (const auto& col : { native_loads, native_entry_points })
+    for (const auto& col : { s_native_loads, s_native_entry_points })
     {
         const auto& libs = pkg_data->get_resolved<VtArray<VtDictionary>>(col);
         for (const auto& lib : libs)
@@ -415,13 +657,9 @@ bool PackageLoader::load_cpp_libs(const std::shared_ptr<PackageSharedData>& pkg_
             const auto path = make_absolute_path(pkg_data->root_dir, it->second.Get<std::string>());
 
             OPENDCC_INFO("Loading library '{}'...", path.string());
-#ifdef OPENDCC_OS_WINDOWS
-            if (auto handle = dl_open(path.string(), LOAD_WITH_ALTERED_SEARCH_PATH))
-#else
-            if (auto handle = dl_open(path.string(), RTLD_NOW))
-#endif
+            if (auto handle = open_library(path.string()))
             {
-                if (col == native_entry_points)
+                if (col == s_native_entry_points)
                 {
                     auto pkg_entry_point_fn = reinterpret_cast<PackageEntryPoint* (*)()>(dl_sym(handle, "opendcc_package_entry_point"));
                     if (!pkg_entry_point_fn)
@@ -480,10 +718,11 @@ bool PackageLoader::load_cpp_libs(const std::shared_ptr<PackageSharedData>& pkg_
 
 OPENDCC_NAMESPACE_CLOSE
 
-#ifdef OPENDCC_OS_WINDOWS
 #define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
 #define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#ifdef OPENDCC_OS_WINDOWS
 #define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#endif
 #include <doctest/doctest.h>
 OPENDCC_NAMESPACE_USING
 
@@ -491,6 +730,7 @@ using namespace pybind11;
 
 DOCTEST_TEST_SUITE("PackagingPackageLoader")
 {
+#ifdef OPENDCC_OS_WINDOWS
     DOCTEST_TEST_CASE("load")
     {
         char tmp_dir_str[1024] = {};
@@ -611,7 +851,92 @@ class SecondEntryPoint(PackageEntryPoint):
             DOCTEST_CHECK(!GetModuleHandle("packaging_tests_b"));
         }
 
+        DOCTEST_SUBCASE("parallel_native_loading")
+        {
+            package_loader->set_parallel_native_loading(true);
+            DOCTEST_CHECK(package_loader->load("test_name"));
+
+            auto hndl1 = GetModuleHandle("packaging_tests_a");
+            auto hndl2 = GetModuleHandle("packaging_tests_b");
+            DOCTEST_REQUIRE(hndl1);
+            DOCTEST_REQUIRE(hndl2);
+            // the libraries opened on the worker threads are initialized once by load_cpp_libs
+            DOCTEST_CHECK(*reinterpret_cast<int*>(dl_sym(hndl1, "s_entry_point_checker")) == 1);
+            DOCTEST_CHECK(*reinterpret_cast<int*>(dl_sym(hndl2, "s_entry_point_checker")) == 1);
+            DOCTEST_CHECK(package_loader->get_load_profile().size() == 1);
+
+            DOCTEST_CHECK(package_loader->unload("test_name"));
+            DOCTEST_CHECK(!GetModuleHandle("packaging_tests_a"));
+            DOCTEST_CHECK(!GetModuleHandle("packaging_tests_b"));
+        }
+
         std::remove(tmp_dir_str);
     }
-}
 #endif
+
+    DOCTEST_TEST_CASE("parallel_load_profile")
+    {
+        std::unique_ptr<scoped_interpreter> interpreter;
+        if (!Py_IsInitialized())
+        {
+            interpreter = std::make_unique<scoped_interpreter>();
+        }
+
+        const auto tmp_dir = ghc::filesystem::temp_directory_path();
+        auto make_package = [&tmp_dir](const std::string& name, const std::vector<std::string>& dependencies) {
+            auto pkg_data = std::make_shared<PackageSharedData>();
+            pkg_data->name = name;
+            pkg_data->loaded = false;
+            pkg_data->root_dir = tmp_dir.lexically_normal().generic_string();
+            pkg_data->resolved_attributes.SetValueAtPath("base.name", VtValue(name), ".");
+            for (const auto& dep : dependencies)
+            {
+                pkg_data->direct_dependencies[dep] = VtValue(std::string());
+            }
+            return pkg_data;
+        };
+
+        // a diamond, the packages in the middle are independent of each other
+        std::unordered_map<std::string, std::shared_ptr<PackageSharedData>> pkg_shared_data;
+        pkg_shared_data["profile_base"] = make_package("profile_base", {});
+        pkg_shared_data["profile_left"] = make_package("profile_left", { "profile_base" });
+        pkg_shared_data["profile_right"] = make_package("profile_right", { "profile_base" });
+        pkg_shared_data["profile_top"] = make_package("profile_top", { "profile_left", "profile_right" });
+        auto package_resolver = std::make_shared<PackageResolver>();
+        package_resolver->set_packages(pkg_shared_data);
+        PackageLoader package_loader(package_resolver, pkg_shared_data);
+        package_loader.set_parallel_native_loading(true);
+
+        DOCTEST_CHECK(package_loader.load(std::vector<std::string> { "profile_top" }));
+        for (const auto& entry : pkg_shared_data)
+        {
+            DOCTEST_CHECK(entry.second->loaded);
+        }
+
+        const auto& profile = package_loader.get_load_profile();
+        DOCTEST_REQUIRE(profile.size() == 4);
+        DOCTEST_CHECK(profile.front().name == "profile_base");
+        DOCTEST_CHECK(profile.back().name == "profile_top");
+
+        const auto profile_path = (tmp_dir / "opendcc_package_load_profile.json").generic_string();
+        DOCTEST_REQUIRE(package_loader.write_load_profile(profile_path));
+        {
+            std::ifstream profile_stream(profile_path);
+            const auto json = JsParseStream(profile_stream);
+            DOCTEST_REQUIRE(json.IsObject());
+            const auto& root = json.GetJsObject();
+            auto packages_it = root.find("packages");
+            DOCTEST_REQUIRE(packages_it != root.end());
+            DOCTEST_REQUIRE(packages_it->second.IsArray());
+            const auto& packages = packages_it->second.GetJsArray();
+            DOCTEST_REQUIRE(packages.size() == 4);
+            const auto& first = packages[0].GetJsObject();
+            DOCTEST_CHECK(first.at("name").GetString() == "profile_base");
+            for (const auto& key : { "environment_ms", "native_open_ms", "native_initialize_ms", "python_ms" })
+            {
+                DOCTEST_CHECK(first.count(key) == 1);
+            }
+        }
+        ghc::filesystem::remove(profile_path);
+    }
+}
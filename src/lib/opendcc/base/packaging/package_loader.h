@@ -12,6 +12,15 @@
 
 OPENDCC_NAMESPACE_OPEN
 
+struct PackageLoadTiming
+{
+    std::string name;
+    double environment_ms = 0;
+    double native_open_ms = 0;
+    double native_initialize_ms = 0;
+    double python_ms = 0;
+};
+
 class PackageLoader
 {
 public:
@@ -20,9 +29,24 @@ public:
     ~PackageLoader();
 
     bool load(const std::string& pkg_name);
+    /**
+     * @brief Loads the packages and their dependencies.
+     *
+     * With parallel native loading the native libraries of the packages are opened on worker threads,
+     * a library is opened after the libraries of the package dependencies. Entry points are initialized
+     * and Python modules are imported on the calling thread in dependency order.
+     */
+    bool load(const std::vector<std::string>& pkg_names);
     bool unload(const std::string& pkg_name);
 
+    void set_parallel_native_loading(bool enable);
+    const std::vector<PackageLoadTiming>& get_load_profile() const;
+    bool write_load_profile(const std::string& path) const;
+
 private:
+    bool prepare_environment(const std::shared_ptr<PackageSharedData>& pkg_data, const std::string& pkg_name) const;
+    std::vector<std::vector<void*>> open_native_libs(const std::vector<std::shared_ptr<PackageSharedData>>& packages,
+                                                     const std::vector<bool>& skipped, std::vector<PackageLoadTiming>& timings) const;
     bool load_cpp_libs(const std::shared_ptr<PackageSharedData>& pkg_data);
     bool load_python_modules(const std::shared_ptr<PackageSharedData>& pkg_data);
 
@@ -32,6 +56,9 @@ private:
 
     std::shared_ptr<PackageResolver> m_pkg_resolver;
     std::unordered_map<std::string, std::shared_ptr<PackageSharedData>>& m_pkg_shared_data;
+    std::vector<PackageLoadTiming> m_load_profile;
+    // the static initializers of the libraries write to unsynchronized registries
+    bool m_parallel_native_loading = false;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -11,6 +11,7 @@
 #include "opendcc/base/packaging/toml_parser.h"
 #include "pxr/base/vt/dictionary.h"
 #include "opendcc/base/packaging/package_entry_point.h"
+#include "opendcc/base/utils/env.h"
 #include <regex>
 
 PXR_NAMESPACE_USING_DIRECTIVE
@@ -45,13 +46,31 @@ void PackageRegistry::fetch_packages(bool load_fetched)
     initialize_package_data();
     m_package_resolver->set_packages(m_package_shared_data);
 
+    std::vector<std::string> pkg_names;
     for (const auto& pkg_data : m_package_shared_data)
     {
         if (load_fetched || pkg_data.second->get_resolved("base.autoload", false))
         {
-            load(Package(pkg_data.second));
+            pkg_names.push_back(pkg_data.first);
         }
     }
+    m_package_loader->load(pkg_names);
+
+    const auto profile_path = get_env("OPENDCC_PACKAGE_LOAD_PROFILE");
+    if (!profile_path.empty())
+    {
+        write_load_profile(profile_path);
+    }
+}
+
+void PackageRegistry::set_parallel_native_loading(bool enable)
+{
+    m_package_loader->set_parallel_native_loading(enable);
+}
+
+bool PackageRegistry::write_load_profile(const std::string& path) const
+{
+    return m_package_loader->write_load_profile(path);
 }
 
 bool PackageRegistry::undefine_token(const std::string& token_name)
@@ -37,6 +37,21 @@ public:
     bool define_token(const std::string& token_name, const std::string& token_value);
     bool undefine_token(const std::string& token_name);
 
+    /**
+     * @brief Enables opening the native libraries of independent packages in parallel, disabled by default.
+     *
+     * Opening a library runs its static initializers. Most of the registries filled by them,
+     * e.g. the tool settings views, aren't synchronized, so this is only safe for the package sets
+     * whose libraries don't register anything during static initialization.
+     */
+    void set_parallel_native_loading(bool enable);
+    /**
+     * @brief Writes the load timings of the packages loaded so far to a JSON file.
+     *
+     * The profile is also written after fetch_packages to the path set in OPENDCC_PACKAGE_LOAD_PROFILE.
+     */
+    bool write_load_profile(const std::string& path) const;
+
 private:
     void initialize_package_data();
     std::tuple<std::string, PXR_NS::VtValue> resolve_tokens(const PackageAttribute& raw_attr) const;
@@ -53,6 +53,8 @@ PYBIND11_MODULE(PYMODULE_NAME, m)
         .def("get_package", &PackageRegistry::get_package, "name"_a)
         .def("define_token", &PackageRegistry::define_token, "token_name"_a, "token_value"_a)
         .def("undefine_token", &PackageRegistry::undefine_token, "token_name"_a)
+        .def("set_parallel_native_loading", &PackageRegistry::set_parallel_native_loading, "enable"_a)
+        .def("write_load_profile", &PackageRegistry::write_load_profile, "path"_a)
         .def("load", overload_cast<const std::string&>(&PackageRegistry::load), "pkg_name"_a)
         .def("load", overload_cast<const Package&>(&PackageRegistry::load), "pkg"_a);
 
@@ -66,7 +68,8 @@ PYBIND11_MODULE(PYMODULE_NAME, m)
         .def("get_cached_packages", &FileSystemPackageProvider::get_cached_packages)
         .def("register_package_parser", &FileSystemPackageProvider::register_package_parser)
         .def("add_path", &FileSystemPackageProvider::add_path)
-        .def("remove_path", &FileSystemPackageProvider::remove_path);
+        .def("remove_path", &FileSystemPackageProvider::remove_path)
+        .def("set_index_path", &FileSystemPackageProvider::set_index_path, "index_path"_a);
 
     class_<PackageAttribute>(m, "PackageAttribute").def_readwrite("name", &PackageAttribute::name).def_readwrite("value", &PackageAttribute::value);
 
@@ -5,6 +5,9 @@
 #include <vector>
 #include "opendcc/render_view/display_driver_api/display_driver_api.h"
 #include <memory.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -191,100 +194,219 @@ namespace display_driver_api
 
     int32_t render_view_write_region(RenderViewConnection& connection, const int32_t image_id, const ROI& region, size_t pixel_size,
                                      const unsigned char* data)
+    {
+        const size_t data_size = (region.xend - region.xstart) * (region.yend - region.ystart) * pixel_size;
+        return render_view_write_region(connection, image_id, region, std::vector<char>(data, data + data_size));
+    }
+
+    int32_t render_view_write_region(RenderViewConnection& connection, const int32_t image_id, const ROI& region, std::vector<char>&& data)
     {
         Message msg;
         msg.type = Message::Type::WriteRegion;
         msg.image_id = image_id;
         msg.region = region;
+        msg.bucket_data = std::move(data);
 
-        size_t data_size = (region.xend - region.xstart) * (region.yend - region.ystart) * pixel_size;
-        msg.bucket_data.resize(data_size / sizeof(unsigned char));
-
-        memcpy(msg.bucket_data.data(), data, data_size);
-
-        connection.send_msg(msg);
-        return connection.recv_msg();
+        return connection.post_msg(std::move(msg));
     }
 
     static void* shared_zmq_context = nullptr;
     static int shared_zmq_context_ref = 0;
+    static std::mutex shared_zmq_context_mutex;
+
+    static const int32_t s_timeout_error = -1;
 
     class RenderViewConnectionImpl
     {
+        struct PendingReply
+        {
+            PostedMessage message;
+            // replies to requests are returned by recv_msg, a late one is only skipped
+            bool posted;
+        };
+
         void* m_context = nullptr;
         void* m_socket = nullptr;
+        std::deque<PendingReply> m_pending;
+        std::vector<PostedMessage> m_failed;
+        PostedMessage m_request {};
+        uint32_t m_max_in_flight = 64;
+
+        static PostedMessage describe(const Message& msg) { return { msg.type, msg.image_id, msg.region, 0 }; }
+
+        // the header is serialized without the bucket data, which travels in its own frame
+        bool send_header(Message& msg)
+        {
+            std::vector<char> bucket_data;
+            bucket_data.swap(msg.bucket_data);
+            std::vector<char> buffer;
+            save_msg_to_buffer(msg, buffer);
+            bucket_data.swap(msg.bucket_data);
+
+            return zmq_send(m_socket, nullptr, 0, ZMQ_SNDMORE) != -1 &&
+                   zmq_send(m_socket, buffer.data(), buffer.size(), msg.bucket_data.empty() ? 0 : ZMQ_SNDMORE) != -1;
+        }
+
+        // returns false on timeout
+        bool recv_response(int32_t& response_code)
+        {
+            response_code = s_timeout_error;
+            bool received = false;
+            int more = 0;
+            do
+            {
+                zmq_msg_t zmsg;
+                zmq_msg_init(&zmsg);
+                if (zmq_msg_recv(&zmsg, m_socket, 0) == -1)
+                {
+                    zmq_msg_close(&zmsg);
+                    return false;
+                }
+                if (zmq_msg_size(&zmsg) == sizeof(int32_t))
+                {
+                    memcpy(&response_code, zmq_msg_data(&zmsg), sizeof(int32_t));
+                    received = true;
+                }
+                more = zmq_msg_more(&zmsg);
+                zmq_msg_close(&zmsg);
+            } while (more);
+            return received;
+        }
+
+        // the reply belongs to the oldest pending message, on timeout the message stays pending
+        bool acknowledge()
+        {
+            int32_t response_code;
+            if (!recv_response(response_code))
+                return false;
+
+            auto reply = m_pending.front();
+            m_pending.pop_front();
+            if (reply.posted && response_code != 0)
+            {
+                reply.message.response_code = response_code;
+                m_failed.push_back(reply.message);
+            }
+            return true;
+        }
+
+        bool acknowledge_all()
+        {
+            while (!m_pending.empty())
+            {
+                if (!acknowledge())
+                    return false;
+            }
+            return true;
+        }
 
     public:
-        void init()
+        void init(const std::string& endpoint)
         {
-            if (!shared_zmq_context)
             {
-                shared_zmq_context = zmq_ctx_new();
+                std::lock_guard<std::mutex> lock(shared_zmq_context_mutex);
+                if (!shared_zmq_context)
+                {
+                    shared_zmq_context = zmq_ctx_new();
+                }
+                shared_zmq_context_ref++;
+                m_context = shared_zmq_context;
             }
 
-            m_context = shared_zmq_context;
-            shared_zmq_context_ref++;
-            m_socket = zmq_socket(m_context, ZMQ_REQ);
+            // a DEALER keeps the REQ envelope, so the listener can serve both
+            m_socket = zmq_socket(m_context, ZMQ_DEALER);
             const int timeout = 10000;
             zmq_setsockopt(m_socket, ZMQ_RCVTIMEO, &timeout, sizeof(int));
-            // data->image_handle = -1;
+            zmq_setsockopt(m_socket, ZMQ_SNDTIMEO, &timeout, sizeof(int));
+            const int linger = 1000;
+            zmq_setsockopt(m_socket, ZMQ_LINGER, &linger, sizeof(int));
 
-            // TODO get port from driver parameters;
-            zmq_connect(m_socket, "tcp://127.0.0.1:5556");
+            zmq_connect(m_socket, endpoint.c_str());
         }
         void destroy()
         {
+            acknowledge_all();
             zmq_close(m_socket);
             m_socket = nullptr;
-            if (shared_zmq_context_ref == 0)
+
+            std::lock_guard<std::mutex> lock(shared_zmq_context_mutex);
+            if (--shared_zmq_context_ref == 0)
             {
                 zmq_ctx_destroy(shared_zmq_context);
                 shared_zmq_context = nullptr;
             }
-            else
-            {
-                shared_zmq_context_ref--;
-            }
             m_context = nullptr;
         }
         void send_msg(Message& msg)
         {
-            zmq_msg_t zmsg;
-
-            std::vector<char> buffer;
-
-            save_msg_to_buffer(msg, buffer);
-            zmq_msg_init_size(&zmsg, buffer.size() * sizeof(char));
-
-            void* msg_data = zmq_msg_data(&zmsg);
-            memcpy(msg_data, buffer.data(), buffer.size() * sizeof(char));
-
-            int rc = zmq_msg_send(&zmsg, m_socket, 0);
-
-            zmq_msg_close(&zmsg);
+            m_request = describe(msg);
+            if (send_header(msg) && !msg.bucket_data.empty())
+                zmq_send(m_socket, msg.bucket_data.data(), msg.bucket_data.size(), 0);
         }
         int32_t recv_msg()
         {
-            zmq_msg_t zmsg;
-            int32_t response_code = -1;
-
-            zmq_msg_init(&zmsg);
-            int rc = zmq_msg_recv(&zmsg, m_socket, 0);
-
-            void* buff = nullptr;
-            buff = zmq_msg_data(&zmsg);
-            memcpy(&response_code, buff, sizeof(int32_t));
-            zmq_msg_close(&zmsg);
-
+            // replies arrive in order, the ones for posted messages come first
+            int32_t response_code;
+            if (!acknowledge_all() || !recv_response(response_code))
+            {
+                // the reply may still arrive, it must not be taken for the reply to a later message
+                m_pending.push_back({ m_request, false });
+                return s_timeout_error;
+            }
             return response_code;
         }
+        int32_t post_msg(Message&& msg)
+        {
+            while (m_pending.size() >= m_max_in_flight)
+            {
+                if (!acknowledge())
+                    return s_timeout_error;
+            }
+
+            const auto posted = describe(msg);
+            if (!send_header(msg))
+                return s_timeout_error;
+            if (!msg.bucket_data.empty())
+            {
+                auto bucket_data = new std::vector<char>(std::move(msg.bucket_data));
+                zmq_msg_t zmsg;
+                zmq_msg_init_data(
+                    &zmsg, bucket_data->data(), bucket_data->size(), [](void*, void* hint) { delete static_cast<std::vector<char>*>(hint); },
+                    bucket_data);
+                if (zmq_msg_send(&zmsg, m_socket, 0) == -1)
+                {
+                    zmq_msg_close(&zmsg);
+                    return s_timeout_error;
+                }
+            }
+            m_pending.push_back({ posted, true });
+            return 0;
+        }
+        int32_t flush()
+        {
+            if (!acknowledge_all())
+                return s_timeout_error;
+            return m_failed.empty() ? 0 : m_failed.front().response_code;
+        }
+        std::vector<PostedMessage> take_failed_messages()
+        {
+            std::vector<PostedMessage> result;
+            result.swap(m_failed);
+            return result;
+        }
+        void set_max_in_flight(uint32_t max_in_flight) { m_max_in_flight = std::max<uint32_t>(max_in_flight, 1); }
+        uint32_t get_max_in_flight() const { return m_max_in_flight; }
     };
 
     RenderViewConnection::RenderViewConnection()
-        : m_impl { std::make_unique<RenderViewConnectionImpl>() }
+        : RenderViewConnection("tcp://127.0.0.1:5556")
     {
+    }
 
-        m_impl->init();
+    RenderViewConnection::RenderViewConnection(const std::string& endpoint)
+        : m_impl { std::make_unique<RenderViewConnectionImpl>() }
+    {
+        m_impl->init(endpoint);
     }
 
     RenderViewConnection::~RenderViewConnection()
@@ -302,6 +424,31 @@ namespace display_driver_api
         return m_impl->recv_msg();
     }
 
+    int32_t RenderViewConnection::post_msg(Message&& msg)
+    {
+        return m_impl->post_msg(std::move(msg));
+    }
+
+    int32_t RenderViewConnection::flush()
+    {
+        return m_impl->flush();
+    }
+
+    std::vector<PostedMessage> RenderViewConnection::take_failed_messages()
+    {
+        return m_impl->take_failed_messages();
+    }
+
+    void RenderViewConnection::set_max_in_flight(uint32_t max_in_flight)
+    {
+        m_impl->set_max_in_flight(max_in_flight);
+    }
+
+    uint32_t RenderViewConnection::get_max_in_flight() const
+    {
+        return m_impl->get_max_in_flight();
+    }
+
 }
 
 OPENDCC_NAMESPACE_CLOSE
@@ -65,15 +65,56 @@ namespace display_driver_api
         std::vector<char> bucket_data;
     };
 
+    /**
+     * @brief Message posted through RenderViewConnection::post_msg whose reply reported an error.
+     */
+    struct PostedMessage
+    {
+        Message::Type type;
+        int32_t image_id;
+        ROI region;
+        int32_t response_code;
+    };
+
     class RenderViewConnectionImpl;
 
+    /**
+     * @brief Connection to the render view listener.
+     *
+     * Messages are sent as a header frame followed by an optional frame with the bucket data.
+     * send_msg/recv_msg form a request/reply pair, while post_msg queues a message without waiting
+     * for its reply. Posted messages are limited by a number of credits: the sender blocks only
+     * when that many messages are still unacknowledged by the listener.
+     * Replies that don't arrive in time are reported as -1 and skipped when they arrive later.
+     */
     class RenderViewConnection
     {
     public:
+        // connects to tcp://127.0.0.1:5556
         OPENDCC_RENDER_VIEW_API RenderViewConnection();
+        OPENDCC_RENDER_VIEW_API explicit RenderViewConnection(const std::string& endpoint);
         OPENDCC_RENDER_VIEW_API virtual ~RenderViewConnection();
         OPENDCC_RENDER_VIEW_API void send_msg(Message& msg);
         OPENDCC_RENDER_VIEW_API int32_t recv_msg();
+        /**
+         * @brief Sends the message without waiting for the reply.
+         *
+         * The bucket data is handed over to the transport without copying.
+         * @return 0 if the message is sent, -1 if the listener didn't return a credit in time and the message was dropped.
+         */
+        OPENDCC_RENDER_VIEW_API int32_t post_msg(Message&& msg);
+        /**
+         * @brief Waits until all posted messages are acknowledged.
+         * @return -1 if some replies didn't arrive in time, otherwise the response code of the first failed
+         * message that is not taken yet, 0 if there is none.
+         */
+        OPENDCC_RENDER_VIEW_API int32_t flush();
+        /**
+         * @brief Returns the acknowledged posted messages that failed, in the order they were posted, and forgets them.
+         */
+        OPENDCC_RENDER_VIEW_API std::vector<PostedMessage> take_failed_messages();
+        OPENDCC_RENDER_VIEW_API void set_max_in_flight(uint32_t max_in_flight);
+        OPENDCC_RENDER_VIEW_API uint32_t get_max_in_flight() const;
 
     private:
         std::unique_ptr<RenderViewConnectionImpl> m_impl;
@@ -86,8 +127,11 @@ namespace display_driver_api
     OPENDCC_RENDER_VIEW_API int32_t render_view_open_image(RenderViewConnection& connection, const int32_t image_id,
                                                            const ImageDescription& image_desc);
 
+    // region writes are posted, the result only tells whether the bucket was sent, see RenderViewConnection::post_msg
     OPENDCC_RENDER_VIEW_API int32_t render_view_write_region(RenderViewConnection& connection, const int32_t image_id, const ROI& region,
                                                              size_t pixel_size, const unsigned char* data);
+    OPENDCC_RENDER_VIEW_API int32_t render_view_write_region(RenderViewConnection& connection, const int32_t image_id, const ROI& region,
+                                                             std::vector<char>&& data);
 }
 
 OPENDCC_NAMESPACE_CLOSE
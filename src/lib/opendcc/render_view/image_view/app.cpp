@@ -55,23 +55,26 @@ class RegionUploadTask : public QRunnable
 {
 public:
     RegionUploadTask(RenderViewMainWindow* app, RenderViewInternalImageCache* image_cache, int image_id, RenderViewMainWindow::ImageROI region,
-                     std::shared_ptr<const std::vector<char>> bucket_data)
+                     std::shared_ptr<const char> bucket_data, std::shared_ptr<RenderViewImagePyramid> pyramid)
     {
         m_app = app;
         m_region = region;
         m_image_id = image_id;
         m_image_cache = image_cache;
         m_bucket_data = bucket_data;
+        m_pyramid = pyramid;
     }
 
     void run()
     {
-        auto image = m_image_cache->acquire_image(m_image_id);
+        auto image = m_image_cache->acquire_image(m_image_id, true);
         if (image)
         {
             auto image_spec = image->spec();
             OIIO::ROI roi(m_region.xstart, m_region.xend, m_region.ystart, m_region.yend, 0, 1, 0, image_spec.nchannels);
-            image->set_pixels(roi, image_spec.format, m_bucket_data->data());
+            image->set_pixels(roi, image_spec.format, m_bucket_data.get());
+            if (m_pyramid)
+                m_pyramid->update_region(roi);
             m_image_cache->release_image(m_image_id);
 
             if (m_app->get_current_image_id() == m_image_id)
@@ -82,7 +85,8 @@ public:
     }
 
 private:
-    std::shared_ptr<const std::vector<char>> m_bucket_data;
+    std::shared_ptr<const char> m_bucket_data;
+    std::shared_ptr<RenderViewImagePyramid> m_pyramid;
     RenderViewMainWindow::ImageROI m_region;
     int m_image_id;
     RenderViewInternalImageCache* m_image_cache;
@@ -101,8 +105,7 @@ RenderViewMainWindow::RenderViewMainWindow(RenderViewPreferences&& preferences,
     m_current_input_colorspace = -1;
     m_gamma = 1.0;
     m_exposure = 0.0;
-    size_t max_size = 100;
-    m_image_cache = new RenderViewInternalImageCache(max_size);
+    m_image_cache = new RenderViewInternalImageCache(uint64_t(m_prefs.image_cache_memory) * 1024 * 1024);
     m_current_image_buf = nullptr;
     m_background_image_buf = nullptr;
     m_toggle_background = false;
@@ -152,12 +155,16 @@ RenderViewMainWindow::RenderViewMainWindow(RenderViewPreferences&& preferences,
     m_main_server_info.input_port = m_app_config.get<uint32_t>("ipc.command_server.port", 8000);
 
     ipc::CommandServer::set_server_timeout(m_app_config.get<int>("ipc.command_server.server_timeout", 1000));
+    if (m_app_config.get<std::string>("ipc.command_server.protocol", "binary") == "text")
+    {
+        ipc::CommandServer::set_protocol(ipc::CommandServer::Protocol::Text);
+    }
 
     ipc::Command command;
     command.name = "ServerCreated";
     command.args["pid"] = get_pid_string();
     command.args["hostname"] = info.hostname;
-    command.args["input_port"] = std::to_string(info.input_port);
+    command.args["input_port"] = info.input_port;
     m_server->send_command(m_main_server_info, command);
 }
 
@@ -633,16 +640,9 @@ void RenderViewMainWindow::delete_image()
     }
 }
 
-void RenderViewMainWindow::update_image(int image_id, const ImageROI& region, std::vector<char>& bucket_data)
+void RenderViewMainWindow::update_image(int image_id, const ImageROI& region, std::shared_ptr<const char> bucket_data)
 {
-    RenderViewGLWidget::ROI gl_region;
-    gl_region.xstart = region.xstart;
-    gl_region.xend = region.xend;
-    gl_region.ystart = region.ystart;
-    gl_region.yend = region.yend;
-    auto shared_buffer = std::make_shared<const std::vector<char>>(bucket_data);
-    m_glwidget->update_image_region(image_id, gl_region, shared_buffer);
-    RegionUploadTask* task = new RegionUploadTask(this, m_image_cache, image_id, region, shared_buffer);
+    RegionUploadTask* task = new RegionUploadTask(this, m_image_cache, image_id, region, bucket_data, m_glwidget->get_image_pyramid(image_id));
     task->setAutoDelete(true);
     QThreadPool::globalInstance()->start(task);
 }
@@ -788,10 +788,10 @@ void RenderViewMainWindow::send_crop_update(bool display, const int region_min_x
             m_region_max_y = 0;
         }
 
-        command.args["min_x"] = std::to_string(m_region_min_x);
-        command.args["max_x"] = std::to_string(m_region_max_x);
-        command.args["min_y"] = std::to_string(m_region_min_y);
-        command.args["max_y"] = std::to_string(m_region_max_y);
+        command.args["min_x"] = m_region_min_x;
+        command.args["max_x"] = m_region_max_x;
+        command.args["min_y"] = m_region_min_y;
+        command.args["max_y"] = m_region_max_y;
     }
 
     m_server->send_command(m_main_server_info, command);
@@ -832,7 +832,7 @@ void RenderViewMainWindow::preferences_updated()
                                  QDir::tempPath().toLocal8Bit().constData() +
                                  i18n("render_view.preferences_updated.message_box", " is used instead."));
     }
-    m_image_cache->set_max_size(m_prefs.image_cache_size);
+    m_image_cache->set_max_memory(uint64_t(m_prefs.image_cache_memory) * 1024 * 1024);
     burn_in_mapping_on_save_act->setChecked(m_prefs.burn_in_mapping_on_save);
     write_settings();
 }
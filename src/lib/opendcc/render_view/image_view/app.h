@@ -127,7 +127,7 @@ public:
 #endif
     void create_menus(QMenu* fillMenu = nullptr);
 
-    void update_image(int image_id, const ImageROI& region, std::vector<char>& bucket_data);
+    void update_image(int image_id, const ImageROI& region, std::shared_ptr<const char> bucket_data);
 
     RenderViewInternalImageCache* get_image_cache() { return m_image_cache; };
 
@@ -8,9 +8,13 @@
 #include <QtWidgets/QMenu>
 #include <QtCore/QTimer>
 #include <QtCore/QResource>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
 
 #include <OpenColorIO/OpenColorIO.h>
 
+#include <cmath>
+
 #include "gl_utils.hpp"
 #include "app.h"
 
@@ -22,6 +26,28 @@ OPENDCC_NAMESPACE_OPEN
 namespace OCIO = OCIO_NAMESPACE;
 
 const int LUT3D_EDGE_SIZE = 32;
+// bounds the time a frame spends uploading, the rest of the stale tiles go to the next frames
+const int MAX_TILE_UPLOADS_PER_FRAME = 32;
+const size_t MAX_GL_TILES = 512;
+
+class PyramidBuildTask : public QRunnable
+{
+public:
+    PyramidBuildTask(std::shared_ptr<RenderViewImagePyramid> pyramid)
+        : m_pyramid(pyramid)
+    {
+    }
+
+    void run() override { m_pyramid->update_all(); }
+
+private:
+    std::shared_ptr<RenderViewImagePyramid> m_pyramid;
+};
+
+static uint64_t tile_key(const RenderViewImagePyramid::TileId& tile)
+{
+    return (uint64_t(tile.level) << 48) | (uint64_t(tile.y) << 24) | uint64_t(tile.x);
+}
 
 const QVector<QString> RenderViewGLWidget::background_mode_names = { i18n("render_view.gl_widget.background_mode", "Checker"),
                                                                      i18n("render_view.gl_widget.background_mode", "Black"),
@@ -107,6 +133,8 @@ void RenderViewGLWidget::initialize_glew()
     m_use_halffloat = glewIsSupported("GL_VERSION_3_0") || glewIsSupported("GL_ARB_half_float_pixel") || glewIsSupported("GL_NV_half_float_pixel");
 
     m_use_float = glewIsSupported("GL_VERSION_3_0") || glewIsSupported("GL_ARB_texture_float") || glewIsSupported("GL_ATI_texture_float");
+
+    m_use_pbo = glewIsSupported("GL_VERSION_3_0") || glewIsSupported("GL_ARB_pixel_buffer_object GL_ARB_map_buffer_range");
 }
 
 void RenderViewGLWidget::initializeGL()
@@ -129,8 +157,9 @@ void RenderViewGLWidget::initializeGL()
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glDisable(GL_DEPTH_TEST);
 
-    glGenTextures(1, &m_image_texture);
     glGenTextures(1, &m_background_texture.texture);
+    if (m_use_pbo)
+        glGenBuffers(s_upload_pbo_count, m_upload_pbos);
     // Allocate LUT3D
 
     glGenTextures(1, &m_lut_texture);
@@ -307,38 +336,53 @@ void RenderViewGLWidget::update_lut()
     print_link_status(m_texture_shader_program);
 }
 
-void RenderViewGLWidget::update_image_region(const int image_id, const ROI& region, std::shared_ptr<const std::vector<char>> bucket_data)
+std::shared_ptr<RenderViewImagePyramid> RenderViewGLWidget::get_image_pyramid(const int image_id)
 {
-    // assume image already updated just refresh
     if (image_id != m_app->get_current_image_id())
-        return;
-
-    auto image = m_app->get_current_image();
-
-    if (!image || !isValid())
-        return;
-
-    Bucket bucket;
-    bucket.image_id = image_id;
-    bucket.region = region;
-    bucket.data = bucket_data;
-
-    {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        m_input_buckets.push(bucket);
-    }
+        return nullptr;
 
-    update();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_pyramid;
 }
 
 void RenderViewGLWidget::update_image()
 {
     auto image = m_app->get_current_image();
 
+    std::shared_ptr<RenderViewImagePyramid> pyramid;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pyramid = std::move(m_pyramid);
+    }
+    if (pyramid)
+        pyramid->cancel();
+
     if (!image)
         return;
 
-    auto upload_image = [&](OIIO::ImageBuf* image, bool background_texture) {
+    {
+        const OIIO::ImageSpec& spec(image->spec());
+        int nchannels = image->nchannels();
+        GLenum gltype = GL_UNSIGNED_BYTE;
+        gl_utils::typespec_to_opengl(spec, nchannels, gltype, m_texture_glformat, m_texture_glinternalformat, m_use_halffloat, m_use_srgb,
+                                     m_use_float);
+        m_spec = spec;
+        m_texture_format = gltype;
+        m_texture_data_stride = spec.channel_bytes();
+        m_texture_nchannels = nchannels;
+
+        // level 0 tiles are read from the image directly, coarser levels are displayed once they are built
+        pyramid = std::make_shared<RenderViewImagePyramid>(image);
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pyramid = pyramid;
+        }
+        auto task = new PyramidBuildTask(pyramid);
+        task->setAutoDelete(true);
+        QThreadPool::globalInstance()->start(task);
+    }
+
+    auto upload_image = [&](OIIO::ImageBuf* image) {
         const OIIO::ImageSpec& spec(image->spec());
         int nchannels = image->nchannels();
 
@@ -347,22 +391,11 @@ void RenderViewGLWidget::update_image()
         GLenum glinternalformat = GL_RGB;
         gl_utils::typespec_to_opengl(spec, nchannels, gltype, glformat, glinternalformat, m_use_halffloat, m_use_srgb, m_use_float);
 
-        if (!background_texture)
-        {
-            m_spec = spec;
-            glBindTexture(GL_TEXTURE_2D, m_image_texture);
-            m_texture_format = gltype;
-            m_texture_data_stride = spec.channel_bytes();
-            m_texture_nchannels = nchannels;
-        }
-        else
-        {
-            m_background_texture.spec = spec;
-            glBindTexture(GL_TEXTURE_2D, m_background_texture.texture);
-            m_background_texture.texture_format = gltype;
-            m_background_texture.texture_data_stride = spec.channel_bytes();
-            m_background_texture.texture_nchannels = nchannels;
-        }
+        m_background_texture.spec = spec;
+        glBindTexture(GL_TEXTURE_2D, m_background_texture.texture);
+        m_background_texture.texture_format = gltype;
+        m_background_texture.texture_data_stride = spec.channel_bytes();
+        m_background_texture.texture_nchannels = nchannels;
 
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
@@ -378,15 +411,13 @@ void RenderViewGLWidget::update_image()
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
     };
 
-    upload_image(image, false);
-
     if (m_app->is_toggle_background_mode())
     {
         auto back_image = m_app->get_background_image();
 
         if (back_image)
         {
-            upload_image(back_image, true);
+            upload_image(back_image);
         }
     }
 
@@ -513,48 +544,126 @@ void RenderViewGLWidget::lock_pixel_readout()
     m_mouse_image_y = (int)(image_y);
 }
 
-void RenderViewGLWidget::load_input_buckets()
+void RenderViewGLWidget::upload_tile(const RenderViewImagePyramid& pyramid, const RenderViewImagePyramid::TileId& tile, const OIIO::ROI& roi,
+                                     uint32_t& version)
 {
-    Bucket bucket;
-    while (true)
+    const size_t data_size = roi.npixels() * pyramid.get_spec().pixel_bytes();
+    if (m_use_pbo)
     {
+        // the tile is copied straight into a PBO, the texture upload from it doesn't stall on the copy
+        const auto pbo = m_upload_pbos[m_upload_pbo_index];
+        m_upload_pbo_index = (m_upload_pbo_index + 1) % s_upload_pbo_count;
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        if (data_size > m_upload_pbo_size)
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
-            if (m_input_buckets.empty())
-                break;
-
-            bucket = m_input_buckets.front();
-            m_input_buckets.pop();
+            m_upload_pbo_size = size_t(RenderViewImagePyramid::s_tile_size) * RenderViewImagePyramid::s_tile_size * pyramid.get_spec().pixel_bytes();
+            for (int i = 0; i < s_upload_pbo_count; ++i)
+            {
+                glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_upload_pbos[i]);
+                glBufferData(GL_PIXEL_UNPACK_BUFFER, m_upload_pbo_size, nullptr, GL_STREAM_DRAW);
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
         }
-
-        if (bucket.image_id == m_app->get_current_image_id())
+        if (auto data = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, data_size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT))
         {
-            auto image = m_app->get_current_image();
-
-            if (image)
-            {
-                const OIIO::ImageSpec& spec(image->spec());
+            version = pyramid.read_tile(tile, data);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, roi.width(), roi.height(), m_texture_glformat, m_texture_format, nullptr);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+    else
+    {
+        m_upload_buffer.resize(data_size);
+        version = pyramid.read_tile(tile, m_upload_buffer.data());
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, roi.width(), roi.height(), m_texture_glformat, m_texture_format, m_upload_buffer.data());
+    }
+}
 
-                int nchannels = image->nchannels();
+void RenderViewGLWidget::draw_image_tiles(const std::shared_ptr<RenderViewImagePyramid>& pyramid_ptr)
+{
+    // a new pyramid can be allocated at the address of a released one, so the tiles are bound to the pyramid
+    // by a weak reference which expires together with it
+    if (m_tiles_pyramid.lock() != pyramid_ptr)
+    {
+        release_tiles(false);
+        m_tiles_pyramid = pyramid_ptr;
+    }
+    const auto& pyramid = *pyramid_ptr;
+    ++m_frame;
+
+    float xstart, ystart, xend, yend;
+    widget_to_image_pos(0, 0, xstart, ystart);
+    widget_to_image_pos(width(), height(), xend, yend);
+    const OIIO::ROI visible(static_cast<int>(std::floor(xstart)) - m_spec.x, static_cast<int>(std::ceil(xend)) - m_spec.x,
+                            static_cast<int>(std::floor(ystart)) - m_spec.y, static_cast<int>(std::ceil(yend)) - m_spec.y);
+
+    int level = pyramid.select_level(m_zoom);
+    while (level > 0 && !pyramid.is_level_built(level))
+        --level;
+    const int scale = 1 << level;
+
+    int uploads = 0;
+    glActiveTexture(GL_TEXTURE0);
+    for (const auto& tile : pyramid.get_tiles(level, visible))
+    {
+        const auto roi = pyramid.get_tile_roi(tile);
+        auto& gl_tile = m_tiles[tile_key(tile)];
+        if (!gl_tile.texture)
+        {
+            glGenTextures(1, &gl_tile.texture);
+            glBindTexture(GL_TEXTURE_2D, gl_tile.texture);
+            glTexImage2D(GL_TEXTURE_2D, 0, m_texture_glinternalformat, roi.width(), roi.height(), 0, m_texture_glformat, m_texture_format, nullptr);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, gl_tile.texture);
+        }
+        gl_tile.last_frame = m_frame;
 
-                GLenum gltype = GL_UNSIGNED_BYTE;
-                GLenum glformat = GL_RGB;
-                GLenum glinternalformat = GL_RGB;
+        if (gl_tile.version != pyramid.get_tile_version(tile) && uploads < MAX_TILE_UPLOADS_PER_FRAME)
+        {
+            upload_tile(pyramid, tile, roi, gl_tile.version);
+            ++uploads;
+        }
+        if (gl_tile.version == 0)
+            continue;
 
-                gl_utils::typespec_to_opengl(spec, nchannels, gltype, glformat, glinternalformat, m_use_halffloat, m_use_srgb, m_use_float);
+        float x, y, x2, y2;
+        image_to_widget_pos(m_spec.x + roi.xbegin * scale, m_spec.y + roi.ybegin * scale, x, y);
+        image_to_widget_pos(m_spec.x + roi.xend * scale, m_spec.y + roi.yend * scale, x2, y2);
+        gl_utils::gl_rect_poly(x, y, x2, y2);
+    }
 
-                glBindTexture(GL_TEXTURE_2D, m_image_texture);
+    if (m_tiles.size() > MAX_GL_TILES)
+        release_tiles(true);
+}
 
-                glTexSubImage2D(GL_TEXTURE_2D, 0, bucket.region.xstart, bucket.region.ystart, bucket.region.xend - bucket.region.xstart,
-                                bucket.region.yend - bucket.region.ystart, glformat, gltype, bucket.data->data());
-            }
+void RenderViewGLWidget::release_tiles(bool keep_visible)
+{
+    for (auto it = m_tiles.begin(); it != m_tiles.end();)
+    {
+        if (keep_visible && it->second.last_frame == m_frame)
+        {
+            ++it;
+            continue;
         }
+        glDeleteTextures(1, &it->second.texture);
+        it = m_tiles.erase(it);
     }
 }
 
 void RenderViewGLWidget::paintGL()
 {
-    load_input_buckets();
+    std::shared_ptr<RenderViewImagePyramid> pyramid;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        pyramid = m_pyramid;
+    }
 
     glClear(GL_COLOR_BUFFER_BIT);
     glPushMatrix();
@@ -614,7 +723,7 @@ void RenderViewGLWidget::paintGL()
         gl_utils::gl_rect_poly(x, y, x2, y2);
     }
 
-    if (m_app->get_current_image())
+    if (m_app->get_current_image() && pyramid)
     {
         glUseProgram(m_texture_shader_program);
 
@@ -641,15 +750,9 @@ void RenderViewGLWidget::paintGL()
         loc = glGetUniformLocation(m_texture_shader_program, "imgchannels");
         glUniform1i(loc, m_texture_nchannels);
 
-        float x, y, x2, y2;
-        image_to_widget_pos(m_spec.x, m_spec.y, x, y);
-        image_to_widget_pos(m_spec.x + m_spec.width, m_spec.y + m_spec.height, x2, y2);
-
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, m_image_texture);
         glActiveTexture(GL_TEXTURE1);
         glBindTexture(GL_TEXTURE_3D, m_lut_texture);
-        gl_utils::gl_rect_poly(x, y, x2, y2);
+        draw_image_tiles(pyramid);
 
         glUseProgram(m_lines_shader_program);
         loc = glGetUniformLocation(m_lines_shader_program, "color");
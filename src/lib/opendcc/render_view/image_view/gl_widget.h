@@ -5,10 +5,13 @@
 
 #pragma once
 #include "opendcc/opendcc.h"
-#include <queue>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <QOpenGLWidget>
 #include <OpenImageIO/imagebuf.h>
 #include "HUD.hpp"
+#include "image_pyramid.h"
 
 class QMenu;
 class QTimer;
@@ -57,7 +60,8 @@ public:
 
     void update_image();
     void update_lut();
-    void update_image_region(const int image_id, const ROI& region, std::shared_ptr<const std::vector<char>> bucket_data);
+    // pyramid displayed for image_id, buckets written to the image must be reported to it
+    std::shared_ptr<RenderViewImagePyramid> get_image_pyramid(const int image_id);
 
     void set_crop_region(const ROI& region);
     void set_crop_display(const bool show);
@@ -80,7 +84,9 @@ public Q_SLOTS:
 private:
     void init_lines_shader();
     void get_focus_image_pixel_color(const int x, const int y, float& r, float& g, float& b, float& a);
-    void load_input_buckets();
+    void draw_image_tiles(const std::shared_ptr<RenderViewImagePyramid>& pyramid_ptr);
+    void upload_tile(const RenderViewImagePyramid& pyramid, const RenderViewImagePyramid::TileId& tile, const OIIO::ROI& roi, uint32_t& version);
+    void release_tiles(bool keep_visible);
 
     void image_to_widget_pos(float image_x, float image_y, float& widget_x, float& widget_y);
 
@@ -93,18 +99,31 @@ private:
         OIIO::ImageSpec spec;
     };
 
-    struct Bucket
+    struct GLTile
     {
-        int image_id;
-        RenderViewGLWidget::ROI region;
-        std::shared_ptr<const std::vector<char>> data;
+        GLuint texture = 0;
+        uint32_t version = 0;
+        uint64_t last_frame = 0;
     };
+    static constexpr int s_upload_pbo_count = 4;
+
     std::mutex m_mutex;
     RenderViewHUD m_hud;
-    std::queue<Bucket> m_input_buckets;
-    GLuint m_image_texture;
+    // current image is displayed by tiles of its pyramid level matching the zoom,
+    // only visible tiles are uploaded, and only when their version changes
+    std::shared_ptr<RenderViewImagePyramid> m_pyramid;
+    std::weak_ptr<RenderViewImagePyramid> m_tiles_pyramid;
+    std::unordered_map<uint64_t, GLTile> m_tiles;
+    uint64_t m_frame = 0;
+    GLuint m_upload_pbos[s_upload_pbo_count] = {};
+    size_t m_upload_pbo_size = 0;
+    int m_upload_pbo_index = 0;
+    bool m_use_pbo = false;
+    std::vector<char> m_upload_buffer;
     GLuint m_lut_texture;
     GLenum m_texture_format;
+    GLenum m_texture_glformat = GL_RGB;
+    GLenum m_texture_glinternalformat = GL_RGB;
     GLTexture m_background_texture;
     GLint m_texture_fragment_shader;
     GLint m_texture_vertex_shader;
@@ -3,6 +3,8 @@
 
 #include "image_cache.h"
 
+#include <OpenImageIO/imageio.h>
+
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
@@ -24,6 +26,9 @@ static std::string make_temporary_file_path(const std::string& scratch_image_loc
     return path;
 }
 
+static const int s_scratch_tile_size = 64;
+static const float s_tile_cache_memory_mb = 512.0f;
+
 //////////////////////////////////////////////////////////////////////////
 // ImageSaveTask
 //////////////////////////////////////////////////////////////////////////
@@ -31,10 +36,11 @@ static std::string make_temporary_file_path(const std::string& scratch_image_loc
 class ImageSaveTask : public QRunnable
 {
 public:
-    ImageSaveTask(RenderViewInternalImageCache* image_cache, OIIO::ImageBuf* image, const std::string& path)
+    ImageSaveTask(RenderViewInternalImageCache* image_cache, OIIO::ImageBuf* image, const std::string& path, uint32_t key)
         : m_image_cache(image_cache)
         , m_image(image)
         , m_path(path)
+        , m_key(key)
     {
     }
 
@@ -49,17 +55,42 @@ public:
                     m_image_cache->m_disk_memory -= check_existing_file.size();
             }
 
-            m_image->write(m_path.c_str());
+            // tiled and compressed, so that spilled images are cheap to store and can be read back per tile
+            OIIO::ImageSpec spec = m_image->spec();
+            spec.tile_width = s_scratch_tile_size;
+            spec.tile_height = s_scratch_tile_size;
+            spec.tile_depth = 1;
+            spec.attribute("compression", "zip");
+            auto out = OIIO::ImageOutput::create(m_path);
+            if (out && out->open(m_path, spec))
+            {
+                m_image->write(out.get());
+                out->close();
+            }
             delete m_image;
 
             {
                 std::lock_guard<std::recursive_mutex> lk(m_image_cache->m_mutex);
+                m_image_cache->m_tile_cache->invalidate(OIIO::ustring(m_path));
                 QFileInfo check_created_file(m_path.c_str());
                 if (check_created_file.exists())
                     m_image_cache->m_disk_memory += check_created_file.size();
                 else
                     printf("ImageSaveTask error, fail to create file :%s\n", m_path.c_str());
+
+                auto image_it = m_image_cache->m_image_map.find(m_key);
+                if (image_it != m_image_cache->m_image_map.end())
+                {
+                    image_it->second->saving = false;
+                }
+                else if (check_created_file.exists() && QFile::remove(m_path.c_str()))
+                {
+                    // the image was deleted while it was being saved
+                    m_image_cache->m_disk_memory -= check_created_file.size();
+                }
+                --m_image_cache->m_pending_saves;
             }
+            m_image_cache->m_save_finished.notify_all();
         }
     }
 
@@ -67,23 +98,34 @@ private:
     RenderViewInternalImageCache* m_image_cache;
     OIIO::ImageBuf* m_image;
     std::string m_path;
+    uint32_t m_key;
 };
 
 //////////////////////////////////////////////////////////////////////////
 // RenderViewInternalImageCache
 //////////////////////////////////////////////////////////////////////////
 
-RenderViewInternalImageCache::RenderViewInternalImageCache(const int max_size)
+RenderViewInternalImageCache::RenderViewInternalImageCache(uint64_t max_memory)
 {
-    m_max_size = max_size;
+    m_max_memory = max_memory;
     m_scratch_image_location = QDir::tempPath().toLocal8Bit().constData();
+    m_tile_cache = OIIO::ImageCache::create(false);
+    m_tile_cache->attribute("max_memory_MB", s_tile_cache_memory_mb);
+    m_tile_cache->attribute("autotile", s_scratch_tile_size);
 }
 
 RenderViewInternalImageCache::~RenderViewInternalImageCache()
 {
-    std::lock_guard<std::recursive_mutex> lk(m_mutex);
+    std::unique_lock<std::recursive_mutex> lk(m_mutex);
+    m_save_finished.wait(lk, [this] { return m_pending_saves == 0; });
     for (auto& image : m_image_list)
     {
+        if (image.active)
+        {
+            delete image.buf;
+            image.buf = nullptr;
+        }
+
         if (image.type == RenderViewImageType::Internal)
         {
             const std::string file_path = make_temporary_file_path(m_scratch_image_location, image.image_id);
@@ -94,19 +136,20 @@ RenderViewInternalImageCache::~RenderViewInternalImageCache()
             }
         }
     }
+    OIIO::ImageCache::destroy(m_tile_cache);
 }
 
 bool RenderViewInternalImageCache::put(OIIO::ImageBuf* buf, uint32_t& key)
 {
     std::lock_guard<std::recursive_mutex> lk(m_mutex);
-    if (!free_memory_for_image())
-    {
-        return false;
-    }
+    // the budget is soft: images in use are never spilled, so the new one is accepted anyway
+    free_memory_for_image(compute_image_size(buf->spec()));
 
     RenderViewImage new_img;
     new_img.buf = buf;
     new_img.active = true;
+    new_img.resident = true;
+    new_img.modified = true;
     new_img.type = RenderViewImageType::Internal;
 
     new_img.image_spec = buf->spec();
@@ -167,56 +210,45 @@ void RenderViewInternalImageCache::delete_image(const uint32_t key)
     }
 }
 
-bool RenderViewInternalImageCache::free_memory_for_image()
+bool RenderViewInternalImageCache::free_memory_for_image(size_t required)
 {
     std::lock_guard<std::recursive_mutex> lk(m_mutex);
 
-    if (m_image_list.size() < m_max_size)
-    {
-        return true;
-    }
-
-    auto in_memory = compute_in_memory_count();
-
-    const auto begin = m_image_list.begin();
     auto image = m_image_list.end();
-
-    while (in_memory >= m_max_size)
+    while (m_allocated_memory + required > m_max_memory && image != m_image_list.begin())
     {
         --image;
-        if (!image->active || image->acquired_count >= 1)
-        {
-            continue;
-        }
-
-        if (image->type == RenderViewImageType::Internal)
-        {
-            image->file_path = make_temporary_file_path(m_scratch_image_location, image->image_id);
-            ImageSaveTask* task = new ImageSaveTask(this, image->buf, image->file_path);
-            task->setAutoDelete(true);
-            QThreadPool::globalInstance()->start(task);
-            image->buf = nullptr;
-        }
-
-        // added that in attempt to fix a lot crash reports
-        // that may mean that we have some memory leaks
-        if (image->buf)
+        if (image->resident && image->acquired_count == 0)
         {
-            delete image->buf;
+            evict(image);
         }
+    }
 
-        image->buf = nullptr;
-        image->active = false;
-        m_allocated_memory = m_allocated_memory - compute_image_size(image->image_spec);
-        --in_memory;
+    return m_allocated_memory + required <= m_max_memory;
+}
 
-        if (image == begin)
-        {
-            break;
-        }
+void RenderViewInternalImageCache::evict(std::list<RenderViewImage>::iterator image)
+{
+    if (image->type == RenderViewImageType::Internal && image->modified)
+    {
+        image->file_path = make_temporary_file_path(m_scratch_image_location, image->image_id);
+        image->saving = true;
+        image->modified = false;
+        ++m_pending_saves;
+        ImageSaveTask* task = new ImageSaveTask(this, image->buf, image->file_path, image->image_id);
+        task->setAutoDelete(true);
+        m_save_pool.start(task);
+    }
+    else
+    {
+        // the file on disk is up to date
+        delete image->buf;
     }
 
-    return in_memory < m_max_size;
+    image->buf = nullptr;
+    image->active = false;
+    image->resident = false;
+    m_allocated_memory = m_allocated_memory - compute_image_size(image->image_spec);
 }
 
 size_t RenderViewInternalImageCache::compute_image_size(OIIO::ImageSpec spec)
@@ -238,57 +270,54 @@ bool RenderViewInternalImageCache::get_spec(const uint32_t key, OIIO::ImageSpec&
     return false;
 }
 
-OIIO::ImageBuf* RenderViewInternalImageCache::acquire_image(const uint32_t key)
+OIIO::ImageBuf* RenderViewInternalImageCache::acquire_image(const uint32_t key, bool for_writing /* = false */)
 {
-    std::lock_guard<std::recursive_mutex> lk(m_mutex);
+    std::unique_lock<std::recursive_mutex> lk(m_mutex);
 
     auto image_it = m_image_map.find(key);
-    if (image_it != m_image_map.end())
+    if (image_it == m_image_map.end())
     {
-        auto image = image_it->second;
+        return nullptr;
+    }
+    auto image = image_it->second;
 
-        if (image->active)
+    // the scratch file is complete only when its save task finishes
+    m_save_finished.wait(lk, [image] { return !image->saving; });
+
+    if (!image->active)
+    {
+        OIIO::ImageBuf* buf = new OIIO::ImageBuf(image->file_path, 0, 0, m_tile_cache);
+        if (!buf->init_spec(image->file_path, 0, 0))
         {
-            ++image->acquired_count;
-            m_image_list.splice(m_image_list.begin(), m_image_list, image_it->second);
-            return image->buf;
+            printf("ImageBuf error, fail to open file :%s\n", image->file_path.c_str());
+            delete buf;
+            return nullptr;
         }
-        else
+        image->buf = buf;
+        image->active = true;
+        image->resident = false;
+    }
+
+    if (for_writing)
+    {
+        if (!image->resident)
         {
             const size_t image_size = compute_image_size(image->image_spec);
-            if (!free_memory_for_image())
-            {
-                return nullptr;
-            }
-
-            auto input = OIIO::ImageInput::open(image->file_path);
-            if (!input)
+            free_memory_for_image(image_size);
+            if (!image->buf->read(0, 0, true, image->image_spec.format))
             {
+                printf("ImageBuf error, fail to read file :%s\n", image->file_path.c_str());
                 return nullptr;
             }
-
-            OIIO::ImageBuf* buf = new OIIO::ImageBuf(image->file_path, image->image_spec);
-
-            auto localpixels = buf->localpixels();
-            if (!localpixels)
-            {
-                printf("ImageBuf error, localpixels is empty :%s\n", image->file_path.c_str());
-                return nullptr;
-            }
-
-            input->read_image(image->image_spec.format, localpixels);
-            input->close();
-
-            image->active = true;
-            image->buf = buf;
+            image->resident = true;
             m_allocated_memory += image_size;
-
-            ++image->acquired_count;
-            m_image_list.splice(m_image_list.begin(), m_image_list, image_it->second);
-            return buf;
         }
+        image->modified = true;
     }
-    return nullptr;
+
+    ++image->acquired_count;
+    m_image_list.splice(m_image_list.begin(), m_image_list, image);
+    return image->buf;
 }
 
 void RenderViewInternalImageCache::release_image(const uint32_t key)
@@ -343,7 +372,7 @@ void RenderViewInternalImageCache::print_actual_cache_size(const char* step)
 
     for (auto& image : m_image_list)
     {
-        if (image.active && image.buf)
+        if (image.resident && image.buf)
         {
             actual_memory += image.buf->spec().image_bytes();
         }
@@ -351,17 +380,6 @@ void RenderViewInternalImageCache::print_actual_cache_size(const char* step)
     printf("%zuMB         |%s\n", actual_memory / 1024u / 1024u, step);
 }
 
-size_t RenderViewInternalImageCache::compute_in_memory_count()
-{
-    int on_disk_count = 0;
-    for (const auto& image : m_image_list)
-    {
-        const bool on_disk = !image.buf && !image.active;
-        on_disk_count += static_cast<int>(on_disk);
-    }
-    return m_image_list.size() - on_disk_count;
-}
-
 void RenderViewInternalImageCache::delete_on_disk(const int32_t key)
 {
     std::lock_guard<std::recursive_mutex> lk(m_mutex);
@@ -374,8 +392,10 @@ void RenderViewInternalImageCache::delete_on_disk(const int32_t key)
         {
             const std::string file_path = make_temporary_file_path(m_scratch_image_location, image->image_id);
             QFileInfo checkFile(file_path.c_str());
-            if (image->type == RenderViewImageType::Internal && checkFile.exists() && checkFile.isFile())
+            // a pending save task removes the file itself once it finds the image gone
+            if (image->type == RenderViewImageType::Internal && !image->saving && checkFile.exists() && checkFile.isFile())
             {
+                m_tile_cache->invalidate(OIIO::ustring(file_path));
                 bool result = QFile::remove(file_path.c_str());
                 if (result)
                     m_disk_memory -= checkFile.size();
@@ -389,7 +409,10 @@ void RenderViewInternalImageCache::delete_on_disk(const int32_t key)
                 image->buf = nullptr;
             }
 
-            m_allocated_memory = m_allocated_memory - compute_image_size(image->image_spec);
+            if (image->resident)
+            {
+                m_allocated_memory = m_allocated_memory - compute_image_size(image->image_spec);
+            }
 
             m_image_list.erase(image_it->second);
             m_image_map.erase(image_it);
@@ -424,10 +447,89 @@ void RenderViewInternalImageCache::used_memory(uint64_t& allocated, uint64_t& di
     disk = m_disk_memory;
 }
 
-void RenderViewInternalImageCache::set_max_size(const int max_size)
+void RenderViewInternalImageCache::set_max_memory(uint64_t max_memory)
 {
-    m_max_size = max_size;
-    free_memory_for_image();
+    std::lock_guard<std::recursive_mutex> lk(m_mutex);
+    m_max_memory = max_memory;
+    free_memory_for_image(0);
+}
+
+uint64_t RenderViewInternalImageCache::get_max_memory() const
+{
+    return m_max_memory;
 }
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("render_view_image_cache")
+{
+    DOCTEST_TEST_CASE("byte_budget_and_tile_reload")
+    {
+        constexpr int image_count = 8;
+        constexpr int resolution = 1024;
+        const OIIO::ImageSpec spec(resolution, resolution, 4, OIIO::TypeDesc::FLOAT);
+        const uint64_t image_bytes = spec.image_bytes();
+        const uint64_t budget = image_bytes * 5 / 2;
+
+        RenderViewInternalImageCache cache(budget);
+        std::vector<uint32_t> keys(image_count);
+        for (int i = 0; i < image_count; ++i)
+        {
+            auto buf = new OIIO::ImageBuf(spec);
+            const float value[] = { float(i), 0.5f, 0.25f, 1.0f };
+            OIIO::ImageBufAlgo::fill(*buf, value);
+            DOCTEST_REQUIRE(cache.put(buf, keys[i]));
+
+            uint64_t allocated, disk;
+            cache.used_memory(allocated, disk);
+            DOCTEST_CHECK(allocated <= budget);
+        }
+
+        using ms = std::chrono::duration<double, std::milli>;
+        // the oldest image is spilled: reading a visible region touches only its tiles
+        const auto start = std::chrono::steady_clock::now();
+        auto spilled = cache.acquire_image(keys[0]);
+        DOCTEST_REQUIRE(spilled != nullptr);
+        const auto acquired = std::chrono::steady_clock::now();
+        std::vector<float> region(256 * 256 * 4);
+        DOCTEST_CHECK(spilled->get_pixels(OIIO::ROI(384, 640, 384, 640, 0, 1, 0, 4), OIIO::TypeDesc::FLOAT, region.data()));
+        const auto region_read = std::chrono::steady_clock::now();
+        DOCTEST_CHECK(region[0] == 0.0f);
+        DOCTEST_CHECK(region[1] == 0.5f);
+
+        std::vector<float> full(size_t(resolution) * resolution * 4);
+        DOCTEST_CHECK(spilled->get_pixels(spilled->roi(), OIIO::TypeDesc::FLOAT, full.data()));
+        const auto full_read = std::chrono::steady_clock::now();
+        DOCTEST_CHECK(full.back() == 1.0f);
+
+        uint64_t allocated, disk;
+        cache.used_memory(allocated, disk);
+        DOCTEST_CHECK(allocated <= budget);
+        DOCTEST_CHECK(disk > 0);
+
+        // writing makes it resident again without exceeding the budget
+        cache.release_image(keys[0]);
+        auto writable = cache.acquire_image(keys[0], true);
+        DOCTEST_REQUIRE(writable != nullptr);
+        float pixel[4];
+        writable->getpixel(resolution - 1, resolution - 1, pixel);
+        DOCTEST_CHECK(pixel[0] == 0.0f);
+        cache.release_image(keys[0]);
+        cache.used_memory(allocated, disk);
+        DOCTEST_CHECK(allocated <= budget);
+
+        DOCTEST_MESSAGE("acquire spilled: " << ms(acquired - start).count() << " ms, 256x256 region: " << ms(region_read - acquired).count()
+                                            << " ms, full image: " << ms(full_read - region_read).count() << " ms, scratch on disk: "
+                                            << disk / 1024 / 1024 << " MB");
+    }
+}
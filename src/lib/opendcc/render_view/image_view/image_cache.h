@@ -8,10 +8,14 @@
 #include "opendcc/opendcc.h"
 
 #include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagecache.h>
+
+#include <QThreadPool>
 
 #include <list>
 #include <mutex>
 #include <atomic>
+#include <condition_variable>
 #include <string>
 #include <unordered_map>
 
@@ -37,14 +41,28 @@ struct RenderViewImage
 
     bool deleted;
     uint32_t acquired_count;
+
+    // buf holds its pixels in memory and counts towards the budget,
+    // otherwise buf reads the tiles it is asked for from file_path
+    bool resident = false;
+    // pixels differ from the scratch file
+    bool modified = false;
+    bool saving = false;
 };
 
+/**
+ * @brief LRU cache of the render view images limited by the memory of their pixels.
+ *
+ * Least recently used internal images are spilled to tiled zip-compressed scratch files.
+ * Acquiring a spilled image doesn't load it back: the returned buffer reads tiles on demand
+ * through a private OIIO::ImageCache, and only acquiring it for writing makes it resident again.
+ */
 class RenderViewInternalImageCache
 {
     friend ImageSaveTask;
 
 public:
-    RenderViewInternalImageCache(const int max_size);
+    RenderViewInternalImageCache(uint64_t max_memory);
     ~RenderViewInternalImageCache();
 
     bool put(OIIO::ImageBuf* buf, uint32_t& key);
@@ -53,7 +71,7 @@ public:
 
     bool get_spec(const uint32_t key, OIIO::ImageSpec& spec);
 
-    OIIO::ImageBuf* acquire_image(const uint32_t key);
+    OIIO::ImageBuf* acquire_image(const uint32_t key, bool for_writing = false);
     bool exist(const uint32_t key);
     bool update_spec(const uint32_t key, OIIO::ImageSpec spec);
 
@@ -65,19 +83,19 @@ public:
     std::string get_file_path(const uint32_t key);
     void used_memory(uint64_t& allocated, uint64_t& disk) const;
 
-    void set_max_size(const int max_size);
+    void set_max_memory(uint64_t max_memory);
+    uint64_t get_max_memory() const;
 
 private:
     void delete_on_disk(const int32_t key);
 
-    bool free_memory_for_image();
+    bool free_memory_for_image(size_t required);
+    void evict(std::list<RenderViewImage>::iterator image);
 
     size_t compute_image_size(OIIO::ImageSpec spec);
 
     void print_actual_cache_size(const char* step);
 
-    size_t compute_in_memory_count();
-
     // https://www.nextptr.com/tutorial/ta1576645374/stdlist-splice-for-implementing-lru-cache
     std::list<RenderViewImage> m_image_list;
     std::unordered_map<uint32_t, std::list<RenderViewImage>::iterator> m_image_map;
@@ -85,10 +103,15 @@ private:
     uint64_t m_allocated_memory = 0;
     uint64_t m_disk_memory = 0;
     uint32_t m_counter = 0;
-    int m_max_size;
+    uint64_t m_max_memory;
+    uint32_t m_pending_saves = 0;
 
     std::string m_scratch_image_location;
+    OIIO::ImageCache* m_tile_cache = nullptr;
     std::recursive_mutex m_mutex;
+    std::condition_variable_any m_save_finished;
+    // acquire_image blocks until a save finishes, so saves must not queue behind the tasks that acquire images
+    QThreadPool m_save_pool;
 };
 
 OPENDCC_NAMESPACE_CLOSE
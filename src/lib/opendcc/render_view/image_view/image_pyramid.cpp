@@ -0,0 +1,346 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "image_pyramid.h"
+
+#include <algorithm>
+#include <cmath>
+
+OPENDCC_NAMESPACE_OPEN
+
+RenderViewImagePyramid::RenderViewImagePyramid(const OIIO::ImageBuf* source)
+    : m_source(source)
+    , m_spec(source->spec())
+{
+    int width = std::max(m_spec.width, 1);
+    int height = std::max(m_spec.height, 1);
+    while (width > s_tile_size || height > s_tile_size)
+    {
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+        m_levels.push_back(std::make_unique<OIIO::ImageBuf>(OIIO::ImageSpec(width, height, m_spec.nchannels, m_spec.format)));
+    }
+
+    m_tile_versions.resize(m_levels.size() + 1);
+    m_built.resize(m_levels.size() + 1, 0);
+    for (int level = 0; level < get_num_levels(); ++level)
+    {
+        // level 0 reads the source directly, so its tiles are valid from the start
+        m_tile_versions[level].resize(size_t(get_num_tiles_x(level)) * get_num_tiles_y(level), level == 0 ? 1 : 0);
+    }
+    m_built[0] = 1;
+}
+
+const OIIO::ImageSpec& RenderViewImagePyramid::get_spec() const
+{
+    return m_spec;
+}
+
+int RenderViewImagePyramid::get_num_levels() const
+{
+    return static_cast<int>(m_levels.size()) + 1;
+}
+
+int RenderViewImagePyramid::get_level_width(int level) const
+{
+    return level == 0 ? m_spec.width : m_levels[level - 1]->spec().width;
+}
+
+int RenderViewImagePyramid::get_level_height(int level) const
+{
+    return level == 0 ? m_spec.height : m_levels[level - 1]->spec().height;
+}
+
+int RenderViewImagePyramid::get_num_tiles_x(int level) const
+{
+    return (get_level_width(level) + s_tile_size - 1) / s_tile_size;
+}
+
+int RenderViewImagePyramid::get_num_tiles_y(int level) const
+{
+    return (get_level_height(level) + s_tile_size - 1) / s_tile_size;
+}
+
+int RenderViewImagePyramid::select_level(float zoom) const
+{
+    if (zoom >= 1.0f || zoom <= 0.0f)
+        return 0;
+    const int level = static_cast<int>(std::floor(std::log2(1.0f / zoom)));
+    return std::min(level, get_num_levels() - 1);
+}
+
+void RenderViewImagePyramid::update_region(const OIIO::ROI& roi)
+{
+    std::lock_guard<std::mutex> update_lock(m_update_mutex);
+    if (m_cancelled)
+        return;
+
+    int xbegin = std::max(roi.xbegin - m_spec.x, 0);
+    int xend = std::min(roi.xend - m_spec.x, m_spec.width);
+    int ybegin = std::max(roi.ybegin - m_spec.y, 0);
+    int yend = std::min(roi.yend - m_spec.y, m_spec.height);
+    if (xbegin >= xend || ybegin >= yend)
+        return;
+
+    for (int level = 0; level < get_num_levels(); ++level)
+    {
+        const OIIO::ROI level_roi(xbegin, xend, ybegin, yend, 0, 1, 0, m_spec.nchannels);
+        if (level > 0)
+            update_level_region(level, level_roi);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const int tiles_x = get_num_tiles_x(level);
+        for (int tile_y = ybegin / s_tile_size; tile_y <= (yend - 1) / s_tile_size; ++tile_y)
+        {
+            for (int tile_x = xbegin / s_tile_size; tile_x <= (xend - 1) / s_tile_size; ++tile_x)
+                ++m_tile_versions[level][size_t(tile_y) * tiles_x + tile_x];
+        }
+
+        // every pixel of the next level averages a 2x2 block of this one
+        xbegin /= 2;
+        ybegin /= 2;
+        xend = (xend + 1) / 2;
+        yend = (yend + 1) / 2;
+    }
+}
+
+void RenderViewImagePyramid::update_all()
+{
+    // chunks bound the float scratch memory; pixels on chunk borders are recomputed by the next chunk
+    constexpr int chunk_size = 4 * s_tile_size;
+    for (int y = m_spec.y; y < m_spec.y + m_spec.height; y += chunk_size)
+    {
+        for (int x = m_spec.x; x < m_spec.x + m_spec.width; x += chunk_size)
+        {
+            if (m_cancelled)
+                return;
+            update_region(OIIO::ROI(x, x + chunk_size, y, y + chunk_size, 0, 1, 0, m_spec.nchannels));
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::fill(m_built.begin(), m_built.end(), 1);
+}
+
+void RenderViewImagePyramid::cancel()
+{
+    m_cancelled = true;
+    std::lock_guard<std::mutex> update_lock(m_update_mutex);
+}
+
+bool RenderViewImagePyramid::is_level_built(int level) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_built[level] != 0;
+}
+
+void RenderViewImagePyramid::update_level_region(int level, const OIIO::ROI& roi)
+{
+    const int nchannels = m_spec.nchannels;
+    const int parent_width = get_level_width(level - 1);
+    const int parent_height = get_level_height(level - 1);
+    const int parent_xbegin = roi.xbegin * 2;
+    const int parent_ybegin = roi.ybegin * 2;
+    const int parent_xend = std::min(roi.xend * 2, parent_width);
+    const int parent_yend = std::min(roi.yend * 2, parent_height);
+    const int parent_row = parent_xend - parent_xbegin;
+
+    std::vector<float> parent_pixels(size_t(parent_row) * (parent_yend - parent_ybegin) * nchannels);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (level == 1)
+        {
+            m_source->get_pixels(OIIO::ROI(parent_xbegin + m_spec.x, parent_xend + m_spec.x, parent_ybegin + m_spec.y, parent_yend + m_spec.y, 0, 1,
+                                           0, nchannels),
+                                 OIIO::TypeDesc::FLOAT, parent_pixels.data());
+        }
+        else
+        {
+            m_levels[level - 2]->get_pixels(OIIO::ROI(parent_xbegin, parent_xend, parent_ybegin, parent_yend, 0, 1, 0, nchannels),
+                                            OIIO::TypeDesc::FLOAT, parent_pixels.data());
+        }
+    }
+
+    std::vector<float> pixels(roi.npixels() * nchannels);
+    for (int y = roi.ybegin; y < roi.yend; ++y)
+    {
+        // odd sized levels repeat their last row and column
+        const int py0 = 2 * y - parent_ybegin;
+        const int py1 = std::min(2 * y + 1, parent_yend - 1) - parent_ybegin;
+        for (int x = roi.xbegin; x < roi.xend; ++x)
+        {
+            const int px0 = 2 * x - parent_xbegin;
+            const int px1 = std::min(2 * x + 1, parent_xend - 1) - parent_xbegin;
+            const float* p00 = &parent_pixels[(size_t(py0) * parent_row + px0) * nchannels];
+            const float* p01 = &parent_pixels[(size_t(py0) * parent_row + px1) * nchannels];
+            const float* p10 = &parent_pixels[(size_t(py1) * parent_row + px0) * nchannels];
+            const float* p11 = &parent_pixels[(size_t(py1) * parent_row + px1) * nchannels];
+            float* dst = &pixels[(size_t(y - roi.ybegin) * roi.width() + (x - roi.xbegin)) * nchannels];
+            for (int c = 0; c < nchannels; ++c)
+                dst[c] = (p00[c] + p01[c] + p10[c] + p11[c]) * 0.25f;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_levels[level - 1]->set_pixels(roi, OIIO::TypeDesc::FLOAT, pixels.data());
+}
+
+std::vector<RenderViewImagePyramid::TileId> RenderViewImagePyramid::get_tiles(int level, const OIIO::ROI& roi) const
+{
+    std::vector<TileId> result;
+    const int scale = 1 << level;
+    const int xbegin = std::max(roi.xbegin, 0) / scale;
+    const int ybegin = std::max(roi.ybegin, 0) / scale;
+    const int xend = std::min((std::max(roi.xend, 0) + scale - 1) / scale, get_level_width(level));
+    const int yend = std::min((std::max(roi.yend, 0) + scale - 1) / scale, get_level_height(level));
+    if (xbegin >= xend || ybegin >= yend)
+        return result;
+
+    for (int tile_y = ybegin / s_tile_size; tile_y <= (yend - 1) / s_tile_size; ++tile_y)
+    {
+        for (int tile_x = xbegin / s_tile_size; tile_x <= (xend - 1) / s_tile_size; ++tile_x)
+            result.push_back({ level, tile_x, tile_y });
+    }
+    return result;
+}
+
+OIIO::ROI RenderViewImagePyramid::get_tile_roi(const TileId& tile) const
+{
+    const int xbegin = tile.x * s_tile_size;
+    const int ybegin = tile.y * s_tile_size;
+    return OIIO::ROI(xbegin, std::min(xbegin + s_tile_size, get_level_width(tile.level)), ybegin,
+                     std::min(ybegin + s_tile_size, get_level_height(tile.level)), 0, 1, 0, m_spec.nchannels);
+}
+
+uint32_t RenderViewImagePyramid::get_tile_version(const TileId& tile) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_tile_versions[tile.level][size_t(tile.y) * get_num_tiles_x(tile.level) + tile.x];
+}
+
+uint32_t RenderViewImagePyramid::read_tile(const TileId& tile, void* data) const
+{
+    auto roi = get_tile_roi(tile);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (tile.level == 0)
+    {
+        roi.xbegin += m_spec.x;
+        roi.xend += m_spec.x;
+        roi.ybegin += m_spec.y;
+        roi.yend += m_spec.y;
+        m_source->get_pixels(roi, m_spec.format, data);
+    }
+    else
+    {
+        m_levels[tile.level - 1]->get_pixels(roi, m_spec.format, data);
+    }
+    return m_tile_versions[tile.level][size_t(tile.y) * get_num_tiles_x(tile.level) + tile.x];
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <OpenImageIO/imagebufalgo.h>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("render_view_image_pyramid")
+{
+    DOCTEST_TEST_CASE("levels_and_tiles")
+    {
+        OIIO::ImageBuf source(OIIO::ImageSpec(1001, 601, 4, OIIO::TypeDesc::HALF));
+        RenderViewImagePyramid pyramid(&source);
+
+        DOCTEST_CHECK(pyramid.get_num_levels() == 3);
+        DOCTEST_CHECK(pyramid.get_level_width(1) == 501);
+        DOCTEST_CHECK(pyramid.get_level_height(2) == 151);
+        DOCTEST_CHECK(pyramid.select_level(1.0f) == 0);
+        DOCTEST_CHECK(pyramid.select_level(0.3f) == 1);
+        DOCTEST_CHECK(pyramid.select_level(0.01f) == 2);
+        DOCTEST_CHECK(pyramid.is_level_built(0));
+        DOCTEST_CHECK(!pyramid.is_level_built(1));
+
+        const auto tiles = pyramid.get_tiles(1, OIIO::ROI(0, 600, 0, 400));
+        DOCTEST_CHECK(tiles.size() == 2);
+        DOCTEST_CHECK(tiles[1].x == 1);
+        DOCTEST_CHECK(tiles[1].y == 0);
+        DOCTEST_CHECK(pyramid.get_tile_roi({ 0, 3, 2 }).width() == 1001 - 3 * RenderViewImagePyramid::s_tile_size);
+    }
+
+    DOCTEST_TEST_CASE("incremental_update_matches_full_build")
+    {
+        const OIIO::ImageSpec spec(1001, 601, 4, OIIO::TypeDesc::FLOAT);
+        OIIO::ImageBuf source(spec);
+        OIIO::ImageBufAlgo::noise(source, "uniform", 0.0f, 1.0f, false, 1);
+        RenderViewImagePyramid pyramid(&source);
+        pyramid.update_all();
+
+        const RenderViewImagePyramid::TileId touched { 2, 0, 0 };
+        const RenderViewImagePyramid::TileId untouched { 0, 3, 2 };
+        const auto touched_version = pyramid.get_tile_version(touched);
+        const auto untouched_version = pyramid.get_tile_version(untouched);
+
+        // a bucket arrives
+        const OIIO::ROI bucket(64, 128, 32, 96, 0, 1, 0, 4);
+        const float color[] = { 1.0f, 0.0f, 0.5f, 1.0f };
+        OIIO::ImageBufAlgo::fill(source, color, bucket);
+        pyramid.update_region(bucket);
+        DOCTEST_CHECK(pyramid.get_tile_version(touched) == touched_version + 1);
+        DOCTEST_CHECK(pyramid.get_tile_version(untouched) == untouched_version);
+
+        RenderViewImagePyramid reference(&source);
+        reference.update_all();
+        for (int level = 1; level < pyramid.get_num_levels(); ++level)
+        {
+            const RenderViewImagePyramid::TileId tile { level, 0, 0 };
+            const auto roi = pyramid.get_tile_roi(tile);
+            std::vector<float> pixels(roi.npixels() * 4);
+            std::vector<float> reference_pixels(pixels.size());
+            pyramid.read_tile(tile, pixels.data());
+            reference.read_tile(tile, reference_pixels.data());
+            DOCTEST_CHECK(pixels == reference_pixels);
+        }
+
+        // 2x2 box filter
+        float level_pixel[4];
+        std::vector<float> level_tile(pyramid.get_tile_roi({ 1, 0, 0 }).npixels() * 4);
+        pyramid.read_tile({ 1, 0, 0 }, level_tile.data());
+        std::copy(level_tile.begin() + (10 * RenderViewImagePyramid::s_tile_size + 10) * 4,
+                  level_tile.begin() + (10 * RenderViewImagePyramid::s_tile_size + 10) * 4 + 4, level_pixel);
+        float expected = 0;
+        for (int y = 20; y < 22; ++y)
+            for (int x = 20; x < 22; ++x)
+                expected += source.getchannel(x, y, 0, 0) * 0.25f;
+        DOCTEST_CHECK(std::abs(level_pixel[0] - expected) < 1e-5f);
+    }
+
+    DOCTEST_TEST_CASE("bucket_update_throughput")
+    {
+        const OIIO::ImageSpec spec(8192, 8192, 4, OIIO::TypeDesc::HALF);
+        OIIO::ImageBuf source(spec);
+        RenderViewImagePyramid pyramid(&source);
+
+        const auto start = std::chrono::steady_clock::now();
+        pyramid.update_all();
+        const auto built = std::chrono::steady_clock::now();
+
+        constexpr int bucket_size = 64;
+        constexpr int bucket_count = 1024;
+        for (int i = 0; i < bucket_count; ++i)
+        {
+            const int x = (i % 128) * bucket_size;
+            const int y = (i / 128) * bucket_size;
+            pyramid.update_region(OIIO::ROI(x, x + bucket_size, y, y + bucket_size, 0, 1, 0, 4));
+        }
+        const auto updated = std::chrono::steady_clock::now();
+
+        using ms = std::chrono::duration<double, std::milli>;
+        DOCTEST_MESSAGE("8K pyramid built in " << ms(built - start).count() << " ms, " << bucket_count << " bucket updates in "
+                                               << ms(updated - built).count() << " ms");
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "opendcc/opendcc.h"
+
+#include <OpenImageIO/imagebuf.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Tiled mip pyramid of a render view image.
+ *
+ * Level 0 is the source image itself, every next level is a 2x2 box filtered half of the previous one
+ * down to a single tile. Each tile of each level has a version which is increased whenever its pixels change,
+ * so a viewer can re-upload only the tiles it shows that became stale. Levels are built and updated
+ * on worker threads, tiles can be read from any thread meanwhile.
+ * Coordinates are local to the data window of the source.
+ */
+class RenderViewImagePyramid
+{
+public:
+    static constexpr int s_tile_size = 256;
+
+    struct TileId
+    {
+        int level = 0;
+        int x = 0;
+        int y = 0;
+    };
+
+    // source must stay alive while the pyramid is used
+    RenderViewImagePyramid(const OIIO::ImageBuf* source);
+
+    const OIIO::ImageSpec& get_spec() const;
+    int get_num_levels() const;
+    int get_level_width(int level) const;
+    int get_level_height(int level) const;
+    int get_num_tiles_x(int level) const;
+    int get_num_tiles_y(int level) const;
+    // level whose resolution is the closest one not below the displayed resolution
+    int select_level(float zoom) const;
+
+    // recomputes the levels covering roi from the source, roi is in the source pixel coordinates
+    void update_region(const OIIO::ROI& roi);
+    // rebuilds everything in chunks, stops early after cancel
+    void update_all();
+    // a level is built when update_all was finished at least once after construction
+    bool is_level_built(int level) const;
+    // stops update_all and waits for the running update, so that the source can be released
+    void cancel();
+
+    // tiles of the level intersecting roi, roi is in level 0 coordinates
+    std::vector<TileId> get_tiles(int level, const OIIO::ROI& roi) const;
+    // tile rectangle in its level coordinates
+    OIIO::ROI get_tile_roi(const TileId& tile) const;
+    uint32_t get_tile_version(const TileId& tile) const;
+    /**
+     * @brief Copies the tile pixels in the source pixel format.
+     *
+     * data must hold get_tile_roi(tile).npixels() * get_spec().pixel_bytes() bytes.
+     * @return The version of the copied pixels.
+     */
+    uint32_t read_tile(const TileId& tile, void* data) const;
+
+private:
+    void update_level_region(int level, const OIIO::ROI& roi);
+
+    const OIIO::ImageBuf* m_source;
+    OIIO::ImageSpec m_spec;
+    // levels starting from 1, level 0 is m_source
+    std::vector<std::unique_ptr<OIIO::ImageBuf>> m_levels;
+    std::vector<std::vector<uint32_t>> m_tile_versions;
+    std::vector<char> m_built;
+    std::atomic<bool> m_cancelled { false };
+    // guards the pixels and versions, held only for short copies
+    mutable std::mutex m_mutex;
+    // serializes updates, so that every level is computed from an up to date parent
+    std::mutex m_update_mutex;
+};
+
+OPENDCC_NAMESPACE_CLOSE
@@ -3,6 +3,7 @@
 
 #include <zmq.h>
 #include <vector>
+#include <memory>
 #include "opendcc/render_view/display_driver_api/display_driver_api.h"
 
 #include "app.h"
@@ -11,105 +12,291 @@
 
 OPENDCC_NAMESPACE_OPEN
 
+namespace
+{
+    using Frame = std::shared_ptr<zmq_msg_t>;
+
+    Frame make_frame()
+    {
+        Frame frame(new zmq_msg_t, [](zmq_msg_t* msg) {
+            zmq_msg_close(msg);
+            delete msg;
+        });
+        zmq_msg_init(frame.get());
+        return frame;
+    }
+};
+
 void RenderViewListenerThread::run()
 {
-    void* listener = zmq_socket(m_zmq_ctx, ZMQ_REP);
+    // ROUTER serves both the pipelined DEALER connections and plain REQ clients,
+    // every message is [identity][empty delimiter][header][optional bucket data]
+    void* listener = zmq_socket(m_zmq_ctx, ZMQ_ROUTER);
 
-    zmq_bind(listener, "tcp://127.0.0.1:5556");
+    zmq_bind(listener, m_endpoint.c_str());
 
     while (true)
     {
         if (isInterruptionRequested())
             break;
-        zmq_msg_t msg;
-        zmq_msg_init(&msg);
-        int rc = zmq_msg_recv(&msg, listener, 0);
+        zmq_msg_t identity;
+        zmq_msg_init(&identity);
+        int rc = zmq_msg_recv(&identity, listener, 0);
 
-        if (rc != -1)
+        std::vector<Frame> frames;
+        int more = rc != -1 ? zmq_msg_more(&identity) : 0;
+        while (more)
         {
-            size_t buff_size = zmq_msg_size(&msg);
-
-            void* buff = nullptr;
-            buff = zmq_msg_data(&msg);
-
-            std::vector<char> buffer;
-            buffer.resize(buff_size / sizeof(char));
+            auto frame = make_frame();
+            rc = zmq_msg_recv(frame.get(), listener, 0);
+            if (rc == -1)
+                break;
+            more = zmq_msg_more(frame.get());
+            frames.push_back(std::move(frame));
+        }
 
-            memcpy(buffer.data(), buff, buff_size);
+        if (rc != -1 && frames.size() >= 2)
+        {
             display_driver_api::Message message;
 
-            display_driver_api::load_msg_from_buffer(message, buffer);
+            const auto header = static_cast<const char*>(zmq_msg_data(frames[1].get()));
+            display_driver_api::load_msg_from_buffer(message, std::vector<char>(header, header + zmq_msg_size(frames[1].get())));
 
-            zmq_msg_t msg_response;
             int32_t response_code = -1;
             switch (message.type)
             {
             case display_driver_api::Message::Type::OpenImage:
             {
-                RenderViewMainWindow::ImageDataType data_type = RenderViewMainWindow::ImageDataType::Float;
-                switch (message.image_desc.image_data_type)
-                {
-                case display_driver_api::ImageType::Byte:
-                    data_type = RenderViewMainWindow::ImageDataType::Byte;
-                    break;
-                case display_driver_api::ImageType::UInt:
-                    data_type = RenderViewMainWindow::ImageDataType::UInt;
-                    break;
-                case display_driver_api::ImageType::Int:
-                    data_type = RenderViewMainWindow::ImageDataType::Int;
-                    break;
-                case display_driver_api::ImageType::Float:
-                    data_type = RenderViewMainWindow::ImageDataType::Float;
-                    break;
-                case display_driver_api::ImageType::HalfFloat:
-                    data_type = RenderViewMainWindow::ImageDataType::HalfFloat;
-                    break;
-                default:
-                    break;
-                }
-                RenderViewMainWindow::ImageDesc image_desc;
-
-                image_desc.image_type = data_type;
-                image_desc.num_channels = message.image_desc.num_channels;
-                image_desc.width = message.image_desc.width;
-                image_desc.height = message.image_desc.height;
-                image_desc.image_name = message.image_desc.image_name;
-                image_desc.parent_image_id = message.image_desc.parent_image_id;
-                image_desc.extra_attributes = message.image_desc.extra_attributes;
-
-                response_code = m_app->create_image(message.image_id, image_desc);
-                emit new_image();
+                response_code = create_image(message.image_id, message.image_desc);
                 break;
             }
             case display_driver_api::Message::Type::WriteRegion:
             {
-                RenderViewMainWindow::ImageROI region;
-
-                region.xstart = message.region.xstart;
-                region.xend = message.region.xend;
-                region.ystart = message.region.ystart;
-                region.yend = message.region.yend;
-
-                m_app->update_image((int)message.image_id, region, message.bucket_data);
-                response_code = 0;
+                std::shared_ptr<const char> bucket_data;
+                if (frames.size() > 2)
+                {
+                    // the upload reads the pixels straight from the received frame
+                    bucket_data = std::shared_ptr<const char>(frames[2], static_cast<const char*>(zmq_msg_data(frames[2].get())));
+                }
+                else
+                {
+                    // REQ clients send the bucket data inside the header
+                    auto data = std::make_shared<const std::vector<char>>(std::move(message.bucket_data));
+                    bucket_data = std::shared_ptr<const char>(data, data->data());
+                }
+                response_code = update_image(message.image_id, message.region, std::move(bucket_data));
                 break;
             }
             default:
                 break;
             }
-            // send response
-            zmq_msg_init_size(&msg_response, sizeof(int32_t));
-
-            void* msg_data = zmq_msg_data(&msg_response);
-            memcpy(msg_data, &response_code, sizeof(int32_t));
-
-            rc = zmq_msg_send(&msg_response, listener, 0);
-
-            zmq_msg_close(&msg_response);
+            // send response, for pipelined connections it also returns the credit
+            if (zmq_msg_send(&identity, listener, ZMQ_SNDMORE) != -1)
+            {
+                zmq_send(listener, nullptr, 0, ZMQ_SNDMORE);
+                zmq_send(listener, &response_code, sizeof(int32_t), 0);
+            }
         }
-        zmq_msg_close(&msg);
+        zmq_msg_close(&identity);
     }
     zmq_close(listener);
 }
 
+/* virtual */
+int32_t RenderViewListenerThread::create_image(int32_t image_id, const display_driver_api::ImageDescription& image_desc)
+{
+    RenderViewMainWindow::ImageDataType data_type = RenderViewMainWindow::ImageDataType::Float;
+    switch (image_desc.image_data_type)
+    {
+    case display_driver_api::ImageType::Byte:
+        data_type = RenderViewMainWindow::ImageDataType::Byte;
+        break;
+    case display_driver_api::ImageType::UInt:
+        data_type = RenderViewMainWindow::ImageDataType::UInt;
+        break;
+    case display_driver_api::ImageType::Int:
+        data_type = RenderViewMainWindow::ImageDataType::Int;
+        break;
+    case display_driver_api::ImageType::Float:
+        data_type = RenderViewMainWindow::ImageDataType::Float;
+        break;
+    case display_driver_api::ImageType::HalfFloat:
+        data_type = RenderViewMainWindow::ImageDataType::HalfFloat;
+        break;
+    default:
+        break;
+    }
+    RenderViewMainWindow::ImageDesc app_image_desc;
+
+    app_image_desc.image_type = data_type;
+    app_image_desc.num_channels = image_desc.num_channels;
+    app_image_desc.width = image_desc.width;
+    app_image_desc.height = image_desc.height;
+    app_image_desc.image_name = image_desc.image_name;
+    app_image_desc.parent_image_id = image_desc.parent_image_id;
+    app_image_desc.extra_attributes = image_desc.extra_attributes;
+
+    const auto result = m_app->create_image(image_id, app_image_desc);
+    emit new_image();
+    return result;
+}
+
+/* virtual */
+int32_t RenderViewListenerThread::update_image(int32_t image_id, const display_driver_api::ROI& region, std::shared_ptr<const char> bucket_data)
+{
+    RenderViewMainWindow::ImageROI app_region;
+
+    app_region.xstart = region.xstart;
+    app_region.xend = region.xend;
+    app_region.ystart = region.ystart;
+    app_region.yend = region.yend;
+
+    m_app->update_image((int)image_id, app_region, std::move(bucket_data));
+    return 0;
+}
+
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+#include <atomic>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+
+namespace
+{
+    // the real listener loop, without the main window behind it
+    class TestListenerThread : public RenderViewListenerThread
+    {
+    public:
+        TestListenerThread(void* zmq_ctx, const std::string& endpoint, uint32_t rejected_xstart)
+            : RenderViewListenerThread(nullptr, zmq_ctx, endpoint)
+            , m_rejected_xstart(rejected_xstart)
+        {
+        }
+
+        std::atomic<int> received_buckets { 0 };
+        std::atomic<int> corrupted_buckets { 0 };
+
+    protected:
+        int32_t create_image(int32_t image_id, const display_driver_api::ImageDescription& image_desc) override { return 1; }
+        int32_t update_image(int32_t image_id, const display_driver_api::ROI& region, std::shared_ptr<const char> bucket_data) override
+        {
+            ++received_buckets;
+            if (bucket_data.get()[0] != 0x7f)
+                ++corrupted_buckets;
+            return region.xstart == m_rejected_xstart ? 2 : 0;
+        }
+
+    private:
+        uint32_t m_rejected_xstart;
+    };
+
+    display_driver_api::ImageDescription make_image_desc()
+    {
+        display_driver_api::ImageDescription image_desc;
+        image_desc.parent_image_id = -1;
+        image_desc.image_name = "beauty";
+        image_desc.width = 4096;
+        image_desc.height = 4096;
+        image_desc.num_channels = 4;
+        image_desc.image_data_type = display_driver_api::ImageType::Float;
+        return image_desc;
+    }
+
+    void stop_listener(RenderViewListenerThread& listener, void* zmq_ctx)
+    {
+        // shutting the context down wakes the blocking receive
+        listener.requestInterruption();
+        zmq_ctx_shutdown(zmq_ctx);
+        listener.wait();
+        zmq_ctx_term(zmq_ctx);
+    }
+};
+
+DOCTEST_TEST_SUITE("render_view_listener_thread")
+{
+    DOCTEST_TEST_CASE("bucket_throughput")
+    {
+        using namespace display_driver_api;
+        constexpr int bucket_count = 20000;
+        constexpr uint32_t bucket_size = 64;
+        constexpr size_t pixel_size = 4 * sizeof(float);
+
+        void* zmq_ctx = zmq_ctx_new();
+        TestListenerThread listener(zmq_ctx, "tcp://127.0.0.1:5596", UINT32_MAX);
+        listener.start();
+
+        std::vector<unsigned char> pixels(bucket_size * bucket_size * pixel_size, 0x7f);
+        std::chrono::steady_clock::duration elapsed;
+        {
+            RenderViewConnection connection("tcp://127.0.0.1:5596");
+            const auto image_id = render_view_open_image(connection, -1, make_image_desc());
+            DOCTEST_CHECK(image_id == 1);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < bucket_count; ++i)
+            {
+                const uint32_t x = (i % 64) * bucket_size;
+                const uint32_t y = (i / 64 % 64) * bucket_size;
+                DOCTEST_CHECK(
+                    render_view_write_region(connection, image_id, ROI { x, x + bucket_size, y, y + bucket_size }, pixel_size, pixels.data()) == 0);
+            }
+            DOCTEST_CHECK(connection.flush() == 0);
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        stop_listener(listener, zmq_ctx);
+
+        DOCTEST_CHECK(listener.received_buckets == bucket_count);
+        DOCTEST_CHECK(listener.corrupted_buckets == 0);
+
+        const auto seconds = std::chrono::duration<double>(elapsed).count();
+        const auto megabytes = double(bucket_count) * pixels.size() / (1024 * 1024);
+        DOCTEST_MESSAGE(bucket_count << " buckets: " << bucket_count / seconds << " buckets/s, " << megabytes / seconds << " MB/s");
+    }
+
+    DOCTEST_TEST_CASE("failed_buckets_are_reported_with_their_region")
+    {
+        using namespace display_driver_api;
+        constexpr uint32_t bucket_size = 16;
+        constexpr size_t pixel_size = 4 * sizeof(float);
+        constexpr uint32_t rejected_xstart = 5 * bucket_size;
+
+        void* zmq_ctx = zmq_ctx_new();
+        TestListenerThread listener(zmq_ctx, "tcp://127.0.0.1:5597", rejected_xstart);
+        listener.start();
+
+        std::vector<unsigned char> pixels(bucket_size * bucket_size * pixel_size, 0x7f);
+        {
+            RenderViewConnection connection("tcp://127.0.0.1:5597");
+            connection.set_max_in_flight(4);
+            const auto image_id = render_view_open_image(connection, -1, make_image_desc());
+            DOCTEST_REQUIRE(image_id == 1);
+
+            for (uint32_t i = 0; i < 16; ++i)
+            {
+                const uint32_t x = i * bucket_size;
+                // a later bucket is not blamed for the rejected one
+                DOCTEST_CHECK(render_view_write_region(connection, image_id, ROI { x, x + bucket_size, 0, bucket_size }, pixel_size, pixels.data()) ==
+                              0);
+            }
+            DOCTEST_CHECK(connection.flush() == 2);
+
+            const auto failed = connection.take_failed_messages();
+            DOCTEST_REQUIRE(failed.size() == 1);
+            DOCTEST_CHECK(failed[0].type == Message::Type::WriteRegion);
+            DOCTEST_CHECK(failed[0].image_id == image_id);
+            DOCTEST_CHECK(failed[0].region.xstart == rejected_xstart);
+            DOCTEST_CHECK(failed[0].response_code == 2);
+            DOCTEST_CHECK(connection.take_failed_messages().empty());
+            DOCTEST_CHECK(connection.flush() == 0);
+
+            // replies to requests are not mixed up with the posted ones
+            DOCTEST_CHECK(render_view_open_image(connection, -1, make_image_desc()) == 1);
+        }
+        stop_listener(listener, zmq_ctx);
+        DOCTEST_CHECK(listener.received_buckets == 16);
+    }
+}
@@ -3,8 +3,10 @@
 
 #pragma once
 #include "opendcc/opendcc.h"
+#include "opendcc/render_view/display_driver_api/display_driver_api.h"
 #include <QtCore/QThread>
 
+#include <memory>
 #include <string>
 
 OPENDCC_NAMESPACE_OPEN
@@ -18,13 +20,21 @@ class RenderViewListenerThread : public QThread
     void run();
 
 public:
-    RenderViewListenerThread(RenderViewMainWindow* app, void* zmq_ctx)
+    RenderViewListenerThread(RenderViewMainWindow* app, void* zmq_ctx, const std::string& endpoint = "tcp://127.0.0.1:5556")
         : m_app(app)
-        , m_zmq_ctx(zmq_ctx) {};
+        , m_zmq_ctx(zmq_ctx)
+        , m_endpoint(endpoint) {};
+
+protected:
+    // the returned codes are sent back to the display driver
+    virtual int32_t create_image(int32_t image_id, const display_driver_api::ImageDescription& image_desc);
+    // bucket_data points into the received message and keeps it alive
+    virtual int32_t update_image(int32_t image_id, const display_driver_api::ROI& region, std::shared_ptr<const char> bucket_data);
 
 private:
     RenderViewMainWindow* m_app;
     void* m_zmq_ctx;
+    std::string m_endpoint;
 Q_SIGNALS:
     void new_image();
 };
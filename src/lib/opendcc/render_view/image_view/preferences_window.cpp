@@ -196,9 +196,9 @@ RenderViewPreferencesWindow::RenderViewPreferencesWindow(RenderViewMainWindow* p
     m_assign_button->setContentsMargins(0, 0, 0, 0);
     QPushButton* m_to_defaults_button = new QPushButton(i18n("render_view.preferences.hotkeys", "Reset"), shortcuts_tab_widget);
 
-    m_image_cache_size = new QSpinBox;
-    m_image_cache_size->setRange(0, std::numeric_limits<int>::max());
-    m_image_cache_size->setSingleStep(1);
+    m_image_cache_memory = new QSpinBox;
+    m_image_cache_memory->setRange(64, std::numeric_limits<int>::max());
+    m_image_cache_memory->setSingleStep(256);
     // INIT WIDGETS END
 
     // FILL GENERALS TAB BEGIN
@@ -206,8 +206,8 @@ RenderViewPreferencesWindow::RenderViewPreferencesWindow(RenderViewMainWindow* p
     img_location_line_layout->addWidget(m_scratch_image_location_ledit);
     img_location_line_layout->addWidget(m_scratch_image_location_button);
 
-    image_cache_size_layout->addWidget(new QLabel(i18n("render_view.preferences.general", "Image Cache Size:")));
-    image_cache_size_layout->addWidget(m_image_cache_size);
+    image_cache_size_layout->addWidget(new QLabel(i18n("render_view.preferences.general", "Image Cache Memory (MB):")));
+    image_cache_size_layout->addWidget(m_image_cache_memory);
 
     auto warning_layout = new QHBoxLayout;
     auto warning_label = new QLabel;
@@ -344,7 +344,7 @@ void RenderViewPreferencesWindow::apply_prefs()
     prefs.burn_in_mapping_on_save = m_burn_in_mapping_on_save_chb->isChecked();
     prefs.default_image_color_space = m_color_space_cmb->itemText(m_color_space_cmb->currentIndex());
     prefs.default_display_view = m_display_space_cmb->itemText(m_display_space_cmb->currentIndex());
-    prefs.image_cache_size = m_image_cache_size->value();
+    prefs.image_cache_memory = m_image_cache_memory->value();
 
     auto& translator = Translator::instance();
     const auto language = translator.from_beauty(m_language_cmb->currentText());
@@ -362,7 +362,7 @@ void RenderViewPreferencesWindow::update_pref_windows()
     fill_shortcuts_table();
     m_key_editor->set_key_sequence(QKeySequence());
     m_burn_in_mapping_on_save_chb->setChecked(prefs.burn_in_mapping_on_save);
-    m_image_cache_size->setValue(prefs.image_cache_size);
+    m_image_cache_memory->setValue(prefs.image_cache_memory);
 }
 
 void RenderViewPreferencesWindow::set_scratch_image_location()
@@ -467,7 +467,7 @@ RenderViewPreferences RenderViewPreferences::read(std::unique_ptr<QSettings> set
     preferences.default_display_view = preferences.settings->value("main/default_display_view", "").toString();
     preferences.background_mode = preferences.settings->value("main/background_mode", 0).toInt();
     preferences.show_resolution_guides = preferences.settings->value("main/show_resolution_guides", false).toBool();
-    preferences.image_cache_size = preferences.settings->value("main/image_cache_size", 100).toInt();
+    preferences.image_cache_memory = preferences.settings->value("main/image_cache_memory", 4096).toInt();
     preferences.language = preferences.settings->value("main/language", "English").toString();
     return preferences;
 }
@@ -480,7 +480,7 @@ void RenderViewPreferences::save() const
     settings->setValue("main/default_display_view", default_display_view);
     settings->setValue("main/background_mode", background_mode);
     settings->setValue("main/show_resolution_guides", show_resolution_guides);
-    settings->setValue("main/image_cache_size", image_cache_size);
+    settings->setValue("main/image_cache_memory", image_cache_memory);
     const auto test = language.toStdString();
     settings->setValue("main/language", language);
 }
@@ -38,7 +38,8 @@ struct OPENDCC_RENDER_VIEW_API RenderViewPreferences
     int background_mode;
     bool burn_in_mapping_on_save;
     bool show_resolution_guides;
-    int image_cache_size = 100;
+    // megabytes
+    int image_cache_memory = 4096;
     QString language;
     std::unique_ptr<QSettings> settings;
 
@@ -86,7 +87,7 @@ private:
     QComboBox* m_language_cmb;
     QTableWidget* m_shortcuts_table_widget;
     KeySequenceEdit* m_key_editor;
-    QSpinBox* m_image_cache_size;
+    QSpinBox* m_image_cache_memory;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -11,6 +11,7 @@
 #include <QPushButton>
 #include <QToolButton>
 #include <QHeaderView>
+#include <QScrollBar>
 #include <opendcc/base/logging/logging_utils.h>
 
 OPENDCC_NAMESPACE_OPEN
@@ -35,6 +36,11 @@ LoggerMessageListWidget::LoggerMessageListWidget(MessageModel* model, QWidget* p
     m_messages_table->setItemDelegate(table_item_delegate);
     m_messages_table->setShowGrid(false);
     m_messages_table->setWordWrap(true);
+    // Rows have a uniform height, only rows in the viewport are fitted to wrapped text,
+    // so neither the view nor the header ever walks the whole log.
+    m_messages_table->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_messages_table->verticalHeader()->setDefaultSectionSize(m_messages_table->fontMetrics().height() + 6);
+    connect(m_messages_table->verticalScrollBar(), &QScrollBar::valueChanged, this, &LoggerMessageListWidget::resize_visible_rows);
 
     m_messages_table_proxy->setSourceModel(m_model);
     m_messages_table->setModel(m_messages_table_proxy);
@@ -111,34 +117,31 @@ void LoggerMessageListWidget::on_selected_channels_cleared()
 void LoggerMessageListWidget::set_search_query(QString query)
 {
     m_messages_table_proxy->set_search_query(query);
-    m_messages_table->resizeRowsToContents();
     m_messages_table->scrollToBottom();
+    resize_visible_rows();
 }
 
 void LoggerMessageListWidget::on_selected_channels_changed(const QSet<QString>& selected_channels)
 {
     LoggerWidget::on_selected_channels_changed(selected_channels);
     m_messages_table_proxy->set_channels(selected_channels);
-    m_messages_table->resizeRowsToContents();
     m_messages_table->scrollToBottom();
+    resize_visible_rows();
 }
 
 void LoggerMessageListWidget::on_wrap_mode_changed(bool is_wrap)
 {
     LoggerWidget::on_wrap_mode_changed(is_wrap);
     m_messages_table->setWordWrap(is_wrap);
-    m_messages_table->resizeRowsToContents();
+    update_row_heights();
 }
 
 void LoggerMessageListWidget::on_model_updated(const QVector<Message>& messages)
 {
     if (!messages.empty())
     {
-        for (int i = m_model->rowCount() - messages.size(); i < m_model->rowCount(); i++)
-        {
-            resize_row(i);
-        }
         m_messages_table->scrollToBottom();
+        resize_visible_rows();
     }
 }
 
@@ -147,21 +150,45 @@ void LoggerMessageListWidget::on_message_added(const Message& message) {}
 void LoggerMessageListWidget::resizeEvent(QResizeEvent* event)
 {
     LoggerWidget::resizeEvent(event);
-    m_messages_table->resizeRowsToContents();
+    update_row_heights();
 }
 
 void LoggerMessageListWidget::update_log_level()
 {
     m_messages_table_proxy->set_log_level_mask(m_log_level_mask);
-    m_messages_table->resizeRowsToContents();
     m_messages_table->scrollToBottom();
+    resize_visible_rows();
+}
+
+void LoggerMessageListWidget::update_row_heights()
+{
+    // drops the heights fitted for the previous width or wrap mode
+    m_messages_table->verticalHeader()->reset();
+    resize_visible_rows();
 }
 
-void LoggerMessageListWidget::resize_row(int row)
+void LoggerMessageListWidget::resize_visible_rows()
 {
-    auto index = m_model->index(row, 0);
-    const int row_to_resize = m_messages_table_proxy->mapFromSource(index).row();
-    m_messages_table->resizeRowToContents(row_to_resize);
+    if (!m_messages_table->wordWrap())
+    {
+        return;
+    }
+
+    const int first_row = m_messages_table->rowAt(0);
+    if (first_row < 0)
+    {
+        return;
+    }
+    int last_row = m_messages_table->rowAt(m_messages_table->viewport()->height());
+    if (last_row < 0)
+    {
+        last_row = m_messages_table_proxy->rowCount() - 1;
+    }
+
+    for (int row = first_row; row <= last_row; ++row)
+    {
+        m_messages_table->resizeRowToContents(row);
+    }
 }
 
 TableItemDelegate::TableItemDelegate(QObject* parent /*= nullptr*/)
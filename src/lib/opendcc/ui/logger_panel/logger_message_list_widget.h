@@ -59,7 +59,8 @@ private Q_SLOTS:
 
 private:
     void update_log_level();
-    void resize_row(int row);
+    void update_row_heights();
+    void resize_visible_rows();
 
     MessageTableProxy* m_messages_table_proxy = nullptr;
     uint32_t m_log_level_mask = LogLevelFlags::None;
@@ -220,6 +220,11 @@ void LoggerManager::on_clear_messages(QSet<QString> channels)
     selected_channels_cleared();
 }
 
+void LoggerManager::set_message_capacity(int capacity)
+{
+    m_model->set_capacity(capacity);
+}
+
 void LoggerManager::flush_messages_to_model()
 {
     m_model->append_rows(m_message_buffer);
@@ -32,6 +32,8 @@ public:
     ~LoggerManager() = default;
 
     MessageModel* model() { return m_model; }
+    // Maximum number of messages kept by the model, the oldest ones are dropped first.
+    void set_message_capacity(int capacity);
 
     LoggerManager(const LoggerManager&) = delete;
     LoggerManager(LoggerManager&&) = delete;
@@ -6,6 +6,9 @@
 #include "opendcc/app/ui/application_ui.h"
 #include <opendcc/base/logging/logging_utils.h>
 
+#include <QtAlgorithms>
+#include <algorithm>
+
 OPENDCC_NAMESPACE_OPEN
 OPENDCC_INITIALIZE_LIBRARY_LOG_CHANNEL("Application");
 
@@ -66,9 +69,17 @@ void LoggerWidget::on_wrap_mode_changed(bool is_wrap)
     m_is_wrap = is_wrap;
 }
 
+namespace
+{
+    int log_level_slot(LoggerWidget::LogLevelFlags log_level_flag)
+    {
+        return qCountTrailingZeroBits(static_cast<uint32_t>(log_level_flag));
+    }
+};
+
 int MessageModel::rowCount(const QModelIndex& parent /*= QModelIndex()*/) const
 {
-    return m_messages.size();
+    return m_size;
 }
 
 int MessageModel::columnCount(const QModelIndex& parent /*= QModelIndex()*/) const
@@ -85,38 +96,40 @@ QVariant MessageModel::data(const QModelIndex& index, int role /*= Qt::DisplayRo
         return QVariant();
     }
 
-    if (row >= m_messages.size() || row < 0)
+    if (row >= m_size || row < 0)
     {
         return QVariant();
     }
 
+    const auto& message = message_at(row);
+
     switch (role)
     {
     case Qt::DisplayRole:
         switch (column)
         {
         case 0:
-            return m_messages[row].channel;
+            return message.channel;
         case 1:
-            return QString::fromStdString(log_level_to_str(m_messages[row].log_level));
+            return QString::fromStdString(log_level_to_str(message.log_level));
         case 2:
-            return m_messages[row].message.simplified();
+            return message.message.simplified();
         }
     case Qt::ForegroundRole:
         if (column == 1)
         {
-            return LoggerWidget::log_level_to_color(m_messages[row].log_level);
+            return LoggerWidget::log_level_to_color(message.log_level);
         }
         break;
     case Qt::EditRole:
         switch (column)
         {
         case 0:
-            return m_messages[row].channel;
+            return message.channel;
         case 1:
-            return QString::fromStdString(log_level_to_str(m_messages[row].log_level));
+            return QString::fromStdString(log_level_to_str(message.log_level));
         case 2:
-            return m_messages[row].message.simplified();
+            return message.message.simplified();
         }
     }
     return QVariant();
@@ -151,35 +164,56 @@ QVariant MessageModel::headerData(int section, Qt::Orientation orientation, int
 
 void MessageModel::append_rows(const QVector<Message>& rows)
 {
-    const int check_overflow = std::numeric_limits<int>::max() - rows.size() - m_messages.size();
-    if (check_overflow < 0)
+    if (rows.empty())
     {
-        removeRows(0, -check_overflow);
+        return;
+    }
+
+    // messages that would be evicted by the same batch are never stored
+    const int skip = std::max(0, rows.size() - m_capacity);
+    const int incoming = rows.size() - skip;
+    const int overflow = m_size + incoming - m_capacity;
+    if (overflow > 0)
+    {
+        beginRemoveRows(QModelIndex(), 0, overflow - 1);
+        drop_front(overflow);
+        endRemoveRows();
     }
 
-    beginInsertRows(QModelIndex(), m_messages.size(), m_messages.size() + rows.size() - 1);
-    m_messages.append(rows);
+    beginInsertRows(QModelIndex(), m_size, m_size + incoming - 1);
+    for (int i = skip; i < rows.size(); ++i)
+    {
+        push_message(rows[i]);
+    }
     endInsertRows();
 }
 
 void MessageModel::remove_if(const std::function<bool(const Message&)>& predicate)
 {
-    auto new_end = std::remove_if(m_messages.begin(), m_messages.end(), predicate);
-    int new_size = std::distance(m_messages.begin(), new_end);
+    std::vector<Message> remaining;
+    remaining.reserve(m_size);
+    for (int row = 0; row < m_size; ++row)
+    {
+        const auto& message = message_at(row);
+        if (!predicate(message))
+        {
+            remaining.push_back(message);
+        }
+    }
 
-    if (new_size == m_messages.size())
+    if (static_cast<int>(remaining.size()) == m_size)
     {
         return;
     }
 
-    beginRemoveRows(QModelIndex(), new_size, m_messages.size() - 1);
-    m_messages.erase(new_end, m_messages.end());
-    endRemoveRows();
+    beginResetModel();
+    reset_storage(remaining);
+    endResetModel();
 }
 
 const MessageModel::Message& MessageModel::message_at(int row) const
 {
-    return m_messages[row];
+    return m_messages[storage_index(row)];
 }
 
 Qt::ItemFlags MessageModel::flags(const QModelIndex& index) const
@@ -191,17 +225,23 @@ Qt::ItemFlags MessageModel::flags(const QModelIndex& index) const
 
 QVector<MessageModel::Message> MessageModel::messages() const
 {
-    return m_messages;
+    QVector<Message> result;
+    result.reserve(m_size);
+    for (int row = 0; row < m_size; ++row)
+    {
+        result.push_back(message_at(row));
+    }
+    return result;
 }
 
 bool MessageModel::removeRows(int row, int count, const QModelIndex& parent /*= QModelIndex()*/)
 {
-    if (row < 0 || row > m_messages.size() - 1 || count < 0)
+    if (row < 0 || row > m_size - 1 || count < 0)
     {
         return false;
     }
 
-    if (row + count > m_messages.size())
+    if (row + count > m_size)
     {
         return false;
     }
@@ -211,11 +251,157 @@ bool MessageModel::removeRows(int row, int count, const QModelIndex& parent /*=
         return false;
     }
 
-    beginRemoveRows(parent, row, count);
-    m_messages.remove(row, count);
-    endRemoveRows();
+    if (count == 0)
+    {
+        return true;
+    }
+
+    if (row == 0)
+    {
+        beginRemoveRows(parent, 0, count - 1);
+        drop_front(count);
+        endRemoveRows();
+        return true;
+    }
 
+    // ids of the following rows change, so there is nothing to gain from fine-grained signals
+    std::vector<Message> remaining;
+    remaining.reserve(m_size - count);
+    for (int i = 0; i < m_size; ++i)
+    {
+        if (i < row || i >= row + count)
+        {
+            remaining.push_back(message_at(i));
+        }
+    }
+
+    beginResetModel();
+    reset_storage(remaining);
+    endResetModel();
     return true;
 }
 
+int MessageModel::capacity() const
+{
+    return m_capacity;
+}
+
+void MessageModel::set_capacity(int capacity)
+{
+    capacity = std::max(1, capacity);
+    if (capacity == m_capacity)
+    {
+        return;
+    }
+
+    std::vector<Message> remaining;
+    const int first_row = std::max(0, m_size - capacity);
+    remaining.reserve(m_size - first_row);
+    for (int row = first_row; row < m_size; ++row)
+    {
+        remaining.push_back(message_at(row));
+    }
+
+    beginResetModel();
+    m_capacity = capacity;
+    reset_storage(remaining);
+    endResetModel();
+}
+
+uint64_t MessageModel::first_id() const
+{
+    return m_first_id;
+}
+
+int MessageModel::row_of(uint64_t id) const
+{
+    if (id < m_first_id || id >= m_first_id + m_size)
+    {
+        return -1;
+    }
+    return static_cast<int>(id - m_first_id);
+}
+
+const MessageModel::IdList& MessageModel::ids_by_log_level(LoggerWidget::LogLevelFlags log_level_flag) const
+{
+    return m_log_level_ids[log_level_slot(log_level_flag)];
+}
+
+const MessageModel::IdList* MessageModel::ids_by_channel(const QString& channel) const
+{
+    auto it = m_channel_ids.find(channel);
+    return it == m_channel_ids.end() ? nullptr : &it.value();
+}
+
+int MessageModel::storage_index(int row) const
+{
+    return (m_first + row) % m_capacity;
+}
+
+void MessageModel::push_message(const Message& message)
+{
+    const uint64_t id = m_first_id + m_size;
+    if (static_cast<int>(m_messages.size()) < m_capacity)
+    {
+        // the buffer grows until it reaches the capacity, m_first stays 0 until then
+        m_messages.push_back(message);
+    }
+    else
+    {
+        m_messages[storage_index(m_size)] = message;
+    }
+    ++m_size;
+
+    m_log_level_ids[log_level_slot(LoggerWidget::log_level_to_flag(message.log_level))].push_back(id);
+    m_channel_ids[message.channel].push_back(id);
+}
+
+void MessageModel::drop_front(int count)
+{
+    m_first = storage_index(count);
+    m_size -= count;
+    m_first_id += count;
+
+    auto drop_evicted = [this](IdList& ids) {
+        while (!ids.empty() && ids.front() < m_first_id)
+        {
+            ids.pop_front();
+        }
+    };
+    for (auto& ids : m_log_level_ids)
+    {
+        drop_evicted(ids);
+    }
+    for (auto it = m_channel_ids.begin(); it != m_channel_ids.end();)
+    {
+        drop_evicted(it.value());
+        if (it.value().empty())
+        {
+            it = m_channel_ids.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void MessageModel::reset_storage(const std::vector<Message>& messages)
+{
+    m_messages.clear();
+    m_first = 0;
+    m_size = 0;
+    m_first_id = 0;
+    for (auto& ids : m_log_level_ids)
+    {
+        ids.clear();
+    }
+    m_channel_ids.clear();
+
+    for (const auto& message : messages)
+    {
+        push_message(message);
+    }
+}
+
 OPENDCC_NAMESPACE_CLOSE
@@ -10,9 +10,14 @@
 #include "opendcc/base/logging/logger.h"
 
 #include <QSet>
+#include <QHash>
 #include <QWidget>
 #include <QAbstractTableModel>
 
+#include <array>
+#include <deque>
+#include <vector>
+
 OPENDCC_NAMESPACE_OPEN
 
 class MessageModel;
@@ -60,6 +65,13 @@ protected:
     MessageModel* m_model = nullptr;
 };
 
+/**
+ * @brief Table model that keeps the last capacity() messages in a ring buffer.
+ *
+ * Every message gets a monotonically increasing id, row r holds the message with id first_id() + r.
+ * Ids of stored messages are additionally indexed by log level and channel, so filters can
+ * visit only the messages they are interested in.
+ */
 class MessageModel : public QAbstractTableModel
 {
     Q_OBJECT;
@@ -67,6 +79,9 @@ class MessageModel : public QAbstractTableModel
     using Message = LoggerWidget::Message;
 
 public:
+    using IdList = std::deque<uint64_t>;
+    static constexpr int s_default_capacity = 100000;
+
     MessageModel(QObject* parent = nullptr);
 
     int rowCount(const QModelIndex& parent = QModelIndex()) const override;
@@ -80,8 +95,29 @@ public:
     Qt::ItemFlags flags(const QModelIndex& index) const override;
     bool removeRows(int row, int count, const QModelIndex& parent = QModelIndex()) override;
 
+    int capacity() const;
+    void set_capacity(int capacity);
+
+    uint64_t first_id() const;
+    int row_of(uint64_t id) const;
+    // Sorted ids of the stored messages with the specified log level flag.
+    const IdList& ids_by_log_level(LoggerWidget::LogLevelFlags log_level_flag) const;
+    // Sorted ids of the stored messages of the channel, nullptr if there are none.
+    const IdList* ids_by_channel(const QString& channel) const;
+
 private:
-    QVector<Message> m_messages;
+    int storage_index(int row) const;
+    void push_message(const Message& message);
+    void drop_front(int count);
+    void reset_storage(const std::vector<Message>& messages);
+
+    std::vector<Message> m_messages;
+    int m_first = 0;
+    int m_size = 0;
+    int m_capacity = s_default_capacity;
+    uint64_t m_first_id = 0;
+    std::array<IdList, 5> m_log_level_ids;
+    QHash<QString, IdList> m_channel_ids;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -4,40 +4,326 @@
 #include "opendcc/ui/logger_panel/message_table_proxy.h"
 #include "opendcc/ui/logger_panel/logger_widget.h"
 
+#include <algorithm>
+#include <vector>
+
 OPENDCC_NAMESPACE_OPEN
 
 MessageTableProxy::MessageTableProxy(QObject* parent /* = nullptr */)
-    : QSortFilterProxyModel(parent)
+    : QAbstractProxyModel(parent)
 {
     m_log_level_filter = LoggerWidget::LogLevelFlags::All;
 }
 
-bool MessageTableProxy::filterAcceptsRow(int source_row, const QModelIndex& source_parent) const
+void MessageTableProxy::setSourceModel(QAbstractItemModel* source_model)
+{
+    beginResetModel();
+    if (m_model)
+    {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+
+    m_model = qobject_cast<MessageModel*>(source_model);
+    Q_ASSERT(source_model == nullptr || m_model != nullptr);
+    QAbstractProxyModel::setSourceModel(m_model);
+
+    if (m_model)
+    {
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, &MessageTableProxy::on_source_rows_inserted);
+        connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &MessageTableProxy::on_source_rows_about_to_be_removed);
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, &MessageTableProxy::on_source_rows_removed);
+        connect(m_model, &QAbstractItemModel::modelAboutToBeReset, this, [this] { beginResetModel(); });
+        connect(m_model, &QAbstractItemModel::modelReset, this, [this] {
+            collect_rows();
+            endResetModel();
+        });
+    }
+    collect_rows();
+    endResetModel();
+}
+
+QModelIndex MessageTableProxy::mapToSource(const QModelIndex& proxy_index) const
+{
+    if (!m_model || !proxy_index.isValid() || proxy_index.row() >= static_cast<int>(m_rows.size()))
+    {
+        return QModelIndex();
+    }
+    return m_model->index(m_model->row_of(m_rows[proxy_index.row()]), proxy_index.column());
+}
+
+QModelIndex MessageTableProxy::mapFromSource(const QModelIndex& source_index) const
+{
+    if (!m_model || !source_index.isValid())
+    {
+        return QModelIndex();
+    }
+
+    const uint64_t id = m_model->first_id() + source_index.row();
+    auto it = std::lower_bound(m_rows.begin(), m_rows.end(), id);
+    if (it == m_rows.end() || *it != id)
+    {
+        return QModelIndex();
+    }
+    return createIndex(static_cast<int>(std::distance(m_rows.begin(), it)), source_index.column());
+}
+
+QModelIndex MessageTableProxy::index(int row, int column, const QModelIndex& parent /* = QModelIndex() */) const
+{
+    if (parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount())
+    {
+        return QModelIndex();
+    }
+    return createIndex(row, column);
+}
+
+QModelIndex MessageTableProxy::parent(const QModelIndex& child) const
 {
-    const auto& model = qobject_cast<MessageModel*>(sourceModel());
-    Q_ASSERT(model != nullptr);
-    const auto& message = model->message_at(source_row);
+    return QModelIndex();
+}
+
+int MessageTableProxy::rowCount(const QModelIndex& parent /* = QModelIndex() */) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(m_rows.size());
+}
+
+int MessageTableProxy::columnCount(const QModelIndex& parent /* = QModelIndex() */) const
+{
+    return (m_model && !parent.isValid()) ? m_model->columnCount() : 0;
+}
+
+QVariant MessageTableProxy::headerData(int section, Qt::Orientation orientation, int role /* = Qt::DisplayRole */) const
+{
+    return m_model ? m_model->headerData(section, orientation, role) : QVariant();
+}
 
+bool MessageTableProxy::accepts(const LoggerWidget::Message& message) const
+{
     return m_filter_channels.contains(message.channel) && (LoggerWidget::log_level_to_flag(message.log_level) & m_log_level_filter) &&
            message.message.contains(m_search_query);
 }
 
+void MessageTableProxy::collect_rows()
+{
+    m_rows.clear();
+    if (!m_model)
+    {
+        return;
+    }
+
+    std::vector<const MessageModel::IdList*> log_level_ids;
+    size_t log_level_ids_count = 0;
+    for (uint32_t flag = LoggerWidget::LogLevelFlags::Info; flag <= LoggerWidget::LogLevelFlags::Fatal; flag <<= 1)
+    {
+        if (m_log_level_filter & flag)
+        {
+            const auto& ids = m_model->ids_by_log_level(static_cast<LoggerWidget::LogLevelFlags>(flag));
+            log_level_ids.push_back(&ids);
+            log_level_ids_count += ids.size();
+        }
+    }
+
+    std::vector<const MessageModel::IdList*> channel_ids;
+    size_t channel_ids_count = 0;
+    for (const auto& channel : m_filter_channels)
+    {
+        if (auto ids = m_model->ids_by_channel(channel))
+        {
+            channel_ids.push_back(ids);
+            channel_ids_count += ids->size();
+        }
+    }
+
+    // walk the smaller of the two index unions, the other filters are checked per message
+    const auto& candidate_lists = log_level_ids_count < channel_ids_count ? log_level_ids : channel_ids;
+    std::vector<uint64_t> candidates;
+    candidates.reserve(std::min(log_level_ids_count, channel_ids_count));
+    for (const auto ids : candidate_lists)
+    {
+        candidates.insert(candidates.end(), ids->begin(), ids->end());
+    }
+    if (candidate_lists.size() > 1)
+    {
+        std::sort(candidates.begin(), candidates.end());
+    }
+
+    for (const auto id : candidates)
+    {
+        const int row = m_model->row_of(id);
+        if (row >= 0 && accepts(m_model->message_at(row)))
+        {
+            m_rows.push_back(id);
+        }
+    }
+}
+
+void MessageTableProxy::on_source_rows_inserted(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+    {
+        return;
+    }
+
+    std::vector<uint64_t> accepted;
+    for (int row = first; row <= last; ++row)
+    {
+        if (accepts(m_model->message_at(row)))
+        {
+            accepted.push_back(m_model->first_id() + row);
+        }
+    }
+    if (accepted.empty())
+    {
+        return;
+    }
+
+    // MessageModel only appends, so the new ids are greater than any accepted one
+    beginInsertRows(QModelIndex(), static_cast<int>(m_rows.size()), static_cast<int>(m_rows.size() + accepted.size()) - 1);
+    m_rows.insert(m_rows.end(), accepted.begin(), accepted.end());
+    endInsertRows();
+}
+
+void MessageTableProxy::on_source_rows_about_to_be_removed(const QModelIndex& parent, int first, int last)
+{
+    if (parent.isValid())
+    {
+        return;
+    }
+
+    const uint64_t first_id = m_model->first_id() + first;
+    const uint64_t last_id = m_model->first_id() + last;
+    const auto begin = std::lower_bound(m_rows.begin(), m_rows.end(), first_id);
+    const auto end = std::upper_bound(begin, m_rows.end(), last_id);
+    if (begin == end)
+    {
+        return;
+    }
+
+    const int proxy_first = static_cast<int>(std::distance(m_rows.begin(), begin));
+    const int proxy_last = static_cast<int>(std::distance(m_rows.begin(), end)) - 1;
+    beginRemoveRows(QModelIndex(), proxy_first, proxy_last);
+    m_rows.erase(begin, end);
+    m_removing_rows = true;
+}
+
+void MessageTableProxy::on_source_rows_removed(const QModelIndex& parent, int first, int last)
+{
+    if (m_removing_rows)
+    {
+        m_removing_rows = false;
+        endRemoveRows();
+    }
+}
+
+void MessageTableProxy::invalidate()
+{
+    beginResetModel();
+    collect_rows();
+    endResetModel();
+}
+
 void MessageTableProxy::set_search_query(const QString& query)
 {
     m_search_query = query;
-    invalidateFilter();
+    invalidate();
 }
 
 void MessageTableProxy::set_log_level_mask(uint32_t log_level_mask)
 {
     m_log_level_filter = log_level_mask;
-    invalidateFilter();
+    invalidate();
 }
 
 void MessageTableProxy::set_channels(const QSet<QString>& channels)
 {
     m_filter_channels = channels;
-    invalidateFilter();
+    invalidate();
 }
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("logger_panel")
+{
+    DOCTEST_TEST_CASE("message_model_ring_buffer")
+    {
+        MessageModel model;
+        model.set_capacity(10);
+
+        QVector<LoggerWidget::Message> messages;
+        for (int i = 0; i < 25; ++i)
+        {
+            messages.push_back({ i % 2 ? "odd" : "even", LogLevel::Info, QString::number(i) });
+        }
+        model.append_rows(messages.mid(0, 8));
+        model.append_rows(messages.mid(8));
+
+        DOCTEST_CHECK(model.rowCount() == 10);
+        DOCTEST_CHECK(model.message_at(0).message == "15");
+        DOCTEST_CHECK(model.message_at(9).message == "24");
+        DOCTEST_CHECK(model.ids_by_channel("odd")->size() == 5);
+        DOCTEST_CHECK(model.ids_by_log_level(LoggerWidget::LogLevelFlags::Info).size() == 10);
+
+        model.remove_if([](const LoggerWidget::Message& message) { return message.channel == "odd"; });
+        DOCTEST_CHECK(model.rowCount() == 5);
+        DOCTEST_CHECK(model.ids_by_channel("odd") == nullptr);
+        DOCTEST_CHECK(model.message_at(0).message == "16");
+    }
+
+    DOCTEST_TEST_CASE("message_table_proxy_throughput")
+    {
+        const QString channels[] = { "Application", "Render", "USD", "Python" };
+        const LogLevel log_levels[] = { LogLevel::Info, LogLevel::Debug, LogLevel::Warning, LogLevel::Error, LogLevel::Fatal };
+        constexpr int message_count = 1000000;
+        constexpr int batch_size = 1000;
+        constexpr int capacity = 100000;
+
+        MessageModel model;
+        model.set_capacity(capacity);
+        MessageTableProxy proxy;
+        proxy.setSourceModel(&model);
+        proxy.set_channels({ channels[0], channels[1] });
+        proxy.set_log_level_mask(LoggerWidget::LogLevelFlags::Warning | LoggerWidget::LogLevelFlags::Error);
+
+        const auto start = std::chrono::steady_clock::now();
+        QVector<LoggerWidget::Message> batch;
+        batch.reserve(batch_size);
+        for (int i = 0; i < message_count; ++i)
+        {
+            batch.push_back({ channels[i % 4], log_levels[i % 5], "message" });
+            if (batch.size() == batch_size)
+            {
+                model.append_rows(batch);
+                batch.clear();
+            }
+        }
+        const auto appended = std::chrono::steady_clock::now();
+
+        int expected_rows = 0;
+        for (int i = message_count - capacity; i < message_count; ++i)
+        {
+            const bool channel_accepted = i % 4 < 2;
+            const bool log_level_accepted = log_levels[i % 5] == LogLevel::Warning || log_levels[i % 5] == LogLevel::Error;
+            expected_rows += channel_accepted && log_level_accepted;
+        }
+        DOCTEST_CHECK(model.rowCount() == capacity);
+        DOCTEST_CHECK(proxy.rowCount() == expected_rows);
+        DOCTEST_CHECK(model.index(model.rowCount() - 1, 2).data().toString() == "message");
+
+        proxy.set_channels({ channels[3] });
+        proxy.set_log_level_mask(LoggerWidget::LogLevelFlags::Fatal);
+        const auto filtered = std::chrono::steady_clock::now();
+        DOCTEST_CHECK(proxy.rowCount() == capacity / 20);
+
+        using ms = std::chrono::duration<double, std::milli>;
+        DOCTEST_MESSAGE("appended " << message_count << " messages in " << ms(appended - start).count() << " ms, refiltered in "
+                                    << ms(filtered - appended).count() << " ms");
+    }
+}
@@ -5,26 +5,51 @@
 
 #pragma once
 #include "opendcc/opendcc.h"
-#include <QSortFilterProxyModel>
+#include <QAbstractProxyModel>
 #include <QSet>
+#include <deque>
 #include "opendcc/base/logging/logger.h"
+#include "opendcc/ui/logger_panel/logger_widget.h"
 
 OPENDCC_NAMESPACE_OPEN
-class MessageTableProxy : public QSortFilterProxyModel
+/**
+ * @brief Filtering proxy over MessageModel.
+ *
+ * Accepted rows are kept as sorted message ids and are collected from the model's
+ * log level and channel indices, so refiltering costs O(matching) rather than O(messages).
+ */
+class MessageTableProxy : public QAbstractProxyModel
 {
     Q_OBJECT;
 
 public:
     MessageTableProxy(QObject* parent = nullptr);
 
+    void setSourceModel(QAbstractItemModel* source_model) override;
+
+    QModelIndex mapToSource(const QModelIndex& proxy_index) const override;
+    QModelIndex mapFromSource(const QModelIndex& source_index) const override;
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
     void set_channels(const QSet<QString>& channels);
     void set_log_level_mask(uint32_t log_level_mask);
     void set_search_query(const QString& query);
-
-protected:
-    bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const override;
+    void invalidate();
 
 private:
+    bool accepts(const LoggerWidget::Message& message) const;
+    void collect_rows();
+    void on_source_rows_inserted(const QModelIndex& parent, int first, int last);
+    void on_source_rows_about_to_be_removed(const QModelIndex& parent, int first, int last);
+    void on_source_rows_removed(const QModelIndex& parent, int first, int last);
+
+    MessageModel* m_model = nullptr;
+    std::deque<uint64_t> m_rows;
+    bool m_removing_rows = false;
     QSet<QString> m_filter_channels;
     uint32_t m_log_level_filter = 0;
     QString m_search_query = "";
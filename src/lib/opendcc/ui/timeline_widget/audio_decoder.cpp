@@ -4,27 +4,70 @@
 #include "audio_decoder.h"
 
 #include <QDebug>
+#include <QRunnable>
+#include <QThreadPool>
+#include <algorithm>
 #include <cmath>
+#include <functional>
+#include <limits>
+
+namespace
+{
+    class WavePyramidTask : public QRunnable
+    {
+    public:
+        WavePyramidTask(std::function<void()> fn)
+            : m_fn(std::move(fn))
+        {
+        }
+
+        void run() override { m_fn(); }
+
+    private:
+        std::function<void()> m_fn;
+    };
+
+    qint16 to_sample(const qreal level)
+    {
+        return static_cast<qint16>(std::lround(qBound(qreal(-1), level, qreal(1)) * std::numeric_limits<qint16>::max()));
+    }
+
+    qreal to_level(const qint16 sample)
+    {
+        return qreal(sample) / std::numeric_limits<qint16>::max();
+    }
+};
 
 AudioDecoder::AudioDecoder(QObject* parent /*= nullptr*/)
+    : QObject(parent)
 {
     m_audio_decoder = new QAudioDecoder(this);
     connect(m_audio_decoder, &QAudioDecoder::finished, this, &AudioDecoder::finish);
 
     connect(m_audio_decoder, &QAudioDecoder::bufferReady, this, &AudioDecoder::process_buffer);
+
+    m_thread_pool = new QThreadPool(this);
+    m_thread_pool->setMaxThreadCount(1);
+}
+
+AudioDecoder::~AudioDecoder()
+{
+    m_thread_pool->waitForDone();
 }
 
 void AudioDecoder::set_source_filename(const QString& path)
 {
-    m_levels.clear();
+    m_samples.clear();
+    m_pyramid.clear();
     m_ready = false;
+    ++m_generation;
     m_audio_decoder->setSourceFilename(path);
     m_audio_decoder->start();
 }
 
-const QVector<qreal>& AudioDecoder::get_levels() const
+const std::vector<qint16>& AudioDecoder::get_samples() const
 {
-    return m_levels;
+    return m_samples;
 }
 
 const bool AudioDecoder::is_ready() const
@@ -45,7 +88,7 @@ void AudioDecoder::compute_wave(QVector<qreal>& wave, const int num_pixels, cons
     const double duration = compute_duration(end_frame - start_frame, fps);
     const qint64 pixel_duration = qint64(duration) / num_pixels;
 
-    auto format = m_audio_buffer.format();
+    const auto& format = m_format;
     int begging_shift = format.framesForDuration(compute_duration(start_frame, fps));
     if (start_frame < 0)
         begging_shift *= -1;
@@ -55,33 +98,89 @@ void AudioDecoder::compute_wave(QVector<qreal>& wave, const int num_pixels, cons
     begging_shift -= play_shift;
 
     const int pixel_frames = format.framesForDuration(pixel_duration);
+    const qint64 num_samples = m_samples.size();
+
+    // the coarsest level whose peaks are not wider than a pixel
+    int level = -1;
+    qint64 peak_frames = 1;
+    while (level + 1 < int(m_pyramid.size()) && peak_frames * s_pyramid_factor <= pixel_frames)
+    {
+        ++level;
+        peak_frames *= s_pyramid_factor;
+    }
 
     for (int i = 0; i < num_pixels; i++)
     {
-        const int frame = pixel_frames * i + begging_shift;
+        const qint64 frame = qint64(pixel_frames) * i + begging_shift;
 
-        qreal wave_max = 0.0;
-        qreal wave_min = 0.0;
+        qint16 wave_max = 0;
+        qint16 wave_min = 0;
 
-        for (int j = 0; j < pixel_frames; j++)
+        if (level < 0)
+        {
+            for (qint64 current_frame = std::max<qint64>(frame, 0); current_frame < std::min(frame + pixel_frames, num_samples); current_frame++)
+            {
+                wave_max = std::max(wave_max, m_samples[current_frame]);
+                wave_min = std::min(wave_min, m_samples[current_frame]);
+            }
+        }
+        else
         {
-            const int current_frame = frame + j;
-            if (current_frame >= 0 && current_frame < m_levels.size())
+            // every peak belongs to the pixel its first sample falls into, so the pixels
+            // partition the peaks without gaps and overlaps
+            const auto& peaks = m_pyramid[level];
+            const qint64 first_peak = std::max<qint64>(0, (std::max<qint64>(frame, 0) + peak_frames - 1) / peak_frames);
+            const qint64 end_peak = std::min<qint64>(peaks.size(), (std::max<qint64>(frame + pixel_frames, 0) + peak_frames - 1) / peak_frames);
+            for (qint64 peak = first_peak; peak < end_peak; peak++)
             {
-                const qreal level = m_levels[current_frame];
-                wave_max = std::max(wave_max, level);
-                wave_min = std::min(wave_min, level);
+                wave_max = std::max(wave_max, peaks[peak].max);
+                wave_min = std::min(wave_min, peaks[peak].min);
             }
         }
 
-        wave.append(wave_max);
-        wave.append(wave_min);
+        wave.append(to_level(wave_max));
+        wave.append(to_level(wave_min));
+    }
+}
+
+void AudioDecoder::build_pyramid(WaveData& data)
+{
+    data.pyramid.clear();
+    if (data.samples.size() < size_t(s_pyramid_factor))
+        return;
+
+    std::vector<Peak> peaks((data.samples.size() + s_pyramid_factor - 1) / s_pyramid_factor);
+    for (size_t i = 0; i < peaks.size(); i++)
+    {
+        const auto begin = data.samples.begin() + i * s_pyramid_factor;
+        const auto end = data.samples.begin() + std::min(data.samples.size(), (i + 1) * s_pyramid_factor);
+        const auto min_max = std::minmax_element(begin, end);
+        peaks[i] = { *min_max.first, *min_max.second };
+    }
+    data.pyramid.push_back(std::move(peaks));
+
+    while (data.pyramid.back().size() >= size_t(s_pyramid_factor))
+    {
+        const auto& prev = data.pyramid.back();
+        std::vector<Peak> next((prev.size() + s_pyramid_factor - 1) / s_pyramid_factor);
+        for (size_t i = 0; i < next.size(); i++)
+        {
+            Peak peak = prev[i * s_pyramid_factor];
+            for (size_t j = i * s_pyramid_factor + 1; j < std::min(prev.size(), (i + 1) * s_pyramid_factor); j++)
+            {
+                peak.min = std::min(peak.min, prev[j].min);
+                peak.max = std::max(peak.max, prev[j].max);
+            }
+            next[i] = peak;
+        }
+        data.pyramid.push_back(std::move(next));
     }
 }
 
 void AudioDecoder::clear()
 {
     m_ready = false;
+    ++m_generation;
 }
 
 inline qreal get_peak_value(const QAudioFormat& format)
@@ -121,37 +220,37 @@ inline qreal get_peak_value(const QAudioFormat& format)
     return qreal(0);
 }
 
-template <class T>
-void get_buffer_levels(const T* buffer, int frames, int channels, QVector<qreal>& levels)
+template <class T, class Normalize>
+void get_buffer_levels(const T* buffer, int frames, int channels, Normalize normalize, std::vector<qint16>& samples)
 {
     for (int i = 0; i < frames; ++i)
     {
-        levels.append(qreal(buffer[i * channels])); // only one channel
+        samples.push_back(to_sample(normalize(qreal(buffer[i * channels])))); // only one channel
     }
 }
 
 void AudioDecoder::process_buffer()
 {
-    m_audio_buffer = m_audio_decoder->read();
+    const QAudioBuffer audio_buffer = m_audio_decoder->read();
+    m_format = audio_buffer.format();
 
-    if (!m_audio_buffer.format().isValid() || m_audio_buffer.format().byteOrder() != QAudioFormat::LittleEndian)
+    if (!m_format.isValid() || m_format.byteOrder() != QAudioFormat::LittleEndian)
     {
         m_ready = false;
         return;
     }
 
-    if (m_audio_buffer.format().codec() != "audio/pcm")
+    if (m_format.codec() != "audio/pcm")
     {
         m_ready = false;
         return;
     }
 
-    int channel_count = m_audio_buffer.format().channelCount();
-    int levels_start = m_levels.size();
-    int frames = m_audio_buffer.frameCount();
-    m_levels.reserve(frames);
+    int channel_count = m_format.channelCount();
+    int frames = audio_buffer.frameCount();
+    m_samples.reserve(m_samples.size() + frames);
 
-    qreal peak_value = get_peak_value(m_audio_buffer.format());
+    qreal peak_value = get_peak_value(m_format);
     if (qFuzzyCompare(peak_value, qreal(0)))
     {
         m_ready = true;
@@ -159,44 +258,58 @@ void AudioDecoder::process_buffer()
         return;
     }
 
-    switch (m_audio_buffer.format().sampleType())
+    const qreal half_peak_value = peak_value / 2;
+    auto normalize_unsigned = [half_peak_value](qreal level) { return qAbs(level - half_peak_value) / half_peak_value; };
+    auto normalize_signed = [peak_value](qreal level) { return level / peak_value; };
+
+    switch (m_format.sampleType())
     {
     case QAudioFormat::Unknown:
     case QAudioFormat::UnSignedInt:
-        if (m_audio_buffer.format().sampleSize() == 32)
-            get_buffer_levels(m_audio_buffer.constData<quint32>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-        if (m_audio_buffer.format().sampleSize() == 16)
-            get_buffer_levels(m_audio_buffer.constData<quint16>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-        if (m_audio_buffer.format().sampleSize() == 8)
-            get_buffer_levels(m_audio_buffer.constData<quint8>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-        for (int i = 0; i < frames; ++i)
-            m_levels[levels_start + i] = qAbs(m_levels.at(levels_start + i) - peak_value / 2) / (peak_value / 2);
+        if (m_format.sampleSize() == 32)
+            get_buffer_levels(audio_buffer.constData<quint32>(), frames, channel_count, normalize_unsigned, m_samples);
+        if (m_format.sampleSize() == 16)
+            get_buffer_levels(audio_buffer.constData<quint16>(), frames, channel_count, normalize_unsigned, m_samples);
+        if (m_format.sampleSize() == 8)
+            get_buffer_levels(audio_buffer.constData<quint8>(), frames, channel_count, normalize_unsigned, m_samples);
         break;
     case QAudioFormat::Float:
-        if (m_audio_buffer.format().sampleSize() == 32)
-        {
-            get_buffer_levels(m_audio_buffer.constData<float>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-            for (int i = 0; i < frames; ++i)
-                m_levels[levels_start + i] /= peak_value;
-        }
+        if (m_format.sampleSize() == 32)
+            get_buffer_levels(audio_buffer.constData<float>(), frames, channel_count, normalize_signed, m_samples);
         break;
     case QAudioFormat::SignedInt:
-        if (m_audio_buffer.format().sampleSize() == 32)
-            get_buffer_levels(m_audio_buffer.constData<qint32>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-        if (m_audio_buffer.format().sampleSize() == 16)
-            get_buffer_levels(m_audio_buffer.constData<qint16>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-        if (m_audio_buffer.format().sampleSize() == 8)
-            get_buffer_levels(m_audio_buffer.constData<qint8>(), m_audio_buffer.frameCount(), channel_count, m_levels);
-        for (int i = 0; i < frames; ++i)
-            m_levels[levels_start + i] /= peak_value;
+        if (m_format.sampleSize() == 32)
+            get_buffer_levels(audio_buffer.constData<qint32>(), frames, channel_count, normalize_signed, m_samples);
+        if (m_format.sampleSize() == 16)
+            get_buffer_levels(audio_buffer.constData<qint16>(), frames, channel_count, normalize_signed, m_samples);
+        if (m_format.sampleSize() == 8)
+            get_buffer_levels(audio_buffer.constData<qint8>(), frames, channel_count, normalize_signed, m_samples);
         break;
     }
 }
 
 void AudioDecoder::finish()
 {
-    m_ready = true;
-    emit finish_decoding();
+    // samples are handed over to the worker and come back together with the pyramid
+    auto data = std::make_shared<WaveData>();
+    data->samples = std::move(m_samples);
+    m_samples.clear();
+
+    const int generation = m_generation;
+    m_thread_pool->start(new WavePyramidTask([this, data, generation] {
+        build_pyramid(*data);
+        QMetaObject::invokeMethod(
+            this,
+            [this, data, generation] {
+                if (generation != m_generation)
+                    return;
+                m_samples = std::move(data->samples);
+                m_pyramid = std::move(data->pyramid);
+                m_ready = true;
+                emit finish_decoding();
+            },
+            Qt::QueuedConnection);
+    }));
 }
 
 void AudioDecoder::handle_error(QAudioDecoder::Error error)
@@ -7,9 +7,18 @@
 
 #include <QObject>
 #include <QAudioDecoder>
+#include <QAudioFormat>
+#include <memory>
+#include <vector>
+
+class QThreadPool;
 
 /**
  * @brief This class represents an audio decoder with waveform analysis capabilities.
+ *
+ * Decoded samples of the first channel are stored as int16 values. Once decoding is finished,
+ * a min/max pyramid is built on a worker thread, each level reduces the previous one by s_pyramid_factor.
+ * The decoder becomes ready when the pyramid is available.
  */
 
 class AudioDecoder : public QObject
@@ -23,6 +32,7 @@ public:
      * @param parent The parent QObject.
      */
     AudioDecoder(QObject* parent = nullptr);
+    ~AudioDecoder() override;
     /**
      * @brief Sets the source filename for decoding.
      *
@@ -31,11 +41,11 @@ public:
     void set_source_filename(const QString& path);
 
     /**
-     * @brief Retrieves the audio levels.
+     * @brief Retrieves the decoded samples of the first channel, normalized to the int16 range.
      *
-     * @return The audio levels.
+     * @return The audio samples.
      */
-    const QVector<qreal>& get_levels() const;
+    const std::vector<qint16>& get_samples() const;
     /**
      * @brief Checks if the decoder is ready for decoding.
      *
@@ -45,6 +55,9 @@ public:
     /**
      * @brief Computes the waveform from the audio samples based on the given parameters.
      *
+     * The min/max pyramid level closest to the pixel width is used, so the cost depends on
+     * the number of pixels rather than on the number of covered samples.
+     *
      * @param wave The computed waveform.
      * @param num_pixels The number of pixels to represent the waveform.
      * @param start_frame The starting frame.
@@ -71,8 +84,25 @@ private Q_SLOTS:
     void handle_error(QAudioDecoder::Error error);
 
 private:
+    struct Peak
+    {
+        qint16 min = 0;
+        qint16 max = 0;
+    };
+    struct WaveData
+    {
+        std::vector<qint16> samples;
+        std::vector<std::vector<Peak>> pyramid;
+    };
+    static constexpr int s_pyramid_factor = 4;
+
+    static void build_pyramid(WaveData& data);
+
     bool m_ready = false;
+    int m_generation = 0;
     QAudioDecoder* m_audio_decoder;
-    QAudioBuffer m_audio_buffer;
-    QVector<qreal> m_levels;
+    QAudioFormat m_format;
+    QThreadPool* m_thread_pool = nullptr;
+    std::vector<qint16> m_samples;
+    std::vector<std::vector<Peak>> m_pyramid;
 };
@@ -323,6 +323,10 @@ void IpcRender::create_command_server()
     m_main_server_info.input_port = config.get<uint32_t>("ipc.command_server.port", 8000);
 
     ipc::CommandServer::set_server_timeout(config.get<int>("ipc.command_server.server_timeout", 1000));
+    if (config.get<std::string>("ipc.command_server.protocol", "binary") == "text")
+    {
+        ipc::CommandServer::set_protocol(ipc::CommandServer::Protocol::Text);
+    }
 
     ipc::ServerInfo info;
     info.hostname = "127.0.0.1";
@@ -333,7 +337,7 @@ void IpcRender::create_command_server()
     command.name = "ServerCreated";
     command.args["pid"] = get_pid_string();
     command.args["hostname"] = info.hostname;
-    command.args["input_port"] = std::to_string(info.input_port);
+    command.args["input_port"] = info.input_port;
     m_server->send_command(m_main_server_info, command);
 
     ipc::CommandRegistry::instance().add_handler("CropUsdRender", [this](const ipc::Command& command) {
@@ -350,10 +354,10 @@ void IpcRender::create_command_server()
         }
         else
         {
-            const auto min_x = std::atoi(min_x_str->second.c_str());
-            const auto max_x = std::atoi(max_x_str->second.c_str());
-            const auto min_y = std::atoi(min_y_str->second.c_str());
-            const auto max_y = std::atoi(max_y_str->second.c_str());
+            const auto min_x = static_cast<int>(min_x_str->second.get_int());
+            const auto max_x = static_cast<int>(max_x_str->second.get_int());
+            const auto min_y = static_cast<int>(min_y_str->second.get_int());
+            const auto max_y = static_cast<int>(max_y_str->second.get_int());
 
             m_params.crop_region = GfRect2i(GfVec2i(min_x, min_y), GfVec2i(max_x, max_y));
         }
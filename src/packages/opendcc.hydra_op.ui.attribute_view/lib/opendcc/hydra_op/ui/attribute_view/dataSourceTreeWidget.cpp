@@ -14,8 +14,10 @@
 #include <QContextMenuEvent>
 #include <QFileDialog>
 #include <QMenu>
+#include <QPalette>
 #include <QTimer>
 
+#include <algorithm>
 #include <cstdio>
 #include <iostream>
 #include <fstream>
@@ -26,6 +28,23 @@ PXR_NAMESPACE_OPEN_SCOPE
 namespace
 {
 
+    // Children of vector data sources are built in pages of this size,
+    // the rest is represented by a placeholder item that loads the next page
+    // when it is clicked.
+    static const size_t _vectorPageSize = 256;
+
+    class Hdui_MoreElementsTreeWidgetItem : public QTreeWidgetItem
+    {
+    public:
+        Hdui_MoreElementsTreeWidgetItem(QTreeWidgetItem *parentItem, size_t remaining)
+            : QTreeWidgetItem(parentItem)
+        {
+            setText(0, QString("... %1 more").arg(static_cast<qulonglong>(remaining)));
+            setForeground(0, QPalette().brush(QPalette::Disabled, QPalette::WindowText));
+            setChildIndicatorPolicy(QTreeWidgetItem::DontShowIndicator);
+        }
+    };
+
     class Hdui_DataSourceTreeWidgetItem : public QTreeWidgetItem
     {
     public:
@@ -141,14 +160,15 @@ namespace
                     // confirm that existing data source is also a vector
                     // of the same length (could reuse items but probably not
                     // worth the extra complexity)
-                    if (!existingVectorDataSource || childCount() != static_cast<int>(vectorDataSource->GetNumElements()))
+                    if (!existingVectorDataSource || existingVectorDataSource->GetNumElements() != vectorDataSource->GetNumElements())
                     {
                         _dataSource = dataSource;
                         _RebuildChildren();
                         return;
                     }
 
-                    for (size_t i = 0, e = vectorDataSource->GetNumElements(); i != e; ++i)
+                    // only the elements of the loaded pages have items
+                    for (size_t i = 0; i != _builtElementCount; ++i)
                     {
                         if (Hdui_DataSourceTreeWidgetItem *childItem = dynamic_cast<Hdui_DataSourceTreeWidgetItem *>(child(i)))
                         {
@@ -166,10 +186,42 @@ namespace
 
         HdDataSourceLocator GetLocator() { return _locator; }
 
+        void BuildNextPage()
+        {
+            HdVectorDataSourceHandle vectorDs = HdVectorDataSource::Cast(_dataSource);
+            if (!vectorDs)
+            {
+                return;
+            }
+
+            if (_moreItem)
+            {
+                delete _moreItem;
+                _moreItem = nullptr;
+            }
+
+            const size_t count = vectorDs->GetNumElements();
+            const size_t end = std::min(count, _builtElementCount + _vectorPageSize);
+            char buffer[32];
+            for (size_t i = _builtElementCount; i != end; ++i)
+            {
+                snprintf(buffer, sizeof(buffer), "i%d", static_cast<int>(i));
+                new Hdui_DataSourceTreeWidgetItem(_locator.Append(TfToken(buffer)), this, vectorDs->GetElement(i));
+            }
+            _builtElementCount = end;
+
+            if (end != count)
+            {
+                _moreItem = new Hdui_MoreElementsTreeWidgetItem(this, count - end);
+            }
+        }
+
     private:
         HdDataSourceLocator _locator;
         HdDataSourceBaseHandle _dataSource;
         bool _childrenBuilt;
+        size_t _builtElementCount = 0;
+        Hdui_MoreElementsTreeWidgetItem *_moreItem = nullptr;
 
         using _LocatorSet = std::unordered_set<HdDataSourceLocator, TfHash>;
         static _LocatorSet &_GetExpandedSet()
@@ -203,6 +255,8 @@ namespace
             {
                 delete item;
             }
+            _builtElementCount = 0;
+            _moreItem = nullptr;
             _BuildChildren();
         }
 
@@ -226,14 +280,9 @@ namespace
                     }
                 }
             }
-            else if (HdVectorDataSourceHandle vectorDs = HdVectorDataSource::Cast(_dataSource))
+            else if (HdVectorDataSource::Cast(_dataSource))
             {
-                char buffer[16];
-                for (size_t i = 0, e = vectorDs->GetNumElements(); i != e; ++i)
-                {
-                    sprintf(buffer, "i%d", static_cast<int>(i));
-                    new Hdui_DataSourceTreeWidgetItem(_locator.Append(TfToken(buffer)), this, vectorDs->GetElement(i));
-                }
+                BuildNextPage();
             }
         }
     };
@@ -262,6 +311,23 @@ HduiDataSourceTreeWidget::HduiDataSourceTreeWidget(QWidget *parent)
         }
     });
 
+    connect(this, &QTreeWidget::itemClicked, [this](QTreeWidgetItem *item) {
+        if (!dynamic_cast<Hdui_MoreElementsTreeWidgetItem *>(item) || !item->parent())
+        {
+            return;
+        }
+
+        // the clicked item is replaced by the next page, so defer it
+        // until the click is handled
+        QPersistentModelIndex parentIndex(indexFromItem(item->parent()));
+        QTimer::singleShot(0, this, [this, parentIndex]() {
+            if (Hdui_DataSourceTreeWidgetItem *dsItem = dynamic_cast<Hdui_DataSourceTreeWidgetItem *>(itemFromIndex(parentIndex)))
+            {
+                dsItem->BuildNextPage();
+            }
+        });
+    });
+
     connect(this, &QTreeWidget::itemSelectionChanged, [this]() {
         QList<QTreeWidgetItem *> items = this->selectedItems();
         if (items.empty())
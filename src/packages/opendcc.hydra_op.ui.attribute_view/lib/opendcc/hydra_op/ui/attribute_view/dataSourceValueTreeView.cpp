@@ -8,13 +8,21 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "dataSourceValueTreeView.h"
+#include "pxr/base/gf/traits.h"
+#include "pxr/base/vt/types.h"
+#include "pxr/base/work/detachedTask.h"
 #include "pxr/imaging/hd/dataSourceTypeDefs.h"
 
 #include <QAbstractItemModel>
+#include <QCoreApplication>
 #include <QHeaderView>
+#include <QPointer>
 #include <QString>
 
+#include <algorithm>
+#include <memory>
 #include <sstream>
+#include <type_traits>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -44,24 +52,7 @@ public:
             if (index.column() == 0)
             {
                 std::ostringstream buffer;
-                if (_value.IsHolding<SdfPathVector>())
-                {
-                    // Special case for SdfPathVector.
-                    //
-                    // Arguably, this would be even more useful defined as
-                    // SdfPath::operator<<(); however, it is unclear what
-                    // formatting would make the most sense there, whereas
-                    // in hdui a newline separator is best for readability.
-                    SdfPathVector paths = _value.Get<SdfPathVector>();
-                    for (SdfPath const &path : paths)
-                    {
-                        buffer << path << "\n";
-                    }
-                }
-                else
-                {
-                    buffer << _value;
-                }
+                buffer << _value;
                 std::string str = buffer.str();
                 return QVariant(QString::fromUtf8(str.data(), str.size()));
             }
@@ -114,17 +105,85 @@ protected:
 
 //-----------------------------------------------------------------------------
 
+// Byte values are shown as numbers rather than characters.
+template <typename T>
+const T &Hdui_Printable(const T &value)
+{
+    return value;
+}
+
+inline int Hdui_Printable(unsigned char value)
+{
+    return value;
+}
+
+// Component-wise min/max of the array values, shown in the header of the
+// array models. Only computed for the scalar and vector types. Values with
+// a NaN component are left out of the range, since comparisons with NaN
+// would make the result depend on the order of the elements.
+template <typename T, typename Enable = void>
+struct Hdui_ValueRange
+{
+    static constexpr bool supported = false;
+    static bool HasNan(const T &) { return false; }
+    static void Extend(T &, T &, const T &) {}
+};
+
+template <typename T>
+struct Hdui_ValueRange<T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, bool>::value>::type>
+{
+    static constexpr bool supported = true;
+    static bool HasNan(const T &value) { return value != value; }
+    static void Extend(T &minValue, T &maxValue, const T &value)
+    {
+        minValue = std::min(minValue, value);
+        maxValue = std::max(maxValue, value);
+    }
+};
+
 template <typename T>
+struct Hdui_ValueRange<T, typename std::enable_if<GfIsGfVec<T>::value>::type>
+{
+    static constexpr bool supported = true;
+    static bool HasNan(const T &value)
+    {
+        for (size_t i = 0; i < T::dimension; ++i)
+        {
+            if (value[i] != value[i])
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+    static void Extend(T &minValue, T &maxValue, const T &value)
+    {
+        for (size_t i = 0; i < T::dimension; ++i)
+        {
+            minValue[i] = std::min(minValue[i], value[i]);
+            maxValue[i] = std::max(maxValue[i], value[i]);
+        }
+    }
+};
+
+//-----------------------------------------------------------------------------
+
+// Shows every array element in its own row. Rows are formatted on demand,
+// so only the visible part of a large array is converted to strings.
+// The value range is computed on a worker thread and added to the header
+// once it is ready.
+template <typename T, typename Array = VtArray<T>>
 class Hdui_TypedArrayValueItemModel : public Hdui_ValueItemModel
 {
 public:
     Hdui_TypedArrayValueItemModel(VtValue value, QObject *parent = nullptr)
         : Hdui_ValueItemModel(value, parent)
     {
-        if (_value.IsHolding<VtArray<T>>())
+        if (_value.IsHolding<Array>())
         {
-            _array = _value.UncheckedGet<VtArray<T>>();
+            _array = _value.UncheckedGet<Array>();
         }
+        _ComputeRangeAsync();
     }
 
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override
@@ -154,7 +213,7 @@ public:
             if (index.row() < static_cast<int>(_array.size()))
             {
                 std::ostringstream buffer;
-                buffer << _array.cdata()[index.row()];
+                buffer << Hdui_Printable(_array[index.row()]);
                 std::string str = buffer.str();
                 return QVariant(QString::fromUtf8(str.data(), str.size()));
             }
@@ -167,7 +226,29 @@ public:
     {
         if (role == Qt::DisplayRole)
         {
-            if (section == 1)
+            if (section == 0)
+            {
+                std::ostringstream buffer;
+                buffer << _value.GetTypeName();
+                if (_range)
+                {
+                    if (_range->valid)
+                    {
+                        buffer << "  min: " << Hdui_Printable(_range->min) << "  max: " << Hdui_Printable(_range->max);
+                    }
+                    if (_range->nanCount > 0)
+                    {
+                        buffer << "  NaN: " << _range->nanCount;
+                    }
+                }
+                else if (Hdui_ValueRange<T>::supported && !_array.empty())
+                {
+                    buffer << "  (computing range...)";
+                }
+                std::string str = buffer.str();
+                return QVariant(QString::fromUtf8(str.data(), str.size()));
+            }
+            else if (section == 1)
             {
                 std::ostringstream buffer;
                 buffer << _array.size() << " values";
@@ -181,8 +262,69 @@ public:
 
     int columnCount(const QModelIndex &parent = QModelIndex()) const override { return 2; }
 
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override
+    {
+        if (parent.isValid() || parent.column() > 0)
+        {
+            return 0;
+        }
+        return static_cast<int>(_array.size());
+    }
+
 private:
-    VtArray<T> _array;
+    struct _Range
+    {
+        T min {};
+        T max {};
+        size_t nanCount = 0;
+        // false if every value has a NaN component
+        bool valid = false;
+    };
+
+    void _ComputeRangeAsync()
+    {
+        if (!Hdui_ValueRange<T>::supported || _array.empty())
+        {
+            return;
+        }
+
+        // the worker keeps its own reference to the array, the result is
+        // delivered on the main thread only if the model is still alive
+        QPointer<QAbstractItemModel> model(this);
+        WorkRunDetachedTask([model, array = _array]() {
+            auto range = std::make_shared<_Range>();
+            for (const T &value : array)
+            {
+                if (Hdui_ValueRange<T>::HasNan(value))
+                {
+                    ++range->nanCount;
+                }
+                else if (!range->valid)
+                {
+                    range->min = value;
+                    range->max = value;
+                    range->valid = true;
+                }
+                else
+                {
+                    Hdui_ValueRange<T>::Extend(range->min, range->max, value);
+                }
+            }
+            QMetaObject::invokeMethod(
+                QCoreApplication::instance(),
+                [model, range]() {
+                    if (auto typedModel = static_cast<Hdui_TypedArrayValueItemModel *>(model.data()))
+                    {
+                        typedModel->_range = range;
+                        Q_EMIT typedModel->headerDataChanged(Qt::Horizontal, 0, 0);
+                    }
+                },
+                Qt::QueuedConnection);
+        });
+    }
+
+    Array _array;
+    std::shared_ptr<_Range> _range;
 };
 
 //-----------------------------------------------------------------------------
@@ -220,6 +362,11 @@ public:
 
 Hdui_ValueItemModel *Hdui_GetModelFromValue(VtValue value, QObject *parent = nullptr)
 {
+    if (value.IsHolding<SdfPathVector>())
+    {
+        return new Hdui_TypedArrayValueItemModel<SdfPath, SdfPathVector>(value, parent);
+    }
+
     if (!value.IsArrayValued())
     {
         return new Hdui_ValueItemModel(value, parent);
@@ -230,6 +377,31 @@ Hdui_ValueItemModel *Hdui_GetModelFromValue(VtValue value, QObject *parent = nul
         return new Hdui_TypedArrayValueItemModel<int>(value, parent);
     }
 
+    if (value.IsHolding<VtArray<unsigned int>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<unsigned int>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<int64_t>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<int64_t>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<uint64_t>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<uint64_t>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<unsigned char>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<unsigned char>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<bool>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<bool>(value, parent);
+    }
+
     if (value.IsHolding<VtArray<float>>())
     {
         return new Hdui_TypedArrayValueItemModel<float>(value, parent);
@@ -240,6 +412,16 @@ Hdui_ValueItemModel *Hdui_GetModelFromValue(VtValue value, QObject *parent = nul
         return new Hdui_TypedArrayValueItemModel<double>(value, parent);
     }
 
+    if (value.IsHolding<VtArray<GfHalf>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfHalf>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<std::string>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<std::string>(value, parent);
+    }
+
     if (value.IsHolding<VtArray<TfToken>>())
     {
         return new Hdui_TypedArrayValueItemModel<TfToken>(value, parent);
@@ -250,24 +432,89 @@ Hdui_ValueItemModel *Hdui_GetModelFromValue(VtValue value, QObject *parent = nul
         return new Hdui_TypedArrayValueItemModel<SdfPath>(value, parent);
     }
 
+    if (value.IsHolding<VtArray<GfVec2i>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec2i>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfVec3i>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec3i>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfVec4i>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec4i>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfVec2f>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec2f>(value, parent);
+    }
+
     if (value.IsHolding<VtArray<GfVec3f>>())
     {
         return new Hdui_TypedArrayValueItemModel<GfVec3f>(value, parent);
     }
 
+    if (value.IsHolding<VtArray<GfVec4f>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec4f>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfVec2d>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec2d>(value, parent);
+    }
+
     if (value.IsHolding<VtArray<GfVec3d>>())
     {
         return new Hdui_TypedArrayValueItemModel<GfVec3d>(value, parent);
     }
 
-    if (value.IsHolding<VtArray<GfMatrix4d>>())
+    if (value.IsHolding<VtArray<GfVec4d>>())
     {
-        return new Hdui_TypedArrayValueItemModel<GfMatrix4d>(value, parent);
+        return new Hdui_TypedArrayValueItemModel<GfVec4d>(value, parent);
     }
 
-    if (value.IsHolding<VtArray<GfVec2f>>())
+    if (value.IsHolding<VtArray<GfVec2h>>())
     {
-        return new Hdui_TypedArrayValueItemModel<GfVec2f>(value, parent);
+        return new Hdui_TypedArrayValueItemModel<GfVec2h>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfVec3h>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec3h>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfVec4h>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfVec4h>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfQuatf>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfQuatf>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfQuatd>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfQuatd>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfMatrix3d>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfMatrix3d>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfMatrix4f>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfMatrix4f>(value, parent);
+    }
+
+    if (value.IsHolding<VtArray<GfMatrix4d>>())
+    {
+        return new Hdui_TypedArrayValueItemModel<GfMatrix4d>(value, parent);
     }
 
     return new Hdui_UnsupportedTypeValueItemModel(value, parent);
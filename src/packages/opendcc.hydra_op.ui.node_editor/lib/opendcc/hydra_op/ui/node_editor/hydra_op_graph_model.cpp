@@ -392,8 +392,8 @@ bool HydraOpGraphModel::has_port(const PortId& port) const
 HydraOpGraphModel::HydraOpGraphModel(QObject* parent)
     : UsdGraphModel(parent)
 {
-    connect(this, &GraphModel::node_created, this, [this](const NodeId& node) { get_graph_cache().nodes.insert(node); });
-    connect(this, &GraphModel::node_removed, this, [this](const NodeId& node) { get_graph_cache().nodes.erase(node); });
+    connect(this, &GraphModel::node_created, this, [this](const NodeId& node) { get_graph_cache().add_node(node); });
+    connect(this, &GraphModel::node_removed, this, [this](const NodeId& node) { get_graph_cache().remove_node(node); });
     m_handlers = std::make_unique<CallbackHandlers>(*this);
     stage_changed_impl();
 }
@@ -506,7 +506,7 @@ void HydraOpGraphModel::delete_connection(const ConnectionId& connection)
 
     remove_connection(prop, to_usd_path(connection.start_port));
 
-    if (get_graph_cache().connections.erase(connection))
+    if (get_graph_cache().remove_connection(connection))
     {
         Q_EMIT connection_removed(connection);
     }
@@ -630,8 +630,7 @@ void HydraOpGraphModel::stage_changed_impl()
 
 void HydraOpGraphModel::init_scene_graph()
 {
-    get_graph_cache().connections.clear();
-    get_graph_cache().nodes.clear();
+    get_graph_cache().clear();
     if (!get_stage() || get_root().IsEmpty())
         return;
 
@@ -657,7 +656,7 @@ void HydraOpGraphModel::init_scene_graph()
             connection_id.start_port = SdfPath(connection.start_port).GetString();
         if (connection_id.end_port.empty())
             connection_id.end_port = SdfPath(connection.end_port).GetString();
-        get_graph_cache().connections.emplace(std::move(connection_id));
+        get_graph_cache().add_connection(connection_id);
     };
     auto add_connections_for_prim = [this, add_connection](const UsdPrim& prim) {
         auto connections = get_connections_for_prim(prim);
@@ -672,7 +671,7 @@ void HydraOpGraphModel::init_scene_graph()
     add_connections_for_prim(root_prim);
     for (const auto& child : root_prim.GetAllChildren())
     {
-        get_graph_cache().nodes.insert(child.GetPath().GetString());
+        get_graph_cache().add_node(child.GetPath().GetString());
         add_connections_for_prim(child);
     }
 }
@@ -718,11 +717,6 @@ void HydraOpGraphModel::on_rename()
         return;
     }
 
-    auto& graph_cache = get_graph_cache();
-    GraphCache new_graph_cache;
-    new_graph_cache.connections.reserve(graph_cache.connections.size());
-    new_graph_cache.nodes.reserve(graph_cache.nodes.size());
-
     const auto& old_paths = get_node_provider().get_old_rename_paths();
     const auto& new_paths = get_node_provider().get_new_rename_paths();
 
@@ -732,20 +726,7 @@ void HydraOpGraphModel::on_rename()
             continue;
 
         m_root = m_root.ReplacePrefix(old_paths[i], new_paths[i], false);
-        const auto old_str = old_paths[i].GetString();
-        const auto new_str = new_paths[i].GetString();
-
-        for (const auto& node : get_graph_cache().nodes)
-            new_graph_cache.nodes.insert(TfStringReplace(node, old_str, new_str));
-
-        for (const auto& con : graph_cache.connections)
-        {
-            ConnectionId new_con;
-            new_con.start_port = TfStringReplace(con.start_port, old_str, new_str);
-            new_con.end_port = TfStringReplace(con.end_port, old_str, new_str);
-            new_graph_cache.connections.insert(std::move(new_con));
-        }
-        std::swap(graph_cache, new_graph_cache);
+        get_graph_cache().rename(old_paths[i], new_paths[i]);
         get_node_provider().rename_performed();
         Q_EMIT model_reset();
         return;
@@ -762,7 +743,7 @@ void HydraOpGraphModel::on_selection_changed()
     nodes.reserve(sel_paths.size());
     for (const auto path : sel_paths)
     {
-        if (get_graph_cache().nodes.find(path.GetString()) != get_graph_cache().nodes.end())
+        if (get_graph_cache().has_node(path.GetString()))
             nodes.push_back(path.GetString());
     }
     Q_EMIT selection_changed(std::move(nodes), QVector<ConnectionId>());
@@ -773,7 +754,7 @@ QVector<NodeId> HydraOpGraphModel::get_nodes() const
     if (get_root() == SdfPath::EmptyPath())
         return {};
 
-    const auto& nodes = get_graph_cache().nodes;
+    const auto& nodes = get_graph_cache().get_nodes();
     QVector<NodeId> result(nodes.size());
     std::transform(nodes.begin(), nodes.end(), result.begin(), [](const NodeId& node) { return node; });
 
@@ -796,7 +777,7 @@ UsdPrim HydraOpGraphModel::get_prim_for_node(const NodeId& node_id) const
 
 QVector<ConnectionId> HydraOpGraphModel::get_connections() const
 {
-    const auto& connections = get_graph_cache().connections;
+    const auto& connections = get_graph_cache().get_connections();
     QVector<ConnectionId> result(connections.size());
     std::transform(connections.begin(), connections.end(), result.begin(), [](const ConnectionId& connection) { return connection; });
     return std::move(result);
@@ -807,21 +788,15 @@ QVector<ConnectionId> HydraOpGraphModel::get_connections_for_node(const NodeId&
     if (!get_stage() || get_root().IsEmpty())
         return {};
 
-    QVector<ConnectionId> result;
-    const auto node_path = node_id;
-
-    for (const auto& connection : get_graph_cache().connections)
-    {
-        if (get_node_path(connection.start_port) == node_path || get_node_path(connection.end_port) == node_path)
-            result.push_back(connection);
-    }
-
-    return std::move(result);
+    const auto connections = get_graph_cache().get_connections_for_node(node_id);
+    QVector<ConnectionId> result(connections.size());
+    std::copy(connections.begin(), connections.end(), result.begin());
+    return result;
 }
 
 void HydraOpGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
 {
-    if (get_graph_cache().nodes.find(prim_path.GetString()) != get_graph_cache().nodes.end())
+    if (get_graph_cache().has_node(prim_path.GetString()))
         return;
 
     if (prim_path.GetParentPath() != get_root())
@@ -852,7 +827,7 @@ void HydraOpGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
     auto outcoming_connections = get_connections_for_node(node_id);
 
     for (auto it = incoming_connections.begin(); it != end_it; ++it)
-        get_graph_cache().connections.emplace(
+        get_graph_cache().add_connection(
             ConnectionId { from_usd_path(SdfPath(it->start_port), m_root), from_usd_path(SdfPath(it->end_port), m_root) });
 
     Q_EMIT node_created(node_id);
@@ -870,22 +845,12 @@ void HydraOpGraphModel::try_remove_prim(const PXR_NS::SdfPath& prim_path)
         return;
     }
     const NodeId node_id = prim_path.GetString();
-    if (get_graph_cache().nodes.find(node_id) == get_graph_cache().nodes.end())
+    if (!get_graph_cache().has_node(node_id))
         return;
 
-    std::vector<ConnectionId> removed_connections;
-    for (auto it = get_graph_cache().connections.begin(); it != get_graph_cache().connections.end();)
-    {
-        if (get_node_path(it->start_port) == prim_path.GetString() || get_node_path(it->end_port) == prim_path.GetString())
-        {
-            removed_connections.emplace_back(*it);
-            it = get_graph_cache().connections.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    const auto removed_connections = get_graph_cache().get_connections_for_node(node_id);
+    for (const auto& connection : removed_connections)
+        get_graph_cache().remove_connection(connection);
 
     for (const auto& connection : removed_connections)
         Q_EMIT connection_removed(connection);
@@ -904,18 +869,19 @@ void HydraOpGraphModel::try_update_prop(const PXR_NS::SdfPath& prop_path)
     }
 
     std::unordered_set<SdfPath, SdfPath::Hash> target_set(connections.begin(), connections.end());
-    for (auto it = get_graph_cache().connections.begin(); it != get_graph_cache().connections.end();)
+    std::vector<ConnectionId> removed_connections;
+    for (const auto& connection : get_graph_cache().get_connections())
     {
-        const auto start_path = to_usd_path(it->start_port);
-        const auto end_path = to_usd_path(it->end_port);
+        const auto start_path = to_usd_path(connection.start_port);
+        const auto end_path = to_usd_path(connection.end_port);
         // If has incoming connection that are no longer exists
         if (end_path == prop_path && target_set.find(start_path) == target_set.end())
-        {
-            const auto removed_connection = *it;
-            it = get_graph_cache().connections.erase(it);
-            Q_EMIT connection_removed(removed_connection);
-        }
-        ++it;
+            removed_connections.push_back(connection);
+    }
+    for (const auto& connection : removed_connections)
+    {
+        get_graph_cache().remove_connection(connection);
+        Q_EMIT connection_removed(connection);
     }
 
     std::string prop_model_path;
@@ -949,9 +915,9 @@ void HydraOpGraphModel::try_update_prop(const PXR_NS::SdfPath& prop_path)
             continue;
         }
 
-        const auto result = get_graph_cache().connections.emplace(ConnectionId { target_model_path, prop_model_path });
-        if (result.second)
-            Q_EMIT connection_created(*result.first);
+        ConnectionId connection { target_model_path, prop_model_path };
+        if (get_graph_cache().add_connection(connection))
+            Q_EMIT connection_created(connection);
     }
     Q_EMIT port_updated(prop_model_path);
 }
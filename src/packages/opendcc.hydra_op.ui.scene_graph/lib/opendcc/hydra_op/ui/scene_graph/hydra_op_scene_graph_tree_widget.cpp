@@ -52,7 +52,17 @@ public:
             //       ununderstood crashes with
             //       PhdRequest::ExtractOptionalValue as called from
             //       HdDataSourceLegacyPrim
-            QTimer::singleShot(0, [this]() { this->setExpanded(true); });
+            //       the item can be deleted before the timer fires, so it is
+            //       looked up by path and the tree bounds the timer lifetime
+            if (HydraOpTree *tree = dynamic_cast<HydraOpTree *>(treeWidget()))
+            {
+                QTimer::singleShot(0, tree, [tree, primPath]() {
+                    if (HydraOpTreeItem *item = tree->_GetPrimItem(primPath, false))
+                    {
+                        item->setExpanded(true);
+                    }
+                });
+            }
         }
     }
 
@@ -202,42 +212,52 @@ void HydraOpTree::PrimsAdded(const HdSceneIndexBase &sender, const AddedPrimEntr
 
 void HydraOpTree::PrimsRemoved(const HdSceneIndexBase &sender, const RemovedPrimEntries &entries)
 {
-    bool sortState = isSortingEnabled();
-    setSortingEnabled(false);
-
+    SdfPathVector removedPaths;
+    removedPaths.reserve(entries.size());
     for (const RemovedPrimEntry &entry : entries)
     {
-        if (HydraOpTreeItem *item = _GetPrimItem(entry.primPath, false))
-        {
+        removedPaths.push_back(entry.primPath);
+    }
+    SdfPath::RemoveDescendentPaths(&removedPaths);
 
-            if (item->parent())
+    size_t removedItemCount = 0;
+    for (const SdfPath &primPath : removedPaths)
+    {
+        auto range = _primItems.FindSubtreeRange(primPath);
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            if (it->second)
             {
-                item->parent()->takeChild(item->parent()->indexOfChild(item));
+                ++removedItemCount;
             }
+        }
+    }
 
-            _ItemMap::iterator it = _primItems.begin();
+    if (removedItemCount == 0)
+    {
+        return;
+    }
 
-            // XXX items are currently stored flat so this loop will not scale
-            //     if run repeatedly
-            while (it != _primItems.end())
-            {
-                if ((*it).first.HasPrefix(entry.primPath))
-                {
-                    _ItemMap::iterator nextIt = it;
-                    ++nextIt;
-                    _primItems.erase(it);
-                    it = nextIt;
-                }
-                else
-                {
-                    ++it;
-                }
-            }
+    // taking items one by one re-layouts the tree each time,
+    // large batches rebuild the lazily populated items instead
+    static const size_t resetItemCount = 1000;
+    if (removedItemCount >= resetItemCount && _primItems.find(SdfPath::AbsoluteRootPath()) != _primItems.end())
+    {
+        _ResetItems();
+        return;
+    }
 
-            // TODO selection change, etc
-        }
+    bool sortState = isSortingEnabled();
+    setSortingEnabled(false);
+    setUpdatesEnabled(false);
+
+    for (const SdfPath &primPath : removedPaths)
+    {
+        _RemoveSubtree(primPath);
+        // TODO selection change, etc
     }
 
+    setUpdatesEnabled(true);
     setSortingEnabled(sortState);
 }
 
@@ -306,7 +326,7 @@ void HydraOpTree::Requery(bool lazy)
 HydraOpTreeItem *HydraOpTree::_GetPrimItem(const SdfPath &primPath, bool createIfNecessary)
 {
     auto it = _primItems.find(primPath);
-    if (it != _primItems.end())
+    if (it != _primItems.end() && it->second)
     {
         return it->second;
     }
@@ -340,31 +360,35 @@ HydraOpTreeItem *HydraOpTree::_GetPrimItem(const SdfPath &primPath, bool createI
 
 void HydraOpTree::_RemoveSubtree(const SdfPath &primPath)
 {
-    HydraOpTreeItem *item = _GetPrimItem(primPath, false);
-    if (!item)
+    auto range = _primItems.FindSubtreeRange(primPath);
+    if (range.first == range.second)
     {
         return;
     }
 
-    if (item->parent())
+    // deleting an item detaches it from its parent and deletes the child items
+    for (auto it = range.first; it != range.second;)
     {
-        item->parent()->takeChild(item->parent()->indexOfChild(item));
-    }
-
-    _ItemMap::const_iterator it = _primItems.begin();
-    while (it != _primItems.end())
-    {
-        if ((*it).first.HasPrefix(primPath))
+        if (it->second)
         {
-            _ItemMap::const_iterator it2 = it;
-            ++it;
-            _primItems.erase(it2);
+            delete it->second;
+            it = it.GetNextSubtree();
         }
         else
         {
             ++it;
         }
     }
+    _primItems.erase(range.first);
+}
+
+void HydraOpTree::_ResetItems()
+{
+    // the expanded paths are kept in the static set of HydraOpTreeItem,
+    // so the rebuilt tree expands back to the remaining prims
+    _primItems.clear();
+    clear();
+    Requery();
 }
 
 void HydraOpTree::_AddPrimItem(const SdfPath &primPath, HydraOpTreeItem *item)
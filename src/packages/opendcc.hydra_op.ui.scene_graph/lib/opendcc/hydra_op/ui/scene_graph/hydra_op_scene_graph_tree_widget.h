@@ -13,9 +13,9 @@
 #include "pxr/pxr.h"
 
 #include "pxr/imaging/hd/sceneIndex.h"
+#include "pxr/usd/sdf/pathTable.h"
 
 #include <QTreeWidget>
-#include <unordered_map>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -54,11 +54,15 @@ private:
 
     void _RemoveSubtree(const SdfPath &primPath);
 
+    void _ResetItems();
+
     void _AddPrimItem(const SdfPath &primPath, HydraOpTreeItem *item);
 
     HydraOpTreeItem *_GetPrimItem(const SdfPath &primPath, bool createIfNecessary = true);
 
-    using _ItemMap = std::unordered_map<SdfPath, HydraOpTreeItem *, SdfPath::Hash>;
+    // items are indexed hierarchically so a subtree is found and erased
+    // in time proportional to its size, paths without an item map to null
+    using _ItemMap = SdfPathTable<HydraOpTreeItem *>;
 
     _ItemMap _primItems;
     HdSceneIndexBaseRefPtr _inputSceneIndex;
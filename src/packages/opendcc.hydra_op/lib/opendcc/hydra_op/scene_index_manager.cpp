@@ -3,7 +3,6 @@
 
 #include "opendcc/hydra_op/scene_index_manager.h"
 #include "opendcc/hydra_op/session.h"
-#include <pxr/usdImaging/usdImaging/selectionSceneIndex.h>
 #include <opendcc/app/viewport/viewport_widget.h>
 
 OPENDCC_NAMESPACE_OPEN
@@ -13,7 +12,7 @@ HydraOpSceneIndexManager::HydraOpSceneIndexManager()
 {
     m_viewable_si = HydraOpSession::instance().get_view_scene_index();
     m_viewable_si->AddObserver(HdSceneIndexObserverPtr(&m_observer));
-    m_selection_si = UsdImagingSelectionSceneIndex::New(m_viewable_si);
+    m_selection_si = HydraOpSelectionSceneIndex::New(m_viewable_si);
     set_selection(HydraOpSession::instance().get_selection());
     m_terminal_si = m_selection_si;
 }
@@ -33,12 +32,10 @@ PXR_NS::HdSceneIndexBaseRefPtr HydraOpSceneIndexManager::get_terminal_index()
 
 void HydraOpSceneIndexManager::set_selection(const SelectionList& selection_list)
 {
-    m_selection_si->ClearSelection();
-    for (const auto& entry : selection_list.get_fully_selected_paths())
+    if (m_selection_si->set_selection(selection_list))
     {
-        m_selection_si->AddSelection(entry);
+        ViewportWidget::update_all_gl_widget();
     }
-    ViewportWidget::update_all_gl_widget();
 }
 
 void HydraOpSceneIndexManager::ViewportUpdateObserver::PrimsAdded(const HdSceneIndexBase& sender, const AddedPrimEntries& entries)
@@ -7,7 +7,7 @@
 
 #include "opendcc/app/viewport/viewport_scene_context.h"
 #include "opendcc/hydra_op/translator/terminal_scene_index.h"
-#include <pxr/usdImaging/usdImaging/selectionSceneIndex.h>
+#include "opendcc/hydra_op/selection_scene_index.h"
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -36,7 +36,7 @@ private:
 
     ViewportUpdateObserver m_observer;
     PXR_NS::TfWeakPtr<HydraOpTerminalSceneIndex> m_viewable_si;
-    PXR_NS::UsdImagingSelectionSceneIndexRefPtr m_selection_si;
+    HydraOpSelectionSceneIndexRefPtr m_selection_si;
     PXR_NS::HdSceneIndexBaseRefPtr m_terminal_si;
 };
 
@@ -0,0 +1,313 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/hydra_op/selection_scene_index.h"
+#include <pxr/imaging/hd/overlayContainerDataSource.h>
+#include <pxr/imaging/hd/retainedDataSource.h>
+#include <pxr/imaging/hd/sceneIndexPrimView.h>
+#include <pxr/imaging/hd/selectionSchema.h>
+#include <pxr/imaging/hd/selectionsSchema.h>
+
+PXR_NAMESPACE_OPEN_SCOPE
+TF_DEFINE_PUBLIC_TOKENS(HydraOpSelectionTokens, (pointIndices)(edgeIndices)(elementIndices)(instanceIndices));
+PXR_NAMESPACE_CLOSE_SCOPE
+
+OPENDCC_NAMESPACE_OPEN
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    // sorted_paths don't contain descendants of each other
+    bool has_ancestor_or_self(const SdfPathVector& sorted_paths, const SdfPath& path)
+    {
+        auto it = std::upper_bound(sorted_paths.begin(), sorted_paths.end(), path);
+        return it != sorted_paths.begin() && path.HasPrefix(*(it - 1));
+    }
+
+    void add_indices(const SelectionData::IndexIntervals::RangeProxy& range, const TfToken& name, TfTokenVector& names,
+                     std::vector<HdDataSourceBaseHandle>& values)
+    {
+        if (range.empty())
+            return;
+
+        VtIntArray indices;
+        indices.reserve(range.size());
+        for (auto index : range)
+            indices.push_back(static_cast<int>(index));
+        names.push_back(name);
+        values.push_back(HdRetainedTypedSampledDataSource<VtIntArray>::New(indices));
+    }
+}
+
+HydraOpSelectionSceneIndexRefPtr HydraOpSelectionSceneIndex::New(const HdSceneIndexBaseRefPtr& input_scene_index)
+{
+    return TfCreateRefPtr(new HydraOpSelectionSceneIndex(input_scene_index));
+}
+
+HydraOpSelectionSceneIndex::HydraOpSelectionSceneIndex(const HdSceneIndexBaseRefPtr& input_scene_index)
+    : HdSingleInputFilteringSceneIndexBase(input_scene_index)
+{
+}
+
+HdSceneIndexPrim HydraOpSelectionSceneIndex::GetPrim(const SdfPath& prim_path) const
+{
+    auto prim = _GetInputSceneIndex()->GetPrim(prim_path);
+    if (!prim.dataSource || m_selection.empty())
+        return prim;
+
+    const auto fully_selected = is_fully_selected(prim_path);
+    const auto it = m_selection.find(prim_path);
+    if (!fully_selected && it == m_selection.end())
+        return prim;
+
+    TfTokenVector names = { HdSelectionSchemaTokens->fullySelected };
+    std::vector<HdDataSourceBaseHandle> values = { HdRetainedTypedSampledDataSource<bool>::New(fully_selected) };
+    if (it != m_selection.end())
+    {
+        add_indices(it->second.get_point_indices(), HydraOpSelectionTokens->pointIndices, names, values);
+        add_indices(it->second.get_edge_indices(), HydraOpSelectionTokens->edgeIndices, names, values);
+        add_indices(it->second.get_element_indices(), HydraOpSelectionTokens->elementIndices, names, values);
+        add_indices(it->second.get_instance_indices(), HydraOpSelectionTokens->instanceIndices, names, values);
+    }
+
+    HdDataSourceBaseHandle selection = HdRetainedContainerDataSource::New(names.size(), names.data(), values.data());
+    prim.dataSource = HdOverlayContainerDataSource::New(
+        HdRetainedContainerDataSource::New(HdSelectionsSchema::GetSchemaToken(), HdRetainedSmallVectorDataSource::New(1, &selection)), prim.dataSource);
+    return prim;
+}
+
+SdfPathVector HydraOpSelectionSceneIndex::GetChildPrimPaths(const SdfPath& prim_path) const
+{
+    return _GetInputSceneIndex()->GetChildPrimPaths(prim_path);
+}
+
+bool HydraOpSelectionSceneIndex::set_selection(const SelectionList& selection_list)
+{
+    std::unordered_map<SdfPath, SelectionData, SdfPath::Hash> new_selection;
+    new_selection.reserve(selection_list.size());
+
+    // full selection changes dirty the whole subtree, component changes only the prim itself
+    SdfPathVector subtree_roots;
+    SdfPathVector changed_paths;
+    auto compare = [&subtree_roots, &changed_paths](const SdfPath& path, const SelectionData* old_data, const SelectionData* new_data) {
+        const auto old_fully_selected = old_data && old_data->is_fully_selected();
+        const auto new_fully_selected = new_data && new_data->is_fully_selected();
+        if (old_fully_selected != new_fully_selected)
+            subtree_roots.push_back(path);
+        else if (!old_data || !new_data || *old_data != *new_data)
+            changed_paths.push_back(path);
+    };
+
+    for (const auto& entry : selection_list)
+    {
+        if (entry.second.empty())
+            continue;
+
+        auto old_it = m_selection.find(entry.first);
+        if (old_it == m_selection.end())
+            compare(entry.first, nullptr, &entry.second);
+        else if (old_it->second != entry.second)
+            compare(entry.first, &old_it->second, &entry.second);
+        new_selection.emplace(entry.first, entry.second);
+    }
+    for (const auto& entry : m_selection)
+    {
+        if (new_selection.find(entry.first) == new_selection.end())
+            compare(entry.first, &entry.second, nullptr);
+    }
+    m_selection.swap(new_selection);
+
+    if (subtree_roots.empty() && changed_paths.empty())
+        return false;
+
+    const auto& locator = HdSelectionsSchema::GetDefaultLocator();
+    HdSceneIndexObserver::DirtiedPrimEntries dirtied_entries;
+    SdfPath::RemoveDescendentPaths(&subtree_roots);
+    for (const auto& root : subtree_roots)
+    {
+        for (const auto& path : HdSceneIndexPrimView(_GetInputSceneIndex(), root))
+            dirtied_entries.emplace_back(path, locator);
+    }
+    for (const auto& path : changed_paths)
+    {
+        if (!has_ancestor_or_self(subtree_roots, path))
+            dirtied_entries.emplace_back(path, locator);
+    }
+
+    _SendPrimsDirtied(dirtied_entries);
+    return true;
+}
+
+void HydraOpSelectionSceneIndex::clear_selection()
+{
+    set_selection(SelectionList());
+}
+
+bool HydraOpSelectionSceneIndex::is_fully_selected(const SdfPath& prim_path) const
+{
+    for (auto path = prim_path; !path.IsEmpty() && !path.IsAbsoluteRootPath(); path = path.GetParentPath())
+    {
+        auto it = m_selection.find(path);
+        if (it != m_selection.end() && it->second.is_fully_selected())
+            return true;
+    }
+    return false;
+}
+
+void HydraOpSelectionSceneIndex::_PrimsAdded(const HdSceneIndexBase& sender, const HdSceneIndexObserver::AddedPrimEntries& entries)
+{
+    _SendPrimsAdded(entries);
+}
+
+void HydraOpSelectionSceneIndex::_PrimsRemoved(const HdSceneIndexBase& sender, const HdSceneIndexObserver::RemovedPrimEntries& entries)
+{
+    _SendPrimsRemoved(entries);
+}
+
+void HydraOpSelectionSceneIndex::_PrimsDirtied(const HdSceneIndexBase& sender, const HdSceneIndexObserver::DirtiedPrimEntries& entries)
+{
+    _SendPrimsDirtied(entries);
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/imaging/hd/retainedSceneIndex.h>
+
+OPENDCC_NAMESPACE_USING
+
+namespace
+{
+    class DirtiedCounter final : public HdSceneIndexObserver
+    {
+    public:
+        void PrimsAdded(const HdSceneIndexBase& sender, const AddedPrimEntries& entries) override {}
+        void PrimsRemoved(const HdSceneIndexBase& sender, const RemovedPrimEntries& entries) override {}
+        void PrimsDirtied(const HdSceneIndexBase& sender, const DirtiedPrimEntries& entries) override { dirtied += entries.size(); }
+        void PrimsRenamed(const HdSceneIndexBase& sender, const RenamedPrimEntries& entries) override {}
+
+        size_t take()
+        {
+            const auto result = dirtied;
+            dirtied = 0;
+            return result;
+        }
+
+        size_t dirtied = 0;
+    };
+
+    HdContainerDataSourceHandle get_selection(const HdSceneIndexBaseRefPtr& scene_index, const SdfPath& path)
+    {
+        auto prim = scene_index->GetPrim(path);
+        if (!prim.dataSource)
+            return nullptr;
+        auto selections = HdVectorDataSource::Cast(prim.dataSource->Get(HdSelectionsSchema::GetSchemaToken()));
+        if (!selections || selections->GetNumElements() == 0)
+            return nullptr;
+        return HdContainerDataSource::Cast(selections->GetElement(0));
+    }
+
+    bool is_fully_selected(const HdSceneIndexBaseRefPtr& scene_index, const SdfPath& path)
+    {
+        auto selection = get_selection(scene_index, path);
+        if (!selection)
+            return false;
+        auto fully_selected = HdBoolDataSource::Cast(selection->Get(HdSelectionSchemaTokens->fullySelected));
+        return fully_selected && fully_selected->GetTypedValue(0);
+    }
+
+    HdRetainedSceneIndexRefPtr make_scene(const SdfPath& group, int count)
+    {
+        auto scene = HdRetainedSceneIndex::New();
+        HdRetainedSceneIndex::AddedPrimEntries entries;
+        entries.push_back({ group, TfToken("Xform"), HdRetainedContainerDataSource::New() });
+        entries.push_back({ SdfPath("/other"), TfToken("mesh"), HdRetainedContainerDataSource::New() });
+        for (int i = 0; i < count; ++i)
+            entries.push_back({ group.AppendChild(TfToken(TfStringPrintf("mesh_%d", i))), TfToken("mesh"), HdRetainedContainerDataSource::New() });
+        scene->AddPrims(entries);
+        return scene;
+    }
+}
+
+DOCTEST_TEST_SUITE("HydraOpSelectionSceneIndex")
+{
+    DOCTEST_TEST_CASE("incremental_dirtying")
+    {
+        const SdfPath group("/group");
+        auto selection_si = HydraOpSelectionSceneIndex::New(make_scene(group, 10));
+        DirtiedCounter counter;
+        selection_si->AddObserver(HdSceneIndexObserverPtr(&counter));
+
+        SelectionList selection(SdfPathVector { SdfPath("/group/mesh_0") });
+        DOCTEST_CHECK(selection_si->set_selection(selection));
+        DOCTEST_CHECK(counter.take() == 1);
+        DOCTEST_CHECK(is_fully_selected(selection_si, SdfPath("/group/mesh_0")));
+        DOCTEST_CHECK(!is_fully_selected(selection_si, SdfPath("/group/mesh_1")));
+
+        // toggling one more prim only dirties that prim
+        selection = SelectionList(SdfPathVector { SdfPath("/group/mesh_0"), SdfPath("/group/mesh_1") });
+        DOCTEST_CHECK(selection_si->set_selection(selection));
+        DOCTEST_CHECK(counter.take() == 1);
+        DOCTEST_CHECK(!selection_si->set_selection(selection));
+        DOCTEST_CHECK(counter.take() == 0);
+
+        // the group selection is inherited by the descendants
+        selection = SelectionList(SdfPathVector { group, SdfPath("/group/mesh_0"), SdfPath("/group/mesh_1") });
+        DOCTEST_CHECK(selection_si->set_selection(selection));
+        DOCTEST_CHECK(counter.take() == 11);
+        DOCTEST_CHECK(is_fully_selected(selection_si, SdfPath("/group/mesh_5")));
+
+        // component selection
+        selection.add_points(SdfPath("/other"), std::vector<SelectionData::IndexType> { 1, 2, 3 });
+        DOCTEST_CHECK(selection_si->set_selection(selection));
+        DOCTEST_CHECK(counter.take() == 1);
+        DOCTEST_CHECK(!is_fully_selected(selection_si, SdfPath("/other")));
+        auto other_selection = get_selection(selection_si, SdfPath("/other"));
+        DOCTEST_REQUIRE(other_selection);
+        auto points = HdTypedSampledDataSource<VtIntArray>::Cast(other_selection->Get(HydraOpSelectionTokens->pointIndices));
+        DOCTEST_REQUIRE(points);
+        DOCTEST_CHECK(points->GetTypedValue(0) == VtIntArray({ 1, 2, 3 }));
+
+        selection.add_points(SdfPath("/other"), std::vector<SelectionData::IndexType> { 4 });
+        DOCTEST_CHECK(selection_si->set_selection(selection));
+        DOCTEST_CHECK(counter.take() == 1);
+
+        // the selected descendants of the deselected group are dirtied once
+        selection_si->clear_selection();
+        DOCTEST_CHECK(counter.take() == 12);
+        DOCTEST_CHECK(!is_fully_selected(selection_si, SdfPath("/group/mesh_0")));
+        DOCTEST_CHECK(!get_selection(selection_si, SdfPath("/other")));
+
+        selection_si->RemoveObserver(HdSceneIndexObserverPtr(&counter));
+    }
+
+    DOCTEST_TEST_CASE("large_selection")
+    {
+        const int count = 50000;
+        const SdfPath group("/instances");
+        auto selection_si = HydraOpSelectionSceneIndex::New(make_scene(group, count));
+        DirtiedCounter counter;
+        selection_si->AddObserver(HdSceneIndexObserverPtr(&counter));
+
+        SdfPathVector paths;
+        for (int i = 0; i < count - 1; ++i)
+            paths.push_back(group.AppendChild(TfToken(TfStringPrintf("mesh_%d", i))));
+        selection_si->set_selection(SelectionList(paths));
+        DOCTEST_CHECK(counter.take() == count - 1);
+
+        paths.push_back(group.AppendChild(TfToken(TfStringPrintf("mesh_%d", count - 1))));
+        selection_si->set_selection(SelectionList(paths));
+        DOCTEST_CHECK(counter.take() == 1);
+
+        paths.erase(paths.begin());
+        selection_si->set_selection(SelectionList(paths));
+        DOCTEST_CHECK(counter.take() == 1);
+
+        selection_si->RemoveObserver(HdSceneIndexObserverPtr(&counter));
+    }
+}
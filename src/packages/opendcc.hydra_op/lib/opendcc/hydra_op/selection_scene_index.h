@@ -0,0 +1,62 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "opendcc/opendcc.h"
+#include "opendcc/hydra_op/api.h"
+#include "opendcc/app/core/selection_list.h"
+#include <pxr/base/tf/staticTokens.h>
+#include <pxr/imaging/hd/filteringSceneIndex.h>
+#include <unordered_map>
+
+namespace PXR_NS
+{
+    // component selection of the prim, stored next to fullySelected in the selections schema entry
+    TF_DECLARE_PUBLIC_TOKENS(HydraOpSelectionTokens, OPENDCC_HYDRA_OP_API, (pointIndices)(edgeIndices)(elementIndices)(instanceIndices));
+}
+
+OPENDCC_NAMESPACE_OPEN
+
+class HydraOpSelectionSceneIndex;
+using HydraOpSelectionSceneIndexRefPtr = PXR_NS::TfRefPtr<HydraOpSelectionSceneIndex>;
+
+/**
+ * @brief Overlays the selections schema on the selected prims of the input scene index.
+ *
+ * The selection is kept per path, set_selection compares the new selection with the current one
+ * and dirties only the prims whose selection has changed. A fully selected prim selects its descendants,
+ * point, edge, element and instance selections are stored on the prim itself.
+ */
+class OPENDCC_HYDRA_OP_API HydraOpSelectionSceneIndex final : public PXR_NS::HdSingleInputFilteringSceneIndexBase
+{
+public:
+    static HydraOpSelectionSceneIndexRefPtr New(const PXR_NS::HdSceneIndexBaseRefPtr& input_scene_index);
+
+    PXR_NS::HdSceneIndexPrim GetPrim(const PXR_NS::SdfPath& prim_path) const override;
+    PXR_NS::SdfPathVector GetChildPrimPaths(const PXR_NS::SdfPath& prim_path) const override;
+
+    /**
+     * @brief Replaces the current selection.
+     *
+     * @return true if the selection of any prim has changed.
+     */
+    bool set_selection(const SelectionList& selection_list);
+    void clear_selection();
+
+protected:
+    HydraOpSelectionSceneIndex(const PXR_NS::HdSceneIndexBaseRefPtr& input_scene_index);
+
+    void _PrimsAdded(const PXR_NS::HdSceneIndexBase& sender, const PXR_NS::HdSceneIndexObserver::AddedPrimEntries& entries) override;
+    void _PrimsRemoved(const PXR_NS::HdSceneIndexBase& sender, const PXR_NS::HdSceneIndexObserver::RemovedPrimEntries& entries) override;
+    void _PrimsDirtied(const PXR_NS::HdSceneIndexBase& sender, const PXR_NS::HdSceneIndexObserver::DirtiedPrimEntries& entries) override;
+
+private:
+    bool is_fully_selected(const PXR_NS::SdfPath& prim_path) const;
+
+    std::unordered_map<PXR_NS::SdfPath, SelectionData, PXR_NS::SdfPath::Hash> m_selection;
+};
+
+OPENDCC_NAMESPACE_CLOSE
@@ -9,21 +9,30 @@
 #include "opendcc/app/core/undo/stack.h"
 #include "opendcc/app/core/application.h"
 #include "opendcc/app/core/session.h"
+#include "opendcc/app/core/sorted_path_set.h"
 #include "opendcc/base/logging/logger.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <unordered_set>
 #include "opendcc/usd_editor/bullet_physics/engine.h"
 
 #include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionDispatch/btCollisionDispatcherMt.h"
+#include "BulletDynamics/ConstraintSolver/btSequentialImpulseConstraintSolverMt.h"
+#include "BulletDynamics/Dynamics/btDiscreteDynamicsWorldMt.h"
+#include "LinearMath/btThreads.h"
+#include "pxr/base/work/threadLimits.h"
 #include "pxr/base/gf/quaternion.h"
 #include "pxr/base/gf/rotation.h"
 #include "opendcc/usd_editor/bullet_physics/debug_drawer.h"
 #include "opendcc/usd_editor/bullet_physics/entry_point.h"
+#include "opendcc/usd_editor/bullet_physics/shape_cache.h"
 #include "opendcc/usd_editor/bullet_physics/utils.h"
 #include "pxr/base/gf/transform.h"
 #include "pxr/usd/usdGeom/metrics.h"
-#include "pxr/imaging/hd/primGather.h"
 
 PXR_NAMESPACE_USING_DIRECTIVE;
 
@@ -33,6 +42,29 @@ namespace
 {
     static const float lever = 10.0f; // todo : make it adaptive to body size
     static const int num_pick_constraints_per_object = 6;
+
+    // the task scheduler is global in Bullet, it is shared by all the engines,
+    // after the call btGetTaskScheduler() is never null
+    void init_task_scheduler()
+    {
+        static std::once_flag once;
+        std::call_once(once, [] {
+            btITaskScheduler* scheduler = btGetTBBTaskScheduler();
+            if (!scheduler)
+                scheduler = btCreateDefaultTaskScheduler();
+            if (scheduler)
+            {
+                scheduler->setNumThreads(std::max(1, std::min(scheduler->getMaxNumThreads(), static_cast<int>(WorkGetConcurrencyLimit()))));
+            }
+            else
+            {
+                // Bullet is built without BT_THREADSAFE, the islands are solved on the calling thread
+                scheduler = btGetSequentialTaskScheduler();
+            }
+            btSetTaskScheduler(scheduler);
+        });
+    }
+
 #ifdef UNUSED_OLD_CODE
     btQuaternion to_quaternion(const GfVec3d& euler_angles)
     {
@@ -51,20 +83,18 @@ const std::string BulletPhysicsEngine::s_extension_short_name = "Physics";
 
 std::vector<BulletPhysicsEngine::BodyInfo> BulletPhysicsEngine::remove_children_from_paths_list(const std::vector<BodyInfo>& in)
 {
+    SdfPathVector paths;
+    paths.reserve(in.size());
+    for (const auto& info : in)
+        paths.push_back(info.path);
+    const SortedPathSet path_set(std::move(paths));
+
     std::vector<BodyInfo> result;
-    for (size_t i = 0; i < in.size(); ++i)
+    std::unordered_set<SdfPath, SdfPath::Hash> added_paths;
+    for (const auto& info : in)
     {
-        bool is_top = true;
-        for (size_t j = 0; j < in.size(); ++j)
-        {
-            if (i != j && in[i].path.HasPrefix(in[j].path))
-            {
-                is_top = false;
-                break;
-            }
-        }
-        if (is_top)
-            result.push_back(in[i]);
+        if (!path_set.has_ancestor(info.path, false) && added_paths.insert(info.path).second)
+            result.push_back(info);
     }
 
     return result;
@@ -74,12 +104,15 @@ BulletPhysicsEngine::BulletPhysicsEngine(UsdStageRefPtr stage, double time)
 {
     m_stage = stage;
     m_last_time = time;
+    init_task_scheduler();
     m_collision_configuration = std::make_unique<btDefaultCollisionConfiguration>();
-    m_cillision_dispatcher = std::make_unique<btCollisionDispatcher>(m_collision_configuration.get());
+    m_cillision_dispatcher = std::make_unique<btCollisionDispatcherMt>(m_collision_configuration.get());
     m_overlapping_pair_cache = std::make_unique<btDbvtBroadphase>();
-    m_solver = std::make_unique<btSequentialImpulseConstraintSolver>();
-    m_dynamics_world = std::make_unique<btDiscreteDynamicsWorld>(m_cillision_dispatcher.get(), m_overlapping_pair_cache.get(), m_solver.get(),
-                                                                 m_collision_configuration.get());
+    // islands are solved in parallel by the solvers from the pool, large islands are split by the Mt solver
+    m_solver_pool = std::make_unique<btConstraintSolverPoolMt>(btGetTaskScheduler()->getNumThreads());
+    m_solver = std::make_unique<btSequentialImpulseConstraintSolverMt>();
+    m_dynamics_world = std::make_unique<btDiscreteDynamicsWorldMt>(m_cillision_dispatcher.get(), m_overlapping_pair_cache.get(), m_solver_pool.get(),
+                                                                   m_solver.get(), m_collision_configuration.get());
 
     m_dynamics_world->setGravity(btVector3(0, 0, 0));
     m_options.read_from_settings(s_extension_short_name);
@@ -100,6 +133,7 @@ BulletPhysicsEngine::~BulletPhysicsEngine()
     // be sure of the correct deletion order
     m_dynamics_world.reset();
     m_solver.reset();
+    m_solver_pool.reset();
     m_overlapping_pair_cache.reset();
     m_cillision_dispatcher.reset();
     m_collision_configuration.reset();
@@ -109,6 +143,7 @@ void BulletPhysicsEngine::update_data_in_stage()
 {
     std::lock_guard<std::mutex> lock(m_mutex);
     SdfChangeBlock change_block;
+    // shared by all bodies, so the parents transforms are computed once
     PXR_NS::UsdGeomXformCache xform_cache;
     for (auto& it : m_bodies)
     {
@@ -116,10 +151,10 @@ void BulletPhysicsEngine::update_data_in_stage()
             continue;
 
         auto& rigid_body = it.second.rigid_body;
-        rigid_body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
         btTransform bullet_transform;
         if (rigid_body && rigid_body->getMotionState())
         {
+            rigid_body->setAngularVelocity(btVector3(0.0f, 0.0f, 0.0f));
             rigid_body->getMotionState()->getWorldTransform(bullet_transform);
         }
         else
@@ -128,32 +163,45 @@ void BulletPhysicsEngine::update_data_in_stage()
             continue;
         }
 
-        auto xform_api = UsdGeomXformCommonAPI(it.second.prim);
-        if (!xform_api)
-            continue;
-
-        auto parent_to_world_inv = xform_cache.GetParentToWorldTransform(it.second.prim).GetInverse();
         auto world_translate = GfVec3d { float(bullet_transform.getOrigin().getX()), float(bullet_transform.getOrigin().getY()),
                                          float(bullet_transform.getOrigin().getZ()) };
         auto bullet_rotation = bullet_transform.getBasis();
         GfMatrix3d world_rotation_matrix(bullet_rotation[0][0], bullet_rotation[1][0], bullet_rotation[2][0], bullet_rotation[0][1],
                                          bullet_rotation[1][1], bullet_rotation[2][1], bullet_rotation[0][2], bullet_rotation[1][2],
                                          bullet_rotation[2][2]);
+        const GfMatrix4d world_transform(world_rotation_matrix, world_translate);
+        if (world_transform == it.second.written_transform)
+            continue;
 
-        auto local_transform_matrix = GfMatrix4d(world_rotation_matrix, world_translate) * parent_to_world_inv;
-        GfTransform local_transform(local_transform_matrix);
-
-        xform_api.SetTranslate(local_transform.GetTranslation());
+        auto parent_to_world_inv = xform_cache.GetParentToWorldTransform(it.second.prim).GetInverse();
+        GfTransform local_transform(world_transform * parent_to_world_inv);
 
         GfVec3d local_rotation = local_transform.GetRotation().Decompose(GfVec3d::ZAxis(), GfVec3d::YAxis(), GfVec3d::XAxis());
-        xform_api.SetRotate(GfVec3f(local_rotation[2], local_rotation[1], local_rotation[0]));
+        if (write_transform(it.second, local_transform.GetTranslation(), GfVec3f(local_rotation[2], local_rotation[1], local_rotation[0])))
+            it.second.written_transform = world_transform;
     }
 }
 
+bool BulletPhysicsEngine::write_transform(RigidBody& body, const GfVec3d& translate, const GfVec3f& rotate)
+{
+    // UsdGeomXformCommonAPI validates the whole op stack on every call, it is only used for the first write
+    if (body.translate_attr && body.rotate_attr)
+        return body.translate_attr.Set(translate) && body.rotate_attr.Set(rotate);
+
+    auto xform_api = UsdGeomXformCommonAPI(body.prim);
+    if (!xform_api || !xform_api.SetTranslate(translate) || !xform_api.SetRotate(rotate))
+        return false;
+
+    body.translate_attr = body.prim.GetAttribute(UsdGeomXformOp::GetOpName(UsdGeomXformOp::TypeTranslate));
+    body.rotate_attr = body.prim.GetAttribute(UsdGeomXformOp::GetOpName(UsdGeomXformOp::TypeRotateXYZ));
+    return true;
+}
+
 void BulletPhysicsEngine::step_simulation(bool add_gravity)
 {
     if (m_bodies.size() == 0)
         return;
+    update_pending_shapes();
     m_miss_objects_changed = true;
     remove_pick_constraints();
     if (add_gravity)
@@ -298,15 +346,12 @@ SdfPathVector BulletPhysicsEngine::get_subtree_bodies_paths(const SdfPathVector&
 {
     std::unordered_set<SdfPath, SdfPath::Hash> unique_paths;
     SdfPathVector result;
-    HdPrimGather gather;
     if (add_children)
     {
         for (auto path : interesting_paths)
         {
-            SdfPathVector paths;
-            gather.Subtree(m_bodies_sorted_paths.GetIds(), path, &paths);
-            for (SdfPath& path : paths)
-                unique_paths.insert(path);
+            const auto range = SortedPathSet::get_subtree_range(m_bodies_sorted_paths.GetIds(), path);
+            unique_paths.insert(range.first, range.second);
         }
     }
     if (add_parents)
@@ -436,9 +481,11 @@ void BulletPhysicsEngine::add_objects(const std::vector<BodyInfo>& bodys_info)
         body.prim = prim;
         body.path = info.path;
         body.mesh_approximation_type = info.mesh_approximation_type;
-        body.shape = create_collision_shape(prim, info.type, info.mesh_approximation_type, Application::instance().get_current_time());
+        body.shape = create_shape(info, prim, body.pending_shape_keys);
         if (!body.shape)
             continue;
+        if (!body.pending_shape_keys.empty())
+            ++m_pending_shapes_count;
 
         const auto transform_matrix = xform_cache.GetLocalToWorldTransform(prim);
         auto transform = GfTransform(transform_matrix);
@@ -507,6 +554,85 @@ void BulletPhysicsEngine::add_objects(const std::vector<BodyInfo>& bodys_info)
     }
 }
 
+std::unique_ptr<btCollisionShape> BulletPhysicsEngine::create_shape(const BodyInfo& info, const UsdPrim& prim, std::vector<uint64_t>& pending_keys)
+{
+    // the engine can be destroyed before the build is finished
+    auto on_shape_ready = [engine = TfCreateWeakPtr(this)] {
+        if (engine)
+            engine->update_pending_shapes();
+    };
+    pending_keys.clear();
+    return create_collision_shape(prim, info.type, info.mesh_approximation_type, Application::instance().get_current_time(), on_shape_ready,
+                                  &pending_keys);
+}
+
+void BulletPhysicsEngine::update_pending_shapes()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending_shapes_count == 0)
+        return;
+
+    auto& cache = CollisionShapeCache::instance();
+    UsdGeomXformCache xform_cache;
+    bool updated = false;
+    for (auto& it : m_bodies)
+    {
+        auto& body = it.second;
+        if (body.pending_shape_keys.empty())
+            continue;
+
+        // called every step, so only the cache is polled until all builds of the body are finished
+        const auto& keys = body.pending_shape_keys;
+        if (std::any_of(keys.begin(), keys.end(), [&cache](uint64_t key) { return cache.is_building(key); }))
+            continue;
+
+        // the mesh could change since the request, then the body waits for the new builds
+        std::vector<uint64_t> pending_keys;
+        auto shape = create_shape(body, body.prim, pending_keys);
+        if (!pending_keys.empty())
+        {
+            body.pending_shape_keys = std::move(pending_keys);
+            continue;
+        }
+
+        body.pending_shape_keys.clear();
+        --m_pending_shapes_count;
+        if (!shape)
+            continue;
+
+        const auto transform = GfTransform(xform_cache.GetLocalToWorldTransform(body.prim));
+        const GfVec3d scale = transform.GetScale();
+        shape->setLocalScaling(btVector3(btScalar(scale[0]), btScalar(scale[1]), btScalar(scale[2])));
+
+        m_dynamics_world->removeRigidBody(body.rigid_body.get());
+        body.rigid_body->setCollisionShape(shape.get());
+        if (body.type == BodyType::DYNAMIC)
+        {
+            const btScalar mass(1.0);
+            btVector3 local_inertia(0, 0, 0);
+            shape->calculateLocalInertia(mass, local_inertia);
+            body.rigid_body->setMassProps(mass, local_inertia);
+            body.rigid_body->updateInertiaTensor();
+        }
+        m_dynamics_world->addRigidBody(body.rigid_body.get());
+
+        body.shape = std::move(shape);
+        updated = true;
+    }
+
+    if (updated)
+        BulletPhysicsViewportUIExtension::update_gl();
+}
+
+void BulletPhysicsEngine::wait_for_pending_shapes()
+{
+    if (m_pending_shapes_count == 0)
+        return;
+
+    CollisionShapeCache::instance().wait();
+    update_pending_shapes();
+}
+
 void BulletPhysicsEngine::remove_objects(const SdfPathVector& paths)
 {
     SdfPathVector paths_to_delete;
@@ -522,8 +648,11 @@ void BulletPhysicsEngine::remove_objects(const SdfPathVector& paths)
     }
     for (auto& path : paths_to_delete)
     {
+        auto it = m_bodies.find(path);
+        if (!it->second.pending_shape_keys.empty())
+            --m_pending_shapes_count;
         m_bodies_sorted_paths.Remove(path);
-        m_bodies.erase(path);
+        m_bodies.erase(it);
     }
     if (paths_to_delete.size() > 0)
         update_pick_constraints();
@@ -531,6 +660,11 @@ void BulletPhysicsEngine::remove_objects(const SdfPathVector& paths)
 
 void BulletPhysicsEngine::update_transforms_in_bullet(RigidBody& body, bool& bullet_scene_updated)
 {
+    // the op stack could be changed
+    body.translate_attr = UsdAttribute();
+    body.rotate_attr = UsdAttribute();
+    body.written_transform = GfMatrix4d(0);
+
     UsdGeomXformCache xform_cache;
     if (body.type == BodyType::DYNAMIC)
     {
@@ -715,13 +849,9 @@ void BulletPhysicsEngine::update_gravity_direction()
         m_gravity = { 0, -m_options.gravity, 0 };
 }
 
-// TODO : speedup it
 SdfPath BulletPhysicsEngine::parent_object(const SdfPath& chaild)
 {
-    for (auto& path : m_bodies_sorted_paths.GetIds())
-        if (chaild.HasPrefix(path))
-            return path;
-    return SdfPath();
+    return SortedPathSet::find_top_most_ancestor(m_bodies_sorted_paths.GetIds(), chaild);
 }
 
 void BulletPhysicsEngine::on_objects_changed(UsdNotice::ObjectsChanged const& notice, UsdStageWeakPtr const& sender)
@@ -736,16 +866,13 @@ void BulletPhysicsEngine::on_objects_changed(UsdNotice::ObjectsChanged const& no
     const PathRange paths_to_update = notice.GetChangedInfoOnlyPaths();
 
     std::unordered_map<SdfPath, ComponentsSet, SdfPath::Hash> children;
-    HdPrimGather gather;
-    SdfPathVector bodies_paths;
 
     auto travers = [&](const SdfPath& path) {
-        bodies_paths.clear();
-        gather.Subtree(m_bodies_sorted_paths.GetIds(), path.GetPrimPath(), &bodies_paths);
-        if (bodies_paths.size() > 0)
+        const auto bodies_range = SortedPathSet::get_subtree_range(m_bodies_sorted_paths.GetIds(), path.GetPrimPath());
+        if (bodies_range.first != bodies_range.second)
         {
-            for (const auto& body_paths : bodies_paths)
-                children[body_paths] = ComponentsSet();
+            for (auto body_path = bodies_range.first; body_path != bodies_range.second; ++body_path)
+                children[*body_path] = ComponentsSet();
         }
         else
         {
@@ -808,6 +935,80 @@ void BulletPhysicsEngine::Options::read_from_settings(const std::string& prefix)
     linear_damping = settings->get(prefix + ".linear_damping", default_options.linear_damping);
     angular_damping = settings->get(prefix + ".angular_damping", default_options.angular_damping);
     num_subtiles = settings->get(prefix + ".num_substeps", default_options.num_subtiles);
+    CollisionShapeCache::instance().set_disk_cache_dir(settings->get(prefix + ".shape_cache_dir", std::string()));
+    CollisionShapeCache::instance().set_max_memory(static_cast<size_t>(settings->get(prefix + ".shape_cache_memory_mb", 512)) * 1024 * 1024);
 }
 
 OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+#include <doctest/doctest.h>
+#include <chrono>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/usd/usdGeom/cube.h>
+
+OPENDCC_NAMESPACE_USING
+
+DOCTEST_TEST_SUITE("BulletPhysicsEngine")
+{
+    DOCTEST_TEST_CASE("stress_scene")
+    {
+        const int rocks_per_side = 20;
+        const int layers = 5;
+        const int steps = 3;
+
+        auto stage = UsdStage::CreateInMemory();
+        UsdGeomSetStageUpAxis(stage, UsdGeomTokens->y);
+
+        auto ground = UsdGeomCube::Define(stage, SdfPath("/ground"));
+        UsdGeomXformCommonAPI(ground).SetTranslate(GfVec3d(0, -1, 0));
+        UsdGeomXformCommonAPI(ground).SetScale(GfVec3f(rocks_per_side * 2, 1, rocks_per_side * 2));
+
+        SdfPathVector rocks;
+        {
+            SdfChangeBlock change_block;
+            for (int layer = 0; layer < layers; ++layer)
+            {
+                for (int i = 0; i < rocks_per_side * rocks_per_side; ++i)
+                {
+                    const SdfPath path(TfStringPrintf("/rocks/rock_%d_%d", layer, i));
+                    auto rock = UsdGeomCube::Define(stage, path);
+                    rock.CreateSizeAttr(VtValue(1.0));
+                    UsdGeomXformCommonAPI(rock).SetTranslate(
+                        GfVec3d((i % rocks_per_side - rocks_per_side / 2) * 1.5, 2 + layer * 1.5, (i / rocks_per_side - rocks_per_side / 2) * 1.5));
+                    rocks.push_back(path);
+                }
+            }
+        }
+        // duplicated paths are added once
+        rocks.push_back(SdfPath("/rocks/rock_0_0"));
+
+        auto& app = Application::instance();
+        BulletPhysicsEngine engine(stage, 0);
+        app.set_prim_selection({ SdfPath("/ground") });
+        engine.create_selected_prims_as_static_object();
+
+        auto start = std::chrono::steady_clock::now();
+        app.set_prim_selection(rocks);
+        engine.create_selected_prims_as_dynamic_object(BulletPhysicsEngine::MeshApproximationType::BOX);
+        app.set_prim_selection({});
+        const auto add_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < steps; ++i)
+            engine.step_simulation(true);
+        const auto step_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        GfVec3d translate;
+        stage->GetPrimAtPath(SdfPath("/rocks/rock_4_0")).GetAttribute(TfToken("xformOp:translate")).Get(&translate);
+        DOCTEST_CHECK(translate[1] < 2 + 4 * 1.5);
+
+        // the engine installs the sequential scheduler if Bullet has no threaded one
+        const auto scheduler = btGetTaskScheduler();
+        DOCTEST_REQUIRE(scheduler);
+        DOCTEST_MESSAGE(rocks.size() - 1 << " bodies, " << scheduler->getNumThreads() << " threads: add " << add_time << " ms, "
+                                          << step_time / steps << " ms per step with the write to the stage");
+        engine.remove_all();
+    }
+}
@@ -6,6 +6,8 @@
 #pragma once
 #include "opendcc/opendcc.h"
 #include "api.h"
+#include "pxr/base/gf/matrix4d.h"
+#include "pxr/usd/usd/attribute.h"
 #include "pxr/usd/usd/prim.h"
 #include "pxr/usd/usd/stage.h"
 #include <atomic>
@@ -21,7 +23,8 @@
 class btDefaultCollisionConfiguration;
 class btCollisionDispatcher;
 struct btDbvtBroadphase;
-class btSequentialImpulseConstraintSolver;
+class btConstraintSolver;
+class btConstraintSolverPoolMt;
 class btDiscreteDynamicsWorld;
 class btCollisionShape;
 class btPoint2PointConstraint;
@@ -52,6 +55,10 @@ public:
     BulletPhysicsEngine(PXR_NS::UsdStageRefPtr stage, double time);
     ~BulletPhysicsEngine();
     void step_simulation(bool add_gravity);
+    // replaces the placeholder shapes of the bodies whose shapes were built in background
+    void update_pending_shapes();
+    // blocks until the shapes in the build are ready and sets them to the bodies
+    void wait_for_pending_shapes();
     void on_selection_changed();
     void deactivate();
     void activate();
@@ -91,6 +98,13 @@ private:
         std::unique_ptr<btCollisionShape> shape;
         std::vector<std::unique_ptr<btPoint2PointConstraint>> pick_constraints;
         PXR_NS::UsdPrim prim;
+        // cache keys of the mesh shapes built in background, the shape is a bounding box placeholder until they are ready
+        std::vector<uint64_t> pending_shape_keys;
+        // xform ops resolved by the first write to the stage, reset when the prim is changed outside of the engine
+        PXR_NS::UsdAttribute translate_attr;
+        PXR_NS::UsdAttribute rotate_attr;
+        // world transform of the last write, unmoved bodies are skipped
+        PXR_NS::GfMatrix4d written_transform = PXR_NS::GfMatrix4d(0);
     };
 
     struct Options
@@ -115,8 +129,10 @@ private:
     void on_objects_changed(PXR_NS::UsdNotice::ObjectsChanged const& notice, PXR_NS::UsdStageWeakPtr const& sender);
     // mesh_approximation_type use only if type == DYNAMIC
     void add_objects(const std::vector<BodyInfo>& bodys_info);
+    std::unique_ptr<btCollisionShape> create_shape(const BodyInfo& info, const PXR_NS::UsdPrim& prim, std::vector<uint64_t>& pending_keys);
     void remove_objects(const PXR_NS::SdfPathVector& paths);
     void update_data_in_stage();
+    bool write_transform(RigidBody& body, const PXR_NS::GfVec3d& translate, const PXR_NS::GfVec3f& rotate);
     void update_data_in_bullet(std::unordered_map<PXR_NS::SdfPath, ComponentsSet, PXR_NS::SdfPath::Hash> paths, bool& bullet_scene_updated);
     void update_transforms_in_bullet(RigidBody& body, bool& bullet_scene_updated);
     void update_gravity_direction();
@@ -133,12 +149,14 @@ private:
     std::unique_ptr<btDefaultCollisionConfiguration> m_collision_configuration;
     std::unique_ptr<btCollisionDispatcher> m_cillision_dispatcher;
     std::unique_ptr<btDbvtBroadphase> m_overlapping_pair_cache;
-    std::unique_ptr<btSequentialImpulseConstraintSolver> m_solver;
+    std::unique_ptr<btConstraintSolverPoolMt> m_solver_pool;
+    std::unique_ptr<btConstraintSolver> m_solver;
     std::unique_ptr<btDiscreteDynamicsWorld> m_dynamics_world;
     std::vector<BodyInfo> m_deactivated_prims;
     bool m_miss_objects_changed = false;
     bool m_need_to_update_pick_constrins = false;
     bool m_is_active = true;
+    size_t m_pending_shapes_count = 0;
     std::mutex m_mutex;
     Options m_options;
 };
@@ -0,0 +1,618 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/usd_editor/bullet_physics/shape_cache.h"
+
+#include "btBulletDynamicsCommon.h"
+#include "VHACD.h"
+#include "pxr/base/gf/vec3f.h"
+#include "pxr/base/work/detachedTask.h"
+#include "opendcc/base/logging/logger.h"
+#include "opendcc/base/vendor/ghc/filesystem.hpp"
+
+#include <QCoreApplication>
+#include <QMetaObject>
+
+#include <cstring>
+#include <fstream>
+
+PXR_NAMESPACE_USING_DIRECTIVE;
+
+OPENDCC_NAMESPACE_OPEN
+
+namespace
+{
+    static const unsigned int vhacd_resolution = 10000;
+    static const unsigned int vhacd_depth = 10;
+    static const char disk_cache_magic[4] = { 'B', 'T', 'H', 'L' };
+    static const uint32_t disk_cache_version = 1;
+
+    uint64_t mix(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        value *= 0xc4ceb9fe1a85ec53ull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    uint64_t hash_bytes(uint64_t seed, const void* data, size_t size)
+    {
+        auto bytes = static_cast<const unsigned char*>(data);
+        uint64_t result = mix(seed ^ size);
+        size_t i = 0;
+        for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            result = mix(result ^ word) + 0x9e3779b97f4a7c15ull;
+        }
+        uint64_t tail = 0;
+        if (i < size)
+            std::memcpy(&tail, bytes + i, size - i);
+        return mix(result ^ tail);
+    }
+
+    struct TriangleMeshBuffers
+    {
+        VtVec3fArray points;
+        VtVec3iArray indices;
+        btIndexedMesh indexed_mesh;
+        btTriangleIndexVertexArray triangle_indexed_mesh;
+
+        TriangleMeshBuffers(const VtVec3fArray& in_points, const VtVec3iArray& in_indices)
+            : points(in_points)
+            , indices(in_indices)
+        {
+            indexed_mesh.m_numTriangles = indices.size();
+            indexed_mesh.m_triangleIndexBase = (const unsigned char*)indices.cdata();
+            indexed_mesh.m_triangleIndexStride = 3 * sizeof(uint32_t);
+            indexed_mesh.m_numVertices = points.size();
+            indexed_mesh.m_vertexBase = (const unsigned char*)points.cdata();
+            indexed_mesh.m_vertexStride = sizeof(GfVec3f);
+            triangle_indexed_mesh.addIndexedMesh(indexed_mesh);
+        }
+    };
+
+    class TriangleMeshShape : public btBvhTriangleMeshShape
+    {
+    public:
+        TriangleMeshShape(std::unique_ptr<TriangleMeshBuffers> buffers)
+            : btBvhTriangleMeshShape(&buffers->triangle_indexed_mesh, true)
+            , m_buffers(std::move(buffers))
+        {
+        }
+
+    private:
+        std::unique_ptr<TriangleMeshBuffers> m_buffers;
+    };
+
+#ifdef VHACD_LOGGING
+    class VHACDUpdate : public VHACD::IVHACD::IUserCallback
+    {
+    public:
+        virtual ~VHACDUpdate() {}
+        virtual void Update(const double overallProgress, const double stageProgress, const double operationProgress, const char* const stage,
+                            const char* const operation)
+        {
+            OPENDCC_INFO("Stage " + std::string(stage) + "; operation " + std::string(operation) + "  " + std::to_string(operationProgress) + "  " +
+                         std::to_string(stageProgress) + "  " + std::to_string(overallProgress));
+        }
+    };
+
+    class VHACDLogger : public VHACD::IVHACD::IUserLogger
+    {
+    public:
+        virtual ~VHACDLogger() {};
+        virtual void Log(const char* const msg) { OPENDCC_WARN(msg); }
+    };
+#endif
+
+    std::vector<float> build_optimized_hull(const float* points, int num_points, int stride)
+    {
+        btConvexHullShape shape(points, num_points, stride);
+        shape.optimizeConvexHull();
+
+        std::vector<float> result(shape.getNumPoints() * 3);
+        const auto unscaled_points = shape.getUnscaledPoints();
+        for (int i = 0; i < shape.getNumPoints(); ++i)
+        {
+            result[i * 3 + 0] = static_cast<float>(unscaled_points[i].x());
+            result[i * 3 + 1] = static_cast<float>(unscaled_points[i].y());
+            result[i * 3 + 2] = static_cast<float>(unscaled_points[i].z());
+        }
+        return result;
+    }
+
+    std::vector<std::vector<float>> build_vhacd_hulls(const VtVec3fArray& points, const VtVec3iArray& indices)
+    {
+        using namespace VHACD;
+        std::vector<std::vector<float>> result;
+
+        IVHACD* interfaceVHACD = CreateVHACD();
+        IVHACD::Parameters paramsVHACD;
+        paramsVHACD.m_resolution = vhacd_resolution;
+        paramsVHACD.m_depth = vhacd_depth;
+
+#ifdef VHACD_LOGGING
+        VHACDLogger logger;
+        VHACDUpdate updates;
+        paramsVHACD.m_logger = &logger;
+        paramsVHACD.m_callback = &updates;
+#endif
+
+        bool res = interfaceVHACD->Compute((const float*)points.cdata(), 3, (unsigned int)points.size(), (const int*)indices.cdata(), 3,
+                                           (unsigned int)indices.size(), paramsVHACD);
+        if (res)
+        {
+            for (unsigned int p = 0; p < interfaceVHACD->GetNConvexHulls(); ++p)
+            {
+                IVHACD::ConvexHull ch;
+                interfaceVHACD->GetConvexHull(p, ch);
+                if (ch.m_nPoints == 0)
+                    continue;
+
+                std::vector<float> hull_points(ch.m_points, ch.m_points + ch.m_nPoints * 3);
+                result.push_back(build_optimized_hull(hull_points.data(), ch.m_nPoints, 3 * sizeof(float)));
+            }
+        }
+
+        interfaceVHACD->Cancel();
+        interfaceVHACD->Release();
+        return result;
+    }
+
+    std::string get_disk_cache_path(const std::string& dir, uint64_t key)
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.hulls", static_cast<unsigned long long>(key));
+        return (ghc::filesystem::path(dir) / name).string();
+    }
+
+    bool read_hulls(const std::string& path, uint64_t key, std::vector<std::vector<float>>& hulls)
+    {
+        try
+        {
+            std::error_code error;
+            const auto file_size = ghc::filesystem::file_size(path, error);
+            std::ifstream file(path, std::ios::binary);
+            if (error || !file)
+                return false;
+
+            char magic[4];
+            uint32_t version = 0;
+            uint64_t file_key = 0;
+            uint32_t num_hulls = 0;
+            file.read(magic, sizeof(magic));
+            file.read((char*)&version, sizeof(version));
+            file.read((char*)&file_key, sizeof(file_key));
+            file.read((char*)&num_hulls, sizeof(num_hulls));
+            if (!file || std::memcmp(magic, disk_cache_magic, sizeof(magic)) != 0 || version != disk_cache_version || file_key != key)
+                return false;
+
+            // the counts of a damaged file must not make us allocate more than the file holds
+            uint64_t remaining = file_size - (sizeof(magic) + sizeof(version) + sizeof(file_key) + sizeof(num_hulls));
+            if (static_cast<uint64_t>(num_hulls) * sizeof(uint32_t) > remaining)
+                return false;
+
+            hulls.resize(num_hulls);
+            for (auto& hull : hulls)
+            {
+                uint32_t size = 0;
+                file.read((char*)&size, sizeof(size));
+                if (!file || size % 3 != 0)
+                    return false;
+                remaining -= sizeof(size);
+                if (static_cast<uint64_t>(size) * sizeof(float) > remaining)
+                    return false;
+                remaining -= size * sizeof(float);
+
+                hull.resize(size);
+                file.read((char*)hull.data(), size * sizeof(float));
+            }
+            return static_cast<bool>(file);
+        }
+        catch (const std::exception& e)
+        {
+            OPENDCC_WARN("Failed to read collision shape cache file \"{}\": {}", path, e.what());
+            return false;
+        }
+    }
+
+    void write_hulls(const std::string& path, uint64_t key, const std::vector<std::vector<float>>& hulls)
+    {
+        // written next to the target and renamed, so that readers never see a partial file
+        const auto tmp_path = path + ".tmp";
+        {
+            std::ofstream file(tmp_path, std::ios::binary);
+            if (!file)
+                return;
+
+            const auto num_hulls = static_cast<uint32_t>(hulls.size());
+            file.write(disk_cache_magic, sizeof(disk_cache_magic));
+            file.write((const char*)&disk_cache_version, sizeof(disk_cache_version));
+            file.write((const char*)&key, sizeof(key));
+            file.write((const char*)&num_hulls, sizeof(num_hulls));
+            for (const auto& hull : hulls)
+            {
+                const auto size = static_cast<uint32_t>(hull.size());
+                file.write((const char*)&size, sizeof(size));
+                file.write((const char*)hull.data(), hull.size() * sizeof(float));
+            }
+            if (!file)
+                return;
+        }
+
+        std::error_code error;
+        ghc::filesystem::rename(tmp_path, path, error);
+        if (error)
+            ghc::filesystem::remove(tmp_path, error);
+    }
+};
+
+/* static */
+CollisionShapeCache& CollisionShapeCache::instance()
+{
+    static CollisionShapeCache cache;
+    return cache;
+}
+
+/* static */
+uint64_t CollisionShapeCache::compute_key(const Source& source)
+{
+    uint64_t result = mix(static_cast<uint64_t>(source.kind) + 1);
+    if (source.kind == Kind::VHACD)
+        result = mix(result ^ (static_cast<uint64_t>(vhacd_resolution) << 32 | vhacd_depth));
+
+    result = hash_bytes(result, source.points.cdata(), source.points.size() * sizeof(GfVec3f));
+    if (source.kind != Kind::CONVEX_HULL)
+        result = hash_bytes(result, source.indices.cdata(), source.indices.size() * sizeof(GfVec3i));
+    return result;
+}
+
+CollisionShapeCache::DataPtr CollisionShapeCache::get(const Source& source)
+{
+    const auto key = compute_key(source);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        auto& entry = m_entries[key];
+        if (entry.data)
+        {
+            touch(entry);
+            return entry.data;
+        }
+
+        if (!entry.building)
+        {
+            entry.building = true;
+            ++m_running_builds;
+            lock.unlock();
+
+            auto data = build(source, key);
+            finish(key, data);
+            return data;
+        }
+
+        // the data can be evicted before this thread wakes up, then it is built again
+        m_build_finished.wait(lock, [this, key] {
+            auto it = m_entries.find(key);
+            return it == m_entries.end() || !it->second.building;
+        });
+    }
+}
+
+CollisionShapeCache::DataPtr CollisionShapeCache::request(const Source& source, uint64_t key, const std::function<void()>& on_ready)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& entry = m_entries[key];
+    if (entry.data)
+    {
+        touch(entry);
+        return entry.data;
+    }
+
+    if (on_ready)
+        entry.waiters.push_back(on_ready);
+    if (entry.building)
+        return nullptr;
+
+    entry.building = true;
+    ++m_running_builds;
+    WorkRunDetachedTask([this, source, key] { finish(key, build(source, key)); });
+    return nullptr;
+}
+
+bool CollisionShapeCache::is_building(uint64_t key) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(key);
+    return it != m_entries.end() && it->second.building;
+}
+
+void CollisionShapeCache::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_build_finished.wait(lock, [this] { return m_running_builds == 0; });
+}
+
+void CollisionShapeCache::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_entries.begin(); it != m_entries.end();)
+    {
+        // running builds still need their entries
+        if (it->second.building)
+            ++it;
+        else
+            it = m_entries.erase(it);
+    }
+    m_lru.clear();
+    m_memory_size = 0;
+}
+
+size_t CollisionShapeCache::size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
+
+void CollisionShapeCache::set_max_memory(size_t max_memory)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_max_memory = max_memory;
+    evict();
+}
+
+size_t CollisionShapeCache::get_max_memory() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_max_memory;
+}
+
+size_t CollisionShapeCache::get_memory_size() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_memory_size;
+}
+
+void CollisionShapeCache::set_disk_cache_dir(const std::string& dir)
+{
+    if (!dir.empty())
+    {
+        std::error_code error;
+        ghc::filesystem::create_directories(dir, error);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_disk_cache_dir = dir;
+}
+
+std::string CollisionShapeCache::get_disk_cache_dir() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_disk_cache_dir;
+}
+
+CollisionShapeCache::DataPtr CollisionShapeCache::build(const Source& source, uint64_t key) const
+{
+    // an exception would leave the entry building forever
+    try
+    {
+        return build_data(source, key);
+    }
+    catch (const std::exception& e)
+    {
+        OPENDCC_ERROR("Failed to build collision shape: {}", e.what());
+        return std::make_shared<Data>();
+    }
+}
+
+CollisionShapeCache::DataPtr CollisionShapeCache::build_data(const Source& source, uint64_t key) const
+{
+    auto result = std::make_shared<Data>();
+    if (source.kind == Kind::TRIANGLE_MESH)
+    {
+        if (source.points.size() > 0 && source.indices.size() > 0)
+        {
+            // bullet shapes use their own aligned operator new
+            result->triangle_mesh =
+                std::shared_ptr<btBvhTriangleMeshShape>(new TriangleMeshShape(std::make_unique<TriangleMeshBuffers>(source.points, source.indices)));
+            // the copied buffers and about two quantized BVH nodes per triangle
+            result->memory_size = source.points.size() * sizeof(GfVec3f) + source.indices.size() * (sizeof(GfVec3i) + 2 * sizeof(btQuantizedBvhNode));
+        }
+        return result;
+    }
+
+    const auto disk_cache_dir = get_disk_cache_dir();
+    const auto disk_cache_path = disk_cache_dir.empty() ? std::string() : get_disk_cache_path(disk_cache_dir, key);
+    if (disk_cache_path.empty() || !read_hulls(disk_cache_path, key, result->hulls))
+    {
+        result->hulls.clear();
+        if (source.kind == Kind::CONVEX_HULL)
+        {
+            if (source.points.size() > 0)
+                result->hulls.push_back(build_optimized_hull((const float*)source.points.cdata(), source.points.size(), sizeof(GfVec3f)));
+        }
+        else if (source.points.size() > 0 && source.indices.size() > 0)
+        {
+            result->hulls = build_vhacd_hulls(source.points, source.indices);
+        }
+
+        if (!disk_cache_path.empty() && !result->hulls.empty())
+            write_hulls(disk_cache_path, key, result->hulls);
+    }
+
+    for (const auto& hull : result->hulls)
+        result->memory_size += hull.size() * sizeof(float);
+    return result;
+}
+
+void CollisionShapeCache::finish(uint64_t key, DataPtr data)
+{
+    std::vector<std::function<void()>> waiters;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& entry = m_entries[key];
+        entry.data = std::move(data);
+        entry.building = false;
+        waiters.swap(entry.waiters);
+        --m_running_builds;
+
+        m_lru.push_front(key);
+        entry.lru_position = m_lru.begin();
+        m_memory_size += entry.data->memory_size;
+        evict();
+    }
+    m_build_finished.notify_all();
+
+    // without the application the requesters poll the cache themselves
+    if (!waiters.empty() && QCoreApplication::instance())
+    {
+        QMetaObject::invokeMethod(
+            QCoreApplication::instance(),
+            [waiters] {
+                for (const auto& waiter : waiters)
+                    waiter();
+            },
+            Qt::QueuedConnection);
+    }
+}
+
+void CollisionShapeCache::touch(Entry& entry)
+{
+    m_lru.splice(m_lru.begin(), m_lru, entry.lru_position);
+}
+
+void CollisionShapeCache::evict()
+{
+    // the most recent data stays even if it alone is over the limit
+    while (m_memory_size > m_max_memory && m_lru.size() > 1)
+    {
+        auto it = m_entries.find(m_lru.back());
+        m_lru.pop_back();
+        m_memory_size -= it->second.data->memory_size;
+        m_entries.erase(it);
+    }
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+
+OPENDCC_NAMESPACE_USING
+PXR_NAMESPACE_USING_DIRECTIVE
+
+DOCTEST_TEST_SUITE("CollisionShapeCache")
+{
+    DOCTEST_TEST_CASE("shared_builds")
+    {
+        CollisionShapeCache::Source source;
+        source.kind = CollisionShapeCache::Kind::CONVEX_HULL;
+        for (int i = 0; i < 8; ++i)
+            source.points.push_back(GfVec3f(i & 1, (i >> 1) & 1, (i >> 2) & 1));
+        // an inner point is dropped from the hull
+        source.points.push_back(GfVec3f(0.5f));
+
+        auto& cache = CollisionShapeCache::instance();
+        cache.clear();
+
+        // concurrent requests of the same mesh build it once
+        const auto key = CollisionShapeCache::compute_key(source);
+        DOCTEST_CHECK(cache.request(source, key, nullptr) == nullptr);
+        DOCTEST_CHECK(cache.request(source, key, nullptr) == nullptr);
+        cache.wait();
+        DOCTEST_CHECK(!cache.is_building(key));
+        auto data = cache.request(source, key, nullptr);
+        DOCTEST_REQUIRE(data);
+        DOCTEST_REQUIRE(data->hulls.size() == 1);
+        DOCTEST_CHECK(data->hulls[0].size() <= 8 * 3);
+        DOCTEST_CHECK(cache.get(source) == data);
+        DOCTEST_CHECK(cache.size() == 1);
+
+        auto other = source;
+        other.kind = CollisionShapeCache::Kind::TRIANGLE_MESH;
+        DOCTEST_CHECK(CollisionShapeCache::compute_key(other) != CollisionShapeCache::compute_key(source));
+        other = source;
+        other.points[0] = GfVec3f(-1);
+        DOCTEST_CHECK(CollisionShapeCache::compute_key(other) != CollisionShapeCache::compute_key(source));
+    }
+
+    DOCTEST_TEST_CASE("disk_cache")
+    {
+        const auto dir = ghc::filesystem::temp_directory_path() / "opendcc_collision_shape_cache_tests";
+        ghc::filesystem::remove_all(dir);
+
+        auto& cache = CollisionShapeCache::instance();
+        const auto prev_dir = cache.get_disk_cache_dir();
+        cache.set_disk_cache_dir(dir.string());
+        cache.clear();
+
+        CollisionShapeCache::Source source;
+        source.points = { GfVec3f(0, 0, 0), GfVec3f(1, 0, 0), GfVec3f(0, 1, 0), GfVec3f(0, 0, 1) };
+        const auto built = cache.get(source);
+        DOCTEST_REQUIRE(built->hulls.size() == 1);
+        DOCTEST_CHECK(ghc::filesystem::exists(dir / get_disk_cache_path("", CollisionShapeCache::compute_key(source))));
+
+        // a new session reads the stored hull
+        cache.clear();
+        const auto read = cache.get(source);
+        DOCTEST_CHECK(read != built);
+        DOCTEST_CHECK(read->hulls == built->hulls);
+
+        // a damaged file claiming more hulls than it holds is a cache miss
+        const auto path = dir / get_disk_cache_path("", CollisionShapeCache::compute_key(source));
+        {
+            const auto key = CollisionShapeCache::compute_key(source);
+            const uint32_t num_hulls = 0xffffffff;
+            std::ofstream file(path.string(), std::ios::binary | std::ios::trunc);
+            file.write(disk_cache_magic, sizeof(disk_cache_magic));
+            file.write((const char*)&disk_cache_version, sizeof(disk_cache_version));
+            file.write((const char*)&key, sizeof(key));
+            file.write((const char*)&num_hulls, sizeof(num_hulls));
+        }
+        cache.clear();
+        const auto rebuilt = cache.get(source);
+        DOCTEST_CHECK(rebuilt->hulls == built->hulls);
+        std::vector<std::vector<float>> stored;
+        DOCTEST_CHECK(read_hulls(path.string(), CollisionShapeCache::compute_key(source), stored));
+
+        cache.set_disk_cache_dir(prev_dir);
+        cache.clear();
+        ghc::filesystem::remove_all(dir);
+    }
+
+    DOCTEST_TEST_CASE("memory_limit")
+    {
+        auto& cache = CollisionShapeCache::instance();
+        const auto prev_max_memory = cache.get_max_memory();
+        cache.clear();
+
+        std::vector<CollisionShapeCache::Source> sources(3);
+        for (size_t i = 0; i < sources.size(); ++i)
+            sources[i].points = { GfVec3f(0, 0, 0), GfVec3f(1, 0, 0), GfVec3f(0, 1, 0), GfVec3f(0, 0, i + 1.0f) };
+
+        const auto first = cache.get(sources[0]);
+        cache.set_max_memory(2 * first->memory_size);
+        cache.get(sources[1]);
+        // the first data is used again, so the second one is the least recently used
+        DOCTEST_CHECK(cache.get(sources[0]) == first);
+        cache.get(sources[2]);
+        DOCTEST_CHECK(cache.size() == 2);
+        DOCTEST_CHECK(cache.get_memory_size() <= cache.get_max_memory());
+        DOCTEST_CHECK(cache.get(sources[0]) == first);
+
+        // the most recent data is kept even if it doesn't fit
+        cache.set_max_memory(0);
+        DOCTEST_CHECK(cache.size() == 1);
+        DOCTEST_CHECK(cache.get(sources[0]) == first);
+
+        cache.set_max_memory(prev_max_memory);
+        cache.clear();
+    }
+}
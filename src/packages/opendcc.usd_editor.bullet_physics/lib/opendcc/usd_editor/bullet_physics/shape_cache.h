@@ -0,0 +1,116 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include "opendcc/opendcc.h"
+#include "api.h"
+#include "pxr/base/vt/array.h"
+#include "pxr/base/vt/types.h"
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class btBvhTriangleMeshShape;
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Cache of the expensive parts of the mesh collision shapes.
+ *
+ * Convex hulls, VHACD decompositions and triangle mesh BVHs are keyed by a hash of the mesh points,
+ * triangle indices, the kind of the shape and its build parameters, so identical meshes share one build.
+ * Builds run on worker threads, hulls can also be stored in a directory to be reused by later sessions.
+ */
+class BULLET_PHYSICS_API CollisionShapeCache
+{
+public:
+    enum class Kind
+    {
+        CONVEX_HULL,
+        VHACD,
+        TRIANGLE_MESH
+    };
+
+    struct Source
+    {
+        Kind kind = Kind::CONVEX_HULL;
+        PXR_NS::VtVec3fArray points;
+        // used by VHACD and TRIANGLE_MESH
+        PXR_NS::VtVec3iArray indices;
+    };
+
+    // immutable once built, shapes are instantiated from it for every body
+    struct Data
+    {
+        // xyz points of every convex hull, empty if the build failed
+        std::vector<std::vector<float>> hulls;
+        // unscaled shape with a built BVH, bodies use it through btScaledBvhTriangleMeshShape
+        std::shared_ptr<btBvhTriangleMeshShape> triangle_mesh;
+        // approximate number of bytes held by the data, counted against the memory limit of the cache
+        size_t memory_size = 0;
+    };
+    using DataPtr = std::shared_ptr<const Data>;
+
+    static CollisionShapeCache& instance();
+
+    // returns the data, builds it on the calling thread or waits for the running build
+    DataPtr get(const Source& source);
+    // returns the data if it is built, otherwise starts building it on a worker thread and returns nullptr,
+    // on_ready is called on the main thread after the build is finished, key is compute_key(source)
+    DataPtr request(const Source& source, uint64_t key, const std::function<void()>& on_ready);
+    // true while the data of the key is being built, cheap enough to be polled every frame
+    bool is_building(uint64_t key) const;
+    // waits until all running builds are finished
+    void wait();
+    void clear();
+    size_t size() const;
+
+    // least recently used data is dropped from the cache when it holds more than max_memory bytes,
+    // bodies keep using the shapes they already have
+    void set_max_memory(size_t max_memory);
+    size_t get_max_memory() const;
+    size_t get_memory_size() const;
+
+    // an empty dir disables the disk cache
+    void set_disk_cache_dir(const std::string& dir);
+    std::string get_disk_cache_dir() const;
+
+    static uint64_t compute_key(const Source& source);
+
+private:
+    struct Entry
+    {
+        DataPtr data;
+        bool building = false;
+        std::vector<std::function<void()>> waiters;
+        // position in m_lru, valid while data is set
+        std::list<uint64_t>::iterator lru_position;
+    };
+
+    CollisionShapeCache() = default;
+    DataPtr build(const Source& source, uint64_t key) const;
+    DataPtr build_data(const Source& source, uint64_t key) const;
+    void finish(uint64_t key, DataPtr data);
+    // both expect m_mutex to be locked
+    void touch(Entry& entry);
+    void evict();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_build_finished;
+    std::unordered_map<uint64_t, Entry> m_entries;
+    // keys of the built entries, most recently used first
+    std::list<uint64_t> m_lru;
+    size_t m_memory_size = 0;
+    size_t m_max_memory = 512 * 1024 * 1024;
+    size_t m_running_builds = 0;
+    std::string m_disk_cache_dir;
+};
+
+OPENDCC_NAMESPACE_CLOSE
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "opendcc/usd_editor/bullet_physics/utils.h"
+#include "opendcc/usd_editor/bullet_physics/shape_cache.h"
 
 // #include "GIMPACTUtils/btGImpactConvexDecompositionShape.h"
 #include "pxr/base/gf/vec3f.h"
@@ -11,14 +12,16 @@
 #include "pxr/usd/usdGeom/cube.h"
 #include "pxr/usd/usdGeom/sphere.h"
 #include "pxr/imaging/hd/meshUtil.h"
+#include "pxr/base/gf/range3f.h"
 #include "btBulletDynamicsCommon.h"
+#include "BulletCollision/CollisionShapes/btScaledBvhTriangleMeshShape.h"
 
-#include "VHACD.h"
 #include <iostream>
 #include <vector>
 #include "pxr/base/gf/transform.h"
 #include "pxr/usd/usdGeom/xformCommonAPI.h"
 #include "opendcc/app/core/undo/block.h"
+#include "opendcc/app/core/sorted_path_set.h"
 #include "pxr/usd/usd/primRange.h"
 #include "pxr/base/gf/vec3f.h"
 
@@ -52,33 +55,6 @@ namespace
         return indices;
     }
 
-    struct TriangleMeshData
-    {
-        VtVec3fArray points;
-        VtVec3iArray indices;
-        btIndexedMesh indexed_mesh;
-        btTriangleIndexVertexArray triangle_indexed_mesh;
-
-        TriangleMeshData(const UsdGeomMesh& mesh, UsdTimeCode time_code, bool& ok)
-        {
-            ok = false;
-            ok = mesh.GetPointsAttr().Get(&points);
-            if (!ok || points.size() == 0)
-                return;
-
-            indices = compute_triangles_indices(mesh, time_code);
-
-            indexed_mesh.m_numTriangles = indices.size();
-            indexed_mesh.m_triangleIndexBase = (const unsigned char*)indices.cdata();
-            indexed_mesh.m_triangleIndexStride = 3 * sizeof(uint32_t);
-            indexed_mesh.m_numVertices = points.size();
-            indexed_mesh.m_vertexBase = (const unsigned char*)points.cdata();
-            indexed_mesh.m_vertexStride = sizeof(GfVec3f);
-            triangle_indexed_mesh.addIndexedMesh(indexed_mesh);
-            ok = true;
-        }
-    };
-
     //     class btGImpactConvexDecompositionShapeWithBuffers : public btGImpactConvexDecompositionShape
     //     {
     //     public:
@@ -95,32 +71,23 @@ namespace
     //         TriangleMeshData* data = nullptr;
     //     };
 
-    class btBvhTriangleMeshShapeWithBuffers : public btBvhTriangleMeshShape
+    // shares the cached triangle mesh and its BVH, the scaling is per body
+    class btScaledBvhTriangleMeshShapeWithBuffers : public btScaledBvhTriangleMeshShape
     {
     public:
-        btBvhTriangleMeshShapeWithBuffers(btStridingMeshInterface* meshInterface, bool useQuantizedAabbCompression, bool buildBvh = true)
-            : btBvhTriangleMeshShape(meshInterface, useQuantizedAabbCompression, buildBvh)
+        btScaledBvhTriangleMeshShapeWithBuffers(const std::shared_ptr<btBvhTriangleMeshShape>& child_shape)
+            : btScaledBvhTriangleMeshShape(child_shape.get(), btVector3(1, 1, 1))
+            , m_child_shape(child_shape)
         {
         }
-        ~btBvhTriangleMeshShapeWithBuffers() { delete data; }
-        TriangleMeshData* data = nullptr;
-    };
 
-    class btConvexHullShapeWithBuffers : public btConvexHullShape
-    {
-    public:
-        btConvexHullShapeWithBuffers(const btScalar* points, int numPoints, int stride)
-            : btConvexHullShape(points, numPoints, stride)
-        {
-        }
-        ~btConvexHullShapeWithBuffers() {}
-        std::shared_ptr<VtVec3fArray> points_buffer;
+    private:
+        std::shared_ptr<btBvhTriangleMeshShape> m_child_shape;
     };
 
     class btVHACDShapeWithBuffers : public btCompoundShape
     {
     public:
-        using Buffer = std::shared_ptr<std::vector<float>>;
         btVHACDShapeWithBuffers() {}
         ~btVHACDShapeWithBuffers()
         {
@@ -128,7 +95,24 @@ namespace
                 delete shape;
         }
         std::vector<btConvexHullShape*> convex_shapes;
-        std::vector<Buffer> points_buffers;
+    };
+
+    // the bounding box used while the actual shape is being built
+    class btPlaceholderShape : public btCompoundShape
+    {
+    public:
+        btPlaceholderShape(const GfRange3f& range)
+            : m_box(btVector3(btScalar(range.GetSize()[0] * 0.5), btScalar(range.GetSize()[1] * 0.5), btScalar(range.GetSize()[2] * 0.5)))
+        {
+            const auto center = range.GetMidpoint();
+            btTransform transform;
+            transform.setIdentity();
+            transform.setOrigin(btVector3(center[0], center[1], center[2]));
+            addChildShape(transform, &m_box);
+        }
+
+    private:
+        btBoxShape m_box;
     };
 
     class CompoundShape : public btCompoundShape
@@ -156,27 +140,6 @@ namespace
     private:
         ChildrenMap m_children;
     };
-
-#ifdef VHACD_LOGGING
-    class VHACDUpdate : public VHACD::IVHACD::IUserCallback
-    {
-    public:
-        virtual ~VHACDUpdate() {}
-        virtual void Update(const double overallProgress, const double stageProgress, const double operationProgress, const char* const stage,
-                            const char* const operation)
-        {
-            OPENDCC_INFO("Stage " + std::string(stage) + "; operation " + std::string(operation) + "  " + std::to_string(operationProgress) + "  " +
-                         std::to_string(stageProgress) + "  " + std::to_string(overallProgress));
-        }
-    };
-
-    class VHACDLogger : public VHACD::IVHACD::IUserLogger
-    {
-    public:
-        virtual ~VHACDLogger() {};
-        virtual void Log(const char* const msg) { OPENDCC_WARN(msg); }
-    };
-#endif
 }
 
 void usd_transform_to_bullet(const GfTransform& from, btTransform& to)
@@ -191,18 +154,68 @@ void usd_transform_to_bullet(const GfTransform& from, btTransform& to)
     to.setRotation(btQuaternion(q.GetImaginary()[0], q.GetImaginary()[1], q.GetImaginary()[2], q.GetReal()));
 }
 
-std::unique_ptr<btCollisionShape> create_bvh_mesh_shape(const UsdGeomMesh& mesh, UsdTimeCode time_code)
+std::unique_ptr<btCollisionShape> create_shape_from_data(const CollisionShapeCache::Data& data, CollisionShapeCache::Kind kind)
 {
-    bool ok = false;
-    auto data = new TriangleMeshData(mesh, time_code, ok);
-    if (!ok)
+    if (kind == CollisionShapeCache::Kind::TRIANGLE_MESH)
+    {
+        if (!data.triangle_mesh)
+            return nullptr;
+        return std::make_unique<btScaledBvhTriangleMeshShapeWithBuffers>(data.triangle_mesh);
+    }
+
+    if (data.hulls.empty())
         return nullptr;
 
-    auto shape = std::make_unique<btBvhTriangleMeshShapeWithBuffers>(&data->triangle_indexed_mesh, true);
-    shape->data = data;
+    // the cached hulls are already optimized
+    if (kind == CollisionShapeCache::Kind::CONVEX_HULL)
+    {
+        const auto& hull = data.hulls[0];
+        return std::make_unique<btConvexHullShape>(hull.data(), int(hull.size() / 3), 3 * sizeof(float));
+    }
+
+    auto shape = std::make_unique<btVHACDShapeWithBuffers>();
+    for (const auto& hull : data.hulls)
+    {
+        auto convex_shape = new btConvexHullShape(hull.data(), int(hull.size() / 3), 3 * sizeof(float));
+        shape->convex_shapes.push_back(convex_shape);
+        shape->addChildShape(btTransform::getIdentity(), convex_shape);
+    }
     return shape;
 }
 
+std::unique_ptr<btCollisionShape> create_cached_mesh_shape(const UsdGeomMesh& mesh, CollisionShapeCache::Kind kind, UsdTimeCode time_code,
+                                                           const std::function<void()>& on_shape_ready, std::vector<uint64_t>* pending_keys)
+{
+    CollisionShapeCache::Source source;
+    source.kind = kind;
+    bool ok = mesh.GetPointsAttr().Get(&source.points);
+    if (!ok || source.points.size() == 0)
+        return nullptr;
+
+    if (kind != CollisionShapeCache::Kind::CONVEX_HULL)
+    {
+        source.indices = compute_triangles_indices(mesh, time_code);
+        if (source.indices.size() == 0)
+            return nullptr;
+    }
+
+    auto& cache = CollisionShapeCache::instance();
+    const auto key = on_shape_ready ? CollisionShapeCache::compute_key(source) : 0;
+    auto data = on_shape_ready ? cache.request(source, key, on_shape_ready) : cache.get(source);
+    if (!data)
+    {
+        if (pending_keys)
+            pending_keys->push_back(key);
+
+        GfRange3f range;
+        for (const auto& point : source.points)
+            range.UnionWith(point);
+        return std::make_unique<btPlaceholderShape>(range);
+    }
+
+    return create_shape_from_data(*data, kind);
+}
+
 void update_children(UsdPrim prim, btCollisionShape* shape, const std::unordered_set<SdfPath, SdfPath::Hash>& components)
 {
     if (!prim || !shape || components.size() == 0)
@@ -214,14 +227,12 @@ void update_children(UsdPrim prim, btCollisionShape* shape, const std::unordered
         OPENDCC_ERROR("Coding error: shape is not compound");
         return;
     }
+    const SortedPathSet changed_components(SdfPathVector(components.begin(), components.end()));
     std::unordered_set<SdfPath, SdfPath::Hash> paths_to_update;
-    for (auto& component : components)
+    for (auto& it : compound_shape->children())
     {
-        for (auto& it : compound_shape->children())
-        {
-            if (it.first.HasPrefix(component))
-                paths_to_update.insert(it.first);
-        }
+        if (changed_components.has_ancestor(it.first))
+            paths_to_update.insert(it.first);
     }
     if (paths_to_update.size() == 0)
         return;
@@ -255,7 +266,8 @@ void update_children(UsdPrim prim, btCollisionShape* shape, const std::unordered
 
 std::unique_ptr<btCollisionShape> create_compound_shape(const UsdPrim& base_prim, const SdfPathVector& atomic_prim_path,
                                                         BulletPhysicsEngine::BodyType type,
-                                                        BulletPhysicsEngine::MeshApproximationType mesh_approximation_type, UsdTimeCode time_code)
+                                                        BulletPhysicsEngine::MeshApproximationType mesh_approximation_type, UsdTimeCode time_code,
+                                                        const std::function<void()>& on_shape_ready, std::vector<uint64_t>* pending_keys)
 {
     std::unordered_map<SdfPath, std::unique_ptr<btCollisionShape>, SdfPath::Hash> atomic_shapes;
     std::unordered_map<SdfPath, btTransform, SdfPath::Hash> transforms;
@@ -266,7 +278,7 @@ std::unique_ptr<btCollisionShape> create_compound_shape(const UsdPrim& base_prim
     for (auto& path : atomic_prim_path)
     {
         auto prim = base_prim.GetStage()->GetPrimAtPath(path);
-        auto shape = create_collision_shape(prim, type, mesh_approximation_type, time_code);
+        auto shape = create_collision_shape(prim, type, mesh_approximation_type, time_code, on_shape_ready, pending_keys);
         if (!shape)
             continue;
         const auto transform_matrix = xform_cache.GetLocalToWorldTransform(prim) * base_transform_inv;
@@ -288,19 +300,6 @@ std::unique_ptr<btCollisionShape> create_compound_shape(const UsdPrim& base_prim
     return nullptr;
 }
 
-std::unique_ptr<btCollisionShape> create_convex_hull_shape(const UsdGeomMesh& mesh, UsdTimeCode time_code)
-{
-    VtVec3fArray points;
-    bool ok = mesh.GetPointsAttr().Get(&points);
-    if (!ok)
-        return nullptr;
-    auto points_buffer = std::make_shared<VtVec3fArray>(points);
-    auto shape = std::make_unique<btConvexHullShapeWithBuffers>((float*)points.data(), points.size(), sizeof(GfVec3f));
-    shape->optimizeConvexHull();
-    shape->points_buffer = points_buffer;
-    return shape;
-}
-
 std::unique_ptr<btCollisionShape> create_box_shape(const UsdGeomMesh& mesh, UsdTimeCode time_code)
 {
     VtVec3fArray extent;
@@ -334,69 +333,6 @@ std::unique_ptr<btCollisionShape> create_convex_decomposition_shape(const UsdGeo
 }
 #endif
 
-std::unique_ptr<btCollisionShape> create_vhacd_shape(const UsdGeomMesh& mesh, UsdTimeCode time_code)
-{
-    using namespace VHACD;
-    VtVec3fArray points;
-    bool ok = mesh.GetPointsAttr().Get(&points);
-    if (!ok || points.size() == 0)
-        return nullptr;
-
-    VtVec3iArray indices = compute_triangles_indices(mesh, time_code);
-    if (indices.size() == 0)
-        return nullptr;
-
-    IVHACD* interfaceVHACD = CreateVHACD();
-    IVHACD::Parameters paramsVHACD;
-    paramsVHACD.m_resolution = 10000;
-    paramsVHACD.m_depth = 10;
-
-#ifdef VHACD_LOGGING
-    VHACDLogger logger;
-    VHACDUpdate updates;
-    paramsVHACD.m_logger = &logger;
-    paramsVHACD.m_callback = &updates;
-#endif
-
-    bool res = interfaceVHACD->Compute((const float*)points.cdata(), 3, (unsigned int)points.size(), (const int*)indices.data(), 3,
-                                       (unsigned int)indices.size(), paramsVHACD);
-
-    if (!res)
-        return nullptr;
-
-    unsigned int nConvexHulls = interfaceVHACD->GetNConvexHulls();
-    if (nConvexHulls == 0)
-        return nullptr;
-
-    auto shape = std::make_unique<btVHACDShapeWithBuffers>();
-    for (unsigned int p = 0; p < nConvexHulls; ++p)
-    {
-        IVHACD::ConvexHull ch;
-        interfaceVHACD->GetConvexHull(p, ch);
-        if (ch.m_nPoints == 0)
-            continue;
-
-        auto shape_points = std::make_shared<std::vector<float>>(ch.m_nPoints * 3);
-        for (size_t i = 0; i < shape_points->size(); ++i)
-            (*shape_points)[i] = ch.m_points[i];
-
-        auto convex_shape = new btConvexHullShape(shape_points->data(), ch.m_nPoints, 3 * sizeof(float));
-        convex_shape->optimizeConvexHull();
-
-        shape->convex_shapes.push_back(convex_shape);
-        shape->points_buffers.push_back(shape_points);
-        shape->addChildShape(btTransform::getIdentity(), convex_shape);
-    }
-
-    interfaceVHACD->Cancel();
-    interfaceVHACD->Release();
-
-    if (shape->getNumChildShapes() == 0)
-        return nullptr;
-
-    return shape;
-}
-
 bool is_supported_type(const UsdPrim& prim)
 {
     return prim && (prim.IsA<UsdGeomMesh>() || prim.IsA<UsdGeomCube>() || prim.IsA<UsdGeomSphere>());
@@ -423,7 +359,8 @@ SdfPathVector get_supported_prims_paths_recursively(const UsdStageRefPtr& stage,
 }
 
 std::unique_ptr<btCollisionShape> create_collision_shape(const UsdPrim& prim, BulletPhysicsEngine::BodyType type,
-                                                         BulletPhysicsEngine::MeshApproximationType mesh_approximation_type, UsdTimeCode time_code)
+                                                         BulletPhysicsEngine::MeshApproximationType mesh_approximation_type, UsdTimeCode time_code,
+                                                         const std::function<void()>& on_shape_ready, std::vector<uint64_t>* pending_keys)
 {
     std::unique_ptr<btCollisionShape> shape;
     if (prim.IsA<UsdGeomSphere>())
@@ -449,9 +386,9 @@ std::unique_ptr<btCollisionShape> create_collision_shape(const UsdPrim& prim, Bu
             if (mesh_approximation_type == BulletPhysicsEngine::MeshApproximationType::BOX)
                 shape = create_box_shape(mesh, time_code);
             else if (mesh_approximation_type == BulletPhysicsEngine::MeshApproximationType::CONVEX_HULL)
-                shape = create_convex_hull_shape(mesh, time_code);
+                shape = create_cached_mesh_shape(mesh, CollisionShapeCache::Kind::CONVEX_HULL, time_code, on_shape_ready, pending_keys);
             else if (mesh_approximation_type == BulletPhysicsEngine::MeshApproximationType::VHACD)
-                shape = create_vhacd_shape(mesh, time_code);
+                shape = create_cached_mesh_shape(mesh, CollisionShapeCache::Kind::VHACD, time_code, on_shape_ready, pending_keys);
             else
             {
                 OPENDCC_INFO(BulletPhysicsEngine::s_extension_short_name, "coding error: trying creating dynamic shape with unsupported shape type");
@@ -460,13 +397,13 @@ std::unique_ptr<btCollisionShape> create_collision_shape(const UsdPrim& prim, Bu
         }
         else if (type == BulletPhysicsEngine::BodyType::STATIC)
         {
-            shape = create_bvh_mesh_shape(mesh, time_code);
+            shape = create_cached_mesh_shape(mesh, CollisionShapeCache::Kind::TRIANGLE_MESH, time_code, on_shape_ready, pending_keys);
         }
     }
     else if (prim.IsA<UsdGeomXformable>())
     {
         SdfPathVector atomic_prims = get_supported_prims_paths_recursively(prim.GetStage(), SdfPathVector(1, prim.GetPath()));
-        shape = create_compound_shape(prim, atomic_prims, type, mesh_approximation_type, time_code);
+        shape = create_compound_shape(prim, atomic_prims, type, mesh_approximation_type, time_code, on_shape_ready, pending_keys);
     }
 
     return shape;
@@ -6,8 +6,10 @@
 #pragma once
 #include "opendcc/opendcc.h"
 #include "api.h"
+#include <functional>
 #include <memory>
 #include <unordered_set>
+#include <vector>
 #include "pxr/usd/usd/prim.h"
 #include "pxr/base/gf/transform.h"
 #include "pxr/usd/usdGeom/mesh.h"
@@ -19,9 +21,18 @@ class btTransform;
 OPENDCC_NAMESPACE_OPEN
 
 bool BULLET_PHYSICS_API is_supported_type(const PXR_NS::UsdPrim& type);
+/**
+ * @brief Creates the collision shape of the prim, mesh shapes are taken from CollisionShapeCache.
+ *
+ * Without on_shape_ready the mesh shapes are built on the calling thread. Otherwise a mesh shape
+ * which isn't cached yet is replaced by its bounding box, its cache key is appended to pending_keys
+ * and on_shape_ready is called on the main thread when the shape can be created again with the actual geometry.
+ */
 std::unique_ptr<btCollisionShape> BULLET_PHYSICS_API create_collision_shape(const PXR_NS::UsdPrim& prim, BulletPhysicsEngine::BodyType type,
                                                                             BulletPhysicsEngine::MeshApproximationType mesh_approximation_type,
-                                                                            PXR_NS::UsdTimeCode time_code);
+                                                                            PXR_NS::UsdTimeCode time_code,
+                                                                            const std::function<void()>& on_shape_ready = nullptr,
+                                                                            std::vector<uint64_t>* pending_keys = nullptr);
 void BULLET_PHYSICS_API reset_pivots(const PXR_NS::SdfPathVector& paths);
 PXR_NS::SdfPathVector BULLET_PHYSICS_API get_supported_prims_paths_recursively(const PXR_NS::UsdStageRefPtr& stage,
                                                                                const PXR_NS::SdfPathVector& paths);
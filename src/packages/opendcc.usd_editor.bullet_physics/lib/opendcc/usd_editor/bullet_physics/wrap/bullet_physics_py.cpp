@@ -47,6 +47,7 @@ PYBIND11_MODULE(bullet_physics, m)
         .def("remove_all", &BulletPhysicsEngine::remove_all)
         .def("print_state", &BulletPhysicsEngine::print_state)
         .def("step_simulation", &BulletPhysicsEngine::step_simulation)
+        .def("wait_for_pending_shapes", &BulletPhysicsEngine::wait_for_pending_shapes)
         .def("update_solver_options", &BulletPhysicsEngine::update_solver_options);
 
     class_<BulletPhysicsSession, std::unique_ptr<BulletPhysicsSession, nodelete>>(m, "BulletPhysicsSession")
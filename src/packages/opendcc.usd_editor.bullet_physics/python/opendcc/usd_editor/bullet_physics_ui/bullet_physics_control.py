@@ -77,6 +77,8 @@ class BulletPhysicsControlInstance:
         engine = bullet.session().current_engine()
         if engine:
             engine.create_selected_prims_as_dynamic_object(bullet.MeshApproximationType.CONVEX_HULL)
+            # relaxing with the bounding box placeholders would move the bodies wrong
+            engine.wait_for_pending_shapes()
             self.step_simulation(False)
             del engine
 
@@ -63,7 +63,7 @@ CommandResult commands::CreateCameraFromViewCommand::execute(const CommandArgs&
     const GfCamera view = *view_ptr;
 
     // stage
-    const std::shared_ptr<CommandArg<UsdStageWeakPtr>> stage_kwarg = args.get_kwarg<UsdStageWeakPtr>("stage");
+    const auto stage_kwarg = args.get_kwarg<UsdStageWeakPtr>("stage");
     const UsdStageWeakPtr stage =
         stage_kwarg ? UsdStageWeakPtr(*stage_kwarg) : UsdStageWeakPtr(Application::instance().get_session()->get_current_stage());
 
@@ -3,6 +3,7 @@
 
 #include "cut_prims.h"
 #include "opendcc/app/core/command_utils.h"
+#include "opendcc/app/core/sorted_path_set.h"
 #include "opendcc/app/core/undo/block.h"
 #include "opendcc/app/core/undo/router.h"
 #include "opendcc/app/core/application.h"
@@ -62,21 +63,23 @@ CommandResult commands::CutPrimsCommand::execute(const CommandArgs& args)
         return CommandResult(CommandResult::Status::INVALID_ARG);
     }
 
+    // the descendants of the selected prims are flattened with their ancestors
+    prim_paths = SortedPathSet(std::move(prim_paths)).get_top_most_paths();
+
     auto clipboard_stage = Application::get_usd_clipboard().get_new_clipboard_stage("prims");
-    std::unordered_map<std::string, std::string> rename_targets_map;
+    SdfPathVector old_paths;
+    SdfPathVector new_paths;
     for (const auto& path : prim_paths)
     {
         auto prim = stage->GetPrimAtPath(path);
         const auto new_path = clipboard_stage->GetPseudoRoot().GetPath().AppendChild(prim.GetName());
         utils::flatten_prim(prim, new_path, clipboard_stage->GetRootLayer());
-        rename_targets_map[prim.GetPath().GetString()] = new_path.GetString();
+        old_paths.push_back(prim.GetPath());
+        new_paths.push_back(new_path);
         stage->RemovePrim(path);
     }
 
-    for (auto element : rename_targets_map)
-    {
-        utils::rename_targets(clipboard_stage, SdfPath(element.first), SdfPath(element.second));
-    }
+    utils::rename_targets(clipboard_stage, old_paths, new_paths);
 
     Application::get_usd_clipboard().set_clipboard_stage(clipboard_stage);
     m_inverse = change_block.take_edits();
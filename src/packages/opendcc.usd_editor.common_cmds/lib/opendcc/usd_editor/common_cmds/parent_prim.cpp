@@ -139,12 +139,12 @@ CommandResult commands::ParentPrimCommand::execute(const CommandArgs& args)
         SdfNamespaceEditDetailVector details;
         if (layer->CanApply(batch, &details))
         {
-            for (const auto& edit : batch.GetEdits())
+            if (args.has_kwarg("preserve_transform") && args.get_kwarg<bool>("preserve_transform")->get_value())
             {
-                if (args.has_kwarg("preserve_transform") && args.get_kwarg<bool>("preserve_transform")->get_value())
+                for (const auto& edit : batch.GetEdits())
                     utils::preserve_transform(stage->GetPrimAtPath(edit.currentPath), new_parent_prim);
-                utils::rename_targets(stage, edit.currentPath, edit.newPath);
             }
+            utils::rename_targets(stage, m_old_paths, m_new_paths);
             if (!layer->Apply(batch))
             {
                 OPENDCC_WARN("Failed to reparent prims.");
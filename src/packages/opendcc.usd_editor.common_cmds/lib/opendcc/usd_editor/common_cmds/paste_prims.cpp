@@ -77,21 +77,18 @@ CommandResult commands::PastePrimsCommand::execute(const CommandArgs& args)
         return CommandResult(CommandResult::Status::FAIL);
     }
 
-    std::unordered_map<std::string, std::string> rename_map;
+    SdfPathVector clipboard_paths;
     SdfPathVector pasted_prims_paths;
     for (const auto& prim : clipboard_stage->GetPseudoRoot().GetAllChildren())
     {
         const auto new_name = utils::get_new_name_for_prim(prim.GetName(), stage->GetPrimAtPath(paste_path), duplicated_paths);
         const auto new_path = paste_path.AppendChild(new_name);
         SdfCopySpec(prim.GetStage()->GetRootLayer(), prim.GetPath(), stage->GetEditTarget().GetLayer(), new_path);
-        rename_map[prim.GetPath().GetString()] = new_path.GetString();
+        clipboard_paths.push_back(prim.GetPath());
         pasted_prims_paths.push_back(new_path);
     }
 
-    for (auto element : rename_map)
-    {
-        utils::rename_targets(stage, SdfPath(element.first), SdfPath(element.second));
-    }
+    utils::rename_targets(stage, clipboard_paths, pasted_prims_paths);
     Application::instance().set_prim_selection(pasted_prims_paths);
     m_inverse = change_block.take_edits();
     return CommandResult { CommandResult::Status::SUCCESS };
@@ -82,10 +82,7 @@ CommandResult commands::RemovePrimsCommand::execute(const CommandArgs& args)
         SdfNamespaceEditDetailVector details;
         if (layer->CanApply(batch, &details))
         {
-            for (const auto& edit : batch.GetEdits())
-            {
-                utils::delete_targets(stage, edit.currentPath);
-            }
+            utils::delete_targets(stage, paths);
             if (!layer->Apply(batch))
             {
                 OPENDCC_WARN("Failed to remove prim.");
@@ -46,10 +46,23 @@ void ViewportMoveToolCommand::redo()
 }
 
 void ViewportMoveToolCommand::set_initial_state(const SelectionList& selection, ViewportMoveToolContext::AxisOrientation orientation)
+{
+    init_state(selection, orientation, true);
+}
+
+void ViewportMoveToolCommand::set_gizmo_state(const SelectionList& selection, ViewportMoveToolContext::AxisOrientation orientation)
+{
+    init_state(selection, orientation, false);
+}
+
+void ViewportMoveToolCommand::init_state(const SelectionList& selection, ViewportMoveToolContext::AxisOrientation orientation, bool collect_start_points)
 {
     m_orientation = orientation;
     m_selection = selection;
     m_can_edit = false;
+    m_prim_transforms.clear();
+    m_points_delta.clear();
+    m_instancer_data.clear();
     m_start_gizmo_matrix.SetZero();
     if (selection.empty())
         return;
@@ -59,9 +72,6 @@ void ViewportMoveToolCommand::set_initial_state(const SelectionList& selection,
     if (!stage)
         return;
 
-    m_prim_transforms.clear();
-    m_points_delta.clear();
-
     const auto time = Application::instance().get_current_time();
     UsdGeomXformCache cache(time);
     auto selected_paths = selection.get_fully_selected_paths();
@@ -147,7 +157,16 @@ void ViewportMoveToolCommand::set_initial_state(const SelectionList& selection,
 
         PointsDelta delta;
         delta.point_based = point_based;
-        if (Application::instance().is_soft_selection_enabled())
+        if (!collect_start_points)
+        {
+            // the gizmo is placed at the centroid of the selected points
+            GfVec3f selected_centroid = { 0.0f, 0.0f, 0.0f };
+            size_t selected_points_count = 0;
+            std::tie(selected_centroid, selected_points_count) = compute_centroid_data(sel_data, prim, points, world_transform);
+            centroid += selected_centroid;
+            point_count += selected_points_count;
+        }
+        else if (Application::instance().is_soft_selection_enabled())
         {
             for (const auto& weight : Application::instance().get_rich_selection().get_weights(entry.first))
             {
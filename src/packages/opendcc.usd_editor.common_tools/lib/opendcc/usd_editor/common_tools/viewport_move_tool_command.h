@@ -33,6 +33,8 @@ public:
     virtual void redo() override;
 
     void set_initial_state(const SelectionList& list, ViewportMoveToolContext::AxisOrientation orientation);
+    // computes only the gizmo placement and whether the selection can be edited, without the per-point start state
+    void set_gizmo_state(const SelectionList& list, ViewportMoveToolContext::AxisOrientation orientation);
     void start_block();
     void end_block();
     bool is_recording() const;
@@ -49,6 +51,8 @@ public:
     static std::shared_ptr<Command> create_cmd();
 
 private:
+    void init_state(const SelectionList& list, ViewportMoveToolContext::AxisOrientation orientation, bool collect_start_points);
+
     struct TransformData
     {
         PXR_NS::UsdGeomXformable xform;
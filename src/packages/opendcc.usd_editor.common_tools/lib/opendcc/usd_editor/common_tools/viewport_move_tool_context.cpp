@@ -41,6 +41,18 @@ OPENDCC_NAMESPACE_OPEN
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+namespace
+{
+    // the gizmo follows the transforms of the selected prims and their ancestors
+    StageChangesDispatcher::Filter selection_changes_filter()
+    {
+        StageChangesDispatcher::Filter filter;
+        filter.paths = Application::instance().get_selection().get_selected_paths();
+        filter.coalesce = true;
+        return filter;
+    }
+}
+
 ViewportMoveToolContext::ViewportMoveToolContext()
     : ViewportSelectToolContext()
 {
@@ -49,14 +61,16 @@ ViewportMoveToolContext::ViewportMoveToolContext()
     m_manipulator = std::make_unique<ViewportMoveManipulator>();
     update_gizmo_via_selection();
     set_snap_mode(static_cast<SnapMode>(settings->get("viewport.move_tool.snap_mode", 0)));
-    m_selection_changed_id =
-        Application::instance().register_event_callback(Application::EventType::SELECTION_CHANGED, [&] { update_gizmo_via_selection(); });
+    m_selection_changed_id = Application::instance().register_event_callback(Application::EventType::SELECTION_CHANGED, [&] {
+        Application::instance().get_session()->set_stage_changes_filter(m_stage_object_changed_id, selection_changes_filter());
+        request_gizmo_update();
+    });
 
     m_time_changed_id =
-        Application::instance().register_event_callback(Application::EventType::CURRENT_TIME_CHANGED, [&] { update_gizmo_via_selection(); });
+        Application::instance().register_event_callback(Application::EventType::CURRENT_TIME_CHANGED, [&] { request_gizmo_update(); });
 
-    m_stage_object_changed_id = Application::instance().get_session()->register_stage_changed_callback(
-        Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED, [&](UsdNotice::ObjectsChanged const& notice) { update_gizmo_via_selection(); });
+    m_stage_object_changed_id = Application::instance().get_session()->register_stage_changes_callback(
+        selection_changes_filter(), [this](const StageChangeSummary&) { request_gizmo_update(); });
     m_settings_changed_cid["viewport.move_tool.snap_mode"] = Application::instance().get_settings()->register_setting_changed(
         "viewport.move_tool.snap_mode", [this](const std::string&, const Settings::Value& val, Settings::ChangeType) {
             int mode;
@@ -72,8 +86,7 @@ ViewportMoveToolContext::~ViewportMoveToolContext()
 {
     Application::instance().unregister_event_callback(Application::EventType::SELECTION_CHANGED, m_selection_changed_id);
     Application::instance().unregister_event_callback(Application::EventType::CURRENT_TIME_CHANGED, m_time_changed_id);
-    Application::instance().get_session()->unregister_stage_changed_callback(Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED,
-                                                                             m_stage_object_changed_id);
+    Application::instance().get_session()->unregister_stage_changes_callback(m_stage_object_changed_id);
     for (const auto& entry : m_settings_changed_cid)
         Application::instance().get_settings()->unregister_setting_changed(entry.first, entry.second);
 }
@@ -83,6 +96,8 @@ bool ViewportMoveToolContext::on_mouse_press(const ViewportMouseEvent& mouse_eve
 {
     if (!viewport_view)
         return false;
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
     if (is_locked() || !m_move_command)
         return ViewportSelectToolContext::on_mouse_press(mouse_event, viewport_view, draw_manager);
 
@@ -99,6 +114,7 @@ bool ViewportMoveToolContext::on_mouse_press(const ViewportMouseEvent& mouse_eve
     {
         return ViewportSelectToolContext::on_mouse_press(mouse_event, viewport_view, draw_manager);
     }
+    m_move_command->set_initial_state(Application::instance().get_selection(), m_axis_orientation);
     m_move_command->start_block();
     return true;
 }
@@ -108,6 +124,8 @@ bool ViewportMoveToolContext::on_mouse_move(const ViewportMouseEvent& mouse_even
 {
     if (!viewport_view)
         return false;
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
 
     if (is_locked() || !m_move_command)
         return ViewportSelectToolContext::on_mouse_move(mouse_event, viewport_view, draw_manager);
@@ -164,6 +182,7 @@ bool ViewportMoveToolContext::on_mouse_release(const ViewportMouseEvent& mouse_e
 
 void ViewportMoveToolContext::update_gizmo_via_selection()
 {
+    m_gizmo_update_requested = false;
     if ((m_move_command && m_move_command->is_recording()) || (m_pivot_editor && m_pivot_editor->is_editing()))
         return;
 
@@ -183,8 +202,9 @@ void ViewportMoveToolContext::update_gizmo_via_selection()
         }
     }
 
-    m_move_command = CommandRegistry::create_command<ViewportMoveToolCommand>("move");
-    m_move_command->set_initial_state(Application::instance().get_selection(), m_axis_orientation);
+    if (!m_move_command)
+        m_move_command = CommandRegistry::create_command<ViewportMoveToolCommand>("move");
+    m_move_command->set_gizmo_state(Application::instance().get_selection(), m_axis_orientation);
     GfMatrix4d gizmo_matrix;
     if (m_move_command->get_start_gizmo_matrix(gizmo_matrix))
     {
@@ -261,8 +281,21 @@ void ViewportMoveToolContext::update_snap_strategy()
         m_pivot_editor->set_snap_strategy(m_snap_strategy);
 }
 
+void ViewportMoveToolContext::request_gizmo_update()
+{
+    if (m_gizmo_update_requested)
+        return;
+
+    // the gizmo is placed on the next draw, so any number of changes within a frame are handled once
+    m_gizmo_update_requested = true;
+    ViewportWidget::update_all_gl_widget();
+}
+
 void ViewportMoveToolContext::draw(const ViewportViewPtr& viewport_view, ViewportUiDrawManager* draw_manager)
 {
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
+
     if (m_pivot_editor)
     {
         m_pivot_editor->draw(viewport_view, draw_manager);
@@ -82,6 +82,7 @@ Q_SIGNALS:
 
 private:
     void update_gizmo_via_selection();
+    void request_gizmo_update();
     void update_snap_strategy();
 
     std::unique_ptr<ViewportMoveManipulator> m_manipulator;
@@ -89,13 +90,14 @@ private:
     AxisOrientation m_axis_orientation = AxisOrientation::WORLD;
     Application::CallbackHandle m_selection_changed_id;
     Application::CallbackHandle m_time_changed_id;
-    Session::StageChangedCallbackHandle m_stage_object_changed_id;
+    StageChangesDispatcher::Handle m_stage_object_changed_id = 0;
     std::unique_ptr<ViewportPivotEditor> m_pivot_editor;
     std::shared_ptr<ViewportSnapStrategy> m_snap_strategy;
     std::unordered_map<std::string, Settings::SettingChangedHandle> m_settings_changed_cid;
     SnapMode m_snap_mode = SnapMode::OFF;
     unsigned long long m_key_press_timepoint = -1;
     bool m_edit_pivot = false;
+    bool m_gizmo_update_requested = false;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -303,10 +303,23 @@ void ViewportRotateToolCommand::redo()
 }
 
 void ViewportRotateToolCommand::set_initial_state(const SelectionList& selection, ViewportRotateToolContext::Orientation orientation)
+{
+    init_state(selection, orientation, true);
+}
+
+void ViewportRotateToolCommand::set_gizmo_state(const SelectionList& selection, ViewportRotateToolContext::Orientation orientation)
+{
+    init_state(selection, orientation, false);
+}
+
+void ViewportRotateToolCommand::init_state(const SelectionList& selection, ViewportRotateToolContext::Orientation orientation, bool collect_start_points)
 {
     m_selection = selection;
     m_orientation = orientation;
     m_can_edit = false;
+    m_prim_transforms.clear();
+    m_points_delta.clear();
+    m_instancer_data.clear();
     m_start_gizmo_data.gizmo_matrix.SetZero();
     m_start_gizmo_data.gizmo_angles.Set(0, 0, 0);
     m_start_gizmo_data.parent_gizmo_matrix.SetZero();
@@ -400,7 +413,16 @@ void ViewportRotateToolCommand::set_initial_state(const SelectionList& selection
 
         PointsDelta delta;
         delta.point_based = point_based;
-        if (Application::instance().is_soft_selection_enabled())
+        if (!collect_start_points)
+        {
+            // the gizmo is placed at the centroid of the selected points
+            GfVec3f selected_centroid = { 0.0f, 0.0f, 0.0f };
+            size_t selected_points_count = 0;
+            std::tie(selected_centroid, selected_points_count) = compute_centroid_data(sel_data, prim, points, world_transform);
+            centroid += selected_centroid;
+            point_count += selected_points_count;
+        }
+        else if (Application::instance().is_soft_selection_enabled())
         {
             for (const auto& weight : Application::instance().get_rich_selection().get_weights(entry.first))
             {
@@ -31,6 +31,7 @@ public:
     virtual void redo() override;
 
     void set_initial_state(const SelectionList& selection, ViewportRotateToolContext::Orientation orientation);
+    void set_gizmo_state(const SelectionList& selection, ViewportRotateToolContext::Orientation orientation);
     void start_block();
     void end_block();
     bool is_recording() const;
@@ -47,6 +48,8 @@ public:
     static std::shared_ptr<Command> create_cmd();
 
 private:
+    void init_state(const SelectionList& selection, ViewportRotateToolContext::Orientation orientation, bool collect_start_points);
+
     struct InstancerData
     {
         PXR_NS::UsdGeomPointInstancer point_instancer;
@@ -33,6 +33,18 @@ namespace PXR_NS
 OPENDCC_NAMESPACE_OPEN
 PXR_NAMESPACE_USING_DIRECTIVE
 
+namespace
+{
+    // the gizmo follows the transforms of the selected prims and their ancestors
+    StageChangesDispatcher::Filter selection_changes_filter()
+    {
+        StageChangesDispatcher::Filter filter;
+        filter.paths = Application::instance().get_selection().get_selected_paths();
+        filter.coalesce = true;
+        return filter;
+    }
+}
+
 ViewportRotateToolContext::ViewportRotateToolContext()
     : ViewportSelectToolContext()
 {
@@ -45,20 +57,21 @@ ViewportRotateToolContext::ViewportRotateToolContext()
     m_manipulator->set_step(settings->get("viewport.rotate_tool.step", 10.0));
     m_manipulator->enable_step_mode(settings->get("viewport.rotate_tool.step_mode", false));
     update_gizmo_via_selection();
-    m_selection_changed_id =
-        Application::instance().register_event_callback(Application::EventType::SELECTION_CHANGED, [this] { update_gizmo_via_selection(); });
+    m_selection_changed_id = Application::instance().register_event_callback(Application::EventType::SELECTION_CHANGED, [this] {
+        Application::instance().get_session()->set_stage_changes_filter(m_stage_object_changed_id, selection_changes_filter());
+        request_gizmo_update();
+    });
     m_time_changed_id =
-        Application::instance().register_event_callback(Application::EventType::CURRENT_TIME_CHANGED, [this] { update_gizmo_via_selection(); });
-    m_stage_object_changed_id = Application::instance().get_session()->register_stage_changed_callback(
-        Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED, [this](const UsdNotice::ObjectsChanged&) { update_gizmo_via_selection(); });
+        Application::instance().register_event_callback(Application::EventType::CURRENT_TIME_CHANGED, [this] { request_gizmo_update(); });
+    m_stage_object_changed_id = Application::instance().get_session()->register_stage_changes_callback(
+        selection_changes_filter(), [this](const StageChangeSummary&) { request_gizmo_update(); });
 }
 
 ViewportRotateToolContext::~ViewportRotateToolContext()
 {
     Application::instance().unregister_event_callback(Application::EventType::SELECTION_CHANGED, m_selection_changed_id);
     Application::instance().unregister_event_callback(Application::EventType::CURRENT_TIME_CHANGED, m_time_changed_id);
-    Application::instance().get_session()->unregister_stage_changed_callback(Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED,
-                                                                             m_stage_object_changed_id);
+    Application::instance().get_session()->unregister_stage_changes_callback(m_stage_object_changed_id);
 }
 
 bool ViewportRotateToolContext::on_mouse_press(const ViewportMouseEvent& mouse_event, const ViewportViewPtr& viewport_view,
@@ -66,6 +79,8 @@ bool ViewportRotateToolContext::on_mouse_press(const ViewportMouseEvent& mouse_e
 {
     if (!viewport_view)
         return false;
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
     if (is_locked() || !m_rotate_command)
         return ViewportSelectToolContext::on_mouse_press(mouse_event, viewport_view, draw_manager);
 
@@ -84,6 +99,7 @@ bool ViewportRotateToolContext::on_mouse_press(const ViewportMouseEvent& mouse_e
     if (m_orientation == Orientation::GIMBAL && m_manipulator->get_rotate_mode() == ViewportRotateManipulator::RotateMode::XYZ)
         return true;
 
+    m_rotate_command->set_initial_state(Application::instance().get_selection(), m_orientation);
     m_rotate_command->start_block();
     return true;
 }
@@ -93,6 +109,8 @@ bool ViewportRotateToolContext::on_mouse_move(const ViewportMouseEvent& mouse_ev
 {
     if (!viewport_view)
         return false;
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
     if (is_locked() || !m_rotate_command)
         return ViewportSelectToolContext::on_mouse_move(mouse_event, viewport_view, draw_manager);
 
@@ -144,6 +162,7 @@ bool ViewportRotateToolContext::on_mouse_release(const ViewportMouseEvent& mouse
 
 void ViewportRotateToolContext::update_gizmo_via_selection()
 {
+    m_gizmo_update_requested = false;
     if ((m_rotate_command && m_rotate_command->is_recording()) || (m_pivot_editor && m_pivot_editor->is_editing()))
         return;
 
@@ -163,8 +182,9 @@ void ViewportRotateToolContext::update_gizmo_via_selection()
         }
     }
 
-    m_rotate_command = CommandRegistry::create_command<ViewportRotateToolCommand>("rotate");
-    m_rotate_command->set_initial_state(Application::instance().get_selection(), m_orientation);
+    if (!m_rotate_command)
+        m_rotate_command = CommandRegistry::create_command<ViewportRotateToolCommand>("rotate");
+    m_rotate_command->set_gizmo_state(Application::instance().get_selection(), m_orientation);
     ViewportRotateManipulator::GizmoData gizmo_data;
     if (m_rotate_command->get_start_gizmo_data(gizmo_data))
     {
@@ -179,8 +199,20 @@ void ViewportRotateToolContext::update_gizmo_via_selection()
     }
 }
 
+void ViewportRotateToolContext::request_gizmo_update()
+{
+    if (m_gizmo_update_requested)
+        return;
+
+    m_gizmo_update_requested = true;
+    ViewportWidget::update_all_gl_widget();
+}
+
 void ViewportRotateToolContext::draw(const ViewportViewPtr& viewport_view, ViewportUiDrawManager* draw_manager)
 {
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
+
     if (m_pivot_editor)
     {
         m_pivot_editor->draw(viewport_view, draw_manager);
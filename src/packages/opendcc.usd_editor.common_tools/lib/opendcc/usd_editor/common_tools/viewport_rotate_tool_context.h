@@ -65,16 +65,18 @@ Q_SIGNALS:
 
 private:
     void update_gizmo_via_selection();
+    void request_gizmo_update();
 
     Orientation m_orientation = Orientation::OBJECT;
     std::shared_ptr<ViewportRotateToolCommand> m_rotate_command;
     std::unique_ptr<ViewportRotateManipulator> m_manipulator;
     Application::CallbackHandle m_selection_changed_id;
     Application::CallbackHandle m_time_changed_id;
-    Session::StageChangedCallbackHandle m_stage_object_changed_id;
+    StageChangesDispatcher::Handle m_stage_object_changed_id = 0;
     std::unique_ptr<ViewportPivotEditor> m_pivot_editor;
     unsigned long long m_key_press_timepoint = -1;
     bool m_edit_pivot = false;
+    bool m_gizmo_update_requested = false;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -42,9 +42,22 @@ void ViewportScaleToolCommand::redo()
 }
 
 void ViewportScaleToolCommand::set_initial_state(const SelectionList& selection)
+{
+    init_state(selection, true);
+}
+
+void ViewportScaleToolCommand::set_gizmo_state(const SelectionList& selection)
+{
+    init_state(selection, false);
+}
+
+void ViewportScaleToolCommand::init_state(const SelectionList& selection, bool collect_start_points)
 {
     m_selection = selection;
     m_can_edit = false;
+    m_prim_transforms.clear();
+    m_points_delta.clear();
+    m_instancer_data.clear();
     m_start_gizmo_data.gizmo_matrix.SetZero();
     if (selection.empty())
         return;
@@ -140,7 +153,16 @@ void ViewportScaleToolCommand::set_initial_state(const SelectionList& selection)
 
         PointsDelta delta;
         delta.point_based = point_based;
-        if (Application::instance().is_soft_selection_enabled())
+        if (!collect_start_points)
+        {
+            // the gizmo is placed at the centroid of the selected points
+            GfVec3f selected_centroid = { 0.0f, 0.0f, 0.0f };
+            size_t selected_points_count = 0;
+            std::tie(selected_centroid, selected_points_count) = compute_centroid_data(sel_data, prim, points, world_transform);
+            centroid += selected_centroid;
+            point_count += selected_points_count;
+        }
+        else if (Application::instance().is_soft_selection_enabled())
         {
             for (const auto& weight : Application::instance().get_rich_selection().get_weights(entry.first))
             {
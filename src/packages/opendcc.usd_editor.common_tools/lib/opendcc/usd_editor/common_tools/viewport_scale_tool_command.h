@@ -34,6 +34,7 @@ public:
     virtual void redo() override;
 
     void set_initial_state(const SelectionList& selection);
+    void set_gizmo_state(const SelectionList& selection);
     void start_block();
     void end_block();
     bool is_recording() const;
@@ -49,6 +50,8 @@ public:
     static std::shared_ptr<Command> create_cmd();
 
 private:
+    void init_state(const SelectionList& selection, bool collect_start_points);
+
     struct TransformData
     {
         PXR_NS::UsdGeomXformable xform;
@@ -36,6 +36,18 @@ OPENDCC_NAMESPACE_OPEN
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+namespace
+{
+    // the gizmo follows the transforms of the selected prims and their ancestors
+    StageChangesDispatcher::Filter selection_changes_filter()
+    {
+        StageChangesDispatcher::Filter filter;
+        filter.paths = Application::instance().get_selection().get_selected_paths();
+        filter.coalesce = true;
+        return filter;
+    }
+}
+
 ViewportScaleToolContext::ViewportScaleToolContext()
     : ViewportSelectToolContext()
 {
@@ -44,22 +56,22 @@ ViewportScaleToolContext::ViewportScaleToolContext()
     m_manipulator->set_step(settings->get("viewport.scale_tool.step", 1.0));
     m_manipulator->set_step_mode(static_cast<StepMode>(settings->get("viewport.scale_tool.step_mode", 0)));
     update_gizmo_via_selection();
-    m_selection_changed_id =
-        Application::instance().register_event_callback(Application::EventType::SELECTION_CHANGED, [this] { update_gizmo_via_selection(); });
+    m_selection_changed_id = Application::instance().register_event_callback(Application::EventType::SELECTION_CHANGED, [this] {
+        Application::instance().get_session()->set_stage_changes_filter(m_stage_object_changed_id, selection_changes_filter());
+        request_gizmo_update();
+    });
     m_time_changed_id =
-        Application::instance().register_event_callback(Application::EventType::CURRENT_TIME_CHANGED, [this] { update_gizmo_via_selection(); });
+        Application::instance().register_event_callback(Application::EventType::CURRENT_TIME_CHANGED, [this] { request_gizmo_update(); });
 
-    m_stage_object_changed_id = Application::instance().get_session()->register_stage_changed_callback(
-        Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED,
-        [this](UsdNotice::ObjectsChanged const& notice) { update_gizmo_via_selection(); });
+    m_stage_object_changed_id = Application::instance().get_session()->register_stage_changes_callback(
+        selection_changes_filter(), [this](const StageChangeSummary&) { request_gizmo_update(); });
 }
 
 ViewportScaleToolContext::~ViewportScaleToolContext()
 {
     Application::instance().unregister_event_callback(Application::EventType::SELECTION_CHANGED, m_selection_changed_id);
     Application::instance().unregister_event_callback(Application::EventType::CURRENT_TIME_CHANGED, m_time_changed_id);
-    Application::instance().get_session()->unregister_stage_changed_callback(Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED,
-                                                                             m_stage_object_changed_id);
+    Application::instance().get_session()->unregister_stage_changes_callback(m_stage_object_changed_id);
 }
 
 bool ViewportScaleToolContext::on_mouse_press(const ViewportMouseEvent& mouse_event, const ViewportViewPtr& viewport_view,
@@ -67,6 +79,8 @@ bool ViewportScaleToolContext::on_mouse_press(const ViewportMouseEvent& mouse_ev
 {
     if (!viewport_view)
         return false;
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
     if (is_locked() || !m_scale_command)
         return ViewportSelectToolContext::on_mouse_press(mouse_event, viewport_view, draw_manager);
 
@@ -81,6 +95,7 @@ bool ViewportScaleToolContext::on_mouse_press(const ViewportMouseEvent& mouse_ev
     m_manipulator->on_mouse_press(mouse_event, viewport_view, draw_manager);
     if (m_manipulator->get_scale_mode() == ViewportScaleManipulator::ScaleMode::NONE)
         return ViewportSelectToolContext::on_mouse_press(mouse_event, viewport_view, draw_manager);
+    m_scale_command->set_initial_state(Application::instance().get_selection());
     m_scale_command->start_block();
     return true;
 }
@@ -90,6 +105,8 @@ bool ViewportScaleToolContext::on_mouse_move(const ViewportMouseEvent& mouse_eve
 {
     if (!viewport_view)
         return false;
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
 
     if (is_locked() || !m_scale_command)
         return ViewportSelectToolContext::on_mouse_move(mouse_event, viewport_view, draw_manager);
@@ -141,6 +158,7 @@ bool ViewportScaleToolContext::on_mouse_release(const ViewportMouseEvent& mouse_
 
 void ViewportScaleToolContext::update_gizmo_via_selection()
 {
+    m_gizmo_update_requested = false;
     if ((m_scale_command && m_scale_command->is_recording()) || (m_pivot_editor && m_pivot_editor->is_editing()))
         return;
 
@@ -158,8 +176,9 @@ void ViewportScaleToolContext::update_gizmo_via_selection()
         }
     }
 
-    m_scale_command = CommandRegistry::create_command<ViewportScaleToolCommand>("scale");
-    m_scale_command->set_initial_state(Application::instance().get_selection());
+    if (!m_scale_command)
+        m_scale_command = CommandRegistry::create_command<ViewportScaleToolCommand>("scale");
+    m_scale_command->set_gizmo_state(Application::instance().get_selection());
     ViewportScaleManipulator::GizmoData gizmo_data;
     if (m_scale_command->get_start_gizmo_data(gizmo_data))
     {
@@ -172,8 +191,20 @@ void ViewportScaleToolContext::update_gizmo_via_selection()
     }
 }
 
+void ViewportScaleToolContext::request_gizmo_update()
+{
+    if (m_gizmo_update_requested)
+        return;
+
+    m_gizmo_update_requested = true;
+    ViewportWidget::update_all_gl_widget();
+}
+
 void ViewportScaleToolContext::draw(const ViewportViewPtr& viewport_view, ViewportUiDrawManager* draw_manager)
 {
+    if (m_gizmo_update_requested)
+        update_gizmo_via_selection();
+
     if (m_pivot_editor)
     {
         m_pivot_editor->draw(viewport_view, draw_manager);
@@ -57,16 +57,18 @@ Q_SIGNALS:
 
 private:
     void update_gizmo_via_selection();
+    void request_gizmo_update();
 
     static bool s_factory_registration;
     std::unique_ptr<ViewportScaleManipulator> m_manipulator;
     std::shared_ptr<ViewportScaleToolCommand> m_scale_command;
     Application::CallbackHandle m_selection_changed_id;
     Application::CallbackHandle m_time_changed_id;
-    Session::StageChangedCallbackHandle m_stage_object_changed_id;
+    StageChangesDispatcher::Handle m_stage_object_changed_id = 0;
     std::unique_ptr<ViewportPivotEditor> m_pivot_editor;
     unsigned long long m_key_press_timepoint = -1;
     bool m_edit_pivot = false;
+    bool m_gizmo_update_requested = false;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -0,0 +1,380 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/usd_editor/material_editor/asset_resolve_cache.h"
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/usd/ar/resolver.h>
+#include <pxr/usd/sdf/layer.h>
+#include <pxr/usd/sdf/layerUtils.h>
+#include <pxr/usd/sdf/propertySpec.h>
+#include <QRunnable>
+#include <QThreadPool>
+#include <functional>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+OPENDCC_NAMESPACE_OPEN
+
+namespace
+{
+    static SdfLayerHandle find_layer_handle(const UsdAttribute& attr, const UsdTimeCode& time)
+    {
+        for (const auto& spec : attr.GetPropertyStack(time))
+        {
+            if (spec->HasDefaultValue() || spec->GetLayer()->GetNumTimeSamplesForPath(spec->GetPath()) > 0)
+            {
+                return spec->GetLayer();
+            }
+        }
+        return TfNullPtr;
+    }
+    static bool resolve_symlinks(const std::string& srcPath, std::string* outPath)
+    {
+        std::string error;
+        *outPath = TfRealPath(srcPath, false, &error);
+
+        if (outPath->empty() || !error.empty())
+        {
+            return false;
+        }
+
+        return true;
+    }
+    static SdfAssetPath resolve_asset_symlinks(const SdfAssetPath& assetPath)
+    {
+        std::string p = assetPath.GetResolvedPath();
+        if (p.empty())
+        {
+            p = assetPath.GetAssetPath();
+        }
+
+        if (resolve_symlinks(p, &p))
+        {
+            return SdfAssetPath(assetPath.GetAssetPath(), p);
+        }
+        else
+        {
+            return assetPath;
+        }
+    }
+    static std::pair<std::string, std::string> split_udim_pattern(const std::string& path)
+    {
+        static const std::string pattern = "<UDIM>";
+        const std::string::size_type pos = path.find(pattern);
+        if (pos != std::string::npos)
+        {
+            return { path.substr(0, pos), path.substr(pos + pattern.size()) };
+        }
+
+        return { std::string(), std::string() };
+    }
+
+    static std::string resolve_path_for_first_tile(const std::pair<std::string, std::string>& split_path, const SdfLayerHandle& layer)
+    {
+        ArResolver& resolver = ArGetResolver();
+
+        for (int i = 1001; i < 1100; i++)
+        {
+            // Fill in integer
+            std::string path = split_path.first + std::to_string(i) + split_path.second;
+            if (layer)
+            {
+                // Deal with layer-relative paths.
+                path = SdfComputeAssetPathRelativeToLayer(layer, path);
+            }
+            // Resolve. Unlike the non-UDIM case, we do not resolve symlinks
+            // here to handle the case where the symlinks follow the UDIM
+            // naming pattern but the files that are linked do not. We'll
+            // let whoever consumes the pattern determine if they want to
+            // resolve symlinks themselves.
+            return resolver.Resolve(path);
+        }
+        return std::string();
+    }
+
+    bool is_udim_pattern(const SdfAssetPath& path)
+    {
+        const auto split_path = split_udim_pattern(path.GetAssetPath());
+        return !split_path.first.empty() || !split_path.second.empty();
+    }
+
+    SdfAssetPath resolve_asset_path(const SdfAssetPath& path, const SdfLayerHandle& layer)
+    {
+        // See whether the asset path contains UDIM pattern.
+        const std::pair<std::string, std::string> split_path = split_udim_pattern(path.GetAssetPath());
+
+        if (split_path.first.empty() && split_path.second.empty())
+        {
+            // Not a UDIM, resolve symlinks and exit.
+            return resolve_asset_symlinks(path);
+        }
+
+        // Find first tile.
+        const std::string first_tile_path = resolve_path_for_first_tile(split_path, layer);
+
+        if (first_tile_path.empty())
+        {
+            return path;
+        }
+
+        // Construct the file path /filePath/myImage.<UDIM>.exr by using
+        // the first part from the first resolved tile, "<UDIM>" and the
+        // suffix.
+
+        const std::string& suffix = split_path.second;
+
+        // Sanity check that the part after <UDIM> did not change.
+        if (!TfStringEndsWith(first_tile_path, suffix))
+        {
+            TF_WARN("Resolution of first udim tile gave ambiguous result. "
+                    "First tile for '%s' is '%s'.",
+                    path.GetAssetPath().c_str(), first_tile_path.c_str());
+            return path;
+        }
+
+        // Length of the part /filePath/myImage.<UDIM>.exr.
+        const std::string::size_type pref_len = first_tile_path.size() - suffix.size() - 4;
+
+        return SdfAssetPath(path.GetAssetPath(), first_tile_path.substr(0, pref_len) + "<UDIM>" + suffix);
+    }
+
+    class AssetResolveTask : public QRunnable
+    {
+    public:
+        AssetResolveTask(const std::function<void(const SdfAssetPath&)>& on_resolved, const SdfAssetPath& asset_path,
+                         const std::string& layer_identifier)
+            : m_on_resolved(on_resolved)
+            , m_asset_path(asset_path)
+            , m_layer_identifier(layer_identifier)
+        {
+        }
+
+        void run() override
+        {
+            // the layer is found by its identifier, so it is kept alive while it is used here
+            const auto layer = m_layer_identifier.empty() ? SdfLayerRefPtr() : SdfLayer::Find(m_layer_identifier);
+            m_on_resolved(resolve_asset_path(m_asset_path, layer));
+        }
+
+    private:
+        std::function<void(const SdfAssetPath&)> m_on_resolved;
+        SdfAssetPath m_asset_path;
+        std::string m_layer_identifier;
+    };
+};
+
+AssetResolveCache& AssetResolveCache::instance()
+{
+    static AssetResolveCache cache;
+    return cache;
+}
+
+AssetResolveCache::AssetResolveCache()
+{
+#if PXR_VERSION >= 2105
+    m_resolver_changed_key = TfNotice::Register(TfCreateWeakPtr(this), &AssetResolveCache::on_resolver_changed);
+#endif
+    m_layer_reloaded_key = TfNotice::Register(TfCreateWeakPtr(this), &AssetResolveCache::on_layer_reloaded);
+}
+
+AssetResolveCache::~AssetResolveCache()
+{
+#if PXR_VERSION >= 2105
+    TfNotice::Revoke(m_resolver_changed_key);
+#endif
+    TfNotice::Revoke(m_layer_reloaded_key);
+}
+
+bool AssetResolveCache::resolve(const SdfAssetPath& asset_path, const UsdAttribute& attr, const UsdTimeCode& time, SdfAssetPath& resolved_path)
+{
+    if (asset_path.GetAssetPath().empty())
+    {
+        resolved_path = asset_path;
+        return true;
+    }
+
+    // UDIM patterns are resolved relative to the authoring layer, the other paths are already resolved by USD
+    std::string layer_identifier;
+    Key key(asset_path.GetAssetPath(), asset_path.GetResolvedPath());
+    if (is_udim_pattern(asset_path) && attr)
+    {
+        if (const auto layer = find_layer_handle(attr, time))
+            layer_identifier = layer->GetIdentifier();
+        key.second = layer_identifier;
+    }
+
+    auto& entry = m_entries[key];
+    if (!entry.is_resolved)
+    {
+        schedule(key, entry, asset_path, layer_identifier);
+        return false;
+    }
+
+    if (std::chrono::steady_clock::now() - entry.resolve_time > m_revalidation_interval)
+        schedule(key, entry, asset_path, layer_identifier);
+    resolved_path = entry.resolved_path;
+    return true;
+}
+
+void AssetResolveCache::clear()
+{
+    m_entries.clear();
+    ++m_generation;
+}
+
+void AssetResolveCache::set_revalidation_interval(std::chrono::milliseconds interval)
+{
+    m_revalidation_interval = interval;
+}
+
+std::chrono::milliseconds AssetResolveCache::get_revalidation_interval() const
+{
+    return m_revalidation_interval;
+}
+
+void AssetResolveCache::schedule(const Key& key, Entry& entry, const SdfAssetPath& asset_path, const std::string& layer_identifier)
+{
+    if (entry.is_pending)
+        return;
+    entry.is_pending = true;
+
+    const auto generation = m_generation;
+    auto on_resolved = [this, key, generation](const SdfAssetPath& resolved_path) {
+        QMetaObject::invokeMethod(
+            this, [this, key, generation, resolved_path] { insert(key, generation, resolved_path); }, Qt::QueuedConnection);
+    };
+    QThreadPool::globalInstance()->start(new AssetResolveTask(on_resolved, asset_path, layer_identifier));
+}
+
+void AssetResolveCache::insert(const Key& key, size_t generation, const SdfAssetPath& resolved_path)
+{
+    if (generation != m_generation)
+        return;
+
+    auto it = m_entries.find(key);
+    if (it == m_entries.end())
+        return;
+
+    auto& entry = it->second;
+    const auto changed = !entry.is_resolved || entry.resolved_path.GetResolvedPath() != resolved_path.GetResolvedPath();
+    entry.resolved_path = resolved_path;
+    entry.resolve_time = std::chrono::steady_clock::now();
+    entry.is_resolved = true;
+    entry.is_pending = false;
+
+    // revalidated entries which resolve to the same file don't trigger the updates
+    if (changed)
+        Q_EMIT path_resolved(QString::fromStdString(key.first));
+}
+
+#if PXR_VERSION >= 2105
+void AssetResolveCache::on_resolver_changed(const ArNotice::ResolverChanged& notice)
+{
+    QMetaObject::invokeMethod(this, [this] { clear(); });
+}
+#endif
+
+void AssetResolveCache::on_layer_reloaded(const SdfNotice::LayerDidReloadContent& notice)
+{
+    // reloading is how the files changed on disk are picked up explicitly
+    QMetaObject::invokeMethod(this, [this] { clear(); });
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include "opendcc/base/vendor/ghc/filesystem.hpp"
+#include <QCoreApplication>
+#include <fstream>
+#include <memory>
+#include <thread>
+
+OPENDCC_NAMESPACE_USING
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    // the results are delivered through the event loop of the UI thread
+    bool wait_resolved(const SdfAssetPath& asset_path, SdfAssetPath& resolved_path)
+    {
+        auto& cache = AssetResolveCache::instance();
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!cache.resolve(asset_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path))
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+                return false;
+            QCoreApplication::processEvents();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return true;
+    }
+
+    std::string make_texture(const ghc::filesystem::path& path)
+    {
+        std::ofstream(path.string()) << "texture";
+        return TfRealPath(path.string());
+    }
+};
+
+DOCTEST_TEST_SUITE("AssetResolveCache")
+{
+    DOCTEST_TEST_CASE("hits_misses_and_invalidation")
+    {
+        static int argc = 1;
+        static char app_name[] = "asset_resolve_cache_tests";
+        static char* argv[] = { app_name, nullptr };
+        std::unique_ptr<QCoreApplication> app;
+        if (!QCoreApplication::instance())
+            app = std::make_unique<QCoreApplication>(argc, argv);
+
+        const auto dir = ghc::filesystem::temp_directory_path() / "opendcc_asset_resolve_cache_tests";
+        ghc::filesystem::remove_all(dir);
+        ghc::filesystem::create_directories(dir);
+        const auto first_texture = make_texture(dir / "first.png");
+        const auto second_texture = make_texture(dir / "second.png");
+
+        auto& cache = AssetResolveCache::instance();
+        cache.clear();
+        SdfAssetPath resolved_path;
+
+        // miss: resolved in the background
+        const SdfAssetPath asset_path("first.png", first_texture);
+        DOCTEST_CHECK(!cache.resolve(asset_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path));
+        DOCTEST_REQUIRE(wait_resolved(asset_path, resolved_path));
+        DOCTEST_CHECK(resolved_path.GetAssetPath() == "first.png");
+        DOCTEST_CHECK(resolved_path.GetResolvedPath() == first_texture);
+
+        // hit: answered right away
+        resolved_path = SdfAssetPath();
+        DOCTEST_CHECK(cache.resolve(asset_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path));
+        DOCTEST_CHECK(resolved_path.GetResolvedPath() == first_texture);
+
+        // another asset path is not served from the entry of the first one
+        const SdfAssetPath other_asset_path("second.png", second_texture);
+        DOCTEST_CHECK(!cache.resolve(other_asset_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path));
+        DOCTEST_REQUIRE(wait_resolved(other_asset_path, resolved_path));
+        DOCTEST_CHECK(resolved_path.GetResolvedPath() == second_texture);
+
+        // the same asset path resolved by USD in another context is a separate entry
+        const SdfAssetPath other_context_path("first.png", second_texture);
+        DOCTEST_CHECK(!cache.resolve(other_context_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path));
+        DOCTEST_REQUIRE(wait_resolved(other_context_path, resolved_path));
+        DOCTEST_CHECK(resolved_path.GetResolvedPath() == second_texture);
+        DOCTEST_CHECK(cache.resolve(asset_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path));
+        DOCTEST_CHECK(resolved_path.GetResolvedPath() == first_texture);
+
+#if PXR_VERSION >= 2105
+        // a resolver context change drops every entry
+        ArNotice::ResolverChanged().Send();
+        DOCTEST_CHECK(!cache.resolve(asset_path, UsdAttribute(), UsdTimeCode::Default(), resolved_path));
+        DOCTEST_CHECK(wait_resolved(asset_path, resolved_path));
+#endif
+
+        cache.clear();
+        ghc::filesystem::remove_all(dir);
+    }
+}
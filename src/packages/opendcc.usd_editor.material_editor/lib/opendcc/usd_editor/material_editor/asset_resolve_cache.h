@@ -0,0 +1,89 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "opendcc/opendcc.h"
+#include "opendcc/usd_editor/material_editor/api.h"
+#include <pxr/base/tf/notice.h>
+#include <pxr/base/tf/weakBase.h>
+#if PXR_VERSION >= 2105
+#include <pxr/usd/ar/notice.h>
+#endif
+#include <pxr/usd/sdf/assetPath.h>
+#include <pxr/usd/sdf/notice.h>
+#include <pxr/usd/usd/attribute.h>
+#include <QObject>
+#include <QString>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Resolves the asset-valued inputs of the material networks on the global thread pool.
+ *
+ * Resolving an asset path reads the filesystem: symlinks are resolved and UDIM patterns are resolved through
+ * their first tile relative to the layer the value is authored in. The results are cached per asset path and
+ * resolution context, which is the authoring layer for UDIM patterns and the path resolved by USD otherwise.
+ *
+ * A path that isn't resolved yet is scheduled and path_resolved is emitted on the UI thread once it is ready.
+ * Cached entries older than the revalidation interval are served as is and re-resolved in the background,
+ * so files changed on disk are picked up. The cache is dropped when the resolver changes or a layer is reloaded.
+ */
+class OPENDCC_MATERIAL_EDITOR_API AssetResolveCache
+    : public QObject
+    , public PXR_NS::TfWeakBase
+{
+    Q_OBJECT
+public:
+    static AssetResolveCache& instance();
+    ~AssetResolveCache() override;
+
+    /**
+     * @brief Looks up the resolved value of an asset path read from the specified attribute.
+     *
+     * @return false if the path is being resolved, path_resolved is emitted when it's done.
+     */
+    bool resolve(const PXR_NS::SdfAssetPath& asset_path, const PXR_NS::UsdAttribute& attr, const PXR_NS::UsdTimeCode& time,
+                 PXR_NS::SdfAssetPath& resolved_path);
+    void clear();
+
+    void set_revalidation_interval(std::chrono::milliseconds interval);
+    std::chrono::milliseconds get_revalidation_interval() const;
+
+Q_SIGNALS:
+    void path_resolved(const QString& asset_path);
+
+private:
+    using Key = std::pair<std::string, std::string>;
+    struct Entry
+    {
+        PXR_NS::SdfAssetPath resolved_path;
+        std::chrono::steady_clock::time_point resolve_time;
+        bool is_resolved = false;
+        bool is_pending = false;
+    };
+
+    AssetResolveCache();
+
+    void schedule(const Key& key, Entry& entry, const PXR_NS::SdfAssetPath& asset_path, const std::string& layer_identifier);
+    void insert(const Key& key, size_t generation, const PXR_NS::SdfAssetPath& resolved_path);
+#if PXR_VERSION >= 2105
+    void on_resolver_changed(const PXR_NS::ArNotice::ResolverChanged& notice);
+#endif
+    void on_layer_reloaded(const PXR_NS::SdfNotice::LayerDidReloadContent& notice);
+
+    std::map<Key, Entry> m_entries;
+    // results of the tasks scheduled before the last clear are dropped
+    size_t m_generation = 0;
+    std::chrono::milliseconds m_revalidation_interval = std::chrono::seconds(10);
+    PXR_NS::TfNotice::Key m_resolver_changed_key;
+    PXR_NS::TfNotice::Key m_layer_reloaded_key;
+};
+
+OPENDCC_NAMESPACE_CLOSE
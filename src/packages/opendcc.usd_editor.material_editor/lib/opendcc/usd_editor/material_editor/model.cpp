@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "opendcc/usd_editor/material_editor/model.h"
+#include "opendcc/usd_editor/material_editor/asset_resolve_cache.h"
 #include "opendcc/app/viewport/viewport_widget.h"
 #include "opendcc/app/viewport/prim_material_override.h"
 #include "opendcc/app/viewport/persistent_material_override.h"
@@ -20,10 +21,9 @@
 #include <pxr/usd/sdr/shaderProperty.h>
 #include <pxr/usd/usdUI/nodeGraphNodeAPI.h>
 #include <pxr/usd/usd/editTarget.h>
-#include <pxr/base/tf/pathUtils.h>
-#include <pxr/usd/ar/resolver.h>
-#include <pxr/usd/sdf/layerUtils.h>
+#include <pxr/base/tf/stringUtils.h>
 
+#include <QTimer>
 #include <regex>
 
 PXR_NAMESPACE_USING_DIRECTIVE
@@ -85,121 +85,6 @@ private:
 
 namespace
 {
-    static SdfLayerHandle find_layer_handle(const UsdAttribute& attr, const UsdTimeCode& time)
-    {
-        for (const auto& spec : attr.GetPropertyStack(time))
-        {
-            if (spec->HasDefaultValue() || spec->GetLayer()->GetNumTimeSamplesForPath(spec->GetPath()) > 0)
-            {
-                return spec->GetLayer();
-            }
-        }
-        return TfNullPtr;
-    }
-    static bool resolve_symlinks(const std::string& srcPath, std::string* outPath)
-    {
-        std::string error;
-        *outPath = TfRealPath(srcPath, false, &error);
-
-        if (outPath->empty() || !error.empty())
-        {
-            return false;
-        }
-
-        return true;
-    }
-    static SdfAssetPath resolve_asset_symlinks(const SdfAssetPath& assetPath)
-    {
-        std::string p = assetPath.GetResolvedPath();
-        if (p.empty())
-        {
-            p = assetPath.GetAssetPath();
-        }
-
-        if (resolve_symlinks(p, &p))
-        {
-            return SdfAssetPath(assetPath.GetAssetPath(), p);
-        }
-        else
-        {
-            return assetPath;
-        }
-    }
-    static std::pair<std::string, std::string> split_udim_pattern(const std::string& path)
-    {
-        static const std::string pattern = "<UDIM>";
-        const std::string::size_type pos = path.find(pattern);
-        if (pos != std::string::npos)
-        {
-            return { path.substr(0, pos), path.substr(pos + pattern.size()) };
-        }
-
-        return { std::string(), std::string() };
-    }
-
-    static std::string resolve_path_for_first_tile(const std::pair<std::string, std::string>& split_path, const SdfLayerHandle& layer)
-    {
-        ArResolver& resolver = ArGetResolver();
-
-        for (int i = 1001; i < 1100; i++)
-        {
-            // Fill in integer
-            std::string path = split_path.first + std::to_string(i) + split_path.second;
-            if (layer)
-            {
-                // Deal with layer-relative paths.
-                path = SdfComputeAssetPathRelativeToLayer(layer, path);
-            }
-            // Resolve. Unlike the non-UDIM case, we do not resolve symlinks
-            // here to handle the case where the symlinks follow the UDIM
-            // naming pattern but the files that are linked do not. We'll
-            // let whoever consumes the pattern determine if they want to
-            // resolve symlinks themselves.
-            return resolver.Resolve(path);
-        }
-        return std::string();
-    }
-
-    SdfAssetPath resolve_asset_attr(const SdfAssetPath& path, const UsdAttribute& attr, const UsdTimeCode& time)
-    {
-        // See whether the asset path contains UDIM pattern.
-        const std::pair<std::string, std::string> split_path = split_udim_pattern(path.GetAssetPath());
-
-        if (split_path.first.empty() && split_path.second.empty())
-        {
-            // Not a UDIM, resolve symlinks and exit.
-            return resolve_asset_symlinks(path);
-        }
-
-        // Find first tile.
-        const std::string first_tile_path = resolve_path_for_first_tile(split_path, find_layer_handle(attr, time));
-
-        if (first_tile_path.empty())
-        {
-            return path;
-        }
-
-        // Construct the file path /filePath/myImage.<UDIM>.exr by using
-        // the first part from the first resolved tile, "<UDIM>" and the
-        // suffix.
-
-        const std::string& suffix = split_path.second;
-
-        // Sanity check that the part after <UDIM> did not change.
-        if (!TfStringEndsWith(first_tile_path, suffix))
-        {
-            TF_WARN("Resolution of first udim tile gave ambiguous result. "
-                    "First tile for '%s' is '%s'.",
-                    path.GetAssetPath().c_str(), first_tile_path.c_str());
-            return path;
-        }
-
-        // Length of the part /filePath/myImage.<UDIM>.exr.
-        const std::string::size_type pref_len = first_tile_path.size() - suffix.size() - 4;
-
-        return SdfAssetPath(path.GetAssetPath(), first_tile_path.substr(0, pref_len) + "<UDIM>" + suffix);
-    }
-
     VtValue resolve_material_param_value(const UsdAttribute& attribute, const UsdTimeCode& time)
     {
         VtValue value;
@@ -214,7 +99,10 @@ namespace
             return value;
         }
 
-        return VtValue(resolve_asset_attr(value.UncheckedGet<SdfAssetPath>(), attribute, time));
+        // the unresolved value is used until the path is resolved in the background
+        SdfAssetPath resolved_path;
+        const auto& asset_path = value.UncheckedGet<SdfAssetPath>();
+        return VtValue(AssetResolveCache::instance().resolve(asset_path, attribute, time, resolved_path) ? resolved_path : asset_path);
     }
 
     std::string make_tagged_path(const PortId& port_id, const std::string& tag)
@@ -454,8 +342,19 @@ bool MaterialGraphModel::has_port(const PortId& port) const
 MaterialGraphModel::MaterialGraphModel(QObject* parent)
     : UsdGraphModel(parent)
 {
-    connect(this, &GraphModel::node_created, this, [this](const NodeId& node) { get_graph_cache().nodes.insert(node); });
-    connect(this, &GraphModel::node_removed, this, [this](const NodeId& node) { get_graph_cache().nodes.erase(node); });
+    connect(this, &GraphModel::node_created, this, [this](const NodeId& node) { get_graph_cache().add_node(node); });
+    connect(this, &GraphModel::node_removed, this, [this](const NodeId& node) { get_graph_cache().remove_node(node); });
+    connect(&AssetResolveCache::instance(), &AssetResolveCache::path_resolved, this, [this] {
+        // a network with many textures resolves them in a burst, the override is rebuilt once for all of them
+        if (m_preview_shader.IsEmpty() || m_material_override_update_requested)
+            return;
+        m_material_override_update_requested = true;
+        QTimer::singleShot(0, this, [this] {
+            m_material_override_update_requested = false;
+            if (!m_preview_shader.IsEmpty())
+                update_material_override();
+        });
+    });
     stage_changed_impl();
 }
 
@@ -552,7 +451,7 @@ void MaterialGraphModel::delete_connection(const ConnectionId& connection)
 
     remove_connection(prop, to_usd_path(connection.start_port));
 
-    if (get_graph_cache().connections.erase(connection))
+    if (get_graph_cache().remove_connection(connection))
     {
         Q_EMIT connection_removed(connection);
     }
@@ -643,8 +542,8 @@ void MaterialGraphModel::stage_changed_impl()
 
 void MaterialGraphModel::init_material_network()
 {
-    get_graph_cache().connections.clear();
-    get_graph_cache().nodes.clear();
+    auto& graph_cache = get_graph_cache();
+    graph_cache.clear();
     if (!get_stage() || get_root().IsEmpty())
         return;
 
@@ -652,27 +551,29 @@ void MaterialGraphModel::init_material_network()
     if (!root_prim)
         return;
 
-    auto add_connection = [this](const ConnectionId& connection) {
+    // the ports are parsed once per connection, the ports of the root are tagged as the ports of the material nodes
+    auto add_connection = [this, &graph_cache](const SdfPath& start_path, const SdfPath& end_path) {
         ConnectionId connection_id;
-        if (SdfPath(connection.start_port).GetPrimPath() == m_network_path)
-            connection_id.start_port =
-                SdfPath(connection.start_port).GetPrimPath().GetString() + "#mat_in." + SdfPath(connection.start_port).GetName();
-        else if (SdfPath(connection.end_port).GetPrimPath() == m_network_path)
-            connection_id.end_port = SdfPath(connection.end_port).GetPrimPath().GetString() + "#mat_out." + SdfPath(connection.end_port).GetName();
+        if (start_path.GetPrimPath() == m_network_path)
+            connection_id.start_port = m_network_path.GetString() + "#mat_in." + start_path.GetName();
+        else if (end_path.GetPrimPath() == m_network_path)
+            connection_id.end_port = m_network_path.GetString() + "#mat_out." + end_path.GetName();
 
         if (connection_id.start_port.empty())
-            connection_id.start_port = SdfPath(connection.start_port).GetString();
+            connection_id.start_port = start_path.GetString();
         if (connection_id.end_port.empty())
-            connection_id.end_port = SdfPath(connection.end_port).GetString();
-        get_graph_cache().connections.emplace(std::move(connection_id));
+            connection_id.end_port = end_path.GetString();
+        graph_cache.add_connection(connection_id);
     };
     auto add_connections_for_prim = [this, add_connection](const UsdPrim& prim) {
         auto connections = get_connections_for_prim(prim);
         for (const auto& connection : connections)
         {
+            const SdfPath start_path(connection.start_port);
+            const SdfPath end_path(connection.end_port);
             // add connections only on the current level of hierarchy
-            if (is_descendant(m_network_path, SdfPath(connection.start_port)) && is_descendant(m_network_path, SdfPath(connection.end_port)))
-                add_connection(connection);
+            if (is_descendant(m_network_path, start_path) && is_descendant(m_network_path, end_path))
+                add_connection(start_path, end_path);
         }
     };
 
@@ -681,23 +582,21 @@ void MaterialGraphModel::init_material_network()
         add_connections_for_prim(root_prim);
         for (const auto& child : root_prim.GetAllChildren())
         {
-            get_graph_cache().nodes.insert(child.GetPath().GetString());
+            graph_cache.add_node(child.GetPath().GetString());
             add_connections_for_prim(child);
         }
     }
     else
     {
-        auto& nodes = get_graph_cache().nodes;
-        std::function<void(const UsdPrim& prim)> traverse = [this, &traverse, &nodes, &add_connection](const UsdPrim& prim) {
-            auto node_path = from_usd_path(prim.GetPath(), get_root());
-            if (nodes.find(node_path) != nodes.end())
+        std::function<void(const UsdPrim& prim)> traverse = [this, &traverse, &graph_cache, &add_connection](const UsdPrim& prim) {
+            if (!graph_cache.add_node(from_usd_path(prim.GetPath(), get_root())))
                 return;
-            nodes.emplace(std::move(node_path));
             const auto connections = get_connections_for_prim(prim);
             const auto is_external = !is_descendant(get_root(), prim.GetPath());
             for (const auto& con : connections)
             {
-                auto prim_path = SdfPath(con.start_port).GetPrimPath();
+                const SdfPath start_path(con.start_port);
+                const auto prim_path = start_path.GetPrimPath();
                 const auto next_prim = get_stage()->GetPrimAtPath(prim_path);
                 if (!next_prim)
                     continue;
@@ -705,8 +604,8 @@ void MaterialGraphModel::init_material_network()
                 if ((UsdShadeNodeGraph(prim) || UsdShadeMaterial(prim)) && prim_path.GetParentPath() == prim.GetPath())
                     continue;
 
-                if (SdfPath(con.start_port).IsPropertyPath())
-                    add_connection(con);
+                if (start_path.IsPropertyPath())
+                    add_connection(start_path, SdfPath(con.end_port));
 
                 if (prim_path == get_root())
                     continue;
@@ -720,13 +619,13 @@ void MaterialGraphModel::init_material_network()
 
         for (const auto& con : get_connections_for_prim(root_prim))
         {
-            auto prim_path = SdfPath(con.start_port).GetPrimPath();
-            auto prim = get_stage()->GetPrimAtPath(prim_path);
+            const SdfPath start_path(con.start_port);
+            auto prim = get_stage()->GetPrimAtPath(start_path.GetPrimPath());
             if (!prim || TfStringStartsWith(get_property_name(con.end_port), "inputs:"))
                 continue;
 
-            if (SdfPath(con.start_port).IsPropertyPath())
-                add_connection(con);
+            if (start_path.IsPropertyPath())
+                add_connection(start_path, SdfPath(con.end_port));
             traverse(prim);
         }
     }
@@ -978,10 +877,6 @@ void MaterialGraphModel::on_rename()
     }
 
     auto& graph_cache = get_graph_cache();
-    GraphCache new_graph_cache;
-    new_graph_cache.connections.reserve(graph_cache.connections.size());
-    new_graph_cache.nodes.reserve(graph_cache.nodes.size());
-
     const auto& old_paths = get_node_provider().get_old_rename_paths();
     const auto& new_paths = get_node_provider().get_new_rename_paths();
 
@@ -990,24 +885,38 @@ void MaterialGraphModel::on_rename()
         if (!m_network_path.HasPrefix(old_paths[i]))
             continue;
 
+        // the material nodes and the navigation follow the root, so the view is rebuilt from the renamed cache
         m_network_path = m_network_path.ReplacePrefix(old_paths[i], new_paths[i], false);
-        const auto old_str = old_paths[i].GetString();
-        const auto new_str = new_paths[i].GetString();
+        graph_cache.rename(old_paths[i], new_paths[i]);
+        get_node_provider().rename_performed();
+        Q_EMIT model_reset();
+        return;
+    }
 
-        for (const auto& node : get_graph_cache().nodes)
-            new_graph_cache.nodes.insert(TfStringReplace(node, old_str, new_str));
+    for (int i = 0; i < old_paths.size(); ++i)
+    {
+        // reparented prims can leave the network, they are removed and added back by the resync
+        if (old_paths[i].GetParentPath() != new_paths[i].GetParentPath())
+            continue;
 
-        for (const auto& con : graph_cache.connections)
+        const auto renamed = graph_cache.rename(old_paths[i], new_paths[i]);
+        for (const auto& node : renamed.nodes)
         {
-            ConnectionId new_con;
-            new_con.start_port = TfStringReplace(con.start_port, old_str, new_str);
-            new_con.end_port = TfStringReplace(con.end_port, old_str, new_str);
-            new_graph_cache.connections.insert(std::move(new_con));
+            auto pos = m_external_node_pos.find(node.first);
+            if (pos == m_external_node_pos.end())
+                continue;
+            m_external_node_pos[node.second] = pos->second;
+            m_external_node_pos.erase(node.first);
         }
-        std::swap(graph_cache, new_graph_cache);
-        get_node_provider().rename_performed();
-        Q_EMIT model_reset();
-        return;
+
+        for (const auto& connection : renamed.connections)
+            Q_EMIT connection_removed(connection.first);
+        for (const auto& node : renamed.nodes)
+            Q_EMIT node_removed(node.first);
+        for (const auto& node : renamed.nodes)
+            Q_EMIT node_created(node.second);
+        for (const auto& connection : renamed.connections)
+            Q_EMIT connection_created(connection.second);
     }
     get_node_provider().rename_performed();
 }
@@ -1021,7 +930,7 @@ void MaterialGraphModel::on_selection_changed()
     nodes.reserve(sel_paths.size());
     for (const auto path : sel_paths)
     {
-        if (get_graph_cache().nodes.find(path.GetString()) != get_graph_cache().nodes.end())
+        if (get_graph_cache().has_node(path.GetString()))
             nodes.push_back(path.GetString());
     }
     Q_EMIT selection_changed(std::move(nodes), QVector<ConnectionId>());
@@ -1029,7 +938,7 @@ void MaterialGraphModel::on_selection_changed()
 
 QVector<NodeId> MaterialGraphModel::get_nodes() const
 {
-    const auto& nodes = get_graph_cache().nodes;
+    const auto& nodes = get_graph_cache().get_nodes();
     QVector<NodeId> result(nodes.size() + 2);
     std::transform(nodes.begin(), nodes.end(), result.begin(), [](const NodeId& node) { return node; });
     result.push_back(m_network_path.GetString() + "#mat_in");
@@ -1069,7 +978,7 @@ void MaterialGraphModel::set_preview_shader(PXR_NS::SdfPath preview_shader_path)
 
 QVector<ConnectionId> MaterialGraphModel::get_connections() const
 {
-    const auto& connections = get_graph_cache().connections;
+    const auto& connections = get_graph_cache().get_connections();
     QVector<ConnectionId> result(connections.size());
     std::transform(connections.begin(), connections.end(), result.begin(), [](const ConnectionId& connection) { return connection; });
     return std::move(result);
@@ -1080,21 +989,15 @@ QVector<ConnectionId> MaterialGraphModel::get_connections_for_node(const NodeId&
     if (!get_stage() || get_root().IsEmpty())
         return {};
 
-    QVector<ConnectionId> result;
-    const auto node_path = node_id;
-
-    for (const auto& connection : get_graph_cache().connections)
-    {
-        if (get_node_path(connection.start_port) == node_path || get_node_path(connection.end_port) == node_path)
-            result.push_back(connection);
-    }
-
-    return std::move(result);
+    const auto connections = get_graph_cache().get_connections_for_node(node_id);
+    QVector<ConnectionId> result(connections.size());
+    std::copy(connections.begin(), connections.end(), result.begin());
+    return result;
 }
 
 void MaterialGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
 {
-    if (get_graph_cache().nodes.find(prim_path.GetString()) != get_graph_cache().nodes.end())
+    if (get_graph_cache().has_node(prim_path.GetString()))
         return;
 
     if (!show_external_nodes())
@@ -1121,7 +1024,7 @@ void MaterialGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
         auto outcoming_connections = get_connections_for_node(node_id);
 
         for (auto it = incoming_connections.begin(); it != end_it; ++it)
-            get_graph_cache().connections.emplace(
+            get_graph_cache().add_connection(
                 ConnectionId { from_usd_path(SdfPath(it->start_port), m_network_path), from_usd_path(SdfPath(it->end_port), m_network_path) });
 
         Q_EMIT node_created(node_id);
@@ -1136,7 +1039,7 @@ void MaterialGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
         if (prim_path == get_root())
             return;
 
-        auto& nodes = get_graph_cache().nodes;
+        auto& graph_cache = get_graph_cache();
         const NodeId node_id = prim_path.GetString();
         const auto prim = get_stage()->GetPrimAtPath(prim_path);
         auto incoming_connections = get_connections_for_prim(prim);
@@ -1149,11 +1052,11 @@ void MaterialGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
                 const SdfPath sdf_start(con.start_port);
                 const SdfPath sdf_end(con.end_port);
                 if (sdf_start.IsPropertyPath())
-                    get_graph_cache().connections.emplace(ConnectionId { from_usd_path(sdf_start, get_root()), from_usd_path(sdf_end, get_root()) });
+                    graph_cache.add_connection(ConnectionId { from_usd_path(sdf_start, get_root()), from_usd_path(sdf_end, get_root()) });
 
                 // add external nodes that are not in the current graph
                 const auto node_path = from_usd_path(sdf_start.GetPrimPath(), get_root());
-                if (sdf_start.GetPrimPath() != get_root() && nodes.find(node_path) == nodes.end())
+                if (sdf_start.GetPrimPath() != get_root() && !graph_cache.has_node(node_path))
                     Q_EMIT node_created(node_path);
             }
             end_it = incoming_connections.end();
@@ -1161,10 +1064,10 @@ void MaterialGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
         else
         {
             // remove external node -> unknown node
-            end_it = std::remove_if(incoming_connections.begin(), incoming_connections.end(), [this, &nodes](const ConnectionId& connection) {
+            end_it = std::remove_if(incoming_connections.begin(), incoming_connections.end(), [this, &graph_cache](const ConnectionId& connection) {
                 const SdfPath sdf_start(connection.start_port);
 
-                return nodes.find(from_usd_path(sdf_start.GetPrimPath(), get_root())) == nodes.end();
+                return !graph_cache.has_node(from_usd_path(sdf_start.GetPrimPath(), get_root()));
             });
 
             if (incoming_connections.begin() == end_it)
@@ -1175,7 +1078,7 @@ void MaterialGraphModel::try_add_prim(const PXR_NS::SdfPath& prim_path)
                 const SdfPath sdf_start(it->start_port);
                 const SdfPath sdf_end(it->end_port);
                 if (sdf_start.IsPropertyPath())
-                    get_graph_cache().connections.emplace(ConnectionId { from_usd_path(sdf_start, get_root()), from_usd_path(sdf_end, get_root()) });
+                    graph_cache.add_connection(ConnectionId { from_usd_path(sdf_start, get_root()), from_usd_path(sdf_end, get_root()) });
             }
         }
 
@@ -1201,22 +1104,12 @@ void MaterialGraphModel::try_remove_prim(const PXR_NS::SdfPath& prim_path)
         return;
     }
     const NodeId node_id = prim_path.GetString();
-    if (get_graph_cache().nodes.find(node_id) == get_graph_cache().nodes.end())
+    if (!get_graph_cache().has_node(node_id))
         return;
 
-    std::vector<ConnectionId> removed_connections;
-    for (auto it = get_graph_cache().connections.begin(); it != get_graph_cache().connections.end();)
-    {
-        if (get_node_path(it->start_port) == prim_path.GetString() || get_node_path(it->end_port) == prim_path.GetString())
-        {
-            removed_connections.emplace_back(*it);
-            it = get_graph_cache().connections.erase(it);
-        }
-        else
-        {
-            ++it;
-        }
-    }
+    const auto removed_connections = get_graph_cache().get_connections_for_node(node_id);
+    for (const auto& connection : removed_connections)
+        get_graph_cache().remove_connection(connection);
 
     for (const auto& connection : removed_connections)
         Q_EMIT connection_removed(connection);
@@ -1242,18 +1135,24 @@ void MaterialGraphModel::try_update_prop(const PXR_NS::SdfPath& prop_path)
             prop.As<UsdRelationship>().GetTargets(&connections);
     }
     std::unordered_set<SdfPath, SdfPath::Hash> target_set(connections.begin(), connections.end());
-    for (auto it = get_graph_cache().connections.begin(); it != get_graph_cache().connections.end();)
+
+    // every connection is checked, a port deleted on another node leaves stale connections indexed under that node
+    std::vector<ConnectionId> removed_connections;
+    for (const auto& connection : get_graph_cache().get_connections())
     {
-        const auto start_path = to_usd_path(it->start_port);
-        const auto end_path = to_usd_path(it->end_port);
+        const auto start_path = to_usd_path(connection.start_port);
+        const auto end_path = to_usd_path(connection.end_port);
         // If incoming connection that are no longer exists or port was deleted
-        if (end_path == prop_path && target_set.find(start_path) == target_set.end() || !has_port(it->end_port) || !has_port(it->start_port))
+        if (end_path == prop_path && target_set.find(start_path) == target_set.end() || !has_port(connection.end_port) ||
+            !has_port(connection.start_port))
         {
-            const auto removed_connection = *it;
-            it = get_graph_cache().connections.erase(it);
-            Q_EMIT connection_removed(removed_connection);
+            removed_connections.push_back(connection);
         }
-        ++it;
+    }
+    for (const auto& connection : removed_connections)
+    {
+        if (get_graph_cache().remove_connection(connection))
+            Q_EMIT connection_removed(connection);
     }
 
     std::string prop_model_path;
@@ -1291,16 +1190,16 @@ void MaterialGraphModel::try_update_prop(const PXR_NS::SdfPath& prop_path)
             if (show_external_nodes() && !is_descendant(get_root(), target))
             {
                 const auto node_id = get_node_id_from_port(from_usd_path(target, get_root()));
-                if (get_graph_cache().nodes.find(node_id) == get_graph_cache().nodes.end())
+                if (!get_graph_cache().has_node(node_id))
                     Q_EMIT node_created(node_id);
             }
         }
 
         if (target.IsPropertyPath())
         {
-            const auto result = get_graph_cache().connections.emplace(ConnectionId { target_model_path, prop_model_path });
-            if (result.second)
-                Q_EMIT connection_created(*result.first);
+            ConnectionId connection { target_model_path, prop_model_path };
+            if (get_graph_cache().add_connection(connection))
+                Q_EMIT connection_created(connection);
         }
     }
     Q_EMIT port_updated(prop_model_path);
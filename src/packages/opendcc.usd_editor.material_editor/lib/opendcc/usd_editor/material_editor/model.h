@@ -94,6 +94,7 @@ private:
     std::unordered_map<NodeId, QPointF> m_mat_out_pos;
     std::unordered_map<NodeId, QPointF> m_external_node_pos;
     bool m_show_external_nodes = false;
+    bool m_material_override_update_requested = false;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -3,14 +3,13 @@
 
 #include "opendcc/usd_editor/material_editor/shader_node.h"
 #include "opendcc/usd_editor/material_editor/model.h"
-#include "opendcc/usd_editor/material_editor/model.h"
+#include "opendcc/usd_editor/material_editor/asset_resolve_cache.h"
 #include "opendcc/ui/node_editor/connection.h"
 #include "opendcc/ui/node_editor/thumbnail_cache.h"
 #include "opendcc/app/ui/shader_node_registry.h"
 #include "opendcc/app/viewport/prim_material_override.h"
 #include "opendcc/app/ui/application_ui.h"
 #include "usd_fallback_proxy/core/usd_prim_fallback_proxy.h"
-#include <pxr/usd/ar/resolver.h>
 #include <pxr/base/tf/stringUtils.h>
 #include <pxr/usd/usdUI/tokens.h>
 #include <pxr/usd/usdShade/shader.h>
@@ -66,6 +65,27 @@ namespace
     };
 
     static constexpr qreal s_texture_size = 100;
+
+    // returns an empty path and sets pending_path if the asset path is being resolved in the background
+    std::string get_texture_path(const UsdPropertyProxyPtr& prop, SdfAssetPath& pending_path)
+    {
+        VtValue val;
+        if (!prop->get(&val))
+            return std::string();
+        if (val.IsHolding<std::string>())
+            return val.UncheckedGet<std::string>();
+        if (!val.IsHolding<SdfAssetPath>())
+            return std::string();
+
+        SdfAssetPath resolved_path;
+        const auto& asset_path = val.UncheckedGet<SdfAssetPath>();
+        if (!AssetResolveCache::instance().resolve(asset_path, prop->get_attribute(), UsdTimeCode::Default(), resolved_path))
+        {
+            pending_path = asset_path;
+            return std::string();
+        }
+        return resolved_path.GetResolvedPath();
+    }
 };
 
 LiveShaderNodeItem::LiveShaderNodeItem(UsdGraphModel& model, const PXR_NS::TfToken& name, const PXR_NS::TfToken& shader_id,
@@ -87,8 +107,32 @@ void LiveShaderNodeItem::on_prim_created(const PXR_NS::UsdPrim& prim)
 TextureLayoutItem::TextureLayoutItem(UsdGraphModel& model, UsdPrimNodeItemBase* node, const PortId& id, const PXR_NS::TfToken& name,
                                      Port::Type port_type, ThumbnailCache* cache, const std::string& texture_path)
     : NamedPropertyLayoutItem(model, node, id, name, port_type)
-    , m_texture_path(texture_path)
 {
+    if (!texture_path.empty())
+        request_image(cache, texture_path);
+}
+
+void TextureLayoutItem::request_resolved_image(ThumbnailCache* cache, const PXR_NS::UsdAttribute& attr, const PXR_NS::SdfAssetPath& asset_path)
+{
+    const auto resolve_key = QString::fromStdString(asset_path.GetAssetPath());
+    m_resolve_connection = connect(&AssetResolveCache::instance(), &AssetResolveCache::path_resolved, this,
+                                   [this, cache, attr, asset_path, resolve_key](const QString& resolved_asset_path) {
+                                       SdfAssetPath resolved_path;
+                                       if (resolved_asset_path != resolve_key ||
+                                           !AssetResolveCache::instance().resolve(asset_path, attr, UsdTimeCode::Default(), resolved_path))
+                                       {
+                                           return;
+                                       }
+
+                                       disconnect(m_resolve_connection);
+                                       if (!resolved_path.GetResolvedPath().empty())
+                                           request_image(cache, resolved_path.GetResolvedPath());
+                                   });
+}
+
+void TextureLayoutItem::request_image(ThumbnailCache* cache, const std::string& texture_path)
+{
+    m_texture_path = texture_path;
     const auto img_path = QString::fromStdString(texture_path);
     if (cache->has_image(img_path))
     {
@@ -210,21 +254,14 @@ QVector<PropertyLayoutItem*> ShaderNodeItem::make_ports(const PXR_NS::UsdPrim& p
             PropertyWithPortsLayoutItem* item = nullptr;
             if (is_texture_attribute(m_shader_type, name))
             {
-                VtValue val;
-                std::string file_path;
-                if (prop->get(&val))
-                {
-                    if (val.IsHolding<SdfAssetPath>())
-#if PXR_VERSION < 2205
-                        file_path = ArGetResolver().Resolve(val.UncheckedGet<SdfAssetPath>().GetAssetPath());
-#else
-                        file_path = ArGetResolver().Resolve(val.UncheckedGet<SdfAssetPath>().GetAssetPath()).GetPathString();
-#endif
-                    else if (val.IsHolding<std::string>())
-                        file_path = val.UncheckedGet<std::string>();
-                }
-                item = new TextureLayoutItem(get_model(), this, prop_path.GetString(), stripped_name,
-                                             col == &outputs ? Port::Type::Output : Port::Type::Input, get_scene()->get_thumbnail_cache(), file_path);
+                SdfAssetPath pending_path;
+                const auto file_path = get_texture_path(prop, pending_path);
+                auto texture_item = new TextureLayoutItem(get_model(), this, prop_path.GetString(), stripped_name,
+                                                          col == &outputs ? Port::Type::Output : Port::Type::Input,
+                                                          get_scene()->get_thumbnail_cache(), file_path);
+                if (!pending_path.GetAssetPath().empty())
+                    texture_item->request_resolved_image(get_scene()->get_thumbnail_cache(), prop->get_attribute(), pending_path);
+                item = texture_item;
             }
             else
             {
@@ -377,23 +414,15 @@ PropertyLayoutItem* ShaderNodeItem::make_port(const PortId& port_id, const PXR_N
     PropertyWithPortsLayoutItem* item = nullptr;
     if (is_texture_attribute(m_shader_type, prop->get_name_token()))
     {
-        VtValue val;
-        std::string file_path;
-        if (prop->get(&val))
-        {
-            if (val.IsHolding<SdfAssetPath>())
-#if PXR_VERSION < 2205
-                file_path = ArGetResolver().Resolve(val.UncheckedGet<SdfAssetPath>().GetAssetPath());
-#else
-                file_path = ArGetResolver().Resolve(val.UncheckedGet<SdfAssetPath>().GetAssetPath()).GetPathString();
-#endif
-            else if (val.IsHolding<std::string>())
-                file_path = val.UncheckedGet<std::string>();
-        }
-        if (!file_path.empty())
+        SdfAssetPath pending_path;
+        const auto file_path = get_texture_path(prop, pending_path);
+        if (!file_path.empty() || !pending_path.GetAssetPath().empty())
         {
-            item = new TextureLayoutItem(get_model(), this, port_id, stripped_name, is_output ? Port::Type::Output : Port::Type::Input,
-                                         get_scene()->get_thumbnail_cache(), file_path);
+            auto texture_item = new TextureLayoutItem(get_model(), this, port_id, stripped_name, is_output ? Port::Type::Output : Port::Type::Input,
+                                                      get_scene()->get_thumbnail_cache(), file_path);
+            if (!pending_path.GetAssetPath().empty())
+                texture_item->request_resolved_image(get_scene()->get_thumbnail_cache(), prop->get_attribute(), pending_path);
+            item = texture_item;
         }
     }
     if (!item)
@@ -8,6 +8,7 @@
 #include "opendcc/opendcc.h"
 #include "opendcc/usd_editor/usd_node_editor/node.h"
 #include "opendcc/usd_editor/material_editor/api.h"
+#include <pxr/usd/sdf/assetPath.h>
 
 class QGraphicsSvgItem;
 OPENDCC_NAMESPACE_OPEN
@@ -24,15 +25,19 @@ public:
                       ThumbnailCache* cache, const std::string& texture_path);
 
     virtual void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget /* = nullptr */) override;
+    // shows the thumbnail once the asset path of the attribute is resolved in the background
+    void request_resolved_image(ThumbnailCache* cache, const PXR_NS::UsdAttribute& attr, const PXR_NS::SdfAssetPath& asset_path);
 
 protected:
     virtual QSizeF sizeHint(Qt::SizeHint which, const QSizeF& constraint = QSizeF()) const override;
 
 private:
+    void request_image(ThumbnailCache* cache, const std::string& texture_path);
     void read_image(ThumbnailCache* cache, const QString& path);
 
     std::string m_texture_path;
     QPixmap m_pixmap;
+    QMetaObject::Connection m_resolve_connection;
 };
 
 class OPENDCC_MATERIAL_EDITOR_API LiveShaderNodeItem : public UsdLiveNodeItem
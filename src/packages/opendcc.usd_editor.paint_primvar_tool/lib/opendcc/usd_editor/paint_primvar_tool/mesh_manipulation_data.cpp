@@ -6,8 +6,6 @@
 
 OPENDCC_NAMESPACE_OPEN
 
-const float MeshManipulationData::empty_scale = -1e10f;
-
 float falloff_function(float falloff, float normalize_radius)
 {
     if (normalize_radius > 1)
@@ -50,7 +48,6 @@ MeshManipulationData::MeshManipulationData(const UsdGeomMesh& in_mesh, bool& suc
     normals = Hd_SmoothNormals::ComputeSmoothNormals(&adjacency, points.size(), points.cdata());
     UsdGeomXformCache xform_cache(Application::instance().get_current_time());
     bvh.add_prim(mesh.GetPrim().GetPath(), xform_cache.GetLocalToWorldTransform(mesh.GetPrim()), points);
-    scales.resize(points.size(), empty_scale);
     success = true;
 }
 
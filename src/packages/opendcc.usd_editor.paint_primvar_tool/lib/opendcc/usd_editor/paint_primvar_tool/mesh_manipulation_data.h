@@ -24,13 +24,11 @@ float falloff_function(float falloff, float normalize_radius);
 struct MeshManipulationData
 {
     UsdGeomMesh mesh;
-    std::vector<float> scales;
     PointCloudBVH bvh;
     VtVec3fArray points;
     VtVec3fArray normals;
     Hd_VertexAdjacency adjacency;
     std::unique_ptr<commands::UsdEditsUndoBlock> undo_block;
-    const static float empty_scale;
     MeshManipulationData(const UsdGeomMesh& in_mesh, bool& success);
 };
 
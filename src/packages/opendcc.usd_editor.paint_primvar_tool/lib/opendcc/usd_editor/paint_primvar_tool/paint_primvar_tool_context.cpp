@@ -25,6 +25,7 @@
 #include "opendcc/app/viewport/viewport_view.h"
 #include "paint_primvar_tool_context.h"
 #include "mesh_manipulation_data.h"
+#include "primvar_brush.h"
 #include <ImathMatrix.h>
 #include <ImathQuat.h>
 #include "opendcc/app/viewport/prim_material_override.h"
@@ -34,6 +35,7 @@
 #endif
 #include "pxr/usd/usdGeom/primvarsAPI.h"
 #include "pxr/usd/sdr/shaderMetadataHelpers.h"
+#include <chrono>
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -42,13 +44,17 @@ PXR_NAMESPACE_USING_DIRECTIVE
 namespace
 {
     static int points_in_unit_radius = 50;
+    // the whole primvar is authored at most this often during the stroke
+    static const std::chrono::milliseconds write_interval { 100 };
 }
 
 struct MeshData : public MeshManipulationData
 {
     PrimvarType type = PrimvarType::None;
-    VtVec3fArray prev_values_vec3f;
-    VtFloatArray prev_values_float;
+    PrimvarBrush<GfVec3f> brush_vec3f;
+    PrimvarBrush<float> brush_float;
+    bool values_changed = false;
+    std::chrono::steady_clock::time_point last_write_time;
     PaintPrimvarToolContext::Properties draw_properties;
 
     std::vector<TfToken> primvars_names;
@@ -78,28 +84,49 @@ struct MeshData : public MeshManipulationData
         auto primvar = primvars_api.GetPrimvar(primvars_names[current_primvar_idx]);
         if (!primvar)
             return;
-        prev_values_float.resize(0);
-        prev_values_vec3f.resize(0);
+        values_changed = false;
         if (primvar.GetTypeName() == SdfValueTypeNames->FloatArray)
         {
-            primvar.Get(&prev_values_float);
-            auto prve_size = prev_values_float.size();
-            prev_values_float.resize(points.size());
-            for (auto i = prve_size; i < points.size(); ++i)
-                prev_values_float[i] = 0;
+            VtFloatArray values;
+            primvar.Get(&values);
+            brush_float.reset(values, points.size());
+            brush_vec3f.reset(VtVec3fArray(), 0);
             type = PrimvarType::Float;
         }
         else
         {
-            primvar.Get(&prev_values_vec3f);
-            auto prve_size = prev_values_vec3f.size();
-            prev_values_vec3f.resize(points.size());
-            for (auto i = prve_size; i < points.size(); ++i)
-                prev_values_vec3f[i] = GfVec3f(0);
+            VtVec3fArray values;
+            primvar.Get(&values);
+            brush_vec3f.reset(values, points.size());
+            brush_float.reset(VtFloatArray(), 0);
             type = PrimvarType::Vec3f;
         }
     }
 
+    void write_values()
+    {
+        last_write_time = std::chrono::steady_clock::now();
+        if (!values_changed)
+            return;
+        values_changed = false;
+
+        if (!undo_block)
+            undo_block = std::make_unique<commands::UsdEditsUndoBlock>();
+        UsdGeomPrimvarsAPI primvars_api(mesh.GetPrim());
+        if (!primvars_api)
+            return;
+        auto primvar = primvars_api.GetPrimvar(primvars_names[current_primvar_idx]);
+        TfToken interpolation;
+        primvar.GetAttr().GetMetadata(UsdGeomTokens->interpolation, &interpolation);
+        if (interpolation != UsdGeomTokens->vertex)
+            primvar.GetAttr().SetMetadata(UsdGeomTokens->interpolation, UsdGeomTokens->vertex);
+
+        if (type == PrimvarType::Vec3f)
+            primvar.Set(brush_vec3f.values());
+        else if (type == PrimvarType::Float)
+            primvar.Set(brush_float.values());
+    }
+
     void set_current_primvar_idx(size_t primvar_index)
     {
         if (primvars_names.size() == 0 || primvar_index >= primvars_names.size())
@@ -112,8 +139,8 @@ struct MeshData : public MeshManipulationData
     void on_start() { update_buffers(); }
     void on_finish()
     {
+        write_values();
         undo_block.reset();
-        std::fill(scales.begin(), scales.end(), empty_scale);
         set_current_primvar_idx(current_primvar_idx);
     }
 };
@@ -124,130 +151,33 @@ void PaintPrimvarToolContext::draw_in_mesh()
         return;
 
     auto indices = m_mesh_data->bvh.get_points_in_radius(m_p, m_mesh_data->mesh.GetPath(), m_properties.radius);
-    const VtVec3fArray& points = m_mesh_data->points;
-    const VtVec3fArray& normals = m_mesh_data->normals;
+    if (indices.empty())
+        return;
+
     UsdGeomXformCache xform_cache(Application::instance().get_current_time());
     auto local_to_world = xform_cache.GetLocalToWorldTransform(m_mesh_data->mesh.GetPrim());
-    VtVec3fArray next_values_vec3f = m_mesh_data->prev_values_vec3f;
-    VtFloatArray next_values_float = m_mesh_data->prev_values_float;
-    VtVec3fArray& prev_values_vec3f = m_mesh_data->prev_values_vec3f;
-    VtFloatArray& prev_values_float = m_mesh_data->prev_values_float;
     const VtIntArray& adjacency_table = m_mesh_data->adjacency.GetAdjacencyTable();
 
-    if (m_properties.mode == Mode::Smooth)
-    {
-        if (m_mesh_data->type == PrimvarType::Vec3f)
-            next_values_vec3f.resize(prev_values_vec3f.size());
-        else
-            next_values_float.resize(prev_values_float.size());
-    }
-
-    if (indices.size() > 0)
-    {
-        auto inv_r = 1.0f / m_properties.radius;
-        auto& scales = m_mesh_data->scales;
-        std::unordered_set<int> sciped_indices;
-        for (size_t i : indices)
-        {
-            if (GfDot(normals[i], m_n) < 0)
-            {
-                sciped_indices.insert(i);
-                continue;
-            }
-
-            auto falloff = falloff_function(properties().falloff, (local_to_world.Transform(points[i]) - m_p).GetLength() * inv_r);
-
-            if (falloff <= 0 || falloff > 1)
-            {
-                sciped_indices.insert(i);
-                continue;
-            }
-
-            if (m_properties.mode == Mode::Smooth)
-            {
-                int offsetIdx = i * 2;
-                int offset = adjacency_table[offsetIdx];
-                int valence = adjacency_table[offsetIdx + 1];
-                const int* e = &adjacency_table[offset];
-                if (m_mesh_data->type == PrimvarType::Vec3f)
-                {
-                    GfVec3f S(prev_values_vec3f[i]);
-                    for (int j = 0; j < valence; ++j)
-                        S += prev_values_vec3f[e[j * 2]];
-                    next_values_vec3f[i] = prev_values_vec3f[i] * (1 - falloff) + falloff * S / (valence + 1);
-                }
-                else
-                {
-                    float S(prev_values_float[i]);
-                    for (int j = 0; j < valence; ++j)
-                        S += prev_values_float[e[j * 2]];
-                    next_values_float[i] = prev_values_float[i] * (1 - falloff) + falloff * S / (valence + 1);
-                }
-            }
-            else
-            {
-                if (scales[i] == MeshData::empty_scale)
-                    scales[i] = falloff;
-                else
-                    scales[i] += falloff;
-
-                if (m_properties.mode != Mode::Add)
-                    scales[i] = std::min(scales[i], 1.0f);
-            }
-        }
-
-        if (m_properties.mode == Mode::Smooth)
-        {
-            if (m_mesh_data->type == PrimvarType::Vec3f)
-                m_mesh_data->prev_values_vec3f = next_values_vec3f;
-            else
-                m_mesh_data->prev_values_float = next_values_float;
-        }
+    auto apply = [&](auto& brush, const auto& value) {
+        typename std::decay_t<decltype(brush)>::Dab dab;
+        dab.center = m_p;
+        dab.normal = m_n;
+        dab.radius = m_properties.radius;
+        dab.falloff = m_properties.falloff;
+        dab.mode = static_cast<decltype(dab.mode)>(m_properties.mode);
+        dab.value = value;
+        return brush.apply(dab, indices, m_mesh_data->points, m_mesh_data->normals, local_to_world, adjacency_table);
+    };
+
+    bool changed = false;
+    if (m_mesh_data->type == PrimvarType::Vec3f)
+        changed = apply(m_mesh_data->brush_vec3f, m_mesh_data->draw_properties.vec3f_value);
+    else
+        changed = apply(m_mesh_data->brush_float, m_mesh_data->draw_properties.float_value);
+    m_mesh_data->values_changed |= changed;
 
-        if (indices.size() > 0)
-        {
-            if (!m_mesh_data->undo_block)
-                m_mesh_data->undo_block = std::make_unique<commands::UsdEditsUndoBlock>();
-            UsdGeomPrimvarsAPI primvars_api(m_mesh_data->mesh.GetPrim());
-            if (!primvars_api)
-                return;
-            auto primvar = primvars_api.GetPrimvar(m_mesh_data->primvars_names[m_mesh_data->current_primvar_idx]);
-            TfToken interpolation;
-            primvar.GetAttr().GetMetadata(UsdGeomTokens->interpolation, &interpolation);
-            if (interpolation != UsdGeomTokens->vertex)
-            {
-                primvar.GetAttr().SetMetadata(UsdGeomTokens->interpolation, UsdGeomTokens->vertex);
-            }
-            if (m_mesh_data->draw_properties.mode != PaintPrimvarToolContext::Mode::Smooth)
-            {
-                for (size_t i : indices)
-                {
-                    if (sciped_indices.find(i) != sciped_indices.end())
-                        continue;
-                    if (m_mesh_data->type == PrimvarType::Vec3f)
-                    {
-                        if (m_mesh_data->draw_properties.mode == PaintPrimvarToolContext::Mode::Add)
-                            prev_values_vec3f[i] += m_mesh_data->draw_properties.vec3f_value * scales[i];
-                        else
-                            prev_values_vec3f[i] =
-                                prev_values_vec3f[i] * std::max(0.0f, (1.0f - scales[i])) + m_mesh_data->draw_properties.vec3f_value * scales[i];
-                    }
-                    else if (m_mesh_data->type == PrimvarType::Float)
-                    {
-                        if (m_mesh_data->draw_properties.mode == PaintPrimvarToolContext::Mode::Add)
-                            prev_values_float[i] += m_mesh_data->draw_properties.float_value * scales[i];
-                        else
-                            prev_values_float[i] =
-                                prev_values_float[i] * std::max(0.0f, (1.0f - scales[i])) + m_mesh_data->draw_properties.float_value * scales[i];
-                    }
-                }
-            }
-            if (m_mesh_data->type == PrimvarType::Vec3f)
-                primvar.Set(prev_values_vec3f);
-            else if (m_mesh_data->type == PrimvarType::Float)
-                primvar.Set(prev_values_float);
-        }
-    }
+    if (std::chrono::steady_clock::now() - m_mesh_data->last_write_time >= write_interval)
+        m_mesh_data->write_values();
 }
 
 void PaintPrimvarToolContext::update_context()
@@ -0,0 +1,263 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/usd_editor/paint_primvar_tool/primvar_brush.h"
+#include "opendcc/usd_editor/paint_primvar_tool/mesh_manipulation_data.h"
+#include "tbb/blocked_range.h"
+#include "tbb/parallel_for.h"
+#include <algorithm>
+
+OPENDCC_NAMESPACE_OPEN
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    static const float empty_scale = -1.0f;
+    // small brushes are cheaper on the calling thread
+    static const size_t grain_size = 1024;
+
+    template <class Fn>
+    void parallel_for(size_t count, Fn&& fn)
+    {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, count, grain_size), [&fn](const tbb::blocked_range<size_t>& range) {
+            for (size_t i = range.begin(); i < range.end(); ++i)
+                fn(i);
+        });
+    }
+}
+
+template <class T>
+void PrimvarBrush<T>::reset(VtArray<T> values, size_t points_count)
+{
+    m_values = std::move(values);
+    const auto prev_size = m_values.size();
+    m_values.resize(points_count);
+    if (prev_size < points_count)
+        std::fill(m_values.data() + prev_size, m_values.data() + points_count, T(0));
+
+    m_scales.assign(points_count, empty_scale);
+}
+
+template <class T>
+bool PrimvarBrush<T>::apply(const Dab& dab, const std::vector<int>& indices, const VtVec3fArray& points, const VtVec3fArray& normals,
+                            const GfMatrix4d& local_to_world, const VtIntArray& adjacency_table)
+{
+    if (indices.empty() || dab.radius <= 0 || m_values.size() != points.size())
+        return false;
+
+    const auto inv_r = 1.0f / dab.radius;
+    const GfVec3f* points_data = points.cdata();
+    const GfVec3f* normals_data = normals.cdata();
+    m_weights.resize(indices.size());
+    parallel_for(indices.size(), [&](size_t k) {
+        const auto i = indices[k];
+        float weight = 0;
+        if (GfDot(normals_data[i], dab.normal) >= 0)
+        {
+            weight = falloff_function(dab.falloff, (local_to_world.Transform(points_data[i]) - dab.center).GetLength() * inv_r);
+            if (weight > 1)
+                weight = 0;
+        }
+        m_weights[k] = std::max(weight, 0.0f);
+    });
+
+    // detaches the working copy only if it is shared with the stage after the last write
+    T* values = m_values.data();
+    if (dab.mode == Mode::Smooth)
+    {
+        const int* adjacency = adjacency_table.cdata();
+        m_scratch.resize(indices.size());
+        parallel_for(indices.size(), [&](size_t k) {
+            const auto weight = m_weights[k];
+            if (weight == 0)
+                return;
+
+            const auto i = indices[k];
+            const int offset = adjacency[i * 2];
+            const int valence = adjacency[i * 2 + 1];
+            const int* e = adjacency + offset;
+            T sum = values[i];
+            for (int j = 0; j < valence; ++j)
+                sum += values[e[j * 2]];
+            m_scratch[k] = values[i] * (1 - weight) + weight * sum / float(valence + 1);
+        });
+        parallel_for(indices.size(), [&](size_t k) {
+            if (m_weights[k] != 0)
+                values[indices[k]] = m_scratch[k];
+        });
+    }
+    else
+    {
+        parallel_for(indices.size(), [&](size_t k) {
+            const auto weight = m_weights[k];
+            if (weight == 0)
+                return;
+
+            const auto i = indices[k];
+            auto& scale = m_scales[i];
+            scale = scale == empty_scale ? weight : scale + weight;
+            if (dab.mode == Mode::Add)
+            {
+                values[i] += dab.value * scale;
+            }
+            else
+            {
+                scale = std::min(scale, 1.0f);
+                values[i] = values[i] * std::max(0.0f, 1.0f - scale) + dab.value * scale;
+            }
+        });
+    }
+
+    return std::any_of(m_weights.begin(), m_weights.end(), [](float weight) { return weight != 0; });
+}
+
+template class PrimvarBrush<float>;
+template class PrimvarBrush<GfVec3f>;
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <chrono>
+#include <pxr/imaging/hd/meshTopology.h>
+#include <pxr/imaging/hd/smoothNormals.h>
+#include <pxr/imaging/hd/vertexAdjacency.h>
+#include <pxr/imaging/pxOsd/tokens.h>
+
+OPENDCC_NAMESPACE_USING
+
+namespace
+{
+    struct Grid
+    {
+        VtVec3fArray points;
+        VtVec3fArray normals;
+        Hd_VertexAdjacency adjacency;
+
+        // side x side points in the xz plane with the unit spacing
+        Grid(int side)
+        {
+            points.resize(side * side);
+            for (int z = 0; z < side; ++z)
+                for (int x = 0; x < side; ++x)
+                    points[z * side + x] = GfVec3f(x, 0, z);
+
+            VtIntArray counts((side - 1) * (side - 1), 4);
+            VtIntArray face_indices;
+            face_indices.reserve(counts.size() * 4);
+            for (int z = 0; z < side - 1; ++z)
+            {
+                for (int x = 0; x < side - 1; ++x)
+                {
+                    face_indices.push_back(z * side + x);
+                    face_indices.push_back((z + 1) * side + x);
+                    face_indices.push_back((z + 1) * side + x + 1);
+                    face_indices.push_back(z * side + x + 1);
+                }
+            }
+            HdMeshTopology topology(PxOsdOpenSubdivTokens->catmullClark, PxOsdOpenSubdivTokens->rightHanded, counts, face_indices);
+            adjacency.BuildAdjacencyTable(&topology);
+            normals = Hd_SmoothNormals::ComputeSmoothNormals(&adjacency, points.size(), points.cdata());
+        }
+
+        std::vector<int> points_in_radius(const GfVec3f& center, float radius) const
+        {
+            std::vector<int> result;
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                if ((points[i] - center).GetLength() <= radius)
+                    result.push_back(static_cast<int>(i));
+            }
+            return result;
+        }
+    };
+}
+
+DOCTEST_TEST_SUITE("PrimvarBrush")
+{
+    DOCTEST_TEST_CASE("modes")
+    {
+        Grid grid(16);
+        const GfVec3f center(8, 0, 8);
+        const auto indices = grid.points_in_radius(center, 3);
+        const auto inside = 8 * 16 + 8;
+        const auto outside = 1;
+
+        PrimvarBrush<float> brush;
+        brush.reset(VtFloatArray(), grid.points.size());
+        DOCTEST_CHECK(brush.values().size() == grid.points.size());
+
+        PrimvarBrush<float>::Dab dab;
+        dab.center = center;
+        dab.normal = grid.normals[inside];
+        dab.radius = 3;
+        dab.falloff = 0;
+        dab.value = 1;
+        DOCTEST_CHECK(brush.apply(dab, indices, grid.points, grid.normals, GfMatrix4d(1), grid.adjacency.GetAdjacencyTable()));
+        DOCTEST_CHECK(brush.values()[inside] == 1);
+        DOCTEST_CHECK(brush.values()[outside] == 0);
+
+        // the points facing away from the brush are rejected
+        dab.normal = -dab.normal;
+        dab.value = 0;
+        DOCTEST_CHECK(!brush.apply(dab, indices, grid.points, grid.normals, GfMatrix4d(1), grid.adjacency.GetAdjacencyTable()));
+        DOCTEST_CHECK(brush.values()[inside] == 1);
+
+        // smoothing spreads the values to the neighbours, the points outside of the brush keep their values
+        dab.normal = -dab.normal;
+        dab.mode = PrimvarBrush<float>::Mode::Smooth;
+        dab.radius = 4;
+        DOCTEST_CHECK(brush.apply(dab, grid.points_in_radius(center, 4), grid.points, grid.normals, GfMatrix4d(1),
+                                  grid.adjacency.GetAdjacencyTable()));
+        DOCTEST_CHECK(brush.values()[8 * 16 + 11] > 0);
+        DOCTEST_CHECK(brush.values()[8 * 16 + 11] < 1);
+        DOCTEST_CHECK(brush.values()[outside] == 0);
+
+        PrimvarBrush<GfVec3f> color_brush;
+        color_brush.reset(VtVec3fArray(3, GfVec3f(0.5f)), grid.points.size());
+        DOCTEST_CHECK(color_brush.values()[2] == GfVec3f(0.5f));
+        DOCTEST_CHECK(color_brush.values()[3] == GfVec3f(0));
+        PrimvarBrush<GfVec3f>::Dab color_dab;
+        color_dab.center = center;
+        color_dab.normal = grid.normals[inside];
+        color_dab.falloff = 0;
+        color_dab.mode = PrimvarBrush<GfVec3f>::Mode::Add;
+        color_dab.value = GfVec3f(0.25f);
+        color_brush.apply(color_dab, indices, grid.points, grid.normals, GfMatrix4d(1), grid.adjacency.GetAdjacencyTable());
+        DOCTEST_CHECK(color_brush.values()[inside] == GfVec3f(0.25f));
+    }
+
+    DOCTEST_TEST_CASE("dab_cost_by_mesh_size")
+    {
+        const int dabs = 200;
+        for (int side : { 128, 1024 })
+        {
+            Grid grid(side);
+            const GfVec3f center(side / 2, 0, side / 2);
+            const auto indices = grid.points_in_radius(center, 20);
+            const auto& adjacency_table = grid.adjacency.GetAdjacencyTable();
+
+            PrimvarBrush<float> brush;
+            brush.reset(VtFloatArray(), grid.points.size());
+            PrimvarBrush<float>::Dab dab;
+            dab.center = center;
+            dab.normal = grid.normals[indices.front()];
+            dab.radius = 20;
+
+            for (auto mode : { PrimvarBrush<float>::Mode::Set, PrimvarBrush<float>::Mode::Smooth })
+            {
+                dab.mode = mode;
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < dabs; ++i)
+                    brush.apply(dab, indices, grid.points, grid.normals, GfMatrix4d(1), adjacency_table);
+                const auto time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / dabs;
+                DOCTEST_MESSAGE(grid.points.size() << " points, " << indices.size() << " in brush, "
+                                                   << (mode == PrimvarBrush<float>::Mode::Set ? "set" : "smooth") << ": " << time << " us per dab");
+            }
+        }
+    }
+}
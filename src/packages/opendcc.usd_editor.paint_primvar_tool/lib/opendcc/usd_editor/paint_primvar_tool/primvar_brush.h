@@ -0,0 +1,64 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include "opendcc/opendcc.h"
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include <vector>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Working copy of a vertex primvar painted by the brush.
+ *
+ * A dab only touches the values inside the brush: the weights of the brush points are computed in parallel
+ * into a flat buffer where zero marks a rejected point, smoothing reads the neighbours from the working copy
+ * and writes the result into a scratch buffer of the brush size, which is copied back after all points are done.
+ * The values are authored by the caller, the working copy isn't copied between the writes.
+ */
+template <class T>
+class PrimvarBrush
+{
+public:
+    // the same values as PaintPrimvarToolContext::Mode
+    enum class Mode
+    {
+        Set = 0,
+        Add = 1,
+        Smooth = 2,
+    };
+
+    struct Dab
+    {
+        // world space
+        PXR_NS::GfVec3f center = PXR_NS::GfVec3f(0);
+        PXR_NS::GfVec3f normal = PXR_NS::GfVec3f(0, 1, 0);
+        float radius = 1;
+        float falloff = 0.3f;
+        Mode mode = Mode::Set;
+        T value = T(1);
+    };
+
+    // starts a new stroke, values are resized to points_count and missing values are filled with zero
+    void reset(PXR_NS::VtArray<T> values, size_t points_count);
+    const PXR_NS::VtArray<T>& values() const { return m_values; }
+
+    // indices are the mesh points inside the dab radius, points and normals are in the local space of the mesh,
+    // returns true if any value is changed
+    bool apply(const Dab& dab, const std::vector<int>& indices, const PXR_NS::VtVec3fArray& points, const PXR_NS::VtVec3fArray& normals,
+               const PXR_NS::GfMatrix4d& local_to_world, const PXR_NS::VtIntArray& adjacency_table);
+
+private:
+    PXR_NS::VtArray<T> m_values;
+    // brush weights accumulated during the stroke, negative for the points the stroke hasn't reached yet
+    std::vector<float> m_scales;
+    std::vector<float> m_weights;
+    std::vector<T> m_scratch;
+};
+
+OPENDCC_NAMESPACE_CLOSE
@@ -0,0 +1,619 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/usd_editor/point_instancer_tool/instance_buffer.h"
+
+#include <pxr/usd/usdGeom/primvarsAPI.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+OPENDCC_NAMESPACE_OPEN
+
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    // element i of the result holds element sources[i] of the array, or default values if it is negative
+    template <class T>
+    bool remap_array(VtValue& value, const std::vector<int64_t>& sources, size_t source_count, size_t element_size)
+    {
+        if (!value.IsHolding<VtArray<T>>())
+            return false;
+
+        const auto& array = value.UncheckedGet<VtArray<T>>();
+        if (array.size() != source_count * element_size)
+            return false;
+
+        VtArray<T> result(sources.size() * element_size);
+        auto dst = result.data();
+        for (size_t i = 0; i < sources.size(); ++i)
+        {
+            if (sources[i] >= 0)
+                std::copy_n(array.cdata() + sources[i] * element_size, element_size, dst + i * element_size);
+        }
+        value = VtValue::Take(result);
+        return true;
+    }
+
+    bool remap_value(VtValue& value, const std::vector<int64_t>& sources, size_t source_count, size_t element_size)
+    {
+        return remap_array<float>(value, sources, source_count, element_size) ||
+               remap_array<GfVec2f>(value, sources, source_count, element_size) ||
+               remap_array<GfVec3f>(value, sources, source_count, element_size) ||
+               remap_array<GfVec4f>(value, sources, source_count, element_size) ||
+               remap_array<int>(value, sources, source_count, element_size) ||
+               remap_array<GfVec2i>(value, sources, source_count, element_size) ||
+               remap_array<GfVec3i>(value, sources, source_count, element_size) ||
+               remap_array<int64_t>(value, sources, source_count, element_size) ||
+               remap_array<double>(value, sources, source_count, element_size) ||
+               remap_array<GfVec2d>(value, sources, source_count, element_size) ||
+               remap_array<GfVec3d>(value, sources, source_count, element_size) ||
+               remap_array<GfVec4d>(value, sources, source_count, element_size) ||
+               remap_array<GfHalf>(value, sources, source_count, element_size) ||
+               remap_array<GfVec3h>(value, sources, source_count, element_size) ||
+               remap_array<GfQuath>(value, sources, source_count, element_size) ||
+               remap_array<GfQuatf>(value, sources, source_count, element_size) ||
+               remap_array<GfMatrix4d>(value, sources, source_count, element_size) ||
+               remap_array<bool>(value, sources, source_count, element_size) ||
+               remap_array<TfToken>(value, sources, source_count, element_size) ||
+               remap_array<std::string>(value, sources, source_count, element_size);
+    }
+};
+
+PointInstancerBuffer::PointInstancerBuffer(float cell_size)
+    : m_cell_size(std::max(cell_size, std::numeric_limits<float>::epsilon()))
+{
+}
+
+void PointInstancerBuffer::read(const UsdGeomPointInstancer& instancer)
+{
+    clear();
+    if (!instancer)
+        return;
+
+    instancer.GetPositionsAttr().Get(&m_synced_positions);
+    instancer.GetProtoIndicesAttr().Get(&m_synced_indices);
+    instancer.GetOrientationsAttr().Get(&m_synced_orientations);
+    instancer.GetScalesAttr().Get(&m_synced_scales);
+
+    const auto count = m_synced_positions.size();
+    const bool has_indices = m_synced_indices.size() == count;
+    const bool has_orientations = m_synced_orientations.size() == count;
+    const bool has_scales = m_synced_scales.size() == count;
+
+    m_chunks.reserve((count + s_chunk_size - 1) / s_chunk_size);
+    for (size_t i = 0; i < count; ++i)
+    {
+        Instance instance;
+        instance.position = m_synced_positions[i];
+        if (has_indices)
+            instance.proto_index = m_synced_indices[i];
+        if (has_orientations)
+            instance.orientation = m_synced_orientations[i];
+        if (has_scales)
+            instance.scale = m_synced_scales[i];
+        add(instance, static_cast<int64_t>(i));
+    }
+    m_source_count = count;
+}
+
+void PointInstancerBuffer::write(const UsdGeomPointInstancer& instancer)
+{
+    if (!instancer)
+        return;
+
+    VtVec3fArray positions(m_size);
+    VtIntArray indices(m_size);
+    VtQuathArray orientations(m_size);
+    VtVec3fArray scales(m_size);
+    std::vector<int64_t> sources(m_size);
+    bool reordered = m_size != m_source_count;
+    for (size_t chunk = 0; chunk < m_chunks.size(); ++chunk)
+    {
+        const auto begin = chunk * s_chunk_size;
+        const auto end = std::min(begin + s_chunk_size, m_size);
+        auto& entries = *m_chunks[chunk];
+        for (size_t i = begin; i < end; ++i)
+        {
+            auto& entry = entries[i - begin];
+            const auto& instance = entry.instance;
+            positions[i] = instance.position;
+            indices[i] = instance.proto_index;
+            orientations[i] = instance.orientation;
+            scales[i] = instance.scale;
+            sources[i] = entry.source;
+            reordered |= entry.source != static_cast<int64_t>(i);
+            // the arrays authored below are the new reference for the next write
+            entry.source = static_cast<int64_t>(i);
+        }
+    }
+
+    if (reordered)
+        write_per_instance_arrays(instancer, sources);
+    m_source_count = m_size;
+
+    instancer.GetPositionsAttr().Set(positions);
+    instancer.GetProtoIndicesAttr().Set(indices);
+    instancer.GetOrientationsAttr().Set(orientations);
+    instancer.GetScalesAttr().Set(scales);
+
+    m_synced_positions = std::move(positions);
+    m_synced_indices = std::move(indices);
+    m_synced_orientations = std::move(orientations);
+    m_synced_scales = std::move(scales);
+}
+
+bool PointInstancerBuffer::is_synced(const UsdGeomPointInstancer& instancer) const
+{
+    if (!instancer)
+        return false;
+
+    // the arrays share their data with the authored values until someone else changes them
+    VtVec3fArray positions;
+    VtIntArray indices;
+    VtQuathArray orientations;
+    VtVec3fArray scales;
+    instancer.GetPositionsAttr().Get(&positions);
+    instancer.GetProtoIndicesAttr().Get(&indices);
+    instancer.GetOrientationsAttr().Get(&orientations);
+    instancer.GetScalesAttr().Get(&scales);
+    return positions.IsIdentical(m_synced_positions) && indices.IsIdentical(m_synced_indices) &&
+           orientations.IsIdentical(m_synced_orientations) && scales.IsIdentical(m_synced_scales);
+}
+
+void PointInstancerBuffer::clear()
+{
+    m_chunks.clear();
+    m_size = 0;
+    m_grid.clear();
+    m_source_count = 0;
+    m_synced_positions = VtVec3fArray();
+    m_synced_indices = VtIntArray();
+    m_synced_orientations = VtQuathArray();
+    m_synced_scales = VtVec3fArray();
+}
+
+void PointInstancerBuffer::set_cell_size(float cell_size)
+{
+    cell_size = std::max(cell_size, std::numeric_limits<float>::epsilon());
+    if (cell_size == m_cell_size)
+        return;
+
+    m_cell_size = cell_size;
+    rebuild_grid();
+}
+
+void PointInstancerBuffer::add(const Instance& instance)
+{
+    add(instance, -1);
+}
+
+void PointInstancerBuffer::add(const Instance& instance, int64_t source)
+{
+    if (m_size == m_chunks.size() * s_chunk_size)
+        m_chunks.push_back(std::make_unique<Chunk>());
+
+    get_mutable(m_size) = Entry { instance, source };
+    insert_to_grid(m_size);
+    ++m_size;
+}
+
+bool PointInstancerBuffer::has_neighbour(const GfVec3f& point, float distance) const
+{
+    return !visit_radius(point, distance, [](size_t) { return false; });
+}
+
+void PointInstancerBuffer::for_each_in_radius(const GfVec3f& center, float radius, const std::function<void(size_t)>& fn) const
+{
+    visit_radius(center, radius, [&fn](size_t index) {
+        fn(index);
+        return true;
+    });
+}
+
+size_t PointInstancerBuffer::erase(const GfVec3f& center, float radius)
+{
+    std::vector<size_t> erased;
+    visit_radius(center, radius, [&erased](size_t index) {
+        erased.push_back(index);
+        return true;
+    });
+
+    // from the back, so that the last instance moved into a freed slot is never one of the erased
+    std::sort(erased.begin(), erased.end(), std::greater<size_t>());
+    for (const auto index : erased)
+    {
+        const auto last = m_size - 1;
+        remove_from_grid(index, get(index).position);
+        if (index != last)
+        {
+            const auto moved = get_entry(last);
+            remove_from_grid(last, moved.instance.position);
+            get_mutable(index) = moved;
+            insert_to_grid(index);
+        }
+        --m_size;
+        if (m_size + s_chunk_size <= m_chunks.size() * s_chunk_size)
+            m_chunks.pop_back();
+    }
+    return erased.size();
+}
+
+void PointInstancerBuffer::write_per_instance_arrays(const UsdGeomPointInstancer& instancer, const std::vector<int64_t>& sources) const
+{
+    VtInt64Array ids;
+    const bool has_ids = instancer.GetIdsAttr().Get(&ids) && ids.size() == m_source_count;
+
+    VtInt64Array invisible_ids;
+    if (instancer.GetInvisibleIdsAttr().Get(&invisible_ids) && !invisible_ids.empty())
+    {
+        // invisibleIds refer to the ids if they are authored and to the instance indices otherwise
+        VtInt64Array remapped;
+        if (has_ids)
+        {
+            std::unordered_set<int64_t> kept;
+            for (const auto source : sources)
+            {
+                if (source >= 0)
+                    kept.insert(ids[source]);
+            }
+            for (const auto id : invisible_ids)
+            {
+                if (kept.count(id))
+                    remapped.push_back(id);
+            }
+        }
+        else
+        {
+            std::vector<int64_t> new_indices(m_source_count, -1);
+            for (size_t i = 0; i < sources.size(); ++i)
+            {
+                if (sources[i] >= 0)
+                    new_indices[sources[i]] = static_cast<int64_t>(i);
+            }
+            for (const auto index : invisible_ids)
+            {
+                if (index >= 0 && static_cast<size_t>(index) < m_source_count && new_indices[index] >= 0)
+                    remapped.push_back(new_indices[index]);
+            }
+        }
+        instancer.GetInvisibleIdsAttr().Set(remapped);
+    }
+
+    if (has_ids)
+    {
+        auto next_id = ids.empty() ? 0 : *std::max_element(ids.cbegin(), ids.cend()) + 1;
+        VtInt64Array new_ids(sources.size());
+        for (size_t i = 0; i < sources.size(); ++i)
+            new_ids[i] = sources[i] >= 0 ? ids[sources[i]] : next_id++;
+        instancer.GetIdsAttr().Set(new_ids);
+    }
+
+    std::vector<UsdAttribute> attributes = { instancer.GetVelocitiesAttr(), instancer.GetAngularVelocitiesAttr() };
+#if PXR_VERSION >= 2105
+    attributes.push_back(instancer.GetAccelerationsAttr());
+#endif
+    for (const auto& attribute : attributes)
+    {
+        VtValue value;
+        if (attribute.Get(&value) && remap_value(value, sources, m_source_count, 1))
+            attribute.Set(value);
+    }
+
+    for (const auto& primvar : UsdGeomPrimvarsAPI(instancer.GetPrim()).GetPrimvars())
+    {
+        const auto interpolation = primvar.GetInterpolation();
+        if (interpolation != UsdGeomTokens->vertex && interpolation != UsdGeomTokens->varying)
+            continue;
+
+        const auto element_size = static_cast<size_t>(std::max(primvar.GetElementSize(), 1));
+        VtValue value;
+        if (primvar.IsIndexed())
+        {
+            VtIntArray primvar_indices;
+            value = primvar.GetIndices(&primvar_indices) ? VtValue(primvar_indices) : VtValue();
+            if (remap_value(value, sources, m_source_count, element_size))
+                primvar.SetIndices(value.UncheckedGet<VtIntArray>());
+        }
+        else if (primvar.Get(&value) && remap_value(value, sources, m_source_count, element_size))
+        {
+            primvar.Set(value);
+        }
+    }
+}
+
+int PointInstancerBuffer::cell_coord(float value) const
+{
+    return static_cast<int>(std::floor(value / m_cell_size));
+}
+
+PointInstancerBuffer::CellKey PointInstancerBuffer::cell_key(const GfVec3f& point) const
+{
+    return cell_key(cell_coord(point[0]), cell_coord(point[1]), cell_coord(point[2]));
+}
+
+/* static */
+PointInstancerBuffer::CellKey PointInstancerBuffer::cell_key(int x, int y, int z)
+{
+    // far away cells may share a key, it only costs extra distance checks
+    const uint64_t mask = (1ull << 21) - 1;
+    return ((static_cast<uint64_t>(x) & mask) << 42) | ((static_cast<uint64_t>(y) & mask) << 21) | (static_cast<uint64_t>(z) & mask);
+}
+
+void PointInstancerBuffer::insert_to_grid(size_t index)
+{
+    m_grid[cell_key(get(index).position)].push_back(static_cast<uint32_t>(index));
+}
+
+void PointInstancerBuffer::remove_from_grid(size_t index, const GfVec3f& position)
+{
+    auto cell = m_grid.find(cell_key(position));
+    if (cell == m_grid.end())
+        return;
+
+    auto& indices = cell->second;
+    auto it = std::find(indices.begin(), indices.end(), static_cast<uint32_t>(index));
+    if (it == indices.end())
+        return;
+
+    *it = indices.back();
+    indices.pop_back();
+    if (indices.empty())
+        m_grid.erase(cell);
+}
+
+void PointInstancerBuffer::rebuild_grid()
+{
+    m_grid.clear();
+    for (size_t i = 0; i < m_size; ++i)
+        insert_to_grid(i);
+}
+
+template <class Fn>
+bool PointInstancerBuffer::visit_radius(const GfVec3f& center, float radius, Fn&& fn) const
+{
+    if (m_size == 0 || radius <= 0)
+        return true;
+
+    const float radius_sq = radius * radius;
+    const int min_x = cell_coord(center[0] - radius), max_x = cell_coord(center[0] + radius);
+    const int min_y = cell_coord(center[1] - radius), max_y = cell_coord(center[1] + radius);
+    const int min_z = cell_coord(center[2] - radius), max_z = cell_coord(center[2] + radius);
+
+    // with a small cell size a large radius covers more cells than there are instances
+    const auto cells_count = static_cast<double>(max_x - min_x + 1) * (max_y - min_y + 1) * (max_z - min_z + 1);
+    if (cells_count > static_cast<double>(m_grid.size()))
+    {
+        for (const auto& cell : m_grid)
+        {
+            for (const auto index : cell.second)
+            {
+                if ((get(index).position - center).GetLengthSq() < radius_sq && !fn(index))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    for (int x = min_x; x <= max_x; ++x)
+    {
+        for (int y = min_y; y <= max_y; ++y)
+        {
+            for (int z = min_z; z <= max_z; ++z)
+            {
+                auto cell = m_grid.find(cell_key(x, y, z));
+                if (cell == m_grid.end())
+                    continue;
+
+                for (const auto index : cell->second)
+                {
+                    if ((get(index).position - center).GetLengthSq() < radius_sq && !fn(index))
+                        return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+
+#include <pxr/usd/usd/stage.h>
+#include <chrono>
+#include <random>
+
+OPENDCC_NAMESPACE_USING
+PXR_NAMESPACE_USING_DIRECTIVE
+
+DOCTEST_TEST_SUITE("PointInstancerBuffer")
+{
+    DOCTEST_TEST_CASE("min_distance_and_erase")
+    {
+        PointInstancerBuffer buffer(0.5f);
+        for (int x = 0; x < 10; ++x)
+        {
+            for (int y = 0; y < 10; ++y)
+            {
+                PointInstancerBuffer::Instance instance;
+                instance.position = GfVec3f(x, y, 0);
+                instance.proto_index = x;
+                buffer.add(instance);
+            }
+        }
+
+        DOCTEST_CHECK(buffer.has_neighbour(GfVec3f(4.6f, 4.6f, 0), 0.6f));
+        DOCTEST_CHECK(!buffer.has_neighbour(GfVec3f(4.5f, 4.5f, 0), 0.6f));
+        DOCTEST_CHECK(!buffer.has_neighbour(GfVec3f(50, 50, 50), 10));
+
+        // the four points around (4.5, 4.5) are closer than 1
+        DOCTEST_CHECK(buffer.erase(GfVec3f(4.5f, 4.5f, 0), 1) == 4);
+        DOCTEST_CHECK(buffer.size() == 96);
+        DOCTEST_CHECK(!buffer.has_neighbour(GfVec3f(4.5f, 4.5f, 0), 0.8f));
+
+        size_t count = 0;
+        buffer.for_each_in_radius(GfVec3f(0), 100, [&count](size_t) { ++count; });
+        DOCTEST_CHECK(count == buffer.size());
+
+        // moved instances are still found after the grid is rebuilt
+        buffer.set_cell_size(3);
+        DOCTEST_CHECK(buffer.erase(GfVec3f(9, 9, 0), 0.1f) == 1);
+        DOCTEST_CHECK(buffer.erase(GfVec3f(0), 100) == 95);
+        DOCTEST_CHECK(buffer.size() == 0);
+    }
+
+    DOCTEST_TEST_CASE("read_write")
+    {
+        auto stage = UsdStage::CreateInMemory();
+        auto instancer = UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+        instancer.GetPositionsAttr().Set(VtVec3fArray { GfVec3f(0), GfVec3f(1) });
+
+        PointInstancerBuffer buffer;
+        buffer.read(instancer);
+        DOCTEST_REQUIRE(buffer.size() == 2);
+        DOCTEST_CHECK(buffer.get(1).position == GfVec3f(1));
+        DOCTEST_CHECK(buffer.get(1).scale == GfVec3f(1));
+
+        PointInstancerBuffer::Instance instance;
+        instance.position = GfVec3f(2);
+        instance.proto_index = 1;
+        buffer.add(instance);
+        buffer.write(instancer);
+        DOCTEST_CHECK(buffer.is_synced(instancer));
+
+        VtIntArray indices;
+        instancer.GetProtoIndicesAttr().Get(&indices);
+        DOCTEST_CHECK(indices == VtIntArray({ 0, 0, 1 }));
+
+        instancer.GetScalesAttr().Set(VtVec3fArray(3, GfVec3f(2)));
+        DOCTEST_CHECK(!buffer.is_synced(instancer));
+    }
+
+    DOCTEST_TEST_CASE("write_reorders_per_instance_arrays")
+    {
+        auto stage = UsdStage::CreateInMemory();
+        auto instancer = UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+        instancer.GetPositionsAttr().Set(VtVec3fArray { GfVec3f(0), GfVec3f(10), GfVec3f(20), GfVec3f(30) });
+        instancer.GetIdsAttr().Set(VtInt64Array { 100, 101, 102, 103 });
+        instancer.GetInvisibleIdsAttr().Set(VtInt64Array { 100, 103 });
+        instancer.GetVelocitiesAttr().Set(VtVec3fArray { GfVec3f(0), GfVec3f(1), GfVec3f(2), GfVec3f(3) });
+        auto primvar = UsdGeomPrimvarsAPI(instancer.GetPrim()).CreatePrimvar(TfToken("weight"), SdfValueTypeNames->FloatArray, UsdGeomTokens->vertex);
+        primvar.Set(VtFloatArray { 0.0f, 0.1f, 0.2f, 0.3f });
+
+        PointInstancerBuffer buffer;
+        buffer.read(instancer);
+        // the last instance takes the place of the first one
+        DOCTEST_REQUIRE(buffer.erase(GfVec3f(0), 1) == 1);
+        PointInstancerBuffer::Instance instance;
+        instance.position = GfVec3f(40);
+        buffer.add(instance);
+        buffer.write(instancer);
+
+        VtVec3fArray positions;
+        instancer.GetPositionsAttr().Get(&positions);
+        DOCTEST_CHECK(positions == VtVec3fArray({ GfVec3f(30), GfVec3f(10), GfVec3f(20), GfVec3f(40) }));
+        VtInt64Array ids;
+        instancer.GetIdsAttr().Get(&ids);
+        DOCTEST_CHECK(ids == VtInt64Array({ 103, 101, 102, 104 }));
+        VtInt64Array invisible_ids;
+        instancer.GetInvisibleIdsAttr().Get(&invisible_ids);
+        DOCTEST_CHECK(invisible_ids == VtInt64Array({ 103 }));
+        VtVec3fArray velocities;
+        instancer.GetVelocitiesAttr().Get(&velocities);
+        DOCTEST_CHECK(velocities == VtVec3fArray({ GfVec3f(3), GfVec3f(1), GfVec3f(2), GfVec3f(0) }));
+        VtFloatArray weights;
+        primvar.Get(&weights);
+        DOCTEST_CHECK(weights == VtFloatArray({ 0.3f, 0.1f, 0.2f, 0.0f }));
+
+        // the next write reorders the arrays authored by the previous one
+        DOCTEST_REQUIRE(buffer.erase(GfVec3f(10), 1) == 1);
+        buffer.write(instancer);
+        instancer.GetIdsAttr().Get(&ids);
+        DOCTEST_CHECK(ids == VtInt64Array({ 103, 104, 102 }));
+        primvar.Get(&weights);
+        DOCTEST_CHECK(weights == VtFloatArray({ 0.3f, 0.0f, 0.2f }));
+    }
+
+    DOCTEST_TEST_CASE("scatter_benchmark")
+    {
+        constexpr size_t instances_count = 1000000;
+        constexpr size_t dab_size = 1000;
+        const float min_distance = 0.25f;
+        std::mt19937 engine(0);
+        std::uniform_real_distribution<float> distribution(0, 1000);
+
+        auto stage = UsdStage::CreateInMemory();
+        auto instancer = UsdGeomPointInstancer::Define(stage, SdfPath("/instancer"));
+
+        PointInstancerBuffer buffer(min_distance);
+        size_t rejected = 0;
+        const auto start = std::chrono::steady_clock::now();
+        while (buffer.size() < instances_count)
+        {
+            for (size_t i = 0; i < dab_size && buffer.size() < instances_count; ++i)
+            {
+                PointInstancerBuffer::Instance instance;
+                instance.position = GfVec3f(distribution(engine), 0, distribution(engine));
+                if (buffer.has_neighbour(instance.position, min_distance))
+                {
+                    ++rejected;
+                    continue;
+                }
+                buffer.add(instance);
+            }
+        }
+        const auto scattered = std::chrono::steady_clock::now();
+        buffer.write(instancer);
+        const auto written = std::chrono::steady_clock::now();
+        size_t erased = 0;
+        for (int i = 0; i < 1000; ++i)
+            erased += buffer.erase(GfVec3f(distribution(engine), 0, distribution(engine)), 2);
+        const auto end = std::chrono::steady_clock::now();
+
+        VtVec3fArray positions;
+        instancer.GetPositionsAttr().Get(&positions);
+        DOCTEST_CHECK(positions.size() == instances_count);
+
+        using ms = std::chrono::duration<double, std::milli>;
+        DOCTEST_MESSAGE("scattered " << instances_count << " instances (" << rejected << " rejected) in " << ms(scattered - start).count()
+                                     << " ms, authored in " << ms(written - scattered).count() << " ms, erased " << erased << " in 1000 dabs in "
+                                     << ms(end - written).count() << " ms");
+
+        // the previous approach, every dab reads and authors the whole arrays
+        constexpr size_t legacy_count = 50000;
+        auto legacy_instancer = UsdGeomPointInstancer::Define(stage, SdfPath("/legacy"));
+        const auto legacy_start = std::chrono::steady_clock::now();
+        for (size_t dab = 0; dab < legacy_count / dab_size; ++dab)
+        {
+            VtVec3fArray points;
+            legacy_instancer.GetPositionsAttr().Get(&points);
+            VtIntArray indices;
+            legacy_instancer.GetProtoIndicesAttr().Get(&indices);
+            VtQuathArray orientations;
+            legacy_instancer.GetOrientationsAttr().Get(&orientations);
+            VtVec3fArray scales;
+            legacy_instancer.GetScalesAttr().Get(&scales);
+            for (size_t i = 0; i < dab_size; ++i)
+            {
+                points.push_back(GfVec3f(distribution(engine), 0, distribution(engine)));
+                indices.push_back(0);
+                orientations.push_back(GfQuath::GetIdentity());
+                scales.push_back(GfVec3f(1));
+            }
+            legacy_instancer.GetPositionsAttr().Set(points);
+            legacy_instancer.GetProtoIndicesAttr().Set(indices);
+            legacy_instancer.GetOrientationsAttr().Set(orientations);
+            legacy_instancer.GetScalesAttr().Set(scales);
+        }
+        DOCTEST_MESSAGE("per dab authoring of " << legacy_count << " instances: "
+                                                << ms(std::chrono::steady_clock::now() - legacy_start).count() << " ms");
+    }
+}
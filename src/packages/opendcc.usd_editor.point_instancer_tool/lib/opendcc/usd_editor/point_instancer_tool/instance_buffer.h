@@ -0,0 +1,106 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+#include "opendcc/opendcc.h"
+#include <pxr/base/gf/quath.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/vt/array.h>
+#include <pxr/base/vt/types.h>
+#include <pxr/usd/usdGeom/pointInstancer.h>
+#include <array>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Working copy of the point instancer arrays edited by the brush.
+ *
+ * Instances are stored in fixed size chunks, so adding an instance never moves the existing ones,
+ * and are indexed by a uniform grid, so distance queries only visit the cells around the query point.
+ * Erased instances are replaced by the last one, the order of the instances isn't preserved. Every instance remembers
+ * where it was in the authored arrays, so write() reorders the other per-instance arrays the same way.
+ */
+class PointInstancerBuffer
+{
+public:
+    struct Instance
+    {
+        PXR_NS::GfVec3f position = PXR_NS::GfVec3f(0);
+        int proto_index = 0;
+        PXR_NS::GfQuath orientation = PXR_NS::GfQuath::GetIdentity();
+        PXR_NS::GfVec3f scale = PXR_NS::GfVec3f(1);
+    };
+
+    PointInstancerBuffer(float cell_size = 1.0f);
+
+    // reads positions, protoIndices, orientations and scales, missing or mismatching arrays are filled with defaults
+    void read(const PXR_NS::UsdGeomPointInstancer& instancer);
+    // authors all four arrays at the default time, ids, velocities, invisibleIds and vertex or varying primvars
+    // are reordered to match the instances, added instances get new ids and default values
+    void write(const PXR_NS::UsdGeomPointInstancer& instancer);
+    // true if the instancer arrays are still the ones read or written last time
+    bool is_synced(const PXR_NS::UsdGeomPointInstancer& instancer) const;
+    void clear();
+
+    size_t size() const { return m_size; }
+    const Instance& get(size_t index) const { return get_entry(index).instance; }
+
+    // rebuilds the grid if the size changes, queries are the fastest with the cell size close to their radius
+    void set_cell_size(float cell_size);
+    float get_cell_size() const { return m_cell_size; }
+
+    void add(const Instance& instance);
+    // true if there is an instance closer than distance to point
+    bool has_neighbour(const PXR_NS::GfVec3f& point, float distance) const;
+    // calls fn with the index of every instance closer than radius to center
+    void for_each_in_radius(const PXR_NS::GfVec3f& center, float radius, const std::function<void(size_t)>& fn) const;
+    // removes the instances closer than radius to center, returns their count
+    size_t erase(const PXR_NS::GfVec3f& center, float radius);
+
+private:
+    static constexpr size_t s_chunk_size = 4096;
+    struct Entry
+    {
+        Instance instance;
+        // index in the authored arrays, -1 for the instances added after the last read or write
+        int64_t source = -1;
+    };
+    using Chunk = std::array<Entry, s_chunk_size>;
+    using CellKey = uint64_t;
+    struct CellKeyHash
+    {
+        size_t operator()(CellKey key) const { return static_cast<size_t>((key ^ (key >> 29)) * 0xbf58476d1ce4e5b9ull); }
+    };
+
+    const Entry& get_entry(size_t index) const { return (*m_chunks[index / s_chunk_size])[index % s_chunk_size]; }
+    Entry& get_mutable(size_t index) { return (*m_chunks[index / s_chunk_size])[index % s_chunk_size]; }
+    void add(const Instance& instance, int64_t source);
+    void write_per_instance_arrays(const PXR_NS::UsdGeomPointInstancer& instancer, const std::vector<int64_t>& sources) const;
+    int cell_coord(float value) const;
+    CellKey cell_key(const PXR_NS::GfVec3f& point) const;
+    static CellKey cell_key(int x, int y, int z);
+    void insert_to_grid(size_t index);
+    void remove_from_grid(size_t index, const PXR_NS::GfVec3f& position);
+    void rebuild_grid();
+    template <class Fn>
+    bool visit_radius(const PXR_NS::GfVec3f& center, float radius, Fn&& fn) const;
+
+    std::vector<std::unique_ptr<Chunk>> m_chunks;
+    size_t m_size = 0;
+    size_t m_source_count = 0;
+    float m_cell_size = 1.0f;
+    std::unordered_map<CellKey, std::vector<uint32_t>, CellKeyHash> m_grid;
+
+    PXR_NS::VtVec3fArray m_synced_positions;
+    PXR_NS::VtIntArray m_synced_indices;
+    PXR_NS::VtQuathArray m_synced_orientations;
+    PXR_NS::VtVec3fArray m_synced_scales;
+};
+
+OPENDCC_NAMESPACE_CLOSE
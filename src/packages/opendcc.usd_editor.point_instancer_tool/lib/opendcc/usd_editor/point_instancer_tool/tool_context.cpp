@@ -53,6 +53,9 @@ namespace
 
 void PointInstancerToolContext::update_context()
 {
+    end_stroke();
+    m_buffer.clear();
+
     auto stage = Application::instance().get_session()->get_current_stage();
     if (!stage)
         return;
@@ -153,6 +156,10 @@ std::vector<Imath::V2f> PointInstancerToolContext::generate_uv()
     {
         return { Imath::V2f(0, 0) };
     }
+    if (m_properties.mode == Mode::Erase)
+    {
+        return {};
+    }
     for (size_t i = 0; i < num_points; ++i)
     {
         float u = 2 * (float_distribution(m_rand_engine) - 0.5f);
@@ -266,6 +273,7 @@ PointInstancerToolContext::PointInstancerToolContext()
 
 PointInstancerToolContext::~PointInstancerToolContext()
 {
+    end_stroke();
     Application::instance().unregister_event_callback(Application::EventType::SELECTION_CHANGED, m_selection_event_hndl);
     delete m_cursor;
 }
@@ -406,43 +414,88 @@ bool PointInstancerToolContext::on_mouse_press(const ViewportMouseEvent& mouse_e
     if (!m_is_intersect)
         return false;
 
-    VtVec3fArray new_points;
-    VtQuathArray new_orientations;
-    VtVec3fArray new_scales;
-    generate(new_points, new_orientations, new_scales);
-    if (new_points.size() > 0)
-    {
-        commands::UsdEditsUndoBlock block;
+    begin_stroke();
+    apply_dab();
+    return true;
+}
 
-        VtVec3fArray points;
-        m_instancer.GetPositionsAttr().Get(&points);
+void PointInstancerToolContext::begin_stroke()
+{
+    // the buffer is kept between strokes unless the instancer was changed by something else, e.g. undo
+    if (!m_buffer.is_synced(m_instancer))
+        m_buffer.read(m_instancer);
+
+    // the grid cell matches the distance queries of the stroke
+    if (m_properties.mode == Mode::Erase)
+        m_buffer.set_cell_size(m_properties.radius * 0.5f);
+    else if (m_properties.min_distance > 0)
+        m_buffer.set_cell_size(m_properties.min_distance);
+    else
+        m_buffer.set_cell_size(m_properties.radius);
 
-        VtIntArray indices;
-        m_instancer.GetProtoIndicesAttr().Get(&indices);
-        VtQuathArray orientations;
-        m_instancer.GetOrientationsAttr().Get(&orientations);
-        VtVec3fArray scales;
-        m_instancer.GetScalesAttr().Get(&scales);
+    m_is_painting = true;
+    m_buffer_changed = false;
+    m_last_write_time = std::chrono::steady_clock::now();
+}
+
+void PointInstancerToolContext::apply_dab()
+{
+    m_last_dab_p = m_p;
 
+    if (m_properties.mode == Mode::Erase)
+    {
+        if (m_buffer.erase(GfVec3f(m_p.x, m_p.y, m_p.z), m_properties.radius) > 0)
+            m_buffer_changed = true;
+    }
+    else
+    {
+        VtVec3fArray new_points;
+        VtQuathArray new_orientations;
+        VtVec3fArray new_scales;
+        generate(new_points, new_orientations, new_scales);
         for (size_t i = 0; i < new_points.size(); ++i)
         {
-            points.push_back(new_points[i]);
-            indices.push_back(m_properties.current_proto_idx);
-            orientations.push_back(new_orientations[i]);
-            scales.push_back(new_scales[i]);
+            // also rejects points too close to the ones added by this dab
+            if (m_properties.min_distance > 0 && m_buffer.has_neighbour(new_points[i], m_properties.min_distance))
+                continue;
+
+            PointInstancerBuffer::Instance instance;
+            instance.position = new_points[i];
+            instance.proto_index = m_properties.current_proto_idx;
+            instance.orientation = new_orientations[i];
+            instance.scale = new_scales[i];
+            m_buffer.add(instance);
+            m_buffer_changed = true;
         }
+        m_generated_uv = generate_uv();
+    }
 
-        m_instancer.GetPositionsAttr().Set(points);
-        m_instancer.GetProtoIndicesAttr().Set(indices);
-        m_instancer.GetOrientationsAttr().Set(orientations);
-        m_instancer.GetScalesAttr().Set(scales);
+    if (m_buffer_changed && std::chrono::steady_clock::now() - m_last_write_time >= s_write_interval)
+        write_instances();
+}
 
-        for (const auto& viewport : ViewportWidget::get_live_widgets())
-            viewport->get_gl_widget()->get_engine()->set_selected(Application::instance().get_selection(),
-                                                                  Application::instance().get_rich_selection());
-    }
+void PointInstancerToolContext::write_instances()
+{
+    if (!m_undo_block)
+        m_undo_block = std::make_unique<commands::UsdEditsUndoBlock>();
 
-    return true;
+    m_buffer.write(m_instancer);
+    m_buffer_changed = false;
+    m_last_write_time = std::chrono::steady_clock::now();
+
+    for (const auto& viewport : ViewportWidget::get_live_widgets())
+        viewport->get_gl_widget()->get_engine()->set_selected(Application::instance().get_selection(), Application::instance().get_rich_selection());
+}
+
+void PointInstancerToolContext::end_stroke()
+{
+    if (!m_is_painting)
+        return;
+
+    if (m_buffer_changed)
+        write_instances();
+    m_undo_block.reset();
+    m_is_painting = false;
 }
 
 bool PointInstancerToolContext::on_mouse_move(const ViewportMouseEvent& mouse_event, const ViewportViewPtr& viewport_view,
@@ -501,12 +554,17 @@ bool PointInstancerToolContext::on_mouse_move(const ViewportMouseEvent& mouse_ev
         }
     }
 
+    // Single places one instance per click, the other modes paint while dragging with dabs spaced by half of the radius
+    if (m_is_painting && m_is_intersect && m_properties.mode != Mode::Single && (m_p - m_last_dab_p).length() >= m_properties.radius * 0.5f)
+        apply_dab();
+
     return true;
 }
 
 bool PointInstancerToolContext::on_mouse_release(const ViewportMouseEvent& mouse_event, const ViewportViewPtr& viewport_view,
                                                  ViewportUiDrawManager* draw_manager)
 {
+    end_stroke();
     m_generated_uv = generate_uv();
     is_adjust_radius = false;
     return true;
@@ -529,6 +587,7 @@ void PointInstancerToolContext::Properties::read_from_settings(const std::string
     density = settings->get(prefix + ".density", 1.0f);
     radius = settings->get(prefix + ".radius", 1.0f);
     falloff = settings->get(prefix + ".falloff", 0.3f);
+    min_distance = settings->get(prefix + ".min_distance", 0.0f);
     rotate_to_normal = settings->get(prefix + ".rotate_to_normal", false);
     mode = settings->get(prefix + ".mode", Mode::Random);
 }
@@ -550,6 +609,7 @@ void PointInstancerToolContext::Properties::write_to_settings(const std::string&
     settings->set(prefix + ".density", density);
     settings->set(prefix + ".radius", radius);
     settings->set(prefix + ".falloff", falloff);
+    settings->set(prefix + ".min_distance", min_distance);
     settings->set(prefix + ".rotate_to_normal", rotate_to_normal);
     settings->set(prefix + ".mode", (int)mode);
 }
@@ -13,6 +13,9 @@
 #include <ImathVec.h>
 #include "pxr/usd/usdGeom/pointInstancer.h"
 #include "opendcc/app/core/mesh_bvh.h"
+#include "opendcc/app/core/undo/block.h"
+#include "opendcc/usd_editor/point_instancer_tool/instance_buffer.h"
+#include <chrono>
 #include <random>
 
 OPENDCC_NAMESPACE_OPEN
@@ -23,7 +26,8 @@ public:
     enum class Mode
     {
         Single = 0,
-        Random = 1
+        Random = 1,
+        Erase = 2
     };
 
     struct Properties
@@ -38,6 +42,8 @@ public:
         float density = 1;
         float radius = 1;
         float falloff = 0.3;
+        // new instances closer than this to the existing ones are skipped, 0 disables the check
+        float min_distance = 0;
         bool rotate_to_normal = false;
         Mode mode = Mode::Random;
         void read_from_settings(const std::string& prefix);
@@ -80,6 +86,11 @@ private:
 
     void generate(PXR_NS::VtVec3fArray& new_points, PXR_NS::VtQuathArray& new_orientations, PXR_NS::VtVec3fArray& new_scales);
 
+    void begin_stroke();
+    void apply_dab();
+    void write_instances();
+    void end_stroke();
+
     static bool s_factory_registration;
     Application::CallbackHandle m_selection_event_hndl;
     PXR_NS::UsdGeomPointInstancer m_instancer;
@@ -98,6 +109,15 @@ private:
     std::vector<Imath::V2f> m_generated_uv;
     static const uint32_t points_in_unit_radius = 50;
 
+    // the instances are edited in the buffer during a stroke and authored at most once per write interval
+    PointInstancerBuffer m_buffer;
+    std::unique_ptr<commands::UsdEditsUndoBlock> m_undo_block;
+    bool m_is_painting = false;
+    bool m_buffer_changed = false;
+    Imath::V3f m_last_dab_p;
+    std::chrono::steady_clock::time_point m_last_write_time;
+    static constexpr std::chrono::milliseconds s_write_interval { 100 };
+
     QCursor* m_cursor = nullptr;
 };
 
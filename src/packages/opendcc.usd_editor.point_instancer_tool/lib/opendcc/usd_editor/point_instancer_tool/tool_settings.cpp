@@ -110,6 +110,7 @@ PointInstancerToolSettingsWidget::PointInstancerToolSettingsWidget(PointInstance
         mode_combo_box->setSizePolicy(QSizePolicy::Maximum, QSizePolicy::Minimum);
         mode_combo_box->addItem(i18n("tool_settings.PointInstancer", "One"));
         mode_combo_box->addItem(i18n("tool_settings.PointInstancer", "RandomInRadius"));
+        mode_combo_box->addItem(i18n("tool_settings.PointInstancer", "Erase"));
         mode_combo_box->setCurrentIndex((int)tool_context->properties().mode);
 
         connect(mode_combo_box, (void(QComboBox::*)(int)) & QComboBox::currentIndexChanged, this, [tool_context, this](int i) {
@@ -352,6 +353,24 @@ PointInstancerToolSettingsWidget::PointInstancerToolSettingsWidget(PointInstance
                                   Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter);
         options_layout->addWidget(falloff_widget, current_layout_line++, 1);
     }
+    {
+        auto min_distance_widget = new FloatValueWidget(0.0f, FLT_MAX, 2);
+        min_distance_widget->set_clamp_minimum(0.f);
+        min_distance_widget->set_soft_range(0.f, 10);
+        min_distance_widget->set_value((double)tool_context->properties().min_distance);
+        min_distance_widget->setEnabled(true);
+        connect(min_distance_widget, &FloatValueWidget::editing_finished, this, [tool_context, min_distance_widget] {
+            if (tool_context)
+            {
+                auto properties = tool_context->properties();
+                properties.min_distance = min_distance_widget->get_value();
+                tool_context->set_properties(properties);
+            }
+        });
+        options_layout->addWidget(new QLabel(i18n("tool_settings.PointInstancer", "Min Distance") + ": "), current_layout_line, 0,
+                                  Qt::AlignmentFlag::AlignRight | Qt::AlignmentFlag::AlignVCenter);
+        options_layout->addWidget(min_distance_widget, current_layout_line++, 1);
+    }
 
     {
         auto settings = Application::instance().get_settings();
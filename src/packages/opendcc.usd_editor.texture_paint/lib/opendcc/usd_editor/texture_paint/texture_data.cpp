@@ -55,7 +55,7 @@ std::unique_ptr<ImageData> ImageData::make_image(const std::string& file, uint32
     }
 
     const auto tex_name = udim_index == 0 ? "texblock://painted_texture.wtex" : "texblock://painted_texture_" + std::to_string(udim_index) + ".wtex";
-    InMemoryTextureRegistry::instance().add_texture(tex_name, img_buf);
+    result->mip_texture = InMemoryTextureRegistry::instance().add_texture(tex_name, img_buf);
     result->texture_buffer = img_buf;
     result->size = result->texture_buffer->spec().image_bytes();
     result->dims = GfVec2i(spec.width, spec.height);
@@ -63,19 +63,9 @@ std::unique_ptr<ImageData> ImageData::make_image(const std::string& file, uint32
     result->texture_file = file;
     result->udim_index = udim_index;
 
-    result->shared_px_data.resize(spec.width * spec.height);
-    for (int y = 0; y < result->dims[1]; ++y)
-    {
-        for (int x = 0; x < result->dims[0]; ++x)
-        {
-            const auto ind = y * spec.width + x;
-            auto& px_data = result->shared_px_data[ind];
-            px_data.img_data = result.get();
-            result->texture_buffer->getpixel(x, y, px_data.orig_color.data());
-            px_data.x = x;
-            px_data.y = y;
-        }
-    }
+    result->tiles_x = (spec.width + SharedPixelTile::s_size - 1) / SharedPixelTile::s_size;
+    result->tiles_y = (spec.height + SharedPixelTile::s_size - 1) / SharedPixelTile::s_size;
+    result->px_tiles.reset(new std::atomic<SharedPixelTile*>[size_t(result->tiles_x) * result->tiles_y]());
 
     return result;
 }
@@ -84,6 +74,51 @@ ImageData::~ImageData()
 {
     if (writing_worker.joinable())
         writing_worker.join();
+    release_pixel_data();
+}
+
+SharedPixelData* ImageData::get_pixel_data(int x, int y)
+{
+    const int tile_x = x / SharedPixelTile::s_size;
+    const int tile_y = y / SharedPixelTile::s_size;
+    auto& slot = px_tiles[size_t(tile_y) * tiles_x + tile_x];
+    auto tile = slot.load(std::memory_order_acquire);
+    if (!tile)
+    {
+        auto new_tile = std::make_unique<SharedPixelTile>();
+        const int x_begin = tile_x * SharedPixelTile::s_size;
+        const int y_begin = tile_y * SharedPixelTile::s_size;
+        for (int py = 0; py < SharedPixelTile::s_size; ++py)
+        {
+            for (int px = 0; px < SharedPixelTile::s_size; ++px)
+            {
+                auto& px_data = new_tile->pixels[py * SharedPixelTile::s_size + px];
+                px_data.img_data = this;
+                px_data.x = x_begin + px;
+                px_data.y = y_begin + py;
+                if (px_data.x < dims[0] && px_data.y < dims[1])
+                    texture_buffer->getpixel(px_data.x, px_data.y, px_data.orig_color.data());
+            }
+        }
+
+        // another painting thread may have allocated the same tile in the meantime
+        if (slot.compare_exchange_strong(tile, new_tile.get(), std::memory_order_acq_rel))
+            tile = new_tile.release();
+    }
+    return &tile->pixels[(y - tile_y * SharedPixelTile::s_size) * SharedPixelTile::s_size + (x - tile_x * SharedPixelTile::s_size)];
+}
+
+SharedPixelTile* ImageData::get_pixel_tile(int tile_x, int tile_y) const
+{
+    return px_tiles[size_t(tile_y) * tiles_x + tile_x].load(std::memory_order_acquire);
+}
+
+void ImageData::release_pixel_data()
+{
+    if (!px_tiles)
+        return;
+    for (size_t i = 0; i < size_t(tiles_x) * tiles_y; ++i)
+        delete px_tiles[i].exchange(nullptr);
 }
 
 void ImageData::write()
@@ -187,15 +222,9 @@ void TextureData::flush()
 
 void TextureData::invalidate()
 {
+    // pixel state is recreated lazily from the current texture on the next access
     for (auto& img : m_image_data)
-    {
-        for (auto& px_data : img.second->shared_px_data)
-        {
-            px_data.img_data->texture_buffer->getpixel(px_data.x, px_data.y, px_data.orig_color.data());
-            px_data.influence = 0.0f;
-            px_data.touched = false;
-        }
-    }
+        img.second->release_pixel_data();
 }
 
 void TextureData::clear()
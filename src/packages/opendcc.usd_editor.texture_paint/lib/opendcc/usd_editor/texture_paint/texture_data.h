@@ -11,9 +11,12 @@
 #include <pxr/imaging/hio/image.h>
 #include <pxr/imaging/hgi/types.h>
 #include <OpenImageIO/imagebuf.h>
+#include <atomic>
+#include <memory>
 
 OPENDCC_NAMESPACE_OPEN
 
+class InMemoryMipmappedTexture;
 struct ImageData;
 struct SharedPixelData
 {
@@ -24,11 +27,22 @@ struct SharedPixelData
     int y = -1;
     bool touched = false;
 };
+struct SharedPixelTile
+{
+    static constexpr int s_size = 64;
+    SharedPixelData pixels[s_size * s_size];
+};
 struct ImageData
 {
     std::string texture_file;
     std::shared_ptr<OIIO::ImageBuf> texture_buffer;
-    std::vector<SharedPixelData> shared_px_data;
+    // viewport representation of texture_buffer, painted pixels must be reported to it
+    std::shared_ptr<InMemoryMipmappedTexture> mip_texture;
+    // Pixel bookkeeping is allocated per tile on first access, so its memory follows the painted area
+    // rather than the texture resolution.
+    std::unique_ptr<std::atomic<SharedPixelTile*>[]> px_tiles;
+    int tiles_x = 0;
+    int tiles_y = 0;
     OIIO::TypeDesc src_descr;
     PXR_NS::GfVec2i dims;
     int src_channels;
@@ -43,6 +57,11 @@ struct ImageData
 
     ~ImageData();
     void write();
+    // Thread-safe, allocates the tile containing the pixel on demand.
+    SharedPixelData* get_pixel_data(int x, int y);
+    // Returns nullptr if the tile was not accessed since the last release_pixel_data call.
+    SharedPixelTile* get_pixel_tile(int tile_x, int tile_y) const;
+    void release_pixel_data();
     static std::unique_ptr<ImageData> make_image(const std::string& file, uint32_t udim_index = 0);
 };
 
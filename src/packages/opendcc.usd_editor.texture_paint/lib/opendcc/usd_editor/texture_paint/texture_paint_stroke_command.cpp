@@ -7,12 +7,14 @@
 #include "opendcc/usd_editor/texture_paint/texture_paint_tool_context.h"
 #include "OpenImageIO/imagebufalgo.h"
 #include "opendcc/app/ui/application_ui.h"
+#include "opendcc/app/viewport/texture_plugin.h"
+#include "opendcc/usd_editor/texture_paint/texture_data.h"
 
 OPENDCC_NAMESPACE_OPEN
 PXR_NAMESPACE_USING_DIRECTIVE
 using namespace OIIO;
 
-TexturePaintStrokeCommand::TexturePaintStrokeCommand(const TextureData& texture_data, const TexturePainter& painter, bool write_to_files)
+TexturePaintStrokeCommand::TexturePaintStrokeCommand(const TextureData& texture_data, bool write_to_files)
 {
     m_command_name = "texture_paint_stroke";
     m_dims = texture_data.get_dimensions();
@@ -22,22 +24,54 @@ TexturePaintStrokeCommand::TexturePaintStrokeCommand(const TextureData& texture_
         m_src_descr = tile.second->src_descr;
         m_src_channels = tile.second->src_channels;
         m_img_spec = tile.second->texture_buffer->spec();
-        m_texture_buffers[tile.first] = { std::weak_ptr<OIIO::ImageBuf>(tile.second->texture_buffer), tile.second->texture_file };
+        m_texture_buffers[tile.first] = { std::weak_ptr<OIIO::ImageBuf>(tile.second->texture_buffer),
+                                          std::weak_ptr<InMemoryMipmappedTexture>(tile.second->mip_texture), tile.second->texture_file };
     }
-    for (const auto& b : painter.m_paint_buckets)
+    // only tiles allocated by the painter can contain touched pixels
+    for (const auto& tile : texture_data.get_image_data())
     {
-        for (const auto& p : b.pixels)
+        const auto& img_data = *tile.second;
+        const auto& spec = img_data.texture_buffer->spec();
+        for (int tile_y = 0; tile_y < img_data.tiles_y; ++tile_y)
         {
-            const auto px_data = p.pixel_data;
-            if (!px_data->touched)
-                continue;
-            TexturePaintStrokeCommand::PixelInfo pi;
-            pi.orig_color = px_data->orig_color;
-            px_data->img_data->texture_buffer->getpixel(px_data->x, px_data->y, pi.new_color.data());
-            pi.tile_id = px_data->img_data->udim_index;
-            pi.x = px_data->x;
-            pi.y = px_data->y;
-            m_pixels.emplace_back(pi);
+            for (int tile_x = 0; tile_x < img_data.tiles_x; ++tile_x)
+            {
+                const auto px_tile = img_data.get_pixel_tile(tile_x, tile_y);
+                if (!px_tile)
+                    continue;
+
+                const auto x_begin = tile_x * SharedPixelTile::s_size;
+                const auto y_begin = tile_y * SharedPixelTile::s_size;
+                const ROI roi(x_begin, std::min(x_begin + SharedPixelTile::s_size, spec.width), y_begin,
+                              std::min(y_begin + SharedPixelTile::s_size, spec.height), 0, 1, 0, spec.nchannels);
+                ImageBuf tile_buf(ImageSpec(roi.width(), roi.height(), spec.nchannels, spec.format));
+                img_data.texture_buffer->get_pixels(roi, spec.format, tile_buf.localpixels());
+
+                bool touched = false;
+                for (int y = 0; y < roi.height(); ++y)
+                {
+                    for (int x = 0; x < roi.width(); ++x)
+                    {
+                        const auto& px_data = px_tile->pixels[y * SharedPixelTile::s_size + x];
+                        if (!px_data.touched)
+                            continue;
+                        if (!touched)
+                        {
+                            m_tiles.emplace_back();
+                            m_tiles.back().after = qCompress(static_cast<const uchar*>(tile_buf.localpixels()), int(roi.npixels() * spec.pixel_bytes()));
+                            touched = true;
+                        }
+                        tile_buf.setpixel(x, y, px_data.orig_color.data());
+                    }
+                }
+                if (!touched)
+                    continue;
+
+                auto& snapshot = m_tiles.back();
+                snapshot.roi = roi;
+                snapshot.tile_id = img_data.udim_index;
+                snapshot.before = qCompress(static_cast<const uchar*>(tile_buf.localpixels()), int(roi.npixels() * spec.pixel_bytes()));
+            }
         }
     }
 }
@@ -118,18 +152,22 @@ void TexturePaintStrokeCommand::exec(bool undo) const
         }
     }
 
-    for (const auto& px : m_pixels)
+    for (const auto& tile : m_tiles)
     {
-        const auto& tex_buf = m_texture_buffers.at(px.tile_id);
-        if (!tex_buf.buf.expired())
+        const auto& tex_buf = m_texture_buffers.at(tile.tile_id);
+        const auto pixels = qUncompress(undo ? tile.before : tile.after);
+        if (auto buf = tex_buf.buf.lock())
         {
-            tex_buf.buf.lock()->setpixel(px.x, px.y, undo ? px.orig_color.data() : px.new_color.data());
+            buf->set_pixels(tile.roi, m_img_spec.format, pixels.constData());
+            if (auto mip_texture = tex_buf.mip_texture.lock())
+                mip_texture->mark_dirty(tile.roi);
             dirty_viewport = true;
         }
         if (m_write_to_files)
         {
             auto& file_buf = file_buffers[tex_buf.file];
-            file_buf.img_buf.setpixel(px.x, px.y, undo ? px.orig_color.data() : px.new_color.data());
+            if (file_buf.img_buf.initialized())
+                file_buf.img_buf.set_pixels(tile.roi, m_img_spec.format, pixels.constData());
         }
     }
 
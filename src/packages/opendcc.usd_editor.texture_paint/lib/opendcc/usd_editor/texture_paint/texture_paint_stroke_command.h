@@ -11,17 +11,18 @@
 #include <pxr/base/gf/vec2i.h>
 #include "OpenImageIO/imagebuf.h"
 #include "OpenImageIO/typedesc.h"
+#include <QByteArray>
 
 OPENDCC_NAMESPACE_OPEN
+class InMemoryMipmappedTexture;
 class TextureData;
-class TexturePainter;
 
 class TexturePaintStrokeCommand
     : public UndoCommand
     , public ToolCommand
 {
 public:
-    TexturePaintStrokeCommand(const TextureData& texture_data, const TexturePainter& painter, bool write_to_files);
+    TexturePaintStrokeCommand(const TextureData& texture_data, bool write_to_files);
     void undo() override;
     void redo() override;
 
@@ -31,21 +32,22 @@ public:
 private:
     void exec(bool undo) const;
 
-    struct PixelInfo
+    // Compressed native-format pixels of a touched 64x64 region before and after the stroke
+    struct TileSnapshot
     {
-        PXR_NS::GfVec4f orig_color;
-        PXR_NS::GfVec4f new_color;
+        OIIO::ROI roi;
+        QByteArray before;
+        QByteArray after;
         int tile_id = 0;
-        int x = 0;
-        int y = 0;
     };
     struct TextureBuffer
     {
         std::weak_ptr<OIIO::ImageBuf> buf;
+        std::weak_ptr<InMemoryMipmappedTexture> mip_texture;
         std::string file;
     };
 
-    std::vector<PixelInfo> m_pixels;
+    std::vector<TileSnapshot> m_tiles;
     std::unordered_map<int, TextureBuffer> m_texture_buffers;
     OIIO::ImageSpec m_img_spec;
     PXR_NS::GfVec2i m_dims;
@@ -167,7 +167,7 @@ void TexturePaintToolContext::push_command()
     if (!m_texture_data)
         return;
 
-    auto cmd = std::make_shared<TexturePaintStrokeCommand>(*m_texture_data.get(), *m_texture_painter.get(), m_writing_to_file);
+    auto cmd = std::make_shared<TexturePaintStrokeCommand>(*m_texture_data.get(), m_writing_to_file);
     CommandInterface::finalize(cmd);
 }
 
@@ -3,6 +3,7 @@
 
 #include "opendcc/usd_editor/texture_paint/texture_painter.h"
 #include "opendcc/app/viewport/viewport_manipulator_utils.h"
+#include "opendcc/app/viewport/texture_plugin.h"
 #include <igl/boundary_loop.h>
 #include "tbb/task_group.h"
 #include "math_utils.h"
@@ -490,10 +491,8 @@ void TexturePainter::add_pixels_from_poly_bounds(const GfRect2i& bounds, int tri
                 const auto wrapped_x = GfClamp(x, 0.0, m_image_size[0] - 1);
                 const auto wrapped_y = GfClamp(y, 0.0, m_image_size[1] - 1);
 
-                const auto px_ind = size_t(wrapped_y) * m_image_size[0] + wrapped_x;
-
                 PixelInfo pix_info;
-                pix_info.pixel_data = &img_data->shared_px_data[px_ind];
+                pix_info.pixel_data = img_data->get_pixel_data(wrapped_x, wrapped_y);
                 pix_info.ss = GfVec2f(screen_coord[0], screen_coord[1]);
                 pix_info.tri_id = tri_id;
                 paint_bucket.pixels.push_back(std::move(pix_info));
@@ -546,10 +545,8 @@ void TexturePainter::add_pixels_from_seam_bounds(const GfRect2i& bounds, int tri
                 const auto wrapped_x = GfClamp(x, 0.0, m_image_size[0] - 1);
                 const auto wrapped_y = GfClamp(y, 0.0, m_image_size[1] - 1);
 
-                const auto px_ind = size_t(wrapped_y) * m_image_size[0] + wrapped_x;
-
                 PixelInfo pix_info;
-                pix_info.pixel_data = &img_data->shared_px_data[px_ind]; // shared_px_data[size_t(wrapped_y) * image_size[0] + wrapped_x];
+                pix_info.pixel_data = img_data->get_pixel_data(wrapped_x, wrapped_y);
                 pix_info.ss = GfVec2f(screen_coord[0], screen_coord[1]);
                 pix_info.tri_id = tri_id;
                 paint_bucket.pixels.push_back(std::move(pix_info));
@@ -686,6 +683,7 @@ void TexturePainter::draw_pixels(PaintBucket& bucket)
         pixel_color[3] = GfLerp(influence, px_data->orig_color[3], m_brush_color[3]);
 
         px_data->img_data->texture_buffer->setpixel(px_data->x, px_data->y, pixel_color);
+        px_data->img_data->mip_texture->mark_dirty(px_data->x, px_data->y);
         px_data->touched = true;
         px_data->img_data->dirty = true;
     }
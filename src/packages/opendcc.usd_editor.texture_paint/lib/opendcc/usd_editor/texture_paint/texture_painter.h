@@ -27,7 +27,6 @@ public:
     bool is_valid() const;
 
 private:
-    friend class TexturePaintStrokeCommand;
     struct PixelInfo
     {
         SharedPixelData* pixel_data = nullptr;
@@ -0,0 +1,334 @@
+// Copyright Contributors to the OpenDCC project
+// SPDX-License-Identifier: Apache-2.0
+
+#include "opendcc/usd_editor/usd_node_editor/graph_cache.h"
+#include <algorithm>
+
+PXR_NAMESPACE_USING_DIRECTIVE
+OPENDCC_NAMESPACE_OPEN
+
+namespace
+{
+    NodeId get_port_node(const PortId& port_id)
+    {
+        return port_id.substr(0, port_id.rfind('.'));
+    }
+
+    // the ids are prim paths followed by a property name or a tag, e.g. "/mat#mat_in.inputs:color"
+    bool has_path_prefix(const std::string& id, const std::string& prefix)
+    {
+        if (id.compare(0, prefix.size(), prefix) != 0)
+            return false;
+        if (id.size() == prefix.size())
+            return true;
+        const auto delimiter = id[prefix.size()];
+        return delimiter == '/' || delimiter == '.' || delimiter == '#';
+    }
+
+    std::string replace_path_prefix(const std::string& id, const std::string& old_prefix, const std::string& new_prefix)
+    {
+        if (!has_path_prefix(id, old_prefix))
+            return id;
+        return new_prefix + id.substr(old_prefix.size());
+    }
+};
+
+bool GraphCache::has_node(const NodeId& node) const
+{
+    return m_nodes.find(node) != m_nodes.end();
+}
+
+bool GraphCache::add_node(const NodeId& node)
+{
+    if (!m_nodes.insert(node).second)
+        return false;
+    m_node_connections.emplace(node, std::vector<const ConnectionId*>());
+    return true;
+}
+
+bool GraphCache::remove_node(const NodeId& node)
+{
+    if (!m_nodes.erase(node))
+        return false;
+    auto it = m_node_connections.find(node);
+    if (it != m_node_connections.end() && it->second.empty())
+        m_node_connections.erase(it);
+    return true;
+}
+
+bool GraphCache::has_connection(const ConnectionId& connection) const
+{
+    return m_connections.find(connection) != m_connections.end();
+}
+
+bool GraphCache::add_connection(const ConnectionId& connection)
+{
+    const auto result = m_connections.insert(connection);
+    if (!result.second)
+        return false;
+
+    const auto start_node = get_port_node(connection.start_port);
+    const auto end_node = get_port_node(connection.end_port);
+    link(start_node, &*result.first);
+    if (end_node != start_node)
+        link(end_node, &*result.first);
+    return true;
+}
+
+bool GraphCache::remove_connection(const ConnectionId& connection)
+{
+    const auto it = m_connections.find(connection);
+    if (it == m_connections.end())
+        return false;
+
+    unlink(get_port_node(connection.start_port), &*it);
+    unlink(get_port_node(connection.end_port), &*it);
+    m_connections.erase(it);
+    return true;
+}
+
+std::vector<ConnectionId> GraphCache::get_connections_for_node(const NodeId& node) const
+{
+    std::vector<ConnectionId> result;
+    const auto it = m_node_connections.find(node);
+    if (it == m_node_connections.end())
+        return result;
+
+    result.reserve(it->second.size());
+    for (const auto connection : it->second)
+        result.push_back(*connection);
+    return result;
+}
+
+void GraphCache::reserve(size_t nodes_count, size_t connections_count)
+{
+    m_nodes.reserve(nodes_count);
+    m_connections.reserve(connections_count);
+}
+
+void GraphCache::clear()
+{
+    m_node_connections.clear();
+    m_connections.clear();
+    m_nodes.clear();
+}
+
+GraphCache::RenameResult GraphCache::rename(const SdfPath& old_path, const SdfPath& new_path)
+{
+    RenameResult result;
+    if (old_path == new_path || !old_path.IsAbsolutePath() || old_path.IsAbsoluteRootPath())
+        return result;
+
+    const auto& old_prefix = old_path.GetString();
+    const auto& new_prefix = new_path.GetString();
+
+    // every id with the prefix starts with its string, so they follow each other in the index
+    std::vector<NodeId> renamed_nodes;
+    std::vector<const ConnectionId*> renamed_connections;
+    for (auto it = m_node_connections.lower_bound(old_prefix); it != m_node_connections.end() && it->first.compare(0, old_prefix.size(), old_prefix) == 0;
+         ++it)
+    {
+        if (!has_path_prefix(it->first, old_prefix))
+            continue;
+        renamed_nodes.push_back(it->first);
+        renamed_connections.insert(renamed_connections.end(), it->second.begin(), it->second.end());
+    }
+    std::sort(renamed_connections.begin(), renamed_connections.end());
+    renamed_connections.erase(std::unique(renamed_connections.begin(), renamed_connections.end()), renamed_connections.end());
+
+    result.connections.reserve(renamed_connections.size());
+    for (const auto connection : renamed_connections)
+    {
+        result.connections.emplace_back(*connection, ConnectionId { replace_path_prefix(connection->start_port, old_prefix, new_prefix),
+                                                                    replace_path_prefix(connection->end_port, old_prefix, new_prefix) });
+    }
+    for (const auto& connection : result.connections)
+        remove_connection(connection.first);
+
+    for (const auto& node : renamed_nodes)
+    {
+        if (remove_node(node))
+            result.nodes.emplace_back(node, replace_path_prefix(node, old_prefix, new_prefix));
+    }
+    for (const auto& node : result.nodes)
+        add_node(node.second);
+    for (const auto& connection : result.connections)
+        add_connection(connection.second);
+    return result;
+}
+
+void GraphCache::link(const NodeId& node, const ConnectionId* connection)
+{
+    m_node_connections[node].push_back(connection);
+}
+
+void GraphCache::unlink(const NodeId& node, const ConnectionId* connection)
+{
+    auto it = m_node_connections.find(node);
+    if (it == m_node_connections.end())
+        return;
+
+    auto& connections = it->second;
+    connections.erase(std::remove(connections.begin(), connections.end(), connection), connections.end());
+    // the nodes without connections are kept so that the renames find them
+    if (connections.empty() && m_nodes.find(node) == m_nodes.end())
+        m_node_connections.erase(it);
+}
+
+OPENDCC_NAMESPACE_CLOSE
+
+#define DOCTEST_CONFIG_NO_SHORT_MACRO_NAMES
+#define DOCTEST_CONFIG_SUPER_FAST_ASSERTS
+// Note: this define should be used once per shared lib
+#define DOCTEST_CONFIG_IMPLEMENTATION_IN_DLL
+#include <doctest/doctest.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <chrono>
+
+OPENDCC_NAMESPACE_USING
+PXR_NAMESPACE_USING_DIRECTIVE
+
+namespace
+{
+    // a chain of shaders with an external texture node for each of them, the last shader drives the material output
+    void make_network(GraphCache& cache, const std::string& root, size_t shaders_count)
+    {
+        for (size_t i = 0; i < shaders_count; ++i)
+        {
+            const auto shader = TfStringPrintf("%s/shader_%zu", root.c_str(), i);
+            const auto texture = TfStringPrintf("/textures/texture_%zu", i);
+            cache.add_node(shader);
+            cache.add_node(texture);
+            cache.add_connection({ texture + ".outputs:rgb", shader + ".inputs:color" });
+            if (i > 0)
+                cache.add_connection({ TfStringPrintf("%s/shader_%zu.outputs:out", root.c_str(), i - 1), shader + ".inputs:in" });
+        }
+        cache.add_connection({ TfStringPrintf("%s/shader_%zu.outputs:out", root.c_str(), shaders_count - 1), root + "#mat_out.outputs:surface" });
+    }
+};
+
+DOCTEST_TEST_SUITE("GraphCache")
+{
+    DOCTEST_TEST_CASE("connections_for_node")
+    {
+        GraphCache cache;
+        make_network(cache, "/mat", 3);
+        DOCTEST_CHECK(cache.get_nodes().size() == 6);
+        DOCTEST_CHECK(cache.get_connections().size() == 6);
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_1").size() == 3);
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat#mat_out").size() == 1);
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat").empty());
+        DOCTEST_CHECK(!cache.add_connection({ "/textures/texture_0.outputs:rgb", "/mat/shader_0.inputs:color" }));
+
+        DOCTEST_CHECK(cache.remove_connection({ "/mat/shader_0.outputs:out", "/mat/shader_1.inputs:in" }));
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_1").size() == 2);
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_0").size() == 1);
+
+        DOCTEST_CHECK(cache.remove_node("/mat/shader_0"));
+        DOCTEST_CHECK(!cache.has_node("/mat/shader_0"));
+        // connections are removed separately from their nodes
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_0").size() == 1);
+
+        cache.clear();
+        DOCTEST_CHECK(cache.get_nodes().empty());
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_1").empty());
+    }
+
+    DOCTEST_TEST_CASE("rename")
+    {
+        GraphCache cache;
+        make_network(cache, "/mat", 3);
+        cache.add_node("/mat_1");
+        cache.add_node("/mat/shader_10");
+
+        auto result = cache.rename(SdfPath("/mat/shader_1"), SdfPath("/mat/diffuse"));
+        DOCTEST_CHECK(result.nodes.size() == 1);
+        DOCTEST_CHECK(result.connections.size() == 3);
+        DOCTEST_CHECK(cache.has_node("/mat/diffuse"));
+        DOCTEST_CHECK(!cache.has_node("/mat/shader_1"));
+        DOCTEST_CHECK(cache.has_node("/mat/shader_10"));
+        DOCTEST_CHECK(cache.has_connection({ "/mat/shader_0.outputs:out", "/mat/diffuse.inputs:in" }));
+        DOCTEST_CHECK(cache.has_connection({ "/mat/diffuse.outputs:out", "/mat/shader_2.inputs:in" }));
+        DOCTEST_CHECK(cache.has_connection({ "/textures/texture_1.outputs:rgb", "/mat/diffuse.inputs:color" }));
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_0").size() == 2);
+        DOCTEST_CHECK(cache.get_connections_for_node("/mat/shader_1").empty());
+
+        result = cache.rename(SdfPath("/mat"), SdfPath("/material"));
+        DOCTEST_CHECK(result.nodes.size() == 4);
+        DOCTEST_CHECK(result.connections.size() == 6);
+        DOCTEST_CHECK(cache.has_node("/material/diffuse"));
+        DOCTEST_CHECK(cache.has_node("/material/shader_10"));
+        DOCTEST_CHECK(cache.has_node("/mat_1"));
+        DOCTEST_CHECK(cache.has_node("/textures/texture_2"));
+        DOCTEST_CHECK(!cache.has_connection({ "/mat/shader_2.outputs:out", "/mat#mat_out.outputs:surface" }));
+        DOCTEST_CHECK(cache.has_connection({ "/material/shader_2.outputs:out", "/material#mat_out.outputs:surface" }));
+        DOCTEST_CHECK(cache.get_connections_for_node("/material#mat_out").size() == 1);
+        DOCTEST_CHECK(cache.get_nodes().size() == 8);
+        DOCTEST_CHECK(cache.get_connections().size() == 6);
+
+        DOCTEST_CHECK(cache.rename(SdfPath("/missing"), SdfPath("/other")).nodes.empty());
+    }
+
+    DOCTEST_TEST_CASE("benchmark")
+    {
+        const size_t shaders_count = 2000;
+        const size_t renames_count = 100;
+        GraphCache cache;
+        make_network(cache, "/mat", shaders_count);
+
+        // the former approach: every rename rewrites all the ids and the connections of a node are found by a scan
+        std::unordered_set<NodeId> nodes = cache.get_nodes();
+        std::unordered_set<ConnectionId, ConnectionId::Hash> connections = cache.get_connections();
+        auto start = std::chrono::steady_clock::now();
+        size_t scanned_connections = 0;
+        for (size_t i = 0; i < renames_count; ++i)
+        {
+            const auto old_node = TfStringPrintf("/mat/shader_%zu", i);
+            const auto new_node = TfStringPrintf("/mat/renamed_%zu", i);
+            const auto old_port_prefix = old_node + ".";
+            const auto new_port_prefix = new_node + ".";
+            std::unordered_set<NodeId> new_nodes;
+            std::unordered_set<ConnectionId, ConnectionId::Hash> new_connections;
+            new_nodes.reserve(nodes.size());
+            new_connections.reserve(connections.size());
+            for (const auto& node : nodes)
+                new_nodes.insert(node == old_node ? new_node : node);
+            for (const auto& con : connections)
+                new_connections.insert(
+                    { TfStringReplace(con.start_port, old_port_prefix, new_port_prefix), TfStringReplace(con.end_port, old_port_prefix, new_port_prefix) });
+            std::swap(nodes, new_nodes);
+            std::swap(connections, new_connections);
+
+            for (const auto& con : connections)
+            {
+                if (TfStringStartsWith(con.start_port, new_port_prefix) || TfStringStartsWith(con.end_port, new_port_prefix))
+                    ++scanned_connections;
+            }
+        }
+        const auto rewrite_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        start = std::chrono::steady_clock::now();
+        size_t indexed_connections = 0;
+        for (size_t i = 0; i < renames_count; ++i)
+        {
+            const SdfPath new_path(TfStringPrintf("/mat/renamed_%zu", i));
+            cache.rename(SdfPath(TfStringPrintf("/mat/shader_%zu", i)), new_path);
+            indexed_connections += cache.get_connections_for_node(new_path.GetString()).size();
+        }
+        const auto incremental_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        DOCTEST_CHECK(cache.get_nodes() == nodes);
+        DOCTEST_CHECK(cache.get_connections() == connections);
+        DOCTEST_CHECK(indexed_connections == scanned_connections);
+
+        start = std::chrono::steady_clock::now();
+        const auto result = cache.rename(SdfPath("/mat"), SdfPath("/material"));
+        const auto root_rename_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        DOCTEST_CHECK(result.nodes.size() == shaders_count);
+        DOCTEST_CHECK(cache.has_node("/textures/texture_0"));
+
+        DOCTEST_MESSAGE(renames_count << " renames in a network of " << cache.get_nodes().size() << " nodes and " << cache.get_connections().size()
+                                      << " connections: full rewrite " << rewrite_time << " ms, incremental " << incremental_time
+                                      << " ms; root rename " << root_rename_time << " ms");
+    }
+}
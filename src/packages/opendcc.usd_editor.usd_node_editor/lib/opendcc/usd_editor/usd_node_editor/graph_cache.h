@@ -0,0 +1,72 @@
+/*
+ * Copyright Contributors to the OpenDCC project
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "opendcc/opendcc.h"
+#include "opendcc/usd_editor/usd_node_editor/api.h"
+#include "opendcc/ui/node_editor/graph_model.h"
+#include <pxr/usd/sdf/path.h>
+#include <map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+OPENDCC_NAMESPACE_OPEN
+
+/**
+ * @brief Nodes and connections displayed by a UsdGraphModel.
+ *
+ * Besides the sets of nodes and connections the cache indexes the connections by the nodes of their ports,
+ * the node of a port being the part of its id before the property name. The index is ordered by node id,
+ * so the ids which start with a prim path form a contiguous range and renaming a prim touches only the nodes
+ * and connections under it instead of rewriting the whole graph.
+ *
+ * The index stores pointers to the elements of the connection set, which stay valid until the connection is removed.
+ */
+class OPENDCC_USD_NODE_EDITOR_API GraphCache
+{
+public:
+    using NodeSet = std::unordered_set<NodeId>;
+    using ConnectionSet = std::unordered_set<ConnectionId, ConnectionId::Hash>;
+
+    struct RenameResult
+    {
+        std::vector<std::pair<NodeId, NodeId>> nodes;
+        std::vector<std::pair<ConnectionId, ConnectionId>> connections;
+    };
+
+    const NodeSet& get_nodes() const { return m_nodes; }
+    const ConnectionSet& get_connections() const { return m_connections; }
+
+    bool has_node(const NodeId& node) const;
+    bool add_node(const NodeId& node);
+    bool remove_node(const NodeId& node);
+
+    bool has_connection(const ConnectionId& connection) const;
+    bool add_connection(const ConnectionId& connection);
+    bool remove_connection(const ConnectionId& connection);
+    std::vector<ConnectionId> get_connections_for_node(const NodeId& node) const;
+
+    void reserve(size_t nodes_count, size_t connections_count);
+    void clear();
+
+    /**
+     * @brief Replaces the prefix of the node ids and ports which belong to the specified prim or its descendants.
+     *
+     * @return The renamed nodes and connections as pairs of the old and the new ids.
+     */
+    RenameResult rename(const PXR_NS::SdfPath& old_path, const PXR_NS::SdfPath& new_path);
+
+private:
+    void link(const NodeId& node, const ConnectionId* connection);
+    void unlink(const NodeId& node, const ConnectionId* connection);
+
+    NodeSet m_nodes;
+    ConnectionSet m_connections;
+    std::map<NodeId, std::vector<const ConnectionId*>> m_node_connections;
+};
+
+OPENDCC_NAMESPACE_CLOSE
@@ -9,6 +9,7 @@
 #include "opendcc/opendcc.h"
 #include "opendcc/usd_editor/usd_node_editor/api.h"
 #include "opendcc/usd_editor/usd_node_editor/node_provider.h"
+#include "opendcc/usd_editor/usd_node_editor/graph_cache.h"
 #include "opendcc/ui/node_editor/graph_model.h"
 #include "opendcc/app/core/application.h"
 #include "opendcc/app/core/stage_watcher.h"
@@ -28,12 +29,6 @@ public:
 
 class NodeProvider;
 
-struct GraphCache
-{
-    std::unordered_set<NodeId> nodes;
-    std::unordered_set<ConnectionId, ConnectionId::Hash> connections;
-};
-
 class OPENDCC_USD_NODE_EDITOR_API UsdGraphModel : public GraphModel
 {
     Q_OBJECT
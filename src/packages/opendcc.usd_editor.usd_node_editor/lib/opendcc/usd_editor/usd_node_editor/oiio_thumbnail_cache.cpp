@@ -3,13 +3,20 @@
 
 #include "opendcc/usd_editor/usd_node_editor/oiio_thumbnail_cache.h"
 #include <OpenImageIO/imagebuf.h>
+#include <OpenImageIO/imagebufalgo.h>
 #include <OpenImageIO/imagecache.h>
 #include <QRunnable>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QSaveFile>
 #include <QImage>
 #include <QString>
 #include <QByteArray>
 #include <QThreadPool>
+#include <algorithm>
 
 OPENDCC_NAMESPACE_OPEN
 
@@ -66,14 +73,111 @@ namespace
         return ret;
     }
 
+    constexpr int s_thumbnail_size = 256;
+
+    // Thumbnails on disk are keyed by the source file identity, so an edited texture
+    // gets a new entry and stale ones are simply never read again.
+    QString get_disk_cache_path(const QString& disk_cache_dir, const QFileInfo& file_info)
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        hash.addData(file_info.absoluteFilePath().toUtf8());
+        hash.addData(QByteArray::number(file_info.lastModified().toMSecsSinceEpoch()));
+        hash.addData(QByteArray::number(file_info.size()));
+        hash.addData(QByteArray::number(s_thumbnail_size));
+        return disk_cache_dir + "/" + QString::fromLatin1(hash.result().toHex()) + ".png";
+    }
+
+    // Returns the smallest mip level that still covers the thumbnail size, falls back to the last one.
+    int find_thumbnail_miplevel(OIIO::ImageBuf& img_buf, const std::string& image_path)
+    {
+        const int nmiplevels = std::max(1, img_buf.nmiplevels());
+        for (int miplevel = nmiplevels - 1; miplevel > 0; --miplevel)
+        {
+            if (!img_buf.init_spec(image_path, 0, miplevel))
+                continue;
+            const auto& spec = img_buf.spec();
+            if (std::max(spec.width, spec.height) >= s_thumbnail_size)
+                return miplevel;
+        }
+        return 0;
+    }
+
+    // ImageBuf_to_QImage wraps the pixels of the buffer and scaled() returns the same image when the size already fits,
+    // so such image is copied before the buffer dies
+    QImage make_thumbnail(const OIIO::ImageBuf& img_buf)
+    {
+        const auto image = ImageBuf_to_QImage(img_buf);
+        auto result = image.scaled(QSize(s_thumbnail_size, s_thumbnail_size), Qt::KeepAspectRatio);
+        if (!result.isNull() && result.constBits() == image.constBits())
+            return result.copy();
+        return result;
+    }
+
+    // Removes the oldest thumbnails until the directory fits into the size limit.
+    void prune_disk_cache(const QString& disk_cache_dir, qint64 size_limit)
+    {
+        const auto entries = QDir(disk_cache_dir).entryInfoList({ "*.png" }, QDir::Files, QDir::Time);
+        qint64 total_size = 0;
+        for (const auto& entry : entries)
+        {
+            total_size += entry.size();
+            if (total_size > size_limit)
+                QFile::remove(entry.absoluteFilePath());
+        }
+    }
+
+    class DiskCachePruneTask : public QRunnable
+    {
+    public:
+        DiskCachePruneTask(const QString& disk_cache_dir, qint64 size_limit)
+            : m_disk_cache_dir(disk_cache_dir)
+            , m_size_limit(size_limit)
+        {
+        }
+
+        void run() override { prune_disk_cache(m_disk_cache_dir, m_size_limit); }
+
+    private:
+        QString m_disk_cache_dir;
+        qint64 m_size_limit = 0;
+    };
+
+    QImage load_thumbnail(const std::string& image_path, OIIO::ImageCache* oiio_cache)
+    {
+        OIIO::ImageBuf img_buf_src(image_path, 0, 0, oiio_cache);
+        if (!img_buf_src.init_spec(image_path, 0, 0))
+            return {};
+
+        const int miplevel = find_thumbnail_miplevel(img_buf_src, image_path);
+        if (!img_buf_src.read(0, miplevel, true, OIIO::TypeDesc::UINT8))
+            return {};
+
+        // Textures without mips are resized right after reading so that the full resolution image
+        // is never converted to QImage.
+        const auto& spec = img_buf_src.spec();
+        const int max_side = std::max(spec.width, spec.height);
+        if (max_side > 2 * s_thumbnail_size)
+        {
+            const int width = std::max(1, spec.width * s_thumbnail_size / max_side);
+            const int height = std::max(1, spec.height * s_thumbnail_size / max_side);
+            OIIO::ImageBuf img_buf_resized(OIIO::ImageSpec(width, height, spec.nchannels, OIIO::TypeDesc::UINT8));
+            if (!OIIO::ImageBufAlgo::resize(img_buf_resized, img_buf_src))
+                return {};
+            return make_thumbnail(img_buf_resized);
+        }
+
+        return make_thumbnail(img_buf_src);
+    }
+
     class ThumbnailLoaderTask : public QRunnable
     {
     public:
-        ThumbnailLoaderTask(OIIO::ImageCache* oiio_cache, OIIOThumbnailCache* cache, const QString& file_path)
+        ThumbnailLoaderTask(OIIO::ImageCache* oiio_cache, OIIOThumbnailCache* cache, const QString& file_path, const QString& disk_cache_dir)
         {
             m_cache = cache;
             m_file_path = file_path;
             m_oiio_cache = oiio_cache;
+            m_disk_cache_dir = disk_cache_dir;
         }
 
         void run() override
@@ -84,28 +188,48 @@ namespace
             {
                 auto result = get_udim_tiles(image_path, 50);
                 if (result.size() > 0)
+                {
                     image_path = std::get<1>(result[0]);
+                }
                 else
+                {
+                    m_cache->insert_image(m_file_path, nullptr);
                     return;
+                }
             }
 
-            OIIO::ImageBuf img_buf_src(image_path.toLocal8Bit().toStdString(), m_oiio_cache);
+            const QFileInfo file_info(image_path);
+            QString disk_cache_path;
+            if (!m_disk_cache_dir.isEmpty() && file_info.exists())
+            {
+                disk_cache_path = get_disk_cache_path(m_disk_cache_dir, file_info);
+                QImage cached_image;
+                if (cached_image.load(disk_cache_path, "PNG"))
+                {
+                    m_cache->insert_image(m_file_path, new QImage(std::move(cached_image)));
+                    return;
+                }
+            }
 
-            const bool read_status = img_buf_src.read(0, 0, true, OIIO::TypeDesc::UINT8);
-            if (!read_status)
+            QImage image = load_thumbnail(image_path.toLocal8Bit().toStdString(), m_oiio_cache);
+            if (image.isNull())
+            {
+                m_cache->insert_image(m_file_path, nullptr);
                 return;
+            }
 
-            QImage image = ImageBuf_to_QImage(img_buf_src);
-
-            if (!image.isNull())
+            if (!disk_cache_path.isEmpty())
             {
-                QImage* image_scaled = new QImage(image.scaled(QSize(256, 256), Qt::KeepAspectRatio));
-                m_cache->insert_image(m_file_path, image_scaled);
+                QSaveFile file(disk_cache_path);
+                if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG"))
+                    file.commit();
             }
+            m_cache->insert_image(m_file_path, new QImage(std::move(image)));
         }
 
         OIIOThumbnailCache* m_cache = nullptr;
         QString m_file_path;
+        QString m_disk_cache_dir;
         OIIO::ImageCache* m_oiio_cache = nullptr;
     };
 
@@ -116,6 +240,7 @@ OIIOThumbnailCache::OIIOThumbnailCache(QObject* parent)
 {
     m_cache.setMaxCost(500);
     m_oiio_cache = OIIO::ImageCache::create(false);
+    set_disk_cache_dir(QDir::tempPath() + "/opendcc_thumbnails");
 }
 
 OIIOThumbnailCache::~OIIOThumbnailCache()
@@ -132,17 +257,91 @@ bool OIIOThumbnailCache::has_image(const QString& path) const
 
 void OIIOThumbnailCache::read_image_async(const QString& path)
 {
-    auto task = new ThumbnailLoaderTask(m_oiio_cache, this, path);
+    QString disk_cache_dir;
+    bool path_is_cached = true;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // the image could be loaded between has_image and read_image_async calls
+        if (!m_cache.contains(path))
+        {
+            // another item already requested this path, it will be notified with the same image_read signal
+            if (m_pending.contains(path))
+                return;
+            m_pending.insert(path);
+            disk_cache_dir = m_disk_cache_dir;
+            path_is_cached = false;
+        }
+    }
+    if (path_is_cached)
+    {
+        // requester expects the notification after the call returns
+        QMetaObject::invokeMethod(
+            this, [this, path] { Q_EMIT image_read(path); }, Qt::QueuedConnection);
+        return;
+    }
+
+    auto task = new ThumbnailLoaderTask(m_oiio_cache, this, path, disk_cache_dir);
     QThreadPool::globalInstance()->start(task);
 }
 
 void OIIOThumbnailCache::insert_image(const QString& path, QImage* image)
 {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    if (m_cache.insert(path, image))
+    bool inserted = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pending.remove(path);
+        inserted = image && m_cache.insert(path, image);
+    }
+    if (inserted)
         Q_EMIT image_read(path);
 }
 
+void OIIOThumbnailCache::set_disk_cache_dir(const QString& dir)
+{
+    if (!dir.isEmpty())
+        QDir().mkpath(dir);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_disk_cache_dir = dir;
+    }
+    prune_disk_cache_async();
+}
+
+QString OIIOThumbnailCache::get_disk_cache_dir() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_disk_cache_dir;
+}
+
+void OIIOThumbnailCache::set_disk_cache_size_limit(qint64 size_limit)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_disk_cache_size_limit = size_limit;
+    }
+    prune_disk_cache_async();
+}
+
+qint64 OIIOThumbnailCache::get_disk_cache_size_limit() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_disk_cache_size_limit;
+}
+
+void OIIOThumbnailCache::prune_disk_cache_async()
+{
+    QString disk_cache_dir;
+    qint64 size_limit = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        disk_cache_dir = m_disk_cache_dir;
+        size_limit = m_disk_cache_size_limit;
+    }
+    if (!disk_cache_dir.isEmpty())
+        QThreadPool::globalInstance()->start(new DiskCachePruneTask(disk_cache_dir, size_limit));
+}
+
 QImage* OIIOThumbnailCache::read_image(const QString& path)
 {
     std::lock_guard<std::mutex> lock(m_mutex);
@@ -10,6 +10,8 @@
 #include "opendcc/usd_editor/usd_node_editor/api.h"
 #include "opendcc/ui/node_editor/thumbnail_cache.h"
 #include <QCache>
+#include <QSet>
+#include <QString>
 #include <mutex>
 
 OIIO_NAMESPACE_BEGIN
@@ -28,10 +30,25 @@ public:
     bool has_image(const QString& path) const override;
     QImage* read_image(const QString& path) override;
     void read_image_async(const QString& path) override;
+    // Takes ownership of image. A null image marks the request for path as failed.
     void insert_image(const QString& path, QImage* image);
 
+    // Directory with downsampled thumbnails shared between sessions.
+    // An empty string disables the on-disk cache.
+    void set_disk_cache_dir(const QString& dir);
+    QString get_disk_cache_dir() const;
+    // Size of the on-disk cache in bytes, the oldest thumbnails above it are removed
+    // when the directory or the limit is set.
+    void set_disk_cache_size_limit(qint64 size_limit);
+    qint64 get_disk_cache_size_limit() const;
+
 private:
+    void prune_disk_cache_async();
+
     QCache<QString, QImage> m_cache;
+    QSet<QString> m_pending;
+    QString m_disk_cache_dir;
+    qint64 m_disk_cache_size_limit = 256 * 1024 * 1024;
     mutable std::mutex m_mutex;
     OIIO::ImageCache* m_oiio_cache = nullptr;
 };
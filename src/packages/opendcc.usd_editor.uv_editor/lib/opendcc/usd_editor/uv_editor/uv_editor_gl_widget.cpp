@@ -204,7 +204,11 @@ QString UVEditorGLWidget::get_uv_primvar() const
 void UVEditorGLWidget::set_prim_paths(const SdfPathVector& prim_paths)
 {
     if (update_if_differs(m_engine_params.user_data, "uv.prim_paths", prim_paths))
+    {
+        if (m_tool)
+            m_tool->on_prim_paths_changed();
         update();
+    }
 }
 
 SdfPathVector UVEditorGLWidget::get_prim_paths() const
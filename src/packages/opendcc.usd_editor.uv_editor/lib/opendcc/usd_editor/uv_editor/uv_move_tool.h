@@ -33,6 +33,7 @@ public:
     void draw(ViewportUiDrawManager* draw_manager) override;
 
     bool is_working() const override;
+    void on_prim_paths_changed() override;
 
 private:
     enum class Mode
@@ -51,7 +52,7 @@ private:
 
     Application::CallbackHandle m_selection_changed_id;
     Application::CallbackHandle m_current_viewport_tool_changed_id;
-    Session::StageChangedCallbackHandle m_current_stage_object_changed_id;
+    StageChangesDispatcher::Handle m_current_stage_object_changed_id = 0;
 };
 
 OPENDCC_NAMESPACE_CLOSE
@@ -19,6 +19,20 @@ OPENDCC_NAMESPACE_OPEN
 
 PXR_NAMESPACE_USING_DIRECTIVE
 
+namespace
+{
+    // the command is built from the meshes shown in the editor and their selected components
+    StageChangesDispatcher::Filter uv_changes_filter(const UVEditorGLWidget* widget)
+    {
+        StageChangesDispatcher::Filter filter;
+        filter.paths = widget->get_prim_paths();
+        const auto& selected_paths = Application::instance().get_selection().get_selected_paths();
+        filter.paths.insert(filter.paths.end(), selected_paths.begin(), selected_paths.end());
+        filter.coalesce = true;
+        return filter;
+    }
+}
+
 //////////////////////////////////////////////////////////////////////////
 // UvScaleTool
 //////////////////////////////////////////////////////////////////////////
@@ -34,8 +48,8 @@ UvScaleTool::UvScaleTool(UVEditorGLWidget* widget)
     m_selection_changed_id = app.register_event_callback(Application::EventType::SELECTION_CHANGED, [&] { update_command(); });
     m_current_viewport_tool_changed_id =
         app.register_event_callback(Application::EventType::CURRENT_VIEWPORT_TOOL_CHANGED, [&] { update_command(); });
-    m_current_stage_object_changed_id = app.get_session()->register_stage_changed_callback(
-        Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED, [&](UsdNotice::ObjectsChanged const& notice) { update_command(); });
+    m_current_stage_object_changed_id = app.get_session()->register_stage_changes_callback(uv_changes_filter(get_widget()),
+                                                                                           [&](const StageChangeSummary&) { update_command(); });
 }
 
 UvScaleTool::~UvScaleTool()
@@ -44,8 +58,7 @@ UvScaleTool::~UvScaleTool()
 
     app.unregister_event_callback(Application::EventType::SELECTION_CHANGED, m_selection_changed_id);
     app.unregister_event_callback(Application::EventType::CURRENT_VIEWPORT_TOOL_CHANGED, m_current_viewport_tool_changed_id);
-    app.get_session()->unregister_stage_changed_callback(Session::StageChangedEventType::CURRENT_STAGE_OBJECT_CHANGED,
-                                                         m_current_stage_object_changed_id);
+    app.get_session()->unregister_stage_changes_callback(m_current_stage_object_changed_id);
 }
 
 bool UvScaleTool::on_mouse_press(QMouseEvent* event) /* override */
@@ -179,8 +192,15 @@ UvScaleTool::Mode UvScaleTool::current_mode() const
     }
 }
 
+void UvScaleTool::on_prim_paths_changed() /* override */
+{
+    update_command();
+}
+
 void UvScaleTool::update_command()
 {
+    Application::instance().get_session()->set_stage_changes_filter(m_current_stage_object_changed_id, uv_changes_filter(get_widget()));
+
     if (m_command && m_command->is_started())
     {
         return;
@@ -21,6 +21,9 @@ UvTool::UvTool(UVEditorGLWidget* widget)
 /* virtual */
 UvTool::~UvTool() {}
 
+/* virtual */
+void UvTool::on_prim_paths_changed() {}
+
 UVEditorGLWidget* UvTool::get_widget()
 {
     return m_widget;
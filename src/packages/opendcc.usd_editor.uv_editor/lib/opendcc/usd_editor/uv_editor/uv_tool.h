@@ -27,6 +27,8 @@ public:
     virtual void draw(ViewportUiDrawManager* draw_manager) = 0;
 
     virtual bool is_working() const = 0;
+    // called when the editor starts showing another set of prims
+    virtual void on_prim_paths_changed();
 
     UVEditorGLWidget* get_widget();
     const UVEditorGLWidget* get_widget() const;